@@ -0,0 +1,421 @@
+#include "LogHelpers.h"
+#include <algorithm>
+#include <bit>
+
+
+namespace LOGGER_NS {
+    // Bounded ring of one producer thread (Vyukov's queue with per-cell sequence numbers).
+    // Owner pushes, writer pops; owner also pops when it drops oldest records, so pop claims cells with CAS.
+    struct AsyncLogWriter::ThreadBuffer {
+        struct Cell {
+            std::atomic<size_t> sequence;
+            AsyncLogRecord record;
+        };
+
+        explicit ThreadBuffer(size_t capacity)
+            : cells{ std::make_unique<Cell[]>(capacity) }
+            , capacity{ capacity }
+            , mask{ capacity - 1 }
+        {
+            for (size_t i = 0; i < capacity; i++) {
+                this->cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool TryPush(AsyncLogRecord& record) {
+            size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+            auto& cell = this->cells[pos & this->mask];
+
+            if (cell.sequence.load(std::memory_order_acquire) != pos) {
+                return false; // full (or the oldest cell is still being read)
+            }
+
+            cell.record = std::move(record);
+            cell.sequence.store(pos + 1, std::memory_order_release);
+            this->enqueuePos.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool TryPop(AsyncLogRecord& record, size_t& poppedPos) {
+            size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+
+            for (;;) {
+                auto& cell = this->cells[pos & this->mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+                if (diff == 0) {
+                    if (this->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        record = std::move(cell.record);
+                        cell.sequence.store(pos + this->mask + 1, std::memory_order_release);
+                        poppedPos = pos;
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false; // empty
+                }
+                else {
+                    pos = this->dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool Empty() const {
+            return this->dequeuePos.load(std::memory_order_acquire) == this->enqueuePos.load(std::memory_order_acquire);
+        }
+
+        void AddStats(AsyncLoggingStats& stats) const {
+            stats.enqueued += this->enqueued.load(std::memory_order_relaxed);
+            stats.written += this->written.load(std::memory_order_relaxed);
+            stats.droppedNewest += this->droppedNewest.load(std::memory_order_relaxed);
+            stats.droppedOldest += this->droppedOldest.load(std::memory_order_relaxed);
+            stats.blockedPushes += this->blockedPushes.load(std::memory_order_relaxed);
+        }
+
+        const std::unique_ptr<Cell[]> cells;
+        const size_t capacity;
+        const size_t mask;
+
+        // written by owner thread
+        alignas(64) std::atomic<size_t> enqueuePos = 0;
+        std::atomic<bool> producerActive = false; // owner is inside Push, writer must not exit while it's set
+        std::atomic<bool> ownerExited = false;
+        std::atomic<uint64_t> enqueued = 0;
+        std::atomic<uint64_t> droppedNewest = 0;
+        std::atomic<uint64_t> droppedOldest = 0;
+        std::atomic<uint64_t> blockedPushes = 0;
+
+        // written by writer thread
+        alignas(64) std::atomic<size_t> dequeuePos = 0;
+        std::atomic<size_t> writtenPos = 0; // all records before it are written and flushed
+        std::atomic<uint64_t> written = 0;
+        size_t pendingWrittenPos = 0; // published as writtenPos after the pass flush
+
+        std::atomic<uint32_t> waitersCount = 0; // threads waiting for writtenPos change
+    };
+
+
+    std::atomic<uint64_t> AsyncLogWriter::nextWriterId = 0;
+
+    namespace {
+        thread_local const AsyncLogWriter* currentThreadWriter = nullptr; // set on the writer thread
+    }
+
+    AsyncLogWriter::AsyncLogWriter(DispatchFn dispatch)
+        : writerId{ nextWriterId++ }
+        , dispatch{ std::move(dispatch) }
+    {
+        this->optionsHistory.push_back(std::make_unique<const AsyncLoggingOptions>());
+        this->options = this->optionsHistory.back().get();
+    }
+
+    AsyncLogWriter::~AsyncLogWriter() {
+        this->Stop();
+    }
+
+    void AsyncLogWriter::Start(const AsyncLoggingOptions& options) {
+        std::lock_guard lk{ this->controlMtx };
+        if (this->running) {
+            return;
+        }
+
+        auto runOptions = std::make_unique<AsyncLoggingOptions>(options);
+        runOptions->threadBufferCapacity = std::bit_ceil((std::max)(options.threadBufferCapacity, size_t{ 2 }));
+
+        this->options = runOptions.get();
+        this->optionsHistory.push_back(std::move(runOptions));
+
+        this->running = true;
+        this->writerThread = std::thread([this] {
+            this->WriterRoutine();
+            });
+    }
+
+    void AsyncLogWriter::Stop() {
+        std::lock_guard lk{ this->controlMtx };
+        if (!this->running) {
+            return;
+        }
+
+        // Producers which saw running == true finish their push before the writer exits (see WriterRoutine),
+        // the rest dispatch on their own thread.
+        this->running = false;
+        this->WakeWriter();
+        this->writerThread.join();
+    }
+
+    void AsyncLogWriter::Push(AsyncLogRecord&& record) {
+        if (currentThreadWriter == this) {
+            // the writer would wait for itself (sync level or full ring)
+            this->DispatchNow(record);
+            return;
+        }
+
+        auto& buffer = this->CurrentThreadBuffer();
+
+        // seq_cst pair with Stop: either the writer sees producerActive or we see running == false
+        buffer.producerActive = true;
+        if (!this->running) {
+            buffer.producerActive = false;
+
+            // keep order with records staged before Stop (the writer drains them before exiting)
+            this->WaitWritten(buffer, buffer.enqueuePos.load(std::memory_order_acquire));
+            this->DispatchNow(record);
+            return;
+        }
+
+        const auto& options = *this->options.load();
+        size_t pos = buffer.enqueuePos.load(std::memory_order_relaxed);
+        bool needWait = record.level >= options.syncLevel && record.level != spdlog::level::off;
+
+        // sync level messages are never dropped
+        auto overflowPolicy = needWait ? AsyncOverflowPolicy::Block : options.overflowPolicy;
+
+        if (this->PushToBuffer(buffer, record, overflowPolicy)) {
+            buffer.enqueued.fetch_add(1, std::memory_order_relaxed);
+
+            size_t staged = pos + 1 - buffer.writtenPos.load(std::memory_order_relaxed);
+            if (needWait || staged == buffer.capacity / 2) {
+                this->WakeWriter();
+            }
+            if (needWait) {
+                this->WaitWritten(buffer, pos + 1);
+            }
+        }
+
+        buffer.producerActive.store(false, std::memory_order_release);
+    }
+
+    void AsyncLogWriter::Flush() {
+        if (currentThreadWriter == this) {
+            return; // records of the writer thread are dispatched inline, the rest is flushed at the end of the pass
+        }
+
+        std::vector<std::pair<std::shared_ptr<ThreadBuffer>, size_t>> targets;
+        {
+            std::lock_guard lk{ this->registryMtx };
+            for (auto& buffer : this->threadBuffers) {
+                targets.emplace_back(buffer, buffer->enqueuePos.load(std::memory_order_acquire));
+            }
+        }
+
+        this->WakeWriter();
+        for (auto& [buffer, pos] : targets) {
+            this->WaitWritten(*buffer, pos);
+        }
+    }
+
+    AsyncLoggingStats AsyncLogWriter::GetStats() {
+        std::lock_guard lk{ this->registryMtx };
+
+        AsyncLoggingStats stats = this->retiredStats;
+        for (auto& buffer : this->threadBuffers) {
+            buffer->AddStats(stats);
+        }
+        return stats;
+    }
+
+
+    AsyncLogWriter::ThreadBuffer& AsyncLogWriter::CurrentThreadBuffer() {
+        struct ThreadBuffersHolder {
+            ~ThreadBuffersHolder() {
+                for (auto& [writerId, buffer] : this->buffers) {
+                    buffer->ownerExited = true;
+                }
+            }
+
+            std::vector<std::pair<uint64_t, std::shared_ptr<ThreadBuffer>>> buffers; // usually one writer per process
+        };
+        thread_local ThreadBuffersHolder holder;
+
+        for (auto& [writerId, buffer] : holder.buffers) {
+            if (writerId == this->writerId) {
+                return *buffer;
+            }
+        }
+
+        auto buffer = std::make_shared<ThreadBuffer>(this->options.load()->threadBufferCapacity);
+        {
+            std::lock_guard lk{ this->registryMtx };
+            this->threadBuffers.push_back(buffer);
+            this->registryVersion++;
+        }
+        holder.buffers.emplace_back(this->writerId, buffer);
+        return *buffer;
+    }
+
+    bool AsyncLogWriter::PushToBuffer(ThreadBuffer& buffer, AsyncLogRecord& record, AsyncOverflowPolicy overflowPolicy) {
+        bool blocked = false;
+
+        while (!buffer.TryPush(record)) {
+            switch (overflowPolicy) {
+            case AsyncOverflowPolicy::DropNewest:
+                buffer.droppedNewest.fetch_add(1, std::memory_order_relaxed);
+                return false;
+
+            case AsyncOverflowPolicy::DropOldest: {
+                AsyncLogRecord oldest;
+                size_t oldestPos;
+                if (buffer.TryPop(oldest, oldestPos)) {
+                    buffer.droppedOldest.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    std::this_thread::yield(); // the writer is moving the oldest record out right now
+                }
+                break;
+            }
+
+            case AsyncOverflowPolicy::Block:
+            default: {
+                if (!blocked) {
+                    blocked = true;
+                    buffer.blockedPushes.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                size_t writtenPos = buffer.writtenPos.load();
+                if (buffer.TryPush(record)) {
+                    return true;
+                }
+
+                buffer.waitersCount++;
+                this->WakeWriter();
+                buffer.writtenPos.wait(writtenPos);
+                buffer.waitersCount--;
+                break;
+            }
+            }
+        }
+
+        return true;
+    }
+
+    void AsyncLogWriter::WaitWritten(ThreadBuffer& buffer, size_t pos) {
+        buffer.waitersCount++;
+
+        for (size_t writtenPos = buffer.writtenPos.load(); writtenPos < pos; writtenPos = buffer.writtenPos.load()) {
+            this->WakeWriter();
+            buffer.writtenPos.wait(writtenPos);
+        }
+
+        buffer.waitersCount--;
+    }
+
+    void AsyncLogWriter::WakeWriter() {
+        {
+            std::lock_guard lk{ this->wakeMtx };
+            this->wakeRequested = true;
+        }
+        this->wakeCv.notify_one();
+    }
+
+
+    void AsyncLogWriter::WriterRoutine() {
+        currentThreadWriter = this;
+
+        const auto pollInterval = this->options.load()->pollInterval;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        uint64_t buffersVersion = 0;
+
+        for (;;) {
+            bool stopping = !this->running;
+
+            if (buffersVersion != this->registryVersion.load()) {
+                std::lock_guard lk{ this->registryMtx };
+
+                // buffers of exited threads go away once drained
+                std::erase_if(this->threadBuffers, [this](const std::shared_ptr<ThreadBuffer>& buffer) {
+                    if (buffer->ownerExited && buffer->Empty()) {
+                        buffer->AddStats(this->retiredStats);
+                        return true;
+                    }
+                    return false;
+                    });
+
+                buffers = this->threadBuffers;
+                buffersVersion = ++this->registryVersion;
+            }
+
+            bool anyProducerActive = std::any_of(buffers.begin(), buffers.end(), [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                return buffer->producerActive.load();
+                });
+
+            size_t written = this->DrainPass(buffers);
+
+            if (stopping) {
+                if (!anyProducerActive && written == 0) {
+                    break;
+                }
+                if (written == 0) {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+
+            if (written == 0) {
+                std::unique_lock lk{ this->wakeMtx };
+                this->wakeCv.wait_for(lk, pollInterval, [this] {
+                    return this->wakeRequested;
+                    });
+                this->wakeRequested = false;
+
+                // pick up buffers of exited threads from time to time
+                this->registryVersion++;
+            }
+        }
+    }
+
+    size_t AsyncLogWriter::DrainPass(std::vector<std::shared_ptr<ThreadBuffer>>& buffers) {
+        std::vector<std::shared_ptr<spdlog::logger>> loggersToFlush;
+        size_t writtenTotal = 0;
+        AsyncLogRecord record;
+
+        for (auto& buffer : buffers) {
+            size_t written = 0;
+            size_t poppedPos;
+
+            // one pass takes at most one ring from each thread, so a noisy thread doesn't hold back the others
+            while (written < buffer->capacity && buffer->TryPop(record, poppedPos)) {
+                this->dispatch(record);
+
+                if (record.level >= record.logger->flush_level() &&
+                    std::find(loggersToFlush.begin(), loggersToFlush.end(), record.logger) == loggersToFlush.end())
+                {
+                    loggersToFlush.push_back(record.logger);
+                }
+
+                buffer->pendingWrittenPos = poppedPos + 1;
+                written++;
+            }
+
+            buffer->written.fetch_add(written, std::memory_order_relaxed);
+            writtenTotal += written;
+        }
+
+        for (auto& logger : loggersToFlush) {
+            logger->flush();
+        }
+
+        for (auto& buffer : buffers) {
+            if (buffer->writtenPos.load(std::memory_order_relaxed) == buffer->pendingWrittenPos) {
+                continue;
+            }
+
+            // seq_cst pair with waitersCount++ in waiting threads
+            buffer->writtenPos.store(buffer->pendingWrittenPos);
+            if (buffer->waitersCount.load() > 0) {
+                buffer->writtenPos.notify_all();
+            }
+        }
+
+        return writtenTotal;
+    }
+
+    void AsyncLogWriter::DispatchNow(const AsyncLogRecord& record) {
+        this->dispatch(record);
+
+        if (record.level >= record.logger->flush_level()) {
+            record.logger->flush();
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+// Include it through "LogHelpers.h" (needs LOGGER_NS / LOGGER_API and spdlog headers).
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+namespace LOGGER_NS {
+    enum class AsyncOverflowPolicy : uint8_t {
+        Block,      // producer waits until the writer frees space
+        DropNewest, // message which doesn't fit is discarded
+        DropOldest, // oldest staged message of this thread is discarded to make room
+    };
+
+    struct AsyncLoggingOptions {
+        size_t threadBufferCapacity = 4096; // messages per thread, rounded up to power of two (used for threads which log first time)
+        AsyncOverflowPolicy overflowPolicy = AsyncOverflowPolicy::Block;
+
+        // Messages with this level or above are never dropped and wait until they are written and flushed,
+        // so the error before a crash isn't lost and GetLastMessage() returns LOG_ERROR_EX text.
+        spdlog::level::level_enum syncLevel = spdlog::level::err;
+
+        std::chrono::milliseconds pollInterval{ 10 }; // idle writer checks staging buffers at least this often
+    };
+
+    struct AsyncLoggingStats {
+        uint64_t enqueued = 0;
+        uint64_t written = 0;
+        uint64_t droppedNewest = 0;
+        uint64_t droppedOldest = 0;
+        uint64_t blockedPushes = 0; // pushes which had to wait for free space (Block policy)
+    };
+
+    // Message formatted on the caller thread. Everything custom flag formatters need travels with it.
+    struct AsyncLogRecord {
+        std::shared_ptr<spdlog::logger> logger;
+        spdlog::source_loc location;
+        spdlog::level::level_enum level = spdlog::level::off;
+        spdlog::log_clock::time_point time;
+        size_t threadId = 0;
+        std::wstring className;
+        std::string payload;
+    };
+
+    // Every producer thread stages records in its own bounded lock-free ring, one background thread drains
+    // all rings and passes records to 'dispatch'. Loggers touched during a drain pass are flushed once per pass.
+    class LOGGER_API AsyncLogWriter {
+    public:
+        using DispatchFn = std::function<void(const AsyncLogRecord&)>;
+
+        explicit AsyncLogWriter(DispatchFn dispatch);
+        ~AsyncLogWriter();
+
+        AsyncLogWriter(const AsyncLogWriter&) = delete;
+        AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+        void Start(const AsyncLoggingOptions& options = {});
+
+        // Writes everything staged so far and joins the writer thread.
+        void Stop();
+
+        bool IsRunning() const {
+            return this->running.load(std::memory_order_relaxed);
+        }
+
+        // Dispatches on the caller thread if the writer isn't running or if called by the writer itself (sink logs something).
+        void Push(AsyncLogRecord&& record);
+
+        // Waits until all records pushed before this call are written and flushed (no-op on the writer thread).
+        void Flush();
+
+        AsyncLoggingStats GetStats();
+
+    private:
+        struct ThreadBuffer;
+
+        ThreadBuffer& CurrentThreadBuffer();
+        bool PushToBuffer(ThreadBuffer& buffer, AsyncLogRecord& record, AsyncOverflowPolicy overflowPolicy);
+        void WaitWritten(ThreadBuffer& buffer, size_t pos);
+        void WakeWriter();
+
+        void WriterRoutine();
+        size_t DrainPass(std::vector<std::shared_ptr<ThreadBuffer>>& buffers);
+        void DispatchNow(const AsyncLogRecord& record);
+
+        static std::atomic<uint64_t> nextWriterId;
+
+        const uint64_t writerId;
+        const DispatchFn dispatch;
+
+        std::mutex controlMtx; // serializes Start / Stop
+
+        // Immutable options of the current (or last) run, published before running is set.
+        // Previous ones are kept until destruction: a producer may still read them while Start replaces them.
+        std::atomic<const AsyncLoggingOptions*> options;
+        std::vector<std::unique_ptr<const AsyncLoggingOptions>> optionsHistory; // under controlMtx
+        std::atomic<bool> running = false;
+        std::thread writerThread;
+
+        std::mutex wakeMtx;
+        std::condition_variable wakeCv;
+        bool wakeRequested = false;
+
+        std::mutex registryMtx;
+        std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+        std::atomic<uint64_t> registryVersion = 0;
+        AsyncLoggingStats retiredStats; // of buffers removed after their thread exited
+    };
+}
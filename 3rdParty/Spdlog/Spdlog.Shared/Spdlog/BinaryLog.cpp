@@ -0,0 +1,386 @@
+#include "LogHelpers.h"
+#include <spdlog/fmt/bundled/args.h>
+#include <cstring>
+
+
+namespace LOGGER_NS {
+    namespace {
+        int64_t TimeToNs(spdlog::log_clock::time_point time) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        spdlog::log_clock::time_point NsToTime(int64_t ns) {
+            return spdlog::log_clock::time_point{ std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds{ ns }) };
+        }
+
+        // Same conversion as spdlog::logger::log_ does for wide messages.
+        void WideToPayload(spdlog::wstring_view_t wstr, spdlog::memory_buf_t& buf) {
+#if defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT)
+            spdlog::details::os::wstr_to_utf8buf(wstr, buf);
+#else
+            spdlog::details::os::wstr_to_ansi_buf(wstr, buf);
+#endif
+        }
+    }
+
+
+    BinaryLogWriter::BinaryLogWriter(std::shared_ptr<SharedFileWriter> fileWriter, spdlog::level::level_enum flushLevel, bool disableEOLforRawLogger)
+        : fileWriter{ std::move(fileWriter) }
+        , flushLevel{ flushLevel }
+        , disableEOLforRawLogger{ disableEOLforRawLogger }
+    {
+        if (this->fileWriter->FileSize() != 0) {
+            // the previous process may have died in the middle of an entry, entries appended after it would be unreadable
+            try {
+                this->fileWriter->TruncateActiveSegment(BinaryLogReader::CompleteSize(this->fileWriter->Filename()));
+            }
+            catch (const spdlog::spdlog_ex&) {
+                // not a binary log of this version, keep it as is
+            }
+        }
+
+        const bool newFile = this->fileWriter->FileSize() == 0;
+
+        this->fileWriter->Append([&](spdlog::memory_buf_t& buffer) {
+            this->PutSessionStart(buffer, newFile);
+            }, true);
+
+        // every segment of a rotated file starts with its own header and session, call sites are written again
+        this->fileWriter->SetSegmentStartHandler([this](spdlog::memory_buf_t& buffer) {
+            this->callSites.clear();
+            this->PutSessionStart(buffer, true);
+            });
+    }
+
+    BinaryLogWriter::~BinaryLogWriter() {
+        this->fileWriter->SetSegmentStartHandler(nullptr);
+    }
+
+    const std::shared_ptr<SharedFileWriter>& BinaryLogWriter::GetFileWriter() const {
+        return this->fileWriter;
+    }
+
+    size_t BinaryLogWriter::CallSiteKeyHash::operator()(const CallSiteKey& key) const {
+        size_t hash = key.formatHash;
+        hash = hash * 31 + std::hash<const void*>{}(key.logger);
+        hash = hash * 31 + std::hash<const void*>{}(key.filename);
+        hash = hash * 31 + static_cast<size_t>(key.line);
+        hash = hash * 31 + static_cast<size_t>(key.level);
+        return hash;
+    }
+
+    void BinaryLogWriter::PutSessionStart(spdlog::memory_buf_t& buffer, bool fileHeader) const {
+        if (fileHeader) {
+            buffer.append(magic.data(), magic.data() + magic.size());
+            binary_log::Put(buffer, version);
+            binary_log::Put(buffer, static_cast<uint8_t>(sizeof(wchar_t)));
+            binary_log::Put(buffer, uint8_t{ 0 });
+        }
+
+        binary_log::Put(buffer, BinaryLogEntry::Session);
+        binary_log::Put(buffer, TimeToNs(spdlog::log_clock::now()));
+        binary_log::Put(buffer, static_cast<uint8_t>(this->disableEOLforRawLogger ? 0x01 : 0x00));
+    }
+
+    spdlog::memory_buf_t& BinaryLogWriter::ThreadArgsBuffer() {
+        thread_local spdlog::memory_buf_t argsBuffer;
+        return argsBuffer;
+    }
+
+    void BinaryLogWriter::WriteMessage(const CallSite& callSite, BinaryLogClassName className, const spdlog::memory_buf_t& args) {
+        const auto time = TimeToNs(spdlog::log_clock::now());
+        const auto threadId = static_cast<uint64_t>(spdlog::details::os::thread_id());
+
+        this->fileWriter->Append([&](spdlog::memory_buf_t& buffer) {
+            auto [it, inserted] = this->callSites.try_emplace(callSite.key);
+            if (inserted || it->second.format != callSite.format) {
+                it->second.id = this->nextCallSiteId++;
+                it->second.format = callSite.format;
+
+                binary_log::Put(buffer, BinaryLogEntry::CallSite);
+                binary_log::Put(buffer, it->second.id);
+                binary_log::Put(buffer, static_cast<uint8_t>(callSite.key.level));
+                binary_log::Put(buffer, callSite.charSize);
+                binary_log::Put(buffer, static_cast<uint32_t>(callSite.location.line));
+                binary_log::PutString(buffer, callSite.loggerName);
+                binary_log::PutString(buffer, std::string_view(callSite.location.filename ? callSite.location.filename : ""));
+                binary_log::PutString(buffer, std::string_view(callSite.location.funcname ? callSite.location.funcname : ""));
+                binary_log::Put(buffer, static_cast<uint32_t>(callSite.format.size() / callSite.charSize));
+                buffer.append(callSite.format.data(), callSite.format.data() + callSite.format.size());
+            }
+
+            binary_log::Put(buffer, BinaryLogEntry::Message);
+            binary_log::Put(buffer, it->second.id);
+            binary_log::Put(buffer, time);
+            binary_log::Put(buffer, threadId);
+            binary_log::Put(buffer, className.context);
+            binary_log::PutString(buffer, className.name);
+            binary_log::Put(buffer, static_cast<uint32_t>(args.size()));
+            buffer.append(args.data(), args.data() + args.size());
+            }, callSite.key.level >= this->flushLevel);
+    }
+
+
+
+    spdlog::source_loc BinaryLogCallSite::Location() const {
+        if (this->filename.empty()) {
+            return {};
+        }
+        return spdlog::source_loc{ this->filename.c_str(), this->line, this->funcname.c_str() };
+    }
+
+
+    namespace {
+        struct EndOfData {}; // entry is cut off
+
+        class BinaryLogParser {
+        public:
+            BinaryLogParser(const char* data, size_t size)
+                : ptr{ data }
+                , end{ data + size }
+            {
+            }
+
+            bool AtEnd() const {
+                return this->ptr == this->end;
+            }
+
+            const char* Position() const {
+                return this->ptr;
+            }
+
+            void ReadBytes(void* dest, size_t size) {
+                if (static_cast<size_t>(this->end - this->ptr) < size) {
+                    throw EndOfData{};
+                }
+                std::memcpy(dest, this->ptr, size);
+                this->ptr += size;
+            }
+
+            template<typename T>
+            T Read() {
+                T value;
+                this->ReadBytes(&value, sizeof(T));
+                return value;
+            }
+
+            std::string ReadString() {
+                std::string str(this->Read<uint32_t>(), '\0');
+                this->ReadBytes(str.data(), str.size());
+                return str;
+            }
+
+            // Wide units of the writer's size, it may differ from local wchar_t (surrogates aren't recombined).
+            std::wstring ReadWString(uint8_t unitSize) {
+                std::wstring str(this->Read<uint32_t>(), L'\0');
+                for (auto& ch : str) {
+                    switch (unitSize) {
+                    case 2:
+                        ch = static_cast<wchar_t>(this->Read<uint16_t>());
+                        break;
+                    case 4:
+                        ch = static_cast<wchar_t>(this->Read<uint32_t>());
+                        break;
+                    default:
+                        spdlog::throw_spdlog_ex("binary log: unsupported wchar_t size " + std::to_string(unitSize));
+                    }
+                }
+                return str;
+            }
+
+            template<typename TChar>
+            std::basic_string<TChar> ReadStringOf(uint8_t wcharSize) {
+                if constexpr (std::is_same_v<TChar, wchar_t>) {
+                    return this->ReadWString(wcharSize);
+                }
+                else {
+                    return this->ReadString();
+                }
+            }
+
+        private:
+            const char* ptr;
+            const char* end;
+        };
+
+        template<typename TChar>
+        void FormatArgs(std::basic_string_view<TChar> format, BinaryLogParser& args, uint8_t wcharSize, fmt::basic_memory_buffer<TChar, 250>& out) {
+            fmt::dynamic_format_arg_store<fmt::buffer_context<TChar>> store;
+
+            while (!args.AtEnd()) {
+                switch (args.Read<BinaryLogArg>()) {
+                case BinaryLogArg::Bool:
+                    store.push_back(args.Read<uint8_t>() != 0);
+                    break;
+                case BinaryLogArg::Char:
+                    store.push_back(static_cast<TChar>(args.Read<uint32_t>()));
+                    break;
+                case BinaryLogArg::Int:
+                    store.push_back(args.Read<int64_t>());
+                    break;
+                case BinaryLogArg::UInt:
+                    store.push_back(args.Read<uint64_t>());
+                    break;
+                case BinaryLogArg::Float:
+                    store.push_back(args.Read<float>());
+                    break;
+                case BinaryLogArg::Double:
+                    store.push_back(args.Read<double>());
+                    break;
+                case BinaryLogArg::Pointer:
+                    store.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(args.Read<uint64_t>())));
+                    break;
+                case BinaryLogArg::String:
+                    store.push_back(args.ReadStringOf<TChar>(wcharSize));
+                    break;
+                default:
+                    spdlog::throw_spdlog_ex("binary log: unknown argument type");
+                }
+            }
+
+            fmt::vformat_to(std::back_inserter(out), fmt::basic_string_view<TChar>(format.data(), format.size()), store);
+        }
+
+        std::string RenderPayload(const BinaryLogCallSite& callSite, const std::string& argsData, uint8_t wcharSize) {
+            BinaryLogParser args{ argsData.data(), argsData.size() };
+            spdlog::memory_buf_t buf;
+
+            try {
+                if (callSite.wideFormat) {
+                    fmt::basic_memory_buffer<wchar_t, 250> wbuf;
+                    FormatArgs<wchar_t>(callSite.wformat, args, wcharSize, wbuf);
+                    WideToPayload(spdlog::wstring_view_t(wbuf.data(), wbuf.size()), buf);
+                }
+                else {
+                    FormatArgs<char>(callSite.format, args, wcharSize, buf);
+                }
+            }
+            catch (const fmt::format_error& ex) {
+                // e.g. format spec of a custom type applied to its "{}" text
+                return fmt::format("[binary log: {}] {}", ex.what(), callSite.wideFormat ? std::string("<wide format>") : callSite.format);
+            }
+            catch (const EndOfData&) {
+                spdlog::throw_spdlog_ex("binary log: malformed message arguments");
+            }
+
+            return std::string(buf.data(), buf.size());
+        }
+
+        // completeSize is updated after every entry, so it's valid when an entry throws. Payload is rendered only for onMessage.
+        void ParseEntries(
+            const std::string& data,
+            const std::function<void(const BinaryLogSession&)>& onSession,
+            const std::function<void(const BinaryLogMessage&)>& onMessage,
+            size_t& completeSize
+        ) {
+            BinaryLogParser parser{ data.data(), data.size() };
+            uint8_t wcharSize = 0;
+            std::unordered_map<uint32_t, BinaryLogCallSite> callSites;
+
+            try {
+                std::string fileMagic(BinaryLogWriter::magic.size(), '\0');
+                parser.ReadBytes(fileMagic.data(), fileMagic.size());
+                if (fileMagic != BinaryLogWriter::magic || parser.Read<uint16_t>() != BinaryLogWriter::version) {
+                    spdlog::throw_spdlog_ex("binary log: unknown file format or version");
+                }
+                wcharSize = parser.Read<uint8_t>();
+                parser.Read<uint8_t>(); // reserved
+                completeSize = static_cast<size_t>(parser.Position() - data.data());
+
+                while (!parser.AtEnd()) {
+                    switch (parser.Read<BinaryLogEntry>()) {
+                    case BinaryLogEntry::Session: {
+                        BinaryLogSession session;
+                        session.time = NsToTime(parser.Read<int64_t>());
+                        session.disableEOLforRawLogger = (parser.Read<uint8_t>() & 0x01) != 0;
+
+                        callSites.clear();
+                        if (onSession) {
+                            onSession(session);
+                        }
+                        break;
+                    }
+
+                    case BinaryLogEntry::CallSite: {
+                        const auto id = parser.Read<uint32_t>();
+                        BinaryLogCallSite callSite;
+                        callSite.level = static_cast<spdlog::level::level_enum>(parser.Read<uint8_t>());
+                        const auto charSize = parser.Read<uint8_t>();
+                        callSite.line = static_cast<int>(parser.Read<uint32_t>());
+                        callSite.loggerName = parser.ReadString();
+                        callSite.filename = parser.ReadString();
+                        callSite.funcname = parser.ReadString();
+                        callSite.wideFormat = charSize != 1;
+                        if (callSite.wideFormat) {
+                            callSite.wformat = parser.ReadWString(charSize);
+                        }
+                        else {
+                            callSite.format = parser.ReadString();
+                        }
+
+                        callSites[id] = std::move(callSite);
+                        break;
+                    }
+
+                    case BinaryLogEntry::Message: {
+                        BinaryLogMessage message;
+                        auto it = callSites.find(parser.Read<uint32_t>());
+                        if (it == callSites.end()) {
+                            spdlog::throw_spdlog_ex("binary log: message refers to unknown call site");
+                        }
+                        message.callSite = &it->second;
+                        message.time = NsToTime(parser.Read<int64_t>());
+                        message.threadId = static_cast<size_t>(parser.Read<uint64_t>());
+                        message.classContext = parser.Read<BinaryLogClassContext>();
+                        message.className = parser.ReadWString(wcharSize);
+
+                        std::string argsData(parser.Read<uint32_t>(), '\0');
+                        parser.ReadBytes(argsData.data(), argsData.size());
+
+                        if (onMessage) {
+                            message.payload = RenderPayload(*message.callSite, argsData, wcharSize);
+                            onMessage(message);
+                        }
+                        break;
+                    }
+
+                    default:
+                        spdlog::throw_spdlog_ex("binary log: unknown entry type");
+                    }
+
+                    completeSize = static_cast<size_t>(parser.Position() - data.data());
+                }
+            }
+            catch (const EndOfData&) {
+                // the last entries weren't flushed before the process died
+            }
+        }
+    }
+
+
+    void BinaryLogReader::Read(
+        const std::filesystem::path& binaryLogPath,
+        const std::function<void(const BinaryLogSession&)>& onSession,
+        const std::function<void(const BinaryLogMessage&)>& onMessage
+    ) {
+        const std::string data = SegmentedLogFile::ReadSegment(binaryLogPath);
+
+        size_t completeSize = 0;
+        ParseEntries(data, onSession, onMessage, completeSize);
+    }
+
+    uintmax_t BinaryLogReader::CompleteSize(const std::filesystem::path& binaryLogPath) {
+        const std::string data = SegmentedLogFile::ReadSegment(binaryLogPath);
+
+        size_t completeSize = 0;
+        try {
+            ParseEntries(data, nullptr, nullptr, completeSize);
+        }
+        catch (const spdlog::spdlog_ex&) {
+            if (completeSize == 0) {
+                throw; // unknown file format or version
+            }
+        }
+        return completeSize;
+    }
+}
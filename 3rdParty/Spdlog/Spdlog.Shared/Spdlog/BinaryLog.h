@@ -0,0 +1,232 @@
+#pragma once
+// Include it through "LogHelpers.h" (needs LOGGER_NS / LOGGER_API and spdlog headers).
+#include "SharedFileSink.h"
+#include <unordered_map>
+#include <type_traits>
+#include <string_view>
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <memory>
+
+namespace LOGGER_NS {
+    // Binary log file layout (native byte order, wide strings are stored as native wchar_t units):
+    //   header:  "LGBINLOG", u16 version, u8 sizeof(wchar_t), u8 reserved
+    //   entries: u8 BinaryLogEntry + entry body
+    // str = u32 units count + units.
+    enum class BinaryLogEntry : uint8_t {
+        Session = 1,  // i64 time ns, u8 session flags; call site ids start from 0 again
+        CallSite = 2, // u32 id, u8 level, u8 format char size, u32 line, str logger, str file, str function, str format
+        Message = 3,  // u32 call site id, i64 time ns, u64 thread id, u8 BinaryLogClassContext, wstr class name, u32 args size, args
+    };
+
+    // Argument tag, followed by its value. Strings are in the format char type.
+    enum class BinaryLogArg : uint8_t {
+        Bool,    // u8
+        Char,    // u32
+        Int,     // i64
+        UInt,    // u64
+        Float,   // f32
+        Double,  // f64
+        Pointer, // u64
+        String,  // str, also used for types with custom formatters (formatted with "{}" on the caller thread)
+    };
+
+    enum class BinaryLogClassContext : uint8_t {
+        None,
+        Instance,
+        Null, // class context passed as nullptr (rendered as "Name(nullptr)")
+    };
+
+    struct BinaryLogClassName {
+        BinaryLogClassContext context = BinaryLogClassContext::None;
+        std::wstring_view name;
+    };
+
+    namespace binary_log {
+        template<typename T>
+        void Put(spdlog::memory_buf_t& buffer, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto bytes = reinterpret_cast<const char*>(&value);
+            buffer.append(bytes, bytes + sizeof(T));
+        }
+
+        template<typename TChar>
+        void PutString(spdlog::memory_buf_t& buffer, std::basic_string_view<TChar> str) {
+            Put(buffer, static_cast<uint32_t>(str.size()));
+            auto bytes = reinterpret_cast<const char*>(str.data());
+            buffer.append(bytes, bytes + str.size() * sizeof(TChar));
+        }
+
+        // Arguments are encoded without formatting, except of types with custom fmt::formatter.
+        template<typename TChar, typename TArg>
+        void PutArg(spdlog::memory_buf_t& buffer, const TArg& arg) {
+            using Arg = std::decay_t<TArg>;
+
+            if constexpr (std::is_convertible_v<const TArg&, std::basic_string_view<TChar>>) {
+                Put(buffer, BinaryLogArg::String);
+                PutString(buffer, std::basic_string_view<TChar>(arg));
+            }
+            else if constexpr (std::is_same_v<Arg, bool>) {
+                Put(buffer, BinaryLogArg::Bool);
+                Put(buffer, static_cast<uint8_t>(arg));
+            }
+            else if constexpr (std::is_same_v<Arg, char> || std::is_same_v<Arg, TChar>) {
+                Put(buffer, BinaryLogArg::Char);
+                Put(buffer, static_cast<uint32_t>(arg));
+            }
+            else if constexpr (std::is_integral_v<Arg> && std::is_signed_v<Arg>) {
+                Put(buffer, BinaryLogArg::Int);
+                Put(buffer, static_cast<int64_t>(arg));
+            }
+            else if constexpr (std::is_integral_v<Arg>) {
+                Put(buffer, BinaryLogArg::UInt);
+                Put(buffer, static_cast<uint64_t>(arg));
+            }
+            else if constexpr (std::is_same_v<Arg, float>) {
+                Put(buffer, BinaryLogArg::Float);
+                Put(buffer, arg);
+            }
+            else if constexpr (std::is_floating_point_v<Arg>) {
+                Put(buffer, BinaryLogArg::Double); // long double loses precision here
+                Put(buffer, static_cast<double>(arg));
+            }
+            else if constexpr (std::is_null_pointer_v<Arg> || std::is_same_v<Arg, void*> || std::is_same_v<Arg, const void*>) {
+                Put(buffer, BinaryLogArg::Pointer);
+                Put(buffer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(static_cast<const void*>(arg))));
+            }
+            else {
+                static constexpr TChar defaultFormat[] = { '{', '}' };
+                fmt::basic_memory_buffer<TChar> text;
+                fmt::vformat_to(std::back_inserter(text), fmt::basic_string_view<TChar>(defaultFormat, 2), fmt::make_format_args<fmt::buffer_context<TChar>>(arg));
+
+                Put(buffer, BinaryLogArg::String);
+                PutString(buffer, std::basic_string_view<TChar>(text.data(), text.size()));
+            }
+        }
+    }
+
+    // Writes log calls as call site id + raw argument bytes, the text is rendered offline (BinaryLogReader,
+    // DefaultLoggers::DecodeBinaryLog). Call site (logger, level, source location, format string) is written
+    // once per session (and per file segment), on its first message. Entries go through the SharedFileWriter buffer and flush policy.
+    class LOGGER_API BinaryLogWriter {
+    public:
+        static constexpr std::string_view magic{ "LGBINLOG" };
+        static constexpr uint16_t version = 1;
+
+        BinaryLogWriter(std::shared_ptr<SharedFileWriter> fileWriter, spdlog::level::level_enum flushLevel, bool disableEOLforRawLogger = false);
+        ~BinaryLogWriter();
+
+        BinaryLogWriter(const BinaryLogWriter&) = delete;
+        BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+        template<typename T, typename... TArgs>
+        void Write(
+            const spdlog::logger& logger,
+            const spdlog::source_loc& location,
+            spdlog::level::level_enum level,
+            fmt::basic_string_view<T> format,
+            BinaryLogClassName className,
+            const TArgs&... args
+        ) {
+            auto& argsBuffer = ThreadArgsBuffer();
+            argsBuffer.clear();
+            (binary_log::PutArg<T>(argsBuffer, args), ...);
+
+            CallSite callSite;
+            callSite.format = std::string_view(reinterpret_cast<const char*>(format.data()), format.size() * sizeof(T));
+            callSite.key = CallSiteKey{ &logger, std::hash<std::string_view>{}(callSite.format), location.filename, location.line, level };
+            callSite.loggerName = logger.name();
+            callSite.location = location;
+            callSite.charSize = sizeof(T);
+
+            this->WriteMessage(callSite, className, argsBuffer);
+        }
+
+        const std::shared_ptr<SharedFileWriter>& GetFileWriter() const;
+
+    private:
+        struct CallSiteKey {
+            const void* logger;
+            size_t formatHash; // of the text, not the pointer: fmt::runtime buffers are reused or new on every call (text is compared too)
+            const char* filename;
+            int line;
+            spdlog::level::level_enum level;
+
+            bool operator==(const CallSiteKey&) const = default;
+        };
+
+        struct CallSiteKeyHash {
+            size_t operator()(const CallSiteKey& key) const;
+        };
+
+        struct CallSite {
+            CallSiteKey key;
+            std::string_view loggerName;
+            spdlog::source_loc location;
+            std::string_view format; // raw bytes
+            uint8_t charSize;
+        };
+
+        static spdlog::memory_buf_t& ThreadArgsBuffer();
+
+        void PutSessionStart(spdlog::memory_buf_t& buffer, bool fileHeader) const;
+        void WriteMessage(const CallSite& callSite, BinaryLogClassName className, const spdlog::memory_buf_t& args);
+
+        const std::shared_ptr<SharedFileWriter> fileWriter;
+        const spdlog::level::level_enum flushLevel;
+        const bool disableEOLforRawLogger;
+
+        struct CallSiteEntry {
+            uint32_t id;
+            std::string format;
+        };
+
+        std::unordered_map<CallSiteKey, CallSiteEntry, CallSiteKeyHash> callSites; // used under fileWriter lock
+        uint32_t nextCallSiteId = 0;
+    };
+
+
+    struct BinaryLogSession {
+        spdlog::log_clock::time_point time;
+        bool disableEOLforRawLogger = false;
+    };
+
+    struct BinaryLogCallSite {
+        std::string loggerName;
+        spdlog::level::level_enum level = spdlog::level::off;
+        std::string filename;
+        int line = 0;
+        std::string funcname;
+        bool wideFormat = false;
+        std::string format;   // if !wideFormat
+        std::wstring wformat; // if wideFormat
+
+        spdlog::source_loc Location() const;
+    };
+
+    struct BinaryLogMessage {
+        const BinaryLogCallSite* callSite = nullptr;
+        spdlog::log_clock::time_point time;
+        size_t threadId = 0;
+        BinaryLogClassContext classContext = BinaryLogClassContext::None;
+        std::wstring className;
+        std::string payload; // formatted and converted like spdlog::logger does for sync logging
+    };
+
+    class LOGGER_API BinaryLogReader {
+    public:
+        // Reads one file or segment (".lz" is decompressed). Entry cut off at the end of file (process died
+        // before the buffer was flushed) ends reading silently, malformed file throws spdlog::spdlog_ex.
+        static void Read(
+            const std::filesystem::path& binaryLogPath,
+            const std::function<void(const BinaryLogSession&)>& onSession,
+            const std::function<void(const BinaryLogMessage&)>& onMessage
+        );
+
+        // Size up to the end of the last entry which can be read, the rest is cut off or malformed
+        // (0 if the header is cut off). Throws spdlog::spdlog_ex on unknown file format or version.
+        static uintmax_t CompleteSize(const std::filesystem::path& binaryLogPath);
+    };
+}
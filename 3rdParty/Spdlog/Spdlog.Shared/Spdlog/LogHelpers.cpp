@@ -1,12 +1,14 @@
 #include "LogHelpers.h"
 //#pragma message(PREPROCESSOR_MSG("Build LogHelpers.cpp with LOGGER_API = '" PP_STRINGIFY(LOGGER_API) "'"))
 //#pragma message(PREPROCESSOR_MSG("Build LogHelpers.cpp with LOGGER_NS = '" PP_STRINGIFY(LOGGER_NS) "'"))
-#include <Helpers/FileSystem_inline.h>
 #include <Helpers/PackageProvider.h> // need link with Helpers.lib
 #include <Helpers/TokenSingleton.hpp>
 #include <Helpers/Macros.h>
 #include <Helpers/Helpers.h>
 #include <ComAPI/ComAPI.h>
+#include <exception>
+#include <cstdlib>
+#include <mutex>
 #include <set>
 
 
@@ -68,8 +70,10 @@ namespace LOGGER_NS {
 
             if (prefixCallback) {
                 std::wstring prefix = std::wstring(padinfo_.width_, ' ') + prefixCallback();
-                auto prefixUtf8 = H::WStrToStr(prefix, CP_UTF8);
-                dest.append(prefixUtf8.data(), prefixUtf8.data() + prefixUtf8.size());
+                if (!prefix.empty()) { // no class context - nothing to convert
+                    auto prefixUtf8 = H::WStrToStr(prefix, CP_UTF8);
+                    dest.append(prefixUtf8.data(), prefixUtf8.data() + prefixUtf8.size());
+                }
             }
             if (postfixCallback) {
                 postfixCallback(std::string{ logMsg.payload.begin(), logMsg.payload.end() });
@@ -183,13 +187,19 @@ namespace LOGGER_NS {
 
 
 
+    // zero initialized = spdlog::level::trace, everything passes until SetLoggingMode / SetCategoryLevel
+    std::array<std::array<std::atomic<spdlog::level::level_enum>, static_cast<size_t>(LogCategory::Count)>, DefaultLoggers::maxLoggers> DefaultLoggers::enabledLevels;
+
+
 	DefaultLoggers::DefaultLoggers()
 		: initializedLoggersById{}
+		, asyncWriter{ std::make_unique<AsyncLogWriter>(&DefaultLoggers::DispatchAsyncRecord) }
 	{
-		this->prefixCallback = [this] {
-			return this->className;
+		this->prefixCallback = [] {
+			return DefaultLoggers::CurrentMessageContext().className;
 			};
 		this->postfixCallback = [this](const std::string& logMsg) {
+			std::unique_lock lk{ this->mxLastMessage };
 			this->lastMessage = logMsg;
 			};
 
@@ -226,10 +236,49 @@ namespace LOGGER_NS {
 	}
 
     DefaultLoggers::~DefaultLoggers() {
+        this->asyncWriter->Stop(); // write staged messages while sinks are alive
         this->standardLoggersList = {}; // clear loggers to release sinks
     }
 
 
+    namespace {
+        // InitFlags::CrashFlushHandlers: buffered lines (file flush policy) are written before the process dies. Previous handlers are chained,
+        // so the app's own crash reporter still runs.
+        std::terminate_handler prevTerminateHandler = nullptr;
+
+        [[noreturn]] void FlushOnTerminate() {
+            DefaultLoggers::FlushOnCrash();
+
+            if (prevTerminateHandler) {
+                prevTerminateHandler();
+            }
+            std::abort();
+        }
+
+#if COMPILE_FOR_DESKTOP && defined(_WIN32)
+        LPTOP_LEVEL_EXCEPTION_FILTER prevUnhandledExceptionFilter = nullptr;
+
+        LONG WINAPI FlushOnUnhandledException(EXCEPTION_POINTERS* exceptionPtrs) {
+            DefaultLoggers::FlushOnCrash();
+
+            return prevUnhandledExceptionFilter
+                ? prevUnhandledExceptionFilter(exceptionPtrs)
+                : EXCEPTION_CONTINUE_SEARCH;
+        }
+#endif
+
+        void InstallCrashFlushHandlers() {
+            static std::once_flag installed;
+            std::call_once(installed, [] {
+                prevTerminateHandler = std::set_terminate(&FlushOnTerminate);
+#if COMPILE_FOR_DESKTOP && defined(_WIN32)
+                prevUnhandledExceptionFilter = SetUnhandledExceptionFilter(&FlushOnUnhandledException);
+#endif
+                });
+        }
+    }
+
+
     void DefaultLoggers::Init(
         std::filesystem::path logFilePath,
         H::Flags<InitFlags> initFlags,
@@ -262,6 +311,11 @@ namespace LOGGER_NS {
             }
         }
 
+        const bool binaryLogging = initFlags.Has(InitFlags::BinaryLogging);
+        if (binaryLogging) {
+            logFilePath.replace_extension(binaryLogExtension);
+        }
+
         if (initializedLoggersByPath.count(logFilePath) > 0) {
 			DefaultLoggers::TimeLogger(loggerId)->warn("the logger on this path has already been initialized");
             return;
@@ -274,15 +328,6 @@ namespace LOGGER_NS {
             initFlags &= ~InitFlags::AppendNewSessionMsg; // don't append new session message at first created log file
             std::filesystem::create_directories(logFilePath.parent_path());
         }
-        else {
-            auto logSize = std::filesystem::file_size(logFilePath);
-            if (!initFlags.Has(InitFlags::Truncate) && logSize > maxSizeLogFile) {
-                auto truncatedBytes = logSize - maxSizeLogFile / 2;
-                H::FS::RemoveBytesFromStart(logFilePath, truncatedBytes, [](std::ofstream& file) {
-                    file.write(logTruncationMessage.data(), logTruncationMessage.size());
-                    });
-            }
-        }
       
         auto& _this = DefaultLoggers::GetInstance();
         if (_this.initializedLoggersById.count(loggerId) > 0) {
@@ -293,13 +338,32 @@ namespace LOGGER_NS {
 
         _this.standardLoggersList[loggerId].maxSizeLogFile = maxSizeLogFile;
 
-        _this.standardLoggersList[loggerId].fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath, initFlags.Has(InitFlags::Truncate));
+        // all variants write to one file handle through one buffer (flushed by time / size / error level),
+        // the file is rotated in segments, the oldest ones are deleted to keep it within maxSizeLogFile
+        _this.standardLoggersList[loggerId].fileWriter = std::make_shared<SharedFileWriter>(
+            logFilePath,
+            initFlags.Has(InitFlags::Truncate),
+            _this.standardLoggersList[loggerId].fileFlushPolicy,
+            maxSizeLogFile,
+            _this.standardLoggersList[loggerId].fileRotationPolicy
+        );
+        auto& fileWriter = _this.standardLoggersList[loggerId].fileWriter;
+        if (initFlags.Has(InitFlags::CrashFlushHandlers)) {
+            InstallCrashFlushHandlers();
+        }
+
+        // binary mode: messages are encoded by Log(), file sinks are created but not attached to the loggers
+        _this.standardLoggersList[loggerId].binaryWriter = binaryLogging
+            ? std::make_shared<BinaryLogWriter>(fileWriter, _this.standardLoggersList[loggerId].fileFlushPolicy.flushLevel, initFlags.Has(InitFlags::DisableEOLforRawLogger))
+            : nullptr;
+
+        _this.standardLoggersList[loggerId].fileSink = fileWriter->CreateSink();
         auto formatterDefault = std::make_unique<spdlog::pattern_formatter>();
         formatterDefault->add_flag<FunctionNameFormatter>(FunctionNameFormatter::flag).set_pattern(GetPattern(Pattern::Default));
         formatterDefault->add_flag<MsgCallbackFormatter>(MsgCallbackFormatter::flag, _this.prefixCallback).set_pattern(GetPattern(Pattern::Default));
         _this.standardLoggersList[loggerId].fileSink->set_formatter(std::move(formatterDefault));
 
-        _this.standardLoggersList[loggerId].fileSinkRaw = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath, initFlags.Has(InitFlags::Truncate));
+        _this.standardLoggersList[loggerId].fileSinkRaw = fileWriter->CreateSink();
         if (initFlags.Has(InitFlags::DisableEOLforRawLogger)) {
             auto formatterRaw = std::make_unique<spdlog::pattern_formatter>(GetPattern(Pattern::Raw), spdlog::pattern_time_type::local, std::string(""));
             _this.standardLoggersList[loggerId].fileSinkRaw->set_formatter(std::move(formatterRaw));
@@ -308,16 +372,16 @@ namespace LOGGER_NS {
             _this.standardLoggersList[loggerId].fileSinkRaw->set_pattern(GetPattern(Pattern::Raw));
         }
 
-        _this.standardLoggersList[loggerId].fileSinkTime = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath, initFlags.Has(InitFlags::Truncate));
+        _this.standardLoggersList[loggerId].fileSinkTime = fileWriter->CreateSink();
         _this.standardLoggersList[loggerId].fileSinkTime->set_pattern(GetPattern(Pattern::Time));
 
-        _this.standardLoggersList[loggerId].fileSinkFunc = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath, initFlags.Has(InitFlags::Truncate));
+        _this.standardLoggersList[loggerId].fileSinkFunc = fileWriter->CreateSink();
         auto formatterFunc = std::make_unique<spdlog::pattern_formatter>();
         formatterFunc->add_flag<FunctionNameFormatter>(FunctionNameFormatter::flag).set_pattern(GetPattern(Pattern::Func));
         formatterFunc->add_flag<MsgCallbackFormatter>(MsgCallbackFormatter::flag, _this.prefixCallback).set_pattern(GetPattern(Pattern::Func));
         _this.standardLoggersList[loggerId].fileSinkFunc->set_formatter(std::move(formatterFunc));
 
-        _this.standardLoggersList[loggerId].fileSinkExtend = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath, initFlags.Has(InitFlags::Truncate));
+        _this.standardLoggersList[loggerId].fileSinkExtend = fileWriter->CreateSink();
         auto formatterExtend = std::make_unique<spdlog::pattern_formatter>();
         formatterExtend->add_flag<FunctionNameFormatter>(FunctionNameFormatter::flag).set_pattern(GetPattern(Pattern::Extend));
         formatterExtend->add_flag<MsgCallbackFormatter>(MsgCallbackFormatter::flag, _this.prefixCallback, _this.postfixCallback).set_pattern(GetPattern(Pattern::Extend));
@@ -354,11 +418,13 @@ namespace LOGGER_NS {
 		std::vector<spdlog::sink_ptr> extendLoggerSinks;
 
 		// Базовые логгеры (только файл)
-		loggerSinks.push_back(list.fileSink);
-		rawLoggerSinks.push_back(list.fileSinkRaw);
-		timeLoggerSinks.push_back(list.fileSinkTime);
-		funcLoggerSinks.push_back(list.fileSinkFunc);
-		extendLoggerSinks.push_back(list.fileSinkExtend);
+		if (!binaryLogging) {
+			loggerSinks.push_back(list.fileSink);
+			rawLoggerSinks.push_back(list.fileSinkRaw);
+			timeLoggerSinks.push_back(list.fileSinkTime);
+			funcLoggerSinks.push_back(list.fileSinkFunc);
+			extendLoggerSinks.push_back(list.fileSinkExtend);
+		}
 
 		// Добавляем stdout (если включено)
 		if (initFlags.Has(InitFlags::EnableLogToStdout)) {
@@ -373,16 +439,27 @@ namespace LOGGER_NS {
 
 
 #ifdef _DEBUG
-		funcLoggerSinks.push_back(_this.debugFnSink); // чтобы LOG_FUNCTION_SCOPE_* летели в Output (паттерн DebugFn)
-		extendLoggerSinks.push_back(_this.debugSink); // extend тоже в Output
+		// binary mode must not format text: Output sinks are attached only when a debugger shows them
+		const bool attachDebuggerSinks = !binaryLogging || IsDebuggerPresent();
+		if (attachDebuggerSinks) {
+			funcLoggerSinks.push_back(_this.debugFnSink); // чтобы LOG_FUNCTION_SCOPE_* летели в Output (паттерн DebugFn)
+			extendLoggerSinks.push_back(_this.debugSink); // extend тоже в Output
+		}
 
-		std::vector<spdlog::sink_ptr> debugLoggerSinks = { list.fileSink, _this.debugSink };
+		std::vector<spdlog::sink_ptr> debugLoggerSinks;
+		if (!binaryLogging) {
+			debugLoggerSinks.push_back(list.fileSink);
+		}
+		if (attachDebuggerSinks) {
+			debugLoggerSinks.push_back(_this.debugSink);
+		}
 		if (initFlags.Has(InitFlags::EnableLogToStdout)) {
 			debugLoggerSinks.push_back(_this.stdoutDebugColorSink);
 		}
 #endif
 
         std::string nameId = loggerId > 0 ? "_" + std::to_string(loggerId) : "";
+        auto flushLevel = _this.standardLoggersList[loggerId].fileFlushPolicy.flushLevel;
 
 		_this.standardLoggersList[loggerId].logger =
 			std::make_shared<spdlog::logger>(
@@ -390,7 +467,7 @@ namespace LOGGER_NS {
 				loggerSinks.begin(),
 				loggerSinks.end()
 			);
-		_this.standardLoggersList[loggerId].logger->flush_on(spdlog::level::trace);
+		_this.standardLoggersList[loggerId].logger->flush_on(flushLevel);
 
 
 		_this.standardLoggersList[loggerId].rawLogger =
@@ -399,7 +476,7 @@ namespace LOGGER_NS {
 				rawLoggerSinks.begin(),
 				rawLoggerSinks.end()
 			);
-		_this.standardLoggersList[loggerId].rawLogger->flush_on(spdlog::level::trace);
+		_this.standardLoggersList[loggerId].rawLogger->flush_on(flushLevel);
 
 
 		_this.standardLoggersList[loggerId].timeLogger =
@@ -408,7 +485,7 @@ namespace LOGGER_NS {
 				timeLoggerSinks.begin(),
 				timeLoggerSinks.end()
 			);
-		_this.standardLoggersList[loggerId].timeLogger->flush_on(spdlog::level::trace);
+		_this.standardLoggersList[loggerId].timeLogger->flush_on(flushLevel);
 
 
 		_this.standardLoggersList[loggerId].funcLogger =
@@ -417,7 +494,7 @@ namespace LOGGER_NS {
 				funcLoggerSinks.begin(),
 				funcLoggerSinks.end()
 			);
-		_this.standardLoggersList[loggerId].funcLogger->flush_on(spdlog::level::trace);
+		_this.standardLoggersList[loggerId].funcLogger->flush_on(flushLevel);
 
 
 		_this.standardLoggersList[loggerId].extendLogger =
@@ -426,7 +503,7 @@ namespace LOGGER_NS {
 				extendLoggerSinks.begin(),
 				extendLoggerSinks.end()
 			);
-		_this.standardLoggersList[loggerId].extendLogger->flush_on(spdlog::level::trace);
+		_this.standardLoggersList[loggerId].extendLogger->flush_on(flushLevel);
 
 
 #ifdef _DEBUG
@@ -436,22 +513,32 @@ namespace LOGGER_NS {
 				debugLoggerSinks.begin(),
 				debugLoggerSinks.end()
 			);
-		_this.standardLoggersList[loggerId].debugLogger->flush_on(spdlog::level::trace);
+		_this.standardLoggersList[loggerId].debugLogger->flush_on(flushLevel);
 #endif
 
         // SetLoggingMode requires pauseLoggingEvent to exist
 		DefaultLoggers::SetLoggingMode(loggingMode, loggerId);
 
+        if (binaryLogging) {
+            _this.binaryLogging = true;
+        }
+
+        if (initFlags.Has(InitFlags::AsyncLogging)) {
+            DefaultLoggers::StartAsyncLogging();
+        }
+
         if (initFlags.Has(InitFlags::AppendNewSessionMsg)) {
             std::string rawEOL = "";
             if (initFlags.Has(InitFlags::DisableEOLforRawLogger)) {
                 rawEOL = "\n";
             }
-            // whitespaces are selected by design
-            _this.standardLoggersList[loggerId].rawLogger->debug("\n" + rawEOL);
-            _this.standardLoggersList[loggerId].rawLogger->debug("==========================================================================================================" + rawEOL);
-            _this.standardLoggersList[loggerId].timeLogger->debug("                       New session started");
-            _this.standardLoggersList[loggerId].rawLogger->debug("==========================================================================================================" + rawEOL);
+            // whitespaces are selected by design (through Log() to get into binary log too)
+            auto& rawLogger = _this.standardLoggersList[loggerId].rawLogger;
+            auto& timeLogger = _this.standardLoggersList[loggerId].timeLogger;
+            DefaultLoggers::Log<char>(nullctx, rawLogger, spdlog::source_loc{}, spdlog::level::debug, "{}", "\n" + rawEOL);
+            DefaultLoggers::Log<char>(nullctx, rawLogger, spdlog::source_loc{}, spdlog::level::debug, "{}", "==========================================================================================================" + rawEOL);
+            DefaultLoggers::Log<char>(nullctx, timeLogger, spdlog::source_loc{}, spdlog::level::debug, "{}", "                       New session started");
+            DefaultLoggers::Log<char>(nullctx, rawLogger, spdlog::source_loc{}, spdlog::level::debug, "{}", "==========================================================================================================" + rawEOL);
         }
     }
 
@@ -462,11 +549,151 @@ namespace LOGGER_NS {
 
 
     std::string DefaultLoggers::GetLastMessage() {
-        std::unique_lock lk{ DefaultLoggers::GetInstance().mxCustomFlagHandlers };
+        std::unique_lock lk{ DefaultLoggers::GetInstance().mxLastMessage };
         return DefaultLoggers::GetInstance().lastMessage;
     }
 
 
+    void DefaultLoggers::StartAsyncLogging(const AsyncLoggingOptions& options) {
+        DefaultLoggers::GetInstance().asyncWriter->Start(options);
+    }
+
+    void DefaultLoggers::StopAsyncLogging() {
+        DefaultLoggers::GetInstance().asyncWriter->Stop();
+    }
+
+    void DefaultLoggers::FlushAsyncLogging() {
+        DefaultLoggers::GetInstance().asyncWriter->Flush();
+    }
+
+    bool DefaultLoggers::IsAsyncLogging() {
+        return DefaultLoggers::GetInstance().asyncWriter->IsRunning();
+    }
+
+    AsyncLoggingStats DefaultLoggers::GetAsyncLoggingStats() {
+        return DefaultLoggers::GetInstance().asyncWriter->GetStats();
+    }
+
+
+    void DefaultLoggers::DecodeBinaryLog(const std::filesystem::path& binaryLogPath, const std::filesystem::path& textLogPath) {
+        std::function<std::wstring()> prefixCallback = [] {
+            return DefaultLoggers::CurrentMessageContext().className;
+            };
+
+        auto makeFormatter = [&prefixCallback](Pattern pattern, std::string eol) {
+            auto formatter = std::make_unique<spdlog::pattern_formatter>(spdlog::pattern_time_type::local, std::move(eol));
+            formatter->add_flag<FunctionNameFormatter>(FunctionNameFormatter::flag);
+            formatter->add_flag<MsgCallbackFormatter>(MsgCallbackFormatter::flag, prefixCallback);
+            formatter->set_pattern(GetPattern(pattern));
+            return formatter;
+            };
+
+        // logger names are set in InitForId
+        auto loggerPattern = [](std::string_view loggerName) {
+            if (loggerName.starts_with("raw_logger")) {
+                return Pattern::Raw;
+            }
+            if (loggerName.starts_with("time_logger")) {
+                return Pattern::Time;
+            }
+            if (loggerName.starts_with("func_logger")) {
+                return Pattern::Func;
+            }
+            if (loggerName.starts_with("extend_logger")) {
+                return Pattern::Extend;
+            }
+            return Pattern::Default;
+            };
+
+        std::unordered_map<Pattern, std::unique_ptr<spdlog::formatter>> formatters;
+        for (auto pattern : { Pattern::Default, Pattern::Raw, Pattern::Time, Pattern::Func, Pattern::Extend }) {
+            formatters[pattern] = makeFormatter(pattern, spdlog::details::os::default_eol);
+        }
+
+        spdlog::details::file_helper textFile;
+        textFile.open(textLogPath, true);
+
+        auto& messageContext = DefaultLoggers::CurrentMessageContext();
+        for (auto& segmentPath : SegmentedLogFile::ListSegments(binaryLogPath)) {
+            BinaryLogReader::Read(segmentPath,
+                [&](const BinaryLogSession& session) {
+                    formatters[Pattern::Raw] = makeFormatter(Pattern::Raw, session.disableEOLforRawLogger ? "" : spdlog::details::os::default_eol);
+                },
+                [&](const BinaryLogMessage& message) {
+                    switch (message.classContext) {
+                    case BinaryLogClassContext::Instance:
+                        messageContext.className = L" [" + message.className + L"]";
+                        break;
+                    case BinaryLogClassContext::Null:
+                        messageContext.className = L" [" + message.className + L"(nullptr)]";
+                        break;
+                    default:
+                        messageContext.className.clear();
+                        break;
+                    }
+
+                    spdlog::details::log_msg logMsg(message.time, message.callSite->Location(), message.callSite->loggerName, message.callSite->level, message.payload);
+                    logMsg.thread_id = message.threadId;
+
+                    spdlog::memory_buf_t formatted;
+                    formatters.at(loggerPattern(message.callSite->loggerName))->format(logMsg, formatted);
+                    textFile.write(formatted);
+                });
+        }
+
+        messageContext.className.clear();
+        textFile.flush();
+    }
+
+
+    DefaultLoggers::MessageContext& DefaultLoggers::CurrentMessageContext() {
+        thread_local MessageContext messageContext;
+        return messageContext;
+    }
+
+    void DefaultLoggers::DispatchAsyncRecord(const AsyncLogRecord& record) {
+        CurrentMessageContext().className = record.className;
+
+        spdlog::details::log_msg logMsg(record.time, record.location, record.logger->name(), record.level, record.payload);
+        logMsg.thread_id = record.threadId;
+
+        for (auto& sink : record.logger->sinks()) {
+            if (sink->should_log(logMsg.level)) {
+                try {
+                    sink->log(logMsg);
+                }
+                catch (...) {
+                    // like spdlog::logger, a failed sink doesn't stop the others (and the writer thread)
+                }
+            }
+        }
+    }
+
+
+    DefaultLoggers::BinaryLogger DefaultLoggers::FindBinaryLogger(const spdlog::logger* logger) {
+        for (auto& loggers : this->standardLoggersList) {
+            if (!loggers.binaryWriter) {
+                continue;
+            }
+
+            if (logger == loggers.extendLogger.get()) {
+                return { loggers.binaryWriter.get(), true };
+            }
+            if (logger == loggers.logger.get() ||
+                logger == loggers.rawLogger.get() ||
+                logger == loggers.timeLogger.get() ||
+#ifdef _DEBUG
+                logger == loggers.debugLogger.get() ||
+#endif
+                logger == loggers.funcLogger.get()
+                ) {
+                return { loggers.binaryWriter.get(), false };
+            }
+        }
+        return {};
+    }
+
+
     LoggingMode DefaultLoggers::GetLoggingMode(uint8_t id) {
         auto& _this = DefaultLoggers::GetInstance();
 
@@ -476,6 +703,7 @@ namespace LOGGER_NS {
             return mode;
         }
 
+        std::lock_guard lk{ _this.mxLevels };
         auto& loggers = _this.standardLoggersList[id];
         return loggers.loggingMode;
     }
@@ -491,6 +719,7 @@ namespace LOGGER_NS {
             return;
         }
 
+        std::lock_guard lk{ _this.mxLevels };
         auto& loggers = _this.standardLoggersList[id];
 
         loggers.loggingMode = mode;
@@ -504,6 +733,32 @@ namespace LOGGER_NS {
 		DefaultLoggers::ForEachLogger(id, [logLevel](auto& logger) {
             logger.set_level(logLevel);
         });
+
+        DefaultLoggers::UpdateEnabledLevels(id);
+    }
+
+
+    spdlog::level::level_enum DefaultLoggers::GetCategoryLevel(LogCategory category, uint8_t id) {
+        if (H::TokenSingleton<DefaultLoggers>::IsExpired()) {
+            return spdlog::level::trace;
+        }
+
+        auto& _this = DefaultLoggers::GetInstance();
+        std::lock_guard lk{ _this.mxLevels };
+        return _this.standardLoggersList[id].categoryLevels[static_cast<size_t>(category)];
+    }
+
+
+    void DefaultLoggers::SetCategoryLevel(LogCategory category, spdlog::level::level_enum level, uint8_t id) {
+        if (H::TokenSingleton<DefaultLoggers>::IsExpired()) {
+            return;
+        }
+
+        auto& _this = DefaultLoggers::GetInstance();
+        std::lock_guard lk{ _this.mxLevels };
+
+        _this.standardLoggersList[id].categoryLevels[static_cast<size_t>(category)] = level;
+        DefaultLoggers::UpdateEnabledLevels(id);
     }
 
 
@@ -528,8 +783,35 @@ namespace LOGGER_NS {
 
         auto& loggers = _this.standardLoggersList[id];
 
-        // Will have effect after the next dynamic sink filesize check timeout
+        // Will have effect on the next segment rotation
         loggers.maxSizeLogFile = size;
+        if (loggers.fileWriter) {
+            loggers.fileWriter->SetMaxTotalSize(size);
+        }
+    }
+
+
+    void DefaultLoggers::SetFileFlushPolicy(const FileFlushPolicy& flushPolicy, uint8_t id) {
+        DefaultLoggers::GetInstance().standardLoggersList[id].fileFlushPolicy = flushPolicy;
+    }
+
+
+    void DefaultLoggers::SetFileRotationPolicy(const FileRotationPolicy& rotationPolicy, uint8_t id) {
+        DefaultLoggers::GetInstance().standardLoggersList[id].fileRotationPolicy = rotationPolicy;
+    }
+
+
+    void DefaultLoggers::FlushOnCrash() noexcept {
+        if (H::TokenSingleton<DefaultLoggers>::IsExpired()) {
+            return;
+        }
+
+        // Staged async messages are not written here: errors are sync level and already in the file buffer.
+        for (auto& loggers : DefaultLoggers::GetInstance().standardLoggersList) {
+            if (loggers.fileWriter) {
+                loggers.fileWriter->FlushOnCrash();
+            }
+        }
     }
 
 
@@ -562,6 +844,15 @@ namespace LOGGER_NS {
         }
     }
 
+    void DefaultLoggers::UpdateEnabledLevels(uint8_t id) {
+        auto& loggers = DefaultLoggers::GetInstance().standardLoggersList[id];
+        const auto modeLevel = DefaultLoggers::LoggingModeToSpdlogLevel(loggers.loggingMode);
+
+        for (size_t category = 0; category < loggers.categoryLevels.size(); category++) {
+            DefaultLoggers::enabledLevels[id][category].store((std::max)(loggers.categoryLevels[category], modeLevel), std::memory_order_relaxed);
+        }
+    }
+
     spdlog::level::level_enum DefaultLoggers::LoggingModeToSpdlogLevel(LoggingMode mode) {
         switch (mode) {
         case LoggingMode::Normal:
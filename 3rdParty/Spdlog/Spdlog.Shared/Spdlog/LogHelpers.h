@@ -73,6 +73,9 @@ namespace LOGGER_NS_ALIAS = LOGGER_NS; // set your alias for original "logger na
 #if defined(LOG_FUNCTION_SCOPE_S) || defined(LOG_FUNCTION_SCOPE_C) || defined(LOG_FUNCTION_SCOPE)
 #error LOG_... macros already defined
 #endif
+#if defined(LOG_EVERY_N) || defined(LOG_FIRST_N) || defined(LOG_RATE_LIMITED)
+#error LOG_... macros already defined
+#endif
 
 
 #if !defined(DISABLE_COMMON_LOGGING)
@@ -82,21 +85,59 @@ namespace LOGGER_NS_ALIAS = LOGGER_NS; // set your alias for original "logger na
 
 #define LOG_CTX spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}
 
-#define LOG_RAW(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::RawLogger(), LOG_CTX, spdlog::level::debug, fmt, ##__VA_ARGS__)
-#define LOG_TIME(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::TimeLogger(), LOG_CTX, spdlog::level::debug, fmt, ##__VA_ARGS__)
+// Compile-time minimum level (SPDLOG_LEVEL_XXX), calls below it are removed with their arguments.
+// Define it at global level like DISABLE_..._LOGGING macros.
+#if !defined(LOGGER_ACTIVE_LEVEL)
+#define LOGGER_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
 
-#define LOG_TRACE(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), LOG_CTX, spdlog::level::trace, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), LOG_CTX, spdlog::level::debug, fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), LOG_CTX, spdlog::level::info, fmt, ##__VA_ARGS__)
-#define LOG_WARNING(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), LOG_CTX, spdlog::level::warn, fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), LOG_CTX, spdlog::level::err, fmt, ##__VA_ARGS__)
+#if LOGGER_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define __LG_IF_ACTIVE_TRACE(...) __VA_ARGS__
+#else
+#define __LG_IF_ACTIVE_TRACE(...) (void)0
+#endif
+#if LOGGER_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define __LG_IF_ACTIVE_DEBUG(...) __VA_ARGS__
+#else
+#define __LG_IF_ACTIVE_DEBUG(...) (void)0
+#endif
+#if LOGGER_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define __LG_IF_ACTIVE_INFO(...) __VA_ARGS__
+#else
+#define __LG_IF_ACTIVE_INFO(...) (void)0
+#endif
+#if LOGGER_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define __LG_IF_ACTIVE_WARN(...) __VA_ARGS__
+#else
+#define __LG_IF_ACTIVE_WARN(...) (void)0
+#endif
+#if LOGGER_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define __LG_IF_ACTIVE_ERROR(...) __VA_ARGS__
+#else
+#define __LG_IF_ACTIVE_ERROR(...) (void)0
+#endif
+
+// Runtime filter: the category level is checked before '_This', logger and arguments are evaluated.
+#define __LG_LOG(_This, __LOGGER__, category, level, fmt, ...) \
+    (LOGGER_NS::DefaultLoggers::IsEnabled(LOGGER_NS::LogCategory::category, level) \
+        ? LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, __LOGGER__, LOG_CTX, level, fmt, ##__VA_ARGS__) \
+        : void())
+
+#define LOG_RAW(fmt, ...) __LG_IF_ACTIVE_DEBUG(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::RawLogger(), Raw, spdlog::level::debug, fmt, ##__VA_ARGS__))
+#define LOG_TIME(fmt, ...) __LG_IF_ACTIVE_DEBUG(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::TimeLogger(), Time, spdlog::level::debug, fmt, ##__VA_ARGS__))
+
+#define LOG_TRACE(fmt, ...) __LG_IF_ACTIVE_TRACE(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), Default, spdlog::level::trace, fmt, ##__VA_ARGS__))
+#define LOG_DEBUG(fmt, ...) __LG_IF_ACTIVE_DEBUG(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), Default, spdlog::level::debug, fmt, ##__VA_ARGS__))
+#define LOG_INFO(fmt, ...) __LG_IF_ACTIVE_INFO(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), Default, spdlog::level::info, fmt, ##__VA_ARGS__))
+#define LOG_WARNING(fmt, ...) __LG_IF_ACTIVE_WARN(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), Default, spdlog::level::warn, fmt, ##__VA_ARGS__))
+#define LOG_ERROR(fmt, ...) __LG_IF_ACTIVE_ERROR(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::Logger(), Default, spdlog::level::err, fmt, ##__VA_ARGS__))
 
 // Use it inside static functions or with custom context:
-#define LOG_TRACE_S(_This, fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), LOG_CTX, spdlog::level::trace, fmt, ##__VA_ARGS__)
-#define LOG_DEBUG_S(_This, fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), LOG_CTX, spdlog::level::debug, fmt, ##__VA_ARGS__)
-#define LOG_INFO_S(_This, fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), LOG_CTX, spdlog::level::info, fmt, ##__VA_ARGS__)
-#define LOG_WARNING_S(_This, fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), LOG_CTX, spdlog::level::warn, fmt, ##__VA_ARGS__)
-#define LOG_ERROR_S(_This, fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), LOG_CTX, spdlog::level::err, fmt, ##__VA_ARGS__)
+#define LOG_TRACE_S(_This, fmt, ...) __LG_IF_ACTIVE_TRACE(__LG_LOG(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), Debug, spdlog::level::trace, fmt, ##__VA_ARGS__))
+#define LOG_DEBUG_S(_This, fmt, ...) __LG_IF_ACTIVE_DEBUG(__LG_LOG(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), Debug, spdlog::level::debug, fmt, ##__VA_ARGS__))
+#define LOG_INFO_S(_This, fmt, ...) __LG_IF_ACTIVE_INFO(__LG_LOG(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), Debug, spdlog::level::info, fmt, ##__VA_ARGS__))
+#define LOG_WARNING_S(_This, fmt, ...) __LG_IF_ACTIVE_WARN(__LG_LOG(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), Debug, spdlog::level::warn, fmt, ##__VA_ARGS__))
+#define LOG_ERROR_S(_This, fmt, ...) __LG_IF_ACTIVE_ERROR(__LG_LOG(_This, LOGGER_NS::DefaultLoggers::DebugLogger(), Debug, spdlog::level::err, fmt, ##__VA_ARGS__))
 
 #define LOG_TRACE_D(fmt, ...) LOG_TRACE_S(__LgCtx(), fmt, ##__VA_ARGS__)
 #define LOG_DEBUG_D(fmt, ...) LOG_DEBUG_S(__LgCtx(), fmt, ##__VA_ARGS__)
@@ -105,37 +146,59 @@ namespace LOGGER_NS_ALIAS = LOGGER_NS; // set your alias for original "logger na
 #define LOG_ERROR_D(fmt, ...) LOG_ERROR_S(__LgCtx(), fmt, ##__VA_ARGS__)
 
 // Extend logger save last message
-#define LOG_DEBUG_EX(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::ExtendLogger(), LOG_CTX, spdlog::level::debug, fmt, ##__VA_ARGS__)
-#define LOG_ERROR_EX(fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(__LgCtx(), LOGGER_NS::DefaultLoggers::ExtendLogger(), LOG_CTX, spdlog::level::err, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_EX(fmt, ...) __LG_IF_ACTIVE_DEBUG(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::ExtendLogger(), Extend, spdlog::level::debug, fmt, ##__VA_ARGS__))
+#define LOG_ERROR_EX(fmt, ...) __LG_IF_ACTIVE_ERROR(__LG_LOG(__LgCtx(), LOGGER_NS::DefaultLoggers::ExtendLogger(), Extend, spdlog::level::err, fmt, ##__VA_ARGS__))
 
 
-#define LOG_FUNCTION_ENTER_S(_This, fmt, ...) LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::FuncLogger(), LOG_CTX, spdlog::level::debug, fmt, ##__VA_ARGS__)
+#define LOG_FUNCTION_ENTER_S(_This, fmt, ...) __LG_IF_ACTIVE_DEBUG(__LG_LOG(_This, LOGGER_NS::DefaultLoggers::FuncLogger(), Func, spdlog::level::debug, fmt, ##__VA_ARGS__))
 #define LOG_FUNCTION_ENTER_C(fmt, ...) LOG_FUNCTION_ENTER_S(__LgCtx(), fmt, ##__VA_ARGS__)
 #define LOG_FUNCTION_ENTER(fmt, ...) LOG_FUNCTION_ENTER_S(LOGGER_NS::nullctx, fmt, ##__VA_ARGS__)
 
 
-#define LOG_SCOPED(__LOGGER__, _This, fmt, ...) \
+// Exit message is written only if the enter one was (the level may change while the scope runs).
+// 'category' is LogCategory of the logger, e.g. LOG_SCOPED(LOGGER_NS::DefaultLoggers::FuncLogger(), Func, this, "Load").
+#define LOG_SCOPED(__LOGGER__, category, _This, fmt, ...) __LG_IF_ACTIVE_DEBUG( \
     auto __fnCtx = LOG_CTX; \
-    LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, __LOGGER__, __fnCtx, spdlog::level::debug, fmt, ##__VA_ARGS__); \
+    const bool __fnLogEnabled = LOGGER_NS::DefaultLoggers::IsEnabled(LOGGER_NS::LogCategory::category, spdlog::level::debug); \
+    if (__fnLogEnabled) { \
+        LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, __LOGGER__, __fnCtx, spdlog::level::debug, fmt, ##__VA_ARGS__); \
+    } \
     \
     auto __functionFinishLogScoped = HELPERS_NS::MakeScope([&] { \
-        LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, __LOGGER__, __fnCtx, spdlog::level::debug, EXPAND_1_VA_ARGS_(JOIN_STRING("<= ", fmt), ##__VA_ARGS__));  \
-        });
+        if (__fnLogEnabled) { \
+            LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, __LOGGER__, __fnCtx, spdlog::level::debug, EXPAND_1_VA_ARGS_(JOIN_STRING("<= ", fmt), ##__VA_ARGS__));  \
+        } \
+        }))
 
 
-#define LOG_DEBUG_SCOPE_D(fmt, ...)  LOG_SCOPED(LOGGER_NS::DefaultLoggers::DebugLogger(), __LgCtx(), fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_SCOPE_D(fmt, ...)  LOG_SCOPED(LOGGER_NS::DefaultLoggers::DebugLogger(), Debug, __LgCtx(), fmt, ##__VA_ARGS__)
 
 
-#define LOG_FUNCTION_SCOPE_S(_This, fmt, ...) \
+#define LOG_FUNCTION_SCOPE_S(_This, fmt, ...) __LG_IF_ACTIVE_DEBUG( \
     auto __fnCtx = LOG_CTX; \
-	LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::FuncLogger(), __fnCtx, spdlog::level::debug, fmt, ##__VA_ARGS__); \
+    const bool __fnLogEnabled = LOGGER_NS::DefaultLoggers::IsEnabled(LOGGER_NS::LogCategory::Func, spdlog::level::debug); \
+    if (__fnLogEnabled) { \
+	    LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::FuncLogger(), __fnCtx, spdlog::level::debug, fmt, ##__VA_ARGS__); \
+    } \
     \
 	auto __functionFinishLogScoped = HELPERS_NS::MakeScope([&] { \
-		LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::FuncLogger(), __fnCtx, spdlog::level::debug, JOIN_STRING("<= ", fmt), ##__VA_ARGS__); \
-		});
+        if (__fnLogEnabled) { \
+		    LOGGER_NS::DefaultLoggers::Log<typename decltype(HELPERS_NS::StringDeductor(fmt))::type>(_This, LOGGER_NS::DefaultLoggers::FuncLogger(), __fnCtx, spdlog::level::debug, JOIN_STRING("<= ", fmt), ##__VA_ARGS__); \
+        } \
+		}))
 
 #define LOG_FUNCTION_SCOPE_C(fmt, ...) LOG_FUNCTION_SCOPE_S(__LgCtx(), fmt, ##__VA_ARGS__)
 #define LOG_FUNCTION_SCOPE(fmt, ...) LOG_FUNCTION_SCOPE_S(LOGGER_NS::nullctx, fmt, ##__VA_ARGS__)
+
+
+// Sampling for hot loops, 'logCall' is any LOG_XXX call: LOG_EVERY_N(100, LOG_DEBUG_D("frame {}", frameIdx));
+// The counters are per call site and shared by all threads.
+#define LOG_EVERY_N(n, logCall) \
+    do { static LOGGER_NS::LogEveryN __lgSampler{ n }; if (__lgSampler.Pass()) { logCall; } } while (false)
+#define LOG_FIRST_N(n, logCall) \
+    do { static LOGGER_NS::LogFirstN __lgSampler{ n }; if (__lgSampler.Pass()) { logCall; } } while (false)
+#define LOG_RATE_LIMITED(perSecond, logCall) \
+    do { static LOGGER_NS::LogRateLimiter __lgSampler{ perSecond }; if (__lgSampler.Pass()) { logCall; } } while (false)
 #else
 #define LOG_CTX
 #define LOG_RAW(fmt, ...)
@@ -166,6 +229,10 @@ namespace LOGGER_NS_ALIAS = LOGGER_NS; // set your alias for original "logger na
 #define LOG_FUNCTION_SCOPE_S(_This, fmt, ...)
 #define LOG_FUNCTION_SCOPE_C(fmt, ...)
 #define LOG_FUNCTION_SCOPE(fmt, ...)
+
+#define LOG_EVERY_N(n, logCall)
+#define LOG_FIRST_N(n, logCall)
+#define LOG_RATE_LIMITED(perSecond, logCall)
 #endif // !defined(DISABLE_COMMON_LOGGING)
 
 
@@ -219,6 +286,10 @@ namespace LOGGER_NS_ALIAS = LOGGER_NS; // set your alias for original "logger na
 #include "Helpers/Flags.h"
 
 #include "CustomTypeSpecialization.h"
+#include "AsyncLogWriter.h"
+#include "LogSampling.h"
+#include "SharedFileSink.h"
+#include "BinaryLog.h"
 //#pragma message("include 'LogHelpers.h' [helpers files included]")
 
 #include <unordered_map>
@@ -249,6 +320,17 @@ namespace LOGGER_NS {
     // define a "__classFullnameLogging" "member checker" class
     define_has_member(__ClassFullnameLogging);
    
+    // Loggers of LOG_XXX macros, each has its own runtime level (DefaultLoggers::SetCategoryLevel).
+    enum class LogCategory : uint8_t {
+        Default, // LOG_TRACE ... LOG_ERROR
+        Raw,     // LOG_RAW
+        Time,    // LOG_TIME
+        Func,    // LOG_FUNCTION_ENTER_XXX, LOG_FUNCTION_SCOPE_XXX
+        Debug,   // LOG_XXX_S, LOG_XXX_D, LOG_DEBUG_SCOPE_D
+        Extend,  // LOG_XXX_EX
+        Count
+    };
+
     enum class LoggingMode : uint8_t {
         // Log `info`, `warn`, `err`, `critical`.
         // Ignore only `trace` and `debug` messages.
@@ -263,6 +345,9 @@ namespace LOGGER_NS {
         uintmax_t maxSizeLogFile = defaultLogSize;
 
         LoggingMode loggingMode = LoggingMode::Verbose;
+        std::array<spdlog::level::level_enum, static_cast<size_t>(LogCategory::Count)> categoryLevels{}; // trace
+        FileFlushPolicy fileFlushPolicy;
+        FileRotationPolicy fileRotationPolicy;
 
         std::shared_ptr<spdlog::logger> logger;
         std::shared_ptr<spdlog::logger> rawLogger;
@@ -273,11 +358,14 @@ namespace LOGGER_NS {
         std::shared_ptr<spdlog::logger> debugLogger;
 #endif
 
-        std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSink;
-        std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSinkRaw;
-        std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSinkTime;
-        std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSinkFunc;
-        std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSinkExtend;
+        // formatter variants of one buffered file (not created in binary mode)
+        std::shared_ptr<SharedFileWriter> fileWriter;
+        std::shared_ptr<BinaryLogWriter> binaryWriter; // InitFlags::BinaryLogging
+        std::shared_ptr<SharedFileSink> fileSink;
+        std::shared_ptr<SharedFileSink> fileSinkRaw;
+        std::shared_ptr<SharedFileSink> fileSinkTime;
+        std::shared_ptr<SharedFileSink> fileSinkFunc;
+        std::shared_ptr<SharedFileSink> fileSinkExtend;
     };
 
 
@@ -290,6 +378,11 @@ namespace LOGGER_NS {
         RedirectRawTimeLogToStdout = 0x10,
         DisableEOLforRawLogger = 0x20, // not append '\n' at the end of line
         CreateInExeFolderForDesktop = 0x40,
+        AsyncLogging = 0x80, // StartAsyncLogging() with default options
+        BinaryLogging = 0x100, // write the log file unformatted to "<name>.binlog", render it with DecodeBinaryLog()
+        // Install std::terminate and unhandled SEH exception handlers (chained to the previous ones) which call FlushOnCrash().
+        // With MSVC set_terminate is per-thread, terminate on other threads is not handled.
+        CrashFlushHandlers = 0x200,
 
         DefaultFlags = AppendNewSessionMsg,
         CreateInAppFolder = CreateInPackageFolder | CreateInExeFolderForDesktop
@@ -306,9 +399,10 @@ namespace LOGGER_NS {
 
         struct UnscopedData;
 
-        static constexpr std::chrono::milliseconds logSizeCheckInterval{30'000};
         static constexpr size_t maxLoggers = 2;
 
+        static constexpr std::wstring_view binaryLogExtension{ L".binlog" };
+
         static void Init(
             std::filesystem::path logFilePath,
             HELPERS_NS::Flags<InitFlags> initFlags = InitFlags::DefaultFlags,
@@ -330,9 +424,26 @@ namespace LOGGER_NS {
         static LoggingMode GetLoggingMode(uint8_t id = 0);
         static void SetLoggingMode(LoggingMode mode, uint8_t id = 0);
 
+        // LOG_XXX macros drop messages below max(category level, logging mode level) before evaluating
+        // the arguments, the check is one relaxed atomic load.
+        static bool IsEnabled(LogCategory category, spdlog::level::level_enum level, uint8_t id = 0) {
+            return level >= enabledLevels[id][static_cast<size_t>(category)].load(std::memory_order_relaxed);
+        }
+        static spdlog::level::level_enum GetCategoryLevel(LogCategory category, uint8_t id = 0);
+        static void SetCategoryLevel(LogCategory category, spdlog::level::level_enum level, uint8_t id = 0);
+
+        // Total size of the log file segments, the oldest segment is deleted when it's exceeded.
         static uintmax_t GetMaxLogFileSize(uint8_t id = 0);
         static void SetMaxLogFileSize(uintmax_t size, uint8_t id = 0);
 
+        // Takes effect on the next InitForId(id).
+        static void SetFileFlushPolicy(const FileFlushPolicy& flushPolicy, uint8_t id = 0);
+        static void SetFileRotationPolicy(const FileRotationPolicy& rotationPolicy, uint8_t id = 0);
+
+        // Writes buffered lines of all log files. Called by H::CrashHandler and by handlers of InitFlags::CrashFlushHandlers,
+        // call it from your own crash handler otherwise.
+        static void FlushOnCrash() noexcept;
+
         static std::shared_ptr<spdlog::logger> Logger(uint8_t id = 0);
         static std::shared_ptr<spdlog::logger> RawLogger(uint8_t id = 0);
         static std::shared_ptr<spdlog::logger> TimeLogger(uint8_t id = 0);
@@ -340,6 +451,17 @@ namespace LOGGER_NS {
         static std::shared_ptr<spdlog::logger> DebugLogger(uint8_t id = 0);
         static std::shared_ptr<spdlog::logger> ExtendLogger(uint8_t id = 0);
 
+        // Async mode: Log() formats the message on the caller thread and stages it in a per-thread buffer,
+        // the background writer passes it to sinks. Messages >= options.syncLevel still wait until written.
+        static void StartAsyncLogging(const AsyncLoggingOptions& options = {});
+        static void StopAsyncLogging(); // writes staged messages, call it before unloading the dll
+        static void FlushAsyncLogging();
+        static bool IsAsyncLogging();
+        static AsyncLoggingStats GetAsyncLoggingStats();
+
+        // Renders a binary log file (InitFlags::BinaryLogging) with the same patterns as the text log file.
+        static void DecodeBinaryLog(const std::filesystem::path& binaryLogPath, const std::filesystem::path& textLogPath);
+
 
         // NOTE: overload for std::basic_string_view<T>
         //template<typename T, typename TClass, typename... Args>
@@ -360,22 +482,123 @@ namespace LOGGER_NS {
             fmt::basic_format_string<T, detail::type_identity_t<TArgs>...> format,
             TArgs&&... args
         ) {
+            if (!logger->should_log(level)) {
+                return; // don't build class name for filtered messages
+            }
+
             auto& _this = GetInstance();
-            std::unique_lock lk{ _this.mxCustomFlagHandlers };
+            if (_this.binaryLogging.load(std::memory_order_relaxed)) {
+                if (auto binaryLogger = _this.FindBinaryLogger(logger.get()); binaryLogger.writer) {
+                    WriteBinary<T>(*binaryLogger.writer, classPtr, *logger, location, level, format.get(), args...);
+
+                    if (binaryLogger.keepLastMessage) {
+                        std::string payload;
+                        FormatPayload<T>(payload, format.get(), args...);
+
+                        std::unique_lock lk{ _this.mxLastMessage };
+                        _this.lastMessage = std::move(payload);
+                    }
+                    if (logger->sinks().empty()) {
+                        return; // the binary file is the only output, nothing to format
+                    }
+                }
+            }
 
+            if (_this.asyncWriter->IsRunning()) {
+                AsyncLogRecord record;
+                record.logger = std::move(logger);
+                record.location = location;
+                record.level = level;
+                record.time = spdlog::log_clock::now();
+                record.threadId = spdlog::details::os::thread_id();
+                AssignClassName(record.className, classPtr);
+                FormatPayload<T>(record.payload, format.get(), args...);
+
+                _this.asyncWriter->Push(std::move(record));
+                return;
+            }
+
+            // formatters run on this thread inside logger->log()
+            AssignClassName(CurrentMessageContext().className, classPtr);
+            logger->log(location, level, format, std::forward<TArgs>(args)...);
+        }
+
+    private:
+        // Data of the message being formatted for custom flag formatters, set by the thread which formats it
+        // (caller thread for sync logging, writer thread for async logging).
+        struct MessageContext {
+            std::wstring className;
+        };
+
+        struct BinaryLogger {
+            BinaryLogWriter* writer = nullptr;
+            bool keepLastMessage = false; // extend logger, GetLastMessage() text is formatted anyway
+        };
+
+        static MessageContext& CurrentMessageContext();
+        static void DispatchAsyncRecord(const AsyncLogRecord& record);
+
+        BinaryLogger FindBinaryLogger(const spdlog::logger* logger);
+
+        // Class name is stored as is, the " [Name]" prefix is made by the decoder.
+        template<typename T, typename TClass, typename... TArgs>
+        static void WriteBinary(
+            BinaryLogWriter& writer,
+            TClass* classPtr,
+            const spdlog::logger& logger,
+            const spdlog::source_loc& location,
+            spdlog::level::level_enum level,
+            fmt::basic_string_view<T> format,
+            const TArgs&... args
+        ) {
             if constexpr (has_member(detail::remove_cvref_t<TClass>, __ClassFullnameLogging)) {
-                _this.className = L" ["
+                if (classPtr) {
+                    writer.Write<T>(logger, location, level, format, BinaryLogClassName{ BinaryLogClassContext::Instance, classPtr->GetFullClassNameW() }, args...);
+                }
+                else {
+                    writer.Write<T>(logger, location, level, format, BinaryLogClassName{ BinaryLogClassContext::Null, TClass::GetOriginalClassName() }, args...);
+                }
+            }
+            else {
+                writer.Write<T>(logger, location, level, format, BinaryLogClassName{}, args...);
+            }
+        }
+
+        template<typename TClass>
+        static void AssignClassName(std::wstring& className, TClass* classPtr) {
+            if constexpr (has_member(detail::remove_cvref_t<TClass>, __ClassFullnameLogging)) {
+                className = L" ["
                     + (classPtr ? classPtr->GetFullClassNameW() : TClass::GetOriginalClassName() + L"(nullptr)")
                     + L"]";
             }
             else {
-                _this.className = L"";
+                className.clear();
             }
-            logger->log(location, level, format, std::forward<TArgs>(args)...);
         }
 
-    private:
+        // Same conversion as spdlog::logger::log_ does for sync logging.
+        template<typename T, typename... TArgs>
+        static void FormatPayload(std::string& payload, fmt::basic_string_view<T> format, TArgs&... args) {
+            spdlog::memory_buf_t buf;
+
+            if constexpr (std::is_same_v<T, wchar_t>) {
+                spdlog::wmemory_buf_t wbuf;
+                fmt::vformat_to(std::back_inserter(wbuf), format, fmt::make_format_args<fmt::wformat_context>(args...));
+#if defined(SPDLOG_WCHAR_TO_UTF8_SUPPORT)
+                spdlog::details::os::wstr_to_utf8buf(spdlog::wstring_view_t(wbuf.data(), wbuf.size()), buf);
+#else
+                spdlog::details::os::wstr_to_ansi_buf(spdlog::wstring_view_t(wbuf.data(), wbuf.size()), buf);
+#endif
+            }
+            else {
+                fmt::vformat_to(fmt::appender(buf), format, fmt::make_format_args(args...));
+            }
+
+            payload.assign(buf.data(), buf.size());
+        }
+
         static void ForEachLogger(uint8_t id, const std::function<void(spdlog::logger&)>& action);
+        static void UpdateEnabledLevels(uint8_t id); // under mxLevels
         
         static spdlog::level::level_enum LoggingModeToSpdlogLevel(LoggingMode mode);
         static LoggingMode SpdlogLevelToLoggingMode(spdlog::level::level_enum mode);
@@ -390,15 +613,19 @@ namespace LOGGER_NS {
 
         std::array<StandardLoggers, maxLoggers> standardLoggersList;
 
-        std::mutex mxCustomFlagHandlers;
+        // max(category level, logging mode level) per logger id, static to be checked without GetInstance()
+        static std::array<std::array<std::atomic<spdlog::level::level_enum>, static_cast<size_t>(LogCategory::Count)>, maxLoggers> enabledLevels;
+        std::mutex mxLevels; // concurrent SetLoggingMode / SetCategoryLevel must not store stale max() to enabledLevels
+
+        std::unique_ptr<AsyncLogWriter> asyncWriter;
+        std::atomic<bool> binaryLogging = false; // some logger id writes binary log
+
+        std::mutex mxLastMessage;
         std::string lastMessage; // spdlog converts all msg to char
-        std::wstring className;
         std::function<std::wstring()> prefixCallback = nullptr;
         std::function<void(const std::string&)> postfixCallback = nullptr;
 
         std::shared_ptr<int> token = std::make_shared<int>();
-
-        static constexpr std::string_view logTruncationMessage{"... [truncated] \n\n"};
     };
 
     constexpr HELPERS_NS::meta::nothing* nullctx = nullptr; // used to pass null ctx for logger explicilty
@@ -0,0 +1,84 @@
+#pragma once
+// Include it through "LogHelpers.h" (needs LOGGER_NS).
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+namespace LOGGER_NS {
+    // Call site state of LOG_EVERY_N / LOG_FIRST_N / LOG_RATE_LIMITED (function local static, constant initialized).
+
+    // Passes the 1st, (n+1)th, (2n+1)th ... call.
+    class LogEveryN {
+    public:
+        explicit constexpr LogEveryN(uint64_t n)
+            : n{ n ? n : 1 }
+        {
+        }
+
+        bool Pass() {
+            return this->counter.fetch_add(1, std::memory_order_relaxed) % this->n == 0;
+        }
+
+    private:
+        const uint64_t n;
+        std::atomic<uint64_t> counter{ 0 };
+    };
+
+    // Passes the first n calls, afterwards costs one relaxed load.
+    class LogFirstN {
+    public:
+        explicit constexpr LogFirstN(uint64_t n)
+            : n{ n }
+        {
+        }
+
+        bool Pass() {
+            return this->counter.load(std::memory_order_relaxed) < this->n
+                && this->counter.fetch_add(1, std::memory_order_relaxed) < this->n;
+        }
+
+    private:
+        const uint64_t n;
+        std::atomic<uint64_t> counter{ 0 };
+    };
+
+    // Passes at most perSecond calls per steady clock second.
+    class LogRateLimiter {
+    public:
+        explicit constexpr LogRateLimiter(uint32_t perSecond)
+            : perSecond{ (std::min)(static_cast<uint64_t>(perSecond), countMask) }
+        {
+        }
+
+        bool Pass() {
+            const uint64_t second = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+            const uint64_t secondState = second << countBits;
+
+            uint64_t state = this->state.load(std::memory_order_relaxed);
+            while (true) {
+                uint64_t nextState;
+                if ((state & ~countMask) != secondState) {
+                    nextState = secondState | 1; // new second, the first call
+                }
+                else if ((state & countMask) >= this->perSecond) {
+                    return false;
+                }
+                else {
+                    nextState = state + 1;
+                }
+
+                if (this->state.compare_exchange_weak(state, nextState, std::memory_order_relaxed)) {
+                    return nextState <= (secondState | this->perSecond);
+                }
+            }
+        }
+
+    private:
+        static constexpr int countBits = 24;
+        static constexpr uint64_t countMask = (uint64_t{ 1 } << countBits) - 1;
+
+        const uint64_t perSecond;
+        std::atomic<uint64_t> state{ 0 }; // second << countBits | calls passed in this second
+    };
+}
@@ -0,0 +1,544 @@
+#include "LogHelpers.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+
+namespace LOGGER_NS {
+    namespace {
+        constexpr std::string_view compressedExtension{ ".lz" };
+
+        void AppendIndexLine(std::string& index, uint64_t seq, const std::filesystem::path& segmentPath) {
+            auto name = segmentPath.filename().u8string();
+            index += std::to_string(seq);
+            index += ' ';
+            index.append(reinterpret_cast<const char*>(name.data()), name.size());
+            index += '\n';
+        }
+
+        // "<stem>.<digits><ext>" or "<stem>.<digits><ext>.lz", returns 0 if 'name' is not a segment of the file.
+        uint64_t ParseSegmentSeq(const std::filesystem::path::string_type& name, const std::filesystem::path::string_type& stem, const std::filesystem::path::string_type& ext) {
+            using string_view_type = std::basic_string_view<std::filesystem::path::value_type>;
+            string_view_type rest{ name };
+
+            if (rest.size() <= stem.size() + 1 || rest.substr(0, stem.size()) != stem || rest[stem.size()] != '.') {
+                return 0;
+            }
+            rest.remove_prefix(stem.size() + 1);
+
+            size_t digits = 0;
+            uint64_t seq = 0;
+            while (digits < rest.size() && digits < 19 && rest[digits] >= '0' && rest[digits] <= '9') {
+                seq = seq * 10 + static_cast<uint64_t>(rest[digits] - '0');
+                digits++;
+            }
+            if (digits == 0) {
+                return 0;
+            }
+            rest.remove_prefix(digits);
+
+            if (rest.substr(0, ext.size()) != ext) {
+                return 0;
+            }
+            rest.remove_prefix(ext.size());
+
+            if (rest.empty()) {
+                return seq;
+            }
+            if (rest.size() == compressedExtension.size() && std::equal(rest.begin(), rest.end(), compressedExtension.begin())) {
+                return seq;
+            }
+            return 0;
+        }
+
+        bool IsCompressed(const std::filesystem::path& segmentPath) {
+            return segmentPath.extension() == compressedExtension;
+        }
+
+        std::string ReadFile(const std::filesystem::path& filePath) {
+            std::ifstream file(filePath, std::ios::binary);
+            if (!file) {
+                spdlog::throw_spdlog_ex("segmented log: can't open " + filePath.filename().string());
+            }
+            return std::string{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        }
+
+        bool WriteFile(const std::filesystem::path& filePath, std::string_view data) {
+            std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), data.size());
+            return static_cast<bool>(file);
+        }
+    }
+
+
+    //
+    // LzCodec
+    //
+    // Layout: magic, u64 raw size, sequences. Sequence = token (literals count << 4 | match length - minMatch),
+    // [literals count extension], literals, u16 match offset, [match length extension]. Counts >= 15 continue
+    // in extension bytes (255 means "add and read the next one"). The last sequence has literals only.
+    namespace {
+        constexpr size_t lzMinMatch = 4;
+        constexpr size_t lzMaxOffset = 0xFFFF;
+        constexpr int lzHashBits = 16;
+
+        uint32_t Read32(const char* data) {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        void PutLength(std::string& out, size_t length) {
+            while (length >= 255) {
+                out += static_cast<char>(255);
+                length -= 255;
+            }
+            out += static_cast<char>(length);
+        }
+
+        void PutSequence(std::string& out, std::string_view literals, size_t offset, size_t matchLength) {
+            const size_t matchCode = matchLength ? matchLength - lzMinMatch : 0;
+            out += static_cast<char>((std::min<size_t>(literals.size(), 15) << 4) | std::min<size_t>(matchCode, 15));
+            if (literals.size() >= 15) {
+                PutLength(out, literals.size() - 15);
+            }
+            out.append(literals);
+
+            if (matchLength == 0) {
+                return; // the last sequence
+            }
+            out += static_cast<char>(offset & 0xFF);
+            out += static_cast<char>(offset >> 8);
+            if (matchCode >= 15) {
+                PutLength(out, matchCode - 15);
+            }
+        }
+    }
+
+    std::string LzCodec::Compress(std::string_view data) {
+        std::string out;
+        out.reserve(magic.size() + sizeof(uint64_t) + data.size() / 2);
+        out.append(magic);
+
+        const uint64_t rawSize = data.size();
+        out.append(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+
+        std::vector<size_t> lastPositions(size_t{ 1 } << lzHashBits, std::string_view::npos);
+        size_t pos = 0;
+        size_t anchor = 0;
+
+        while (pos + lzMinMatch <= data.size()) {
+            const uint32_t sequence = Read32(data.data() + pos);
+            const size_t hash = (sequence * 2654435761u) >> (32 - lzHashBits);
+            const size_t candidate = lastPositions[hash];
+            lastPositions[hash] = pos;
+
+            if (candidate == std::string_view::npos || pos - candidate > lzMaxOffset || Read32(data.data() + candidate) != sequence) {
+                pos++;
+                continue;
+            }
+
+            size_t matchLength = lzMinMatch;
+            while (pos + matchLength < data.size() && data[candidate + matchLength] == data[pos + matchLength]) {
+                matchLength++;
+            }
+
+            PutSequence(out, data.substr(anchor, pos - anchor), pos - candidate, matchLength);
+            pos += matchLength;
+            anchor = pos;
+        }
+
+        PutSequence(out, data.substr(anchor), 0, 0);
+        return out;
+    }
+
+    std::string LzCodec::Decompress(std::string_view compressed) {
+        const size_t headerSize = magic.size() + sizeof(uint64_t);
+        if (compressed.size() < headerSize || compressed.substr(0, magic.size()) != magic) {
+            spdlog::throw_spdlog_ex("lz codec: unknown format");
+        }
+
+        uint64_t rawSize;
+        std::memcpy(&rawSize, compressed.data() + magic.size(), sizeof(rawSize));
+        if (rawSize / 256 > compressed.size()) {
+            spdlog::throw_spdlog_ex("lz codec: malformed data");
+        }
+
+        std::string out(static_cast<size_t>(rawSize), '\0');
+        size_t outPos = 0;
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(compressed.data()) + headerSize;
+        const unsigned char* end = reinterpret_cast<const unsigned char*>(compressed.data()) + compressed.size();
+
+        auto readLength = [&](size_t length) {
+            if (length < 15) {
+                return length;
+            }
+            unsigned char extension;
+            do {
+                if (in == end) {
+                    spdlog::throw_spdlog_ex("lz codec: malformed data");
+                }
+                extension = *in++;
+                length += extension;
+            } while (extension == 255);
+            return length;
+        };
+
+        while (in < end) {
+            const unsigned char token = *in++;
+
+            const size_t literalsCount = readLength(token >> 4);
+            if (static_cast<size_t>(end - in) < literalsCount || out.size() - outPos < literalsCount) {
+                spdlog::throw_spdlog_ex("lz codec: malformed data");
+            }
+            std::memcpy(out.data() + outPos, in, literalsCount);
+            in += literalsCount;
+            outPos += literalsCount;
+
+            if (in == end) {
+                break;
+            }
+
+            if (end - in < 2) {
+                spdlog::throw_spdlog_ex("lz codec: malformed data");
+            }
+            const size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+            in += 2;
+
+            const size_t matchLength = readLength(token & 0x0F) + lzMinMatch;
+            if (offset == 0 || offset > outPos || out.size() - outPos < matchLength) {
+                spdlog::throw_spdlog_ex("lz codec: malformed data");
+            }
+            for (size_t i = 0; i < matchLength; i++, outPos++) { // may overlap itself (repeated runs)
+                out[outPos] = out[outPos - offset];
+            }
+        }
+
+        if (outPos != out.size()) {
+            spdlog::throw_spdlog_ex("lz codec: malformed data");
+        }
+        return out;
+    }
+
+
+
+    //
+    // SegmentedLogFile
+    //
+    SegmentedLogFile::SegmentedLogFile(const spdlog::filename_t& filename, bool truncate, uintmax_t maxTotalSize, FileRotationPolicy rotationPolicy)
+        : path{ filename }
+        , rotationPolicy{ rotationPolicy }
+        , maxTotalSize{ maxTotalSize }
+    {
+        auto closed = FindClosedSegments(this->path);
+        std::error_code ec;
+
+        for (auto& segment : closed) {
+            if (truncate) {
+                std::filesystem::remove(segment.path, ec);
+            }
+            else if (IsCompressed(segment.path)) {
+                // process stopped between compression and removing the original
+                std::filesystem::remove(std::filesystem::path{ segment.path }.replace_extension(), ec);
+            }
+        }
+        if (truncate) {
+            closed.clear();
+        }
+
+        this->file.open(filename, truncate);
+        this->activeSize = this->file.size();
+        this->nextRotationSize = this->SegmentSize();
+
+        this->closedSegments.assign(closed.begin(), closed.end());
+        this->activeSeq = closed.empty() ? 1 : closed.back().seq + 1;
+
+        if (this->maxTotalSize == 0) {
+            return;
+        }
+
+        if (this->rotationPolicy.compressClosedSegments) {
+            for (auto& segment : this->closedSegments) {
+                if (!IsCompressed(segment.path)) {
+                    this->compressQueue.push_back(segment.seq);
+                }
+            }
+            this->compressThread = std::thread(&SegmentedLogFile::CompressRoutine, this);
+        }
+
+        if (this->activeSize >= this->nextRotationSize) {
+            this->Rotate(); // the previous run filled it up
+        }
+        else {
+            std::lock_guard lk{ this->segmentsMtx };
+            this->RemoveOldSegments();
+            this->WriteIndex();
+        }
+    }
+
+    SegmentedLogFile::~SegmentedLogFile() {
+        if (this->compressThread.joinable()) {
+            {
+                std::lock_guard lk{ this->segmentsMtx };
+                this->stopCompression = true;
+            }
+            this->compressCv.notify_all();
+            this->compressThread.join();
+        }
+    }
+
+    bool SegmentedLogFile::Write(const spdlog::memory_buf_t& buffer) {
+        this->file.write(buffer);
+        this->activeSize += buffer.size();
+
+        if (this->maxTotalSize.load(std::memory_order_relaxed) == 0 || this->activeSize < this->nextRotationSize) {
+            return false;
+        }
+
+        this->Rotate();
+        return this->activeSize == 0;
+    }
+
+    void SegmentedLogFile::Flush() {
+        this->file.flush();
+    }
+
+    const spdlog::filename_t& SegmentedLogFile::Filename() const {
+        return this->file.filename();
+    }
+
+    size_t SegmentedLogFile::Size() const {
+        return static_cast<size_t>(this->activeSize);
+    }
+
+    void SegmentedLogFile::SetMaxTotalSize(uintmax_t maxTotalSize) {
+        this->maxTotalSize = maxTotalSize;
+    }
+
+    void SegmentedLogFile::TruncateActive(uintmax_t size) {
+        if (size >= this->activeSize) {
+            return;
+        }
+
+        const auto filename = this->file.filename();
+
+        this->file.close();
+        std::error_code ec;
+        std::filesystem::resize_file(this->path, size, ec);
+        this->file.open(filename, false);
+
+        this->activeSize = this->file.size();
+    }
+
+    std::filesystem::path SegmentedLogFile::IndexPath(const std::filesystem::path& filename) {
+        auto indexPath = filename;
+        indexPath += ".index";
+        return indexPath;
+    }
+
+    std::vector<std::filesystem::path> SegmentedLogFile::ListSegments(const std::filesystem::path& filename) {
+        std::vector<std::filesystem::path> segments;
+        for (auto& segment : FindClosedSegments(filename)) {
+            segments.push_back(std::move(segment.path));
+        }
+
+        std::error_code ec;
+        if (std::filesystem::exists(filename, ec)) {
+            segments.push_back(filename);
+        }
+        return segments;
+    }
+
+    std::string SegmentedLogFile::ReadSegment(const std::filesystem::path& segmentPath) {
+        auto data = ReadFile(segmentPath);
+        if (IsCompressed(segmentPath)) {
+            return LzCodec::Decompress(data);
+        }
+        return data;
+    }
+
+    std::vector<SegmentedLogFile::Segment> SegmentedLogFile::FindClosedSegments(const std::filesystem::path& filename) {
+        std::vector<Segment> segments;
+
+        auto directory = filename.parent_path();
+        if (directory.empty()) {
+            directory = ".";
+        }
+        const auto stem = filename.stem().native();
+        const auto ext = filename.extension().native();
+
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            const uint64_t seq = ParseSegmentSeq(entry.path().filename().native(), stem, ext);
+            if (seq == 0 || !entry.is_regular_file(ec)) {
+                continue;
+            }
+            segments.push_back(Segment{ seq, entry.path(), entry.file_size(ec) });
+        }
+
+        std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            // compressed copy goes first and wins over the original left by an interrupted compression
+            return a.seq != b.seq ? a.seq < b.seq : IsCompressed(a.path) > IsCompressed(b.path);
+            });
+        segments.erase(std::unique(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            return a.seq == b.seq;
+            }), segments.end());
+
+        return segments;
+    }
+
+    uintmax_t SegmentedLogFile::SegmentSize() const {
+        return (std::max)(this->maxTotalSize.load(std::memory_order_relaxed) / (std::max)(this->rotationPolicy.segmentsCount, 1u), minSegmentSize);
+    }
+
+    std::filesystem::path SegmentedLogFile::ClosedSegmentPath(uint64_t seq) const {
+        char seqText[32];
+        std::snprintf(seqText, sizeof(seqText), ".%06llu", static_cast<unsigned long long>(seq));
+
+        auto segmentPath = this->path.parent_path() / this->path.stem();
+        segmentPath += seqText;
+        segmentPath += this->path.extension();
+        return segmentPath;
+    }
+
+    void SegmentedLogFile::Rotate() {
+        const auto filename = this->file.filename();
+        const auto segmentPath = this->ClosedSegmentPath(this->activeSeq);
+
+        this->file.close();
+        std::error_code ec;
+        std::filesystem::rename(this->path, segmentPath, ec);
+        this->file.open(filename, false);
+
+        if (ec) {
+            // the file may be opened without FILE_SHARE_DELETE by a viewer, try again a bit later
+            this->nextRotationSize = this->activeSize + this->SegmentSize() / 8;
+            return;
+        }
+
+        const uintmax_t segmentSize = this->activeSize;
+        this->activeSize = 0;
+        this->nextRotationSize = this->SegmentSize();
+
+        {
+            std::lock_guard lk{ this->segmentsMtx };
+            this->closedSegments.push_back(Segment{ this->activeSeq, segmentPath, segmentSize });
+            this->activeSeq++;
+
+            this->RemoveOldSegments();
+            this->WriteIndex();
+
+            if (this->compressThread.joinable()) {
+                this->compressQueue.push_back(this->closedSegments.back().seq);
+            }
+        }
+        this->compressCv.notify_one();
+    }
+
+    void SegmentedLogFile::RemoveOldSegments() {
+        uintmax_t closedSize = 0;
+        for (auto& segment : this->closedSegments) {
+            closedSize += segment.size;
+        }
+
+        // leave room for the active segment
+        const uintmax_t segmentSize = this->SegmentSize();
+        const uintmax_t maxSize = this->maxTotalSize.load(std::memory_order_relaxed);
+
+        // the newest closed segment is always kept: a reader may still be finishing it, and with a single segment
+        // (or after SetMaxTotalSize shrank the limit) the just rotated data would be gone
+        std::error_code ec;
+        while (this->closedSegments.size() > 1 && closedSize + segmentSize > maxSize) {
+            std::filesystem::remove(this->closedSegments.front().path, ec);
+            closedSize -= this->closedSegments.front().size;
+            this->closedSegments.pop_front();
+        }
+    }
+
+    void SegmentedLogFile::WriteIndex() {
+        std::string index;
+        for (auto& segment : this->closedSegments) {
+            AppendIndexLine(index, segment.seq, segment.path);
+        }
+        AppendIndexLine(index, this->activeSeq, this->path);
+
+        // readers never see a partially written index
+        const auto indexPath = IndexPath(this->path);
+        auto tmpPath = indexPath;
+        tmpPath += ".tmp";
+
+        std::error_code ec;
+        if (WriteFile(tmpPath, index)) {
+            std::filesystem::rename(tmpPath, indexPath, ec);
+        }
+    }
+
+    void SegmentedLogFile::CompressRoutine() {
+        while (true) {
+            uint64_t seq = 0;
+            std::filesystem::path segmentPath;
+            {
+                std::unique_lock lk{ this->segmentsMtx };
+                this->compressCv.wait(lk, [this] {
+                    return this->stopCompression || !this->compressQueue.empty();
+                    });
+                if (this->stopCompression) {
+                    return;
+                }
+
+                seq = this->compressQueue.front();
+                this->compressQueue.pop_front();
+
+                auto it = std::find_if(this->closedSegments.begin(), this->closedSegments.end(), [seq](const Segment& segment) {
+                    return segment.seq == seq;
+                    });
+                if (it == this->closedSegments.end()) {
+                    continue; // already removed
+                }
+                segmentPath = it->path;
+            }
+
+            try {
+                const auto data = ReadFile(segmentPath);
+                const auto compressed = LzCodec::Compress(data);
+                if (compressed.size() >= data.size()) {
+                    continue;
+                }
+
+                auto compressedPath = segmentPath;
+                compressedPath += compressedExtension;
+                auto tmpPath = compressedPath;
+                tmpPath += ".tmp";
+
+                std::error_code ec;
+                if (!WriteFile(tmpPath, compressed)) {
+                    std::filesystem::remove(tmpPath, ec);
+                    continue;
+                }
+
+                std::lock_guard lk{ this->segmentsMtx };
+                auto it = std::find_if(this->closedSegments.begin(), this->closedSegments.end(), [seq](const Segment& segment) {
+                    return segment.seq == seq;
+                    });
+                if (it == this->closedSegments.end()) {
+                    std::filesystem::remove(tmpPath, ec); // removed while compressing
+                    continue;
+                }
+
+                std::filesystem::rename(tmpPath, compressedPath, ec);
+                if (ec) {
+                    std::filesystem::remove(tmpPath, ec);
+                    continue;
+                }
+                std::filesystem::remove(segmentPath, ec);
+
+                it->path = compressedPath;
+                it->size = compressed.size();
+                this->WriteIndex();
+            }
+            catch (...) {
+            }
+        }
+    }
+}
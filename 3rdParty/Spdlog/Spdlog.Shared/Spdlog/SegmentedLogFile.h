@@ -0,0 +1,101 @@
+#pragma once
+// Include it through "LogHelpers.h" (needs LOGGER_NS / LOGGER_API and spdlog headers).
+#include <spdlog/details/file_helper.h>
+#include <condition_variable>
+#include <string_view>
+#include <filesystem>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace LOGGER_NS {
+    struct FileRotationPolicy {
+        uint32_t segmentsCount = 8; // segment size = max total size / segmentsCount
+        bool compressClosedSegments = false; // compress closed segments in background to "<segment>.lz" (LzCodec)
+    };
+
+    // LZ77 block codec (LZ4-like sequences), good enough for text logs and needs no third party library.
+    class LOGGER_API LzCodec {
+    public:
+        static constexpr std::string_view magic{ "LGLZ" };
+
+        static std::string Compress(std::string_view data);
+        static std::string Decompress(std::string_view compressed); // throws spdlog::spdlog_ex on malformed data
+    };
+
+    // Log file split into fixed size segments. "name.ext" is always the active segment, when it is full
+    // it is renamed to "name.000042.ext" (and optionally compressed to "name.000042.ext.lz" in background).
+    // If the total size exceeds maxTotalSize the oldest segments are deleted (except the newest closed one), nothing is rewritten.
+    //
+    // "name.ext.index" lists segments oldest first as "<seq> <file name>" lines, the last one is the active file.
+    // A reader tails the active file and, when the index changes, finishes the segment with the same seq.
+    class LOGGER_API SegmentedLogFile {
+    public:
+        static constexpr uintmax_t minSegmentSize = 64 * 1024;
+
+        // maxTotalSize = 0 - one file without rotation.
+        SegmentedLogFile(const spdlog::filename_t& filename, bool truncate, uintmax_t maxTotalSize = 0, FileRotationPolicy rotationPolicy = {});
+        ~SegmentedLogFile(); // pending compression is left for the next start
+
+        SegmentedLogFile(const SegmentedLogFile&) = delete;
+        SegmentedLogFile& operator=(const SegmentedLogFile&) = delete;
+
+        // Returns true if the active segment was rotated after this write (the next write starts a new segment).
+        bool Write(const spdlog::memory_buf_t& buffer);
+        void Flush();
+
+        const spdlog::filename_t& Filename() const;
+        size_t Size() const; // of the active segment
+
+        void SetMaxTotalSize(uintmax_t maxTotalSize); // applied on the next rotation
+
+        // Cuts the active segment to 'size' bytes (e.g. an entry torn by the previous process), kept as is if it can't be resized.
+        void TruncateActive(uintmax_t size);
+
+        static std::filesystem::path IndexPath(const std::filesystem::path& filename);
+
+        // All segments on disk oldest first, the active file (if exists) is the last.
+        static std::vector<std::filesystem::path> ListSegments(const std::filesystem::path& filename);
+
+        // Segment content, ".lz" segments are decompressed.
+        static std::string ReadSegment(const std::filesystem::path& segmentPath);
+
+    private:
+        struct Segment {
+            uint64_t seq = 0;
+            std::filesystem::path path;
+            uintmax_t size = 0;
+        };
+
+        static std::vector<Segment> FindClosedSegments(const std::filesystem::path& filename);
+
+        uintmax_t SegmentSize() const;
+        std::filesystem::path ClosedSegmentPath(uint64_t seq) const;
+
+        void Rotate();
+        void RemoveOldSegments(); // under segmentsMtx
+        void WriteIndex();        // under segmentsMtx
+        void CompressRoutine();
+
+        const std::filesystem::path path;
+        const FileRotationPolicy rotationPolicy;
+        std::atomic<uintmax_t> maxTotalSize;
+
+        spdlog::details::file_helper file;
+        uintmax_t activeSize = 0;
+        uintmax_t nextRotationSize = 0; // postponed if renaming failed (file is opened by someone else)
+
+        std::mutex segmentsMtx;
+        std::deque<Segment> closedSegments;
+        uint64_t activeSeq = 1;
+
+        std::condition_variable compressCv;
+        std::deque<uint64_t> compressQueue;
+        bool stopCompression = false;
+        std::thread compressThread;
+    };
+}
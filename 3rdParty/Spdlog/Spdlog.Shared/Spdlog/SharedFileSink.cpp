@@ -0,0 +1,132 @@
+#include "LogHelpers.h"
+#include <spdlog/pattern_formatter.h>
+
+
+namespace LOGGER_NS {
+    SharedFileWriter::SharedFileWriter(const spdlog::filename_t& filename, bool truncate, FileFlushPolicy flushPolicy, uintmax_t maxTotalSize, FileRotationPolicy rotationPolicy)
+        : flushPolicy{ flushPolicy }
+        , file{ filename, truncate, maxTotalSize, rotationPolicy }
+    {
+        this->buffer.reserve(this->flushPolicy.bufferSize + 1024);
+
+        this->flushWorker = std::make_unique<spdlog::details::periodic_worker>([this] {
+            this->Flush();
+            }, this->flushPolicy.interval);
+    }
+
+    SharedFileWriter::~SharedFileWriter() {
+        this->flushWorker.reset(); // joins, no more Flush() from it
+
+        try {
+            this->Flush();
+        }
+        catch (...) {
+        }
+    }
+
+    std::shared_ptr<SharedFileSink> SharedFileWriter::CreateSink() {
+        return std::make_shared<SharedFileSink>(this->shared_from_this());
+    }
+
+    void SharedFileWriter::Write(spdlog::formatter& formatter, const spdlog::details::log_msg& msg) {
+        this->Append([&](spdlog::memory_buf_t& buffer) {
+            formatter.format(msg, buffer);
+            }, false);
+    }
+
+    void SharedFileWriter::Flush() {
+        std::lock_guard lk{ this->mtx };
+        this->FlushBuffer();
+        this->file.Flush();
+    }
+
+    void SharedFileWriter::FlushOnCrash() noexcept {
+        try {
+            if (this->writingThreadId.load() == std::this_thread::get_id()) {
+                // crashed inside Write on this thread, mtx is ours already
+                this->FlushBuffer();
+                this->file.Flush();
+                return;
+            }
+
+            // the lock owner may be stopped inside a crashed process, don't wait for it forever
+            for (int attempt = 0; attempt < 50; attempt++) {
+                if (this->mtx.try_lock()) {
+                    std::lock_guard lk{ this->mtx, std::adopt_lock };
+                    this->FlushBuffer();
+                    this->file.Flush();
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        catch (...) {
+        }
+    }
+
+    const spdlog::filename_t& SharedFileWriter::Filename() const {
+        return this->file.Filename();
+    }
+
+    size_t SharedFileWriter::FileSize() {
+        std::lock_guard lk{ this->mtx };
+        return this->file.Size() + this->buffer.size();
+    }
+
+    void SharedFileWriter::SetMaxTotalSize(uintmax_t maxTotalSize) {
+        this->file.SetMaxTotalSize(maxTotalSize);
+    }
+
+    void SharedFileWriter::TruncateActiveSegment(uintmax_t size) {
+        std::lock_guard lk{ this->mtx };
+        this->FlushBuffer();
+        this->file.Flush();
+        this->file.TruncateActive(size);
+    }
+
+    void SharedFileWriter::SetSegmentStartHandler(std::function<void(spdlog::memory_buf_t&)> handler) {
+        std::lock_guard lk{ this->mtx };
+        this->segmentStartHandler = std::move(handler);
+    }
+
+    void SharedFileWriter::FlushBuffer() {
+        if (this->buffer.size() == 0) {
+            return;
+        }
+
+        const bool segmentStarted = this->file.Write(this->buffer);
+        this->buffer.clear();
+
+        if (segmentStarted && this->segmentStartHandler) {
+            this->segmentStartHandler(this->buffer); // stays buffered, ahead of the next lines
+        }
+    }
+
+
+
+    SharedFileSink::SharedFileSink(std::shared_ptr<SharedFileWriter> writer)
+        : writer{ std::move(writer) }
+        , formatter{ std::make_unique<spdlog::pattern_formatter>() }
+    {
+    }
+
+    void SharedFileSink::log(const spdlog::details::log_msg& msg) {
+        this->writer->Write(*this->formatter, msg);
+    }
+
+    void SharedFileSink::flush() {
+        this->writer->Flush();
+    }
+
+    void SharedFileSink::set_pattern(const std::string& pattern) {
+        this->formatter = std::make_unique<spdlog::pattern_formatter>(pattern);
+    }
+
+    void SharedFileSink::set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter) {
+        this->formatter = std::move(sinkFormatter);
+    }
+
+    const std::shared_ptr<SharedFileWriter>& SharedFileSink::GetWriter() const {
+        return this->writer;
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+// Include it through "LogHelpers.h" (needs LOGGER_NS / LOGGER_API and spdlog headers).
+#include "SegmentedLogFile.h"
+#include <spdlog/sinks/sink.h>
+#include <spdlog/details/periodic_worker.h>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+namespace LOGGER_NS {
+    struct FileFlushPolicy {
+        std::chrono::milliseconds interval{ 1000 }; // buffered lines reach the file at least this often
+        size_t bufferSize = 64 * 1024; // flush when this many bytes are buffered
+        spdlog::level::level_enum flushLevel = spdlog::level::err; // loggers flush immediately on this level and above (flush_on)
+    };
+
+    class SharedFileSink;
+
+    // One file handle and one write buffer shared by several formatter variants (sinks made by CreateSink),
+    // so lines of all variants keep their order and cost one lock and no syscall until the buffer is flushed.
+    class LOGGER_API SharedFileWriter : public std::enable_shared_from_this<SharedFileWriter> {
+    public:
+        // maxTotalSize > 0 splits the file into segments (see SegmentedLogFile).
+        SharedFileWriter(const spdlog::filename_t& filename, bool truncate, FileFlushPolicy flushPolicy = {}, uintmax_t maxTotalSize = 0, FileRotationPolicy rotationPolicy = {});
+        ~SharedFileWriter();
+
+        SharedFileWriter(const SharedFileWriter&) = delete;
+        SharedFileWriter& operator=(const SharedFileWriter&) = delete;
+
+        std::shared_ptr<SharedFileSink> CreateSink();
+
+        void Write(spdlog::formatter& formatter, const spdlog::details::log_msg& msg);
+
+        // Appends what 'write' puts to the buffer (under the writer lock), 'flush' writes it to the file right away.
+        template<typename TWriteFn>
+        void Append(TWriteFn&& write, bool flush) {
+            std::lock_guard lk{ this->mtx };
+            this->writingThreadId = std::this_thread::get_id();
+
+            write(this->buffer);
+            if (flush || this->buffer.size() >= this->flushPolicy.bufferSize) {
+                this->FlushBuffer();
+                this->file.Flush(); // don't leave a part of the buffer in the CRT one until the next interval
+            }
+
+            this->writingThreadId = std::thread::id{};
+        }
+
+        void Flush();
+
+        // Best effort for crash handlers: never blocks for long and never throws.
+        void FlushOnCrash() noexcept;
+
+        const spdlog::filename_t& Filename() const;
+        size_t FileSize(); // written + buffered bytes of the active segment
+
+        void SetMaxTotalSize(uintmax_t maxTotalSize);
+
+        // Writes the buffer and cuts the active segment to 'size' bytes (see SegmentedLogFile::TruncateActive).
+        void TruncateActiveSegment(uintmax_t size);
+
+        // Called under the writer lock with the empty buffer when a new segment starts, lets formats
+        // with a file header (binary log) keep every segment readable on its own.
+        void SetSegmentStartHandler(std::function<void(spdlog::memory_buf_t&)> handler);
+
+    private:
+        void FlushBuffer(); // under mtx
+
+        const FileFlushPolicy flushPolicy;
+
+        std::mutex mtx;
+        std::atomic<std::thread::id> writingThreadId; // owner of mtx, lets crash handler on this thread skip the lock
+        SegmentedLogFile file;
+        spdlog::memory_buf_t buffer;
+        std::function<void(spdlog::memory_buf_t&)> segmentStartHandler;
+
+        std::unique_ptr<spdlog::details::periodic_worker> flushWorker;
+    };
+
+    // Formatter variant of SharedFileWriter, formats under the writer lock straight into the shared buffer.
+    class LOGGER_API SharedFileSink : public spdlog::sinks::sink {
+    public:
+        explicit SharedFileSink(std::shared_ptr<SharedFileWriter> writer);
+
+        void log(const spdlog::details::log_msg& msg) override;
+        void flush() override;
+        void set_pattern(const std::string& pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+        const std::shared_ptr<SharedFileWriter>& GetWriter() const;
+
+    private:
+        const std::shared_ptr<SharedFileWriter> writer;
+        std::unique_ptr<spdlog::formatter> formatter; // used under writer lock
+    };
+}
@@ -1,123 +1,220 @@
 #pragma once
+#include "array_wrapper.h"
 
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
 #include <vector>
-#include <list>
 #include <assert.h>
 
+// FIFO of chunks kept in a ring: fully read chunks are cleared and reused by PushBack (capacity stays allocated),
+// ring grows only when all chunks are in use.
+// Bulk PushBack/Front/Pop copy whole chunk pieces (memcpy for trivially copyable T), PeekSpans gives data without copying.
 template<class T, size_t ChunkSize = 1024 * 4>
 class ChunkedDataBuffer{
 public:
+	typedef array_wrapper<const T, size_t> span;
 
-	ChunkedDataBuffer()
-		: frontChunkBeg(0){
+	explicit ChunkedDataBuffer(size_t chunkSize = ChunkSize)
+		: chunkSize(chunkSize), frontChunkBeg(0), headChunk(0), chunkCount(0), size(0){
+		assert(chunkSize > 0);
 	}
 
 	void PushBack(const T &v){
-		this->AddChunkIfNeeded();
-		this->storage.back().push_back(v);
+		this->AddChunkIfNeeded().push_back(v);
+		this->size++;
 	}
 
 	void PushBack(T &&v){
-		this->AddChunkIfNeeded();
-		this->storage.back().push_back(std::move(v));
+		this->AddChunkIfNeeded().push_back(std::move(v));
+		this->size++;
 	}
 
 	template<class It>
 	void PushBack(It first, It last){
-		auto curIt = first;
+		typedef typename std::iterator_traits<It>::iterator_category category;
 
-		while (curIt != last){
-			this->AddChunkIfNeeded();
+		if constexpr (std::is_base_of<std::random_access_iterator_tag, category>::value){
+			while (first != last){
+				auto &back = this->AddChunkIfNeeded();
+				size_t count = (std::min)(static_cast<size_t>(last - first), this->chunkSize - back.size());
 
-			while (this->storage.back().size() != ChunkSize && curIt != last){
-				this->storage.back().push_back(*curIt);
-				curIt++;
+				back.insert(back.end(), first, first + count);
+				first += count;
+				this->size += count;
 			}
 		}
+		else{
+			for (; first != last; ++first){
+				this->PushBack(*first);
+			}
+		}
+	}
+
+	void PushBack(const T *src, size_t count){
+		this->PushBack(src, src + count);
 	}
 
+	// Removes min(count, Size()) elements.
 	void PopFront(size_t count = 1){
-		if (!this->Empty()){
-			size_t chunksToRemove = (count + this->frontChunkBeg) / ChunkSize;
+		count = (std::min)(count, this->size);
+		this->size -= count;
 
-			for (size_t i = 0; i < chunksToRemove && !this->storage.empty(); i++){
-				this->storage.pop_front();
-			}
+		while (count > 0){
+			auto &front = this->FrontChunk();
+			size_t fromFront = (std::min)(count, front.size() - this->frontChunkBeg);
 
-			if (this->storage.empty()){
-				this->frontChunkBeg = 0;
-			}
-			else{
-				this->frontChunkBeg = (count + this->frontChunkBeg) % ChunkSize;
+			this->frontChunkBeg += fromFront;
+			count -= fromFront;
+
+			if (this->frontChunkBeg == front.size()){
+				this->RecycleFrontChunk();
 			}
 		}
 	}
 
 	T &Front(){
 		assert(!this->Empty());
-		return this->storage.front()[this->frontChunkBeg];
+		return this->FrontChunk()[this->frontChunkBeg];
 	}
 
 	template<class It>
-	size_t Front(It first, It last){
+	size_t Front(It first, It last) const{
 		size_t copied = 0;
-		auto curIt = first;
-		auto storageIt = this->storage.begin();
-		auto chunkIdx = this->frontChunkBeg;
-
-		while (curIt != last && storageIt != this->storage.end()){
-			while (chunkIdx < storageIt->size() && curIt != last){
-				*curIt = (*storageIt)[chunkIdx];
 
-				chunkIdx++;
-				curIt++;
-				copied++;
+		this->PeekSpans(this->size, [&first, &last, &copied](const span &piece){
+			size_t i = 0;
+			for (; i < piece.size && first != last; i++, ++first){
+				*first = piece.data[i];
 			}
+			copied += i;
+			return first != last;
+		});
 
-			chunkIdx = 0;
-			storageIt++;
-		}
+		return copied;
+	}
+
+	// Copies min(count, Size()) elements to dst without removing them.
+	size_t Front(T *dst, size_t count) const{
+		size_t copied = 0;
+
+		this->PeekSpans(count, [dst, &copied](const span &piece){
+			if constexpr (std::is_trivially_copyable<T>::value){
+				std::memcpy(dst + copied, piece.data, piece.size * sizeof(T));
+			}
+			else{
+				std::copy(piece.data, piece.data + piece.size, dst + copied);
+			}
+			copied += piece.size;
+			return true;
+		});
 
 		return copied;
 	}
 
-	bool Empty() const{
-		return this->storage.empty() || this->storage.back().size() == this->frontChunkBeg;
+	// Front + PopFront.
+	size_t Pop(T *dst, size_t count){
+		size_t copied = this->Front(dst, count);
+		this->PopFront(copied);
+		return copied;
 	}
 
-	size_t Size() const{
-		size_t sz = 0;
+	// Calls func(span) for contiguous pieces of the first min(count, Size()) elements, func returns false to stop.
+	// Spans are valid until next PopFront/Pop.
+	template<class F>
+	size_t PeekSpans(size_t count, F func) const{
+		count = (std::min)(count, this->size);
 
-		if (this->storage.size() > 0){
-			// have at least front() chunk
-			sz += this->storage.front().size() - this->frontChunkBeg;
+		size_t peeked = 0;
+		size_t chunkBeg = this->frontChunkBeg;
 
-			if (this->storage.size() > 1){
-				// have at least back() chunk
-				sz += this->storage.back().size();
+		for (size_t i = 0; i < this->chunkCount && peeked < count; i++){
+			auto &chunk = this->ring[(this->headChunk + i) % this->ring.size()];
+			size_t pieceSize = (std::min)(count - peeked, chunk.size() - chunkBeg);
 
-				if (this->storage.size() > 2){
-					// have this->storage.size() - 2 full chunks
-					sz += (this->storage.size() - 2) * ChunkSize;
-				}
+			peeked += pieceSize;
+			if (!func(span(chunk.data() + chunkBeg, pieceSize))){
+				break;
 			}
+
+			chunkBeg = 0;
 		}
 
-		return sz;
+		return peeked;
+	}
+
+	// Contiguous part of data at front (may be shorter than Size()).
+	span FrontSpan() const{
+		if (this->Empty()){
+			return span();
+		}
+
+		auto &front = this->FrontChunk();
+		return span(front.data() + this->frontChunkBeg, front.size() - this->frontChunkBeg);
+	}
+
+	void Clear(){
+		this->PopFront(this->size);
+	}
+
+	bool Empty() const{
+		return this->size == 0;
+	}
+
+	size_t Size() const{
+		return this->size;
+	}
+
+	size_t GetChunkSize() const{
+		return this->chunkSize;
 	}
 
 private:
 	typedef std::vector<T> chunk;
-	typedef std::list<chunk> data_storage;
 
-	data_storage storage;
+	const size_t chunkSize;
+	std::vector<chunk> ring; // active chunks are [headChunk, headChunk + chunkCount) modulo ring.size()
 	size_t frontChunkBeg;
+	size_t headChunk;
+	size_t chunkCount;
+	size_t size;
 
-	void AddChunkIfNeeded(){
-		if (storage.empty() || storage.back().size() == ChunkSize){
-			storage.push_back(chunk());
-			storage.back().reserve(ChunkSize);
+	chunk &FrontChunk(){
+		return this->ring[this->headChunk];
+	}
+
+	const chunk &FrontChunk() const{
+		return this->ring[this->headChunk];
+	}
+
+	chunk &AddChunkIfNeeded(){
+		if (this->chunkCount > 0){
+			auto &back = this->ring[(this->headChunk + this->chunkCount - 1) % this->ring.size()];
+			if (back.size() != this->chunkSize){
+				return back;
+			}
 		}
+
+		if (this->chunkCount == this->ring.size()){
+			// all chunks in use: make active chunks linear and append new one
+			std::rotate(this->ring.begin(), this->ring.begin() + this->headChunk, this->ring.end());
+			this->headChunk = 0;
+			this->ring.emplace_back();
+		}
+
+		auto &newBack = this->ring[(this->headChunk + this->chunkCount) % this->ring.size()];
+		newBack.reserve(this->chunkSize); // no-op for recycled chunk
+		this->chunkCount++;
+
+		return newBack;
+	}
+
+	void RecycleFrontChunk(){
+		this->FrontChunk().clear();
+		this->frontChunkBeg = 0;
+		this->headChunk = (this->headChunk + 1) % this->ring.size();
+		this->chunkCount--;
 	}
 };
\ No newline at end of file
@@ -1,14 +1,33 @@
 #pragma once
 #include "..\Macros.h"
-#include "..\Thread\critical_section.h"
-#include "..\Thread\condition_variable.h"
 
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <atomic>
 #include <vector>
+#include <array>
+#include <mutex>
 
 namespace containers {
+    enum class ObjectPoolMtPolicy {
+        BlockOnEmpty, // Get waits until some object is returned
+        GrowOnEmpty, // Get creates new object with factory
+    };
+
+    // Pool with per-thread magazines (Bonwick, "Magazines and Vmem").
+    // Every thread slot caches up to 2 magazines of MagazineSize objects, so Get/Add usually touch only own slot.
+    // Full and empty magazines are exchanged with the depot - 2 lock-free stacks - once per MagazineSize operations.
+    // Thread slots are assigned round-robin, threads above slot count share slots (slot is guarded by spin flag).
     template<class T>
     class ObjectPoolMt {
     public:
+        static const uint32_t MagazineSize = 16;
+
         struct UsageScope {
         public:
             NO_COPY(UsageScope);
@@ -50,35 +69,280 @@ namespace containers {
             ObjectPoolMt *parent;
         };
 
-        ObjectPoolMt() {}
-        ~ObjectPoolMt() {}
+        ObjectPoolMt()
+            : ObjectPoolMt(ObjectPoolMtPolicy::BlockOnEmpty)
+        {}
 
-        void Add(T &&obj) {
-            {
-                thread::critical_section::scoped_lock lk(this->cs);
-                this->pool.push_back(std::move(obj));
+        // factory is required for GrowOnEmpty
+        ObjectPoolMt(ObjectPoolMtPolicy policy, std::function<T()> factory = nullptr)
+            : policy(policy), factory(std::move(factory))
+        {
+            uint32_t slotCount = 4;
+            while (slotCount < 2 * std::thread::hardware_concurrency()) {
+                slotCount <<= 1;
+            }
+
+            this->slots = std::make_unique<ThreadSlot[]>(slotCount);
+            this->slotMask = slotCount - 1;
+        }
+
+        ~ObjectPoolMt() {
+            for (auto &block : this->blocks) {
+                delete[] block.load(std::memory_order_relaxed);
             }
-            
-            this->cv.notify();
+        }
+
+        NO_COPY_MOVE(ObjectPoolMt);
+
+        void Add(T &&obj) {
+            auto &slot = this->LockSlot(this->CurrentSlotIdx());
+            this->PushLocked(slot, std::move(obj));
+            slot.busy.store(false, std::memory_order_release);
+
+            this->NotifyWaiters();
         }
 
         UsageScope Get() {
-            thread::critical_section::scoped_lock lk(this->cs);
+            if (auto obj = this->TryGetFromSlot(this->CurrentSlotIdx())) {
+                return UsageScope(this, std::move(*obj));
+            }
+
+            if (this->policy == ObjectPoolMtPolicy::GrowOnEmpty) {
+                return UsageScope(this, this->factory());
+            }
+
+            std::unique_lock<std::mutex> lk(this->waitMtx);
+            this->waitersCount.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with NotifyWaiters, scan below sees objects added before
+
+            std::optional<T> obj;
+            while (!(obj = this->TryGetFromAnySlot())) {
+                this->waitCv.wait(lk);
+            }
+
+            if (this->waitersCount.fetch_sub(1, std::memory_order_relaxed) > 1) {
+                this->waitCv.notify_one(); // objects may be left in slots, next waiter rescans
+            }
+            return UsageScope(this, std::move(*obj));
+        }
+
+    private:
+        static const uint32_t InvalidIdx = UINT32_MAX;
+        static const uint32_t FirstBlockSize = 16; // magazines in first block, every next block is twice larger
+        static const uint32_t MaxBlocks = 27; // FirstBlockSize * (2^MaxBlocks - 1) fits into uint32_t
+
+        struct Magazine {
+            std::vector<T> objs; // reserved to MagazineSize, so push_back never reallocates
+            std::atomic<uint32_t> next = InvalidIdx; // link in depot stack
+        };
+
+        struct alignas(64) ThreadSlot {
+            std::atomic<bool> busy = false;
+            uint32_t loaded = InvalidIdx; // Get/Add work with this magazine
+            uint32_t previous = InvalidIdx; // always full or empty, swapped with loaded before going to depot
+        };
+
+        // Treiber stack of magazine indices. Head is {index, tag}, tag changes on every operation against ABA.
+        class MagazineStack {
+        public:
+            void Push(ObjectPoolMt &pool, uint32_t idx) {
+                uint64_t head = this->head.load(std::memory_order_relaxed);
+                do {
+                    pool.GetMagazine(idx).next.store(HeadIdx(head), std::memory_order_relaxed);
+                } while (!this->head.compare_exchange_weak(head, MakeHead(idx, HeadTag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            uint32_t Pop(ObjectPoolMt &pool) {
+                uint64_t head = this->head.load(std::memory_order_acquire);
+                while (HeadIdx(head) != InvalidIdx) {
+                    // magazines are never freed while pool is alive, so reading 'next' of already popped one is safe (CAS fails)
+                    uint32_t next = pool.GetMagazine(HeadIdx(head)).next.load(std::memory_order_relaxed);
+                    if (this->head.compare_exchange_weak(head, MakeHead(next, HeadTag(head) + 1), std::memory_order_acquire, std::memory_order_acquire)) {
+                        return HeadIdx(head);
+                    }
+                }
+                return InvalidIdx;
+            }
+
+        private:
+            static uint64_t MakeHead(uint32_t idx, uint32_t tag) {
+                return (static_cast<uint64_t>(tag) << 32) | idx;
+            }
+            static uint32_t HeadIdx(uint64_t head) {
+                return static_cast<uint32_t>(head);
+            }
+            static uint32_t HeadTag(uint64_t head) {
+                return static_cast<uint32_t>(head >> 32);
+            }
+
+            std::atomic<uint64_t> head = MakeHead(InvalidIdx, 0);
+        };
+
+        static uint32_t CurrentThreadNumber() {
+            static std::atomic<uint32_t> nextThreadNumber = 0;
+            thread_local uint32_t threadNumber = nextThreadNumber.fetch_add(1, std::memory_order_relaxed);
+            return threadNumber;
+        }
+
+        uint32_t CurrentSlotIdx() const {
+            return CurrentThreadNumber() & this->slotMask;
+        }
+
+        ThreadSlot &LockSlot(uint32_t slotIdx) {
+            auto &slot = this->slots[slotIdx];
+            while (slot.busy.exchange(true, std::memory_order_acquire)) {
+                while (slot.busy.load(std::memory_order_relaxed)) {
+                    std::this_thread::yield(); // other thread shares the slot, critical sections are tiny
+                }
+            }
+            return slot;
+        }
+
+        // notifyWaiters = false when called by waiter (it holds waitMtx)
+        std::optional<T> TryGetFromSlot(uint32_t slotIdx, bool notifyWaiters = true) {
+            auto &slot = this->LockSlot(slotIdx);
+            bool loadedFromDepot = false;
+            auto obj = this->PopLocked(slot, loadedFromDepot);
+            slot.busy.store(false, std::memory_order_release);
+
+            if (loadedFromDepot && notifyWaiters) {
+                this->NotifyWaiters(); // rest of magazine moved to slot which waiters may have already scanned
+            }
+            return obj;
+        }
+
+        std::optional<T> TryGetFromAnySlot() {
+            const uint32_t currentSlotIdx = this->CurrentSlotIdx();
+            for (uint32_t i = 0; i <= this->slotMask; i++) {
+                if (auto obj = this->TryGetFromSlot((currentSlotIdx + i) & this->slotMask, false)) {
+                    return obj;
+                }
+            }
+            return std::nullopt;
+        }
+
+        std::optional<T> PopLocked(ThreadSlot &slot, bool &loadedFromDepot) {
+            if (slot.loaded == InvalidIdx || this->GetMagazine(slot.loaded).objs.empty()) {
+                if (slot.previous != InvalidIdx && !this->GetMagazine(slot.previous).objs.empty()) {
+                    std::swap(slot.loaded, slot.previous);
+                }
+                else {
+                    uint32_t fullIdx = this->fullMagazines.Pop(*this);
+                    if (fullIdx == InvalidIdx) {
+                        return std::nullopt;
+                    }
 
-            while (this->pool.empty()) {
-                this->cv.wait(this->cs);
+                    this->EnsureSlotMagazines(slot); // unused slots get magazines only when they really need them
+                    this->emptyMagazines.Push(*this, slot.previous);
+                    slot.previous = slot.loaded;
+                    slot.loaded = fullIdx;
+                    loadedFromDepot = true;
+                }
             }
 
-            UsageScope scope(this, std::move(this->pool.back()));
+            auto &objs = this->GetMagazine(slot.loaded).objs;
+            std::optional<T> obj(std::move(objs.back()));
+            objs.pop_back();
+            return obj;
+        }
+
+        void PushLocked(ThreadSlot &slot, T &&obj) {
+            this->EnsureSlotMagazines(slot);
+
+            if (this->GetMagazine(slot.loaded).objs.size() == MagazineSize) {
+                if (this->GetMagazine(slot.previous).objs.empty()) {
+                    std::swap(slot.loaded, slot.previous);
+                }
+                else {
+                    uint32_t emptyIdx = this->AcquireEmptyMagazine();
+                    this->fullMagazines.Push(*this, slot.previous);
+                    slot.previous = slot.loaded;
+                    slot.loaded = emptyIdx;
+                }
+            }
 
-            this->pool.pop_back();
+            this->GetMagazine(slot.loaded).objs.push_back(std::move(obj));
+        }
 
-            return scope;
+        void EnsureSlotMagazines(ThreadSlot &slot) {
+            if (slot.loaded == InvalidIdx) {
+                slot.loaded = this->AcquireEmptyMagazine();
+                slot.previous = this->AcquireEmptyMagazine();
+            }
+        }
+
+        void NotifyWaiters() {
+            if (this->policy != ObjectPoolMtPolicy::BlockOnEmpty) {
+                return;
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with fence in Get
+            if (this->waitersCount.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lk(this->waitMtx); // waiter is either before scan or already waits
+                this->waitCv.notify_one(); // successful waiter wakes the next one
+            }
+        }
+
+        uint32_t AcquireEmptyMagazine() {
+            uint32_t idx = this->emptyMagazines.Pop(*this);
+            if (idx != InvalidIdx) {
+                return idx;
+            }
+
+            std::lock_guard<std::mutex> lk(this->growMtx);
+            idx = this->magazineCount.load(std::memory_order_relaxed);
+
+            uint32_t block = 0;
+            uint32_t blockStart = 0;
+            while (idx >= blockStart + (FirstBlockSize << block)) {
+                blockStart += FirstBlockSize << block;
+                block++;
+            }
+
+            if (idx == blockStart) {
+                if (block >= MaxBlocks) {
+                    throw std::bad_alloc();
+                }
+
+                auto magazines = new Magazine[FirstBlockSize << block];
+                for (uint32_t i = 0; i < (FirstBlockSize << block); i++) {
+                    magazines[i].objs.reserve(MagazineSize);
+                }
+                this->blocks[block].store(magazines, std::memory_order_release);
+            }
+
+            this->magazineCount.store(idx + 1, std::memory_order_relaxed);
+            return idx;
+        }
+
+        Magazine &GetMagazine(uint32_t idx) {
+            // block b holds indices [FirstBlockSize * (2^b - 1), FirstBlockSize * (2^(b+1) - 1))
+            uint32_t blockNumber = idx / FirstBlockSize + 1;
+            uint32_t block = 0;
+            while (blockNumber >> (block + 1)) {
+                block++;
+            }
+
+            uint32_t blockStart = FirstBlockSize * ((1u << block) - 1);
+            return this->blocks[block].load(std::memory_order_acquire)[idx - blockStart];
         }
 
     private:
-        thread::critical_section cs;
-        thread::condition_variable cv;
-        std::vector<T> pool;
+        const ObjectPoolMtPolicy policy;
+        const std::function<T()> factory;
+
+        std::unique_ptr<ThreadSlot[]> slots;
+        uint32_t slotMask = 0;
+
+        MagazineStack fullMagazines;
+        MagazineStack emptyMagazines;
+
+        std::array<std::atomic<Magazine *>, MaxBlocks> blocks = {};
+        std::mutex growMtx;
+        std::atomic<uint32_t> magazineCount = 0;
+
+        std::mutex waitMtx;
+        std::condition_variable waitCv;
+        std::atomic<uint32_t> waitersCount = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+struct slot_map_handle{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool operator==(const slot_map_handle &other) const{
+		return this->index == other.index && this->generation == other.generation;
+	}
+
+	bool operator!=(const slot_map_handle &other) const{
+		return !(*this == other);
+	}
+
+	uint64_t to_uint64() const{
+		return (static_cast<uint64_t>(this->generation) << 32) | this->index;
+	}
+
+	static slot_map_handle from_uint64(uint64_t v){
+		return slot_map_handle{ static_cast<uint32_t>(v), static_cast<uint32_t>(v >> 32) };
+	}
+};
+
+// Slot map: O(1) push/remove/get by generational handle, values are packed in dense array for iteration.
+// Slot generation changes on every remove, so stale handles are rejected instead of aliasing new objects.
+// remove moves the last value into the hole: iteration order is not stable and pointers to values are invalidated.
+// Generation - unsigned type of slot generation counter, slot is retired when it wraps (narrower type retires slots sooner).
+template<class T, class Alloc = std::allocator<T>, class Generation = uint32_t>
+class slot_map{
+public:
+	using handle = slot_map_handle;
+	using iterator = typename std::vector<T, Alloc>::iterator;
+	using const_iterator = typename std::vector<T, Alloc>::const_iterator;
+
+	handle push(const T &v){
+		return this->emplace(v);
+	}
+
+	handle push(T &&v){
+		return this->emplace(std::move(v));
+	}
+
+	// Strong guarantee: all containers are reserved first, so only value constructor may throw and map stays unchanged.
+	template<class... Args>
+	handle emplace(Args&&... args){
+		reserve_one_more(this->denseToSlot);
+		if (this->freeSlots.empty()){
+			reserve_one_more(this->slots);
+		}
+		this->values.emplace_back(std::forward<Args>(args)...);
+
+		uint32_t slotIdx;
+
+		if (!this->freeSlots.empty()){
+			slotIdx = this->freeSlots.back();
+			this->freeSlots.pop_back();
+		}
+		else{
+			slotIdx = static_cast<uint32_t>(this->slots.size());
+			this->slots.push_back(slot());
+		}
+
+		this->denseToSlot.push_back(slotIdx);
+		this->slots[slotIdx].denseIdx = static_cast<uint32_t>(this->values.size() - 1);
+
+		return handle{ slotIdx, static_cast<uint32_t>(this->slots[slotIdx].generation) };
+	}
+
+	// nullptr if handle is stale or invalid
+	T *get(handle h){
+		uint32_t denseIdx = this->find_dense(h);
+		return denseIdx != InvalidIdx ? &this->values[denseIdx] : nullptr;
+	}
+
+	const T *get(handle h) const{
+		uint32_t denseIdx = this->find_dense(h);
+		return denseIdx != InvalidIdx ? &this->values[denseIdx] : nullptr;
+	}
+
+	bool contains(handle h) const{
+		return this->find_dense(h) != InvalidIdx;
+	}
+
+	// false if handle is stale or invalid
+	bool remove(handle h){
+		uint32_t denseIdx = this->find_dense(h);
+		if (denseIdx == InvalidIdx){
+			return false;
+		}
+
+		uint32_t lastIdx = static_cast<uint32_t>(this->values.size() - 1);
+		if (denseIdx != lastIdx){
+			this->values[denseIdx] = std::move(this->values[lastIdx]);
+			this->denseToSlot[denseIdx] = this->denseToSlot[lastIdx];
+			this->slots[this->denseToSlot[denseIdx]].denseIdx = denseIdx;
+		}
+
+		this->values.pop_back();
+		this->denseToSlot.pop_back();
+
+		auto &removedSlot = this->slots[h.index];
+		removedSlot.denseIdx = InvalidIdx;
+		removedSlot.generation++;
+		if (removedSlot.generation != 0){
+			this->freeSlots.push_back(h.index);
+		}
+		// else: generation wrapped, slot is retired so old handles can't match it again
+
+		return true;
+	}
+
+	void clear(){
+		for (uint32_t slotIdx : this->denseToSlot){
+			this->slots[slotIdx].denseIdx = InvalidIdx;
+			this->slots[slotIdx].generation++;
+			if (this->slots[slotIdx].generation != 0){
+				this->freeSlots.push_back(slotIdx);
+			}
+		}
+
+		this->values.clear();
+		this->denseToSlot.clear();
+	}
+
+	void reserve(size_t count){
+		this->values.reserve(count);
+		this->denseToSlot.reserve(count);
+		this->slots.reserve(count);
+	}
+
+	size_t size() const{
+		return this->values.size();
+	}
+
+	bool empty() const{
+		return this->values.empty();
+	}
+
+	// Dense access: i in [0, size())
+	T &at_dense(size_t i){
+		return this->values[i];
+	}
+
+	const T &at_dense(size_t i) const{
+		return this->values[i];
+	}
+
+	handle handle_at_dense(size_t i) const{
+		uint32_t slotIdx = this->denseToSlot[i];
+		return handle{ slotIdx, static_cast<uint32_t>(this->slots[slotIdx].generation) };
+	}
+
+	T *data(){
+		return this->values.data();
+	}
+
+	iterator begin(){
+		return this->values.begin();
+	}
+
+	iterator end(){
+		return this->values.end();
+	}
+
+	const_iterator begin() const{
+		return this->values.begin();
+	}
+
+	const_iterator end() const{
+		return this->values.end();
+	}
+
+	// Splits dense array into chunks for pool.ParallelFor (see ThreadPool), func(T &) or func(handle, T &).
+	// Container must not be modified until it returns.
+	template<class Pool, class F>
+	void parallel_for_each(Pool &pool, F &&func, size_t grainSize = 0){
+		pool.ParallelFor(size_t(0), this->values.size(), [this, &func](size_t i){
+			if constexpr (std::is_invocable_v<F &, handle, T &>){
+				func(this->handle_at_dense(i), this->values[i]);
+			}
+			else{
+				func(this->values[i]);
+			}
+		}, grainSize);
+	}
+
+private:
+	static const uint32_t InvalidIdx = UINT32_MAX;
+
+	static_assert(std::is_unsigned_v<Generation> && sizeof(Generation) <= sizeof(uint32_t), "Generation must fit slot_map_handle::generation");
+
+	struct slot{
+		uint32_t denseIdx = InvalidIdx; // InvalidIdx - free slot
+		Generation generation = 0;
+	};
+
+	// Geometric growth, reserve(size + 1) would reallocate on every call.
+	template<class V>
+	static void reserve_one_more(V &v){
+		if (v.size() == v.capacity()){
+			v.reserve(v.empty() ? 4 : v.size() * 2);
+		}
+	}
+
+	uint32_t find_dense(handle h) const{
+		if (h.index >= this->slots.size()){
+			return InvalidIdx;
+		}
+
+		const auto &s = this->slots[h.index];
+		return s.generation == h.generation ? s.denseIdx : InvalidIdx;
+	}
+
+	std::vector<T, Alloc> values;
+	std::vector<uint32_t> denseToSlot;
+	std::vector<slot> slots;
+	std::vector<uint32_t> freeSlots;
+};
\ No newline at end of file
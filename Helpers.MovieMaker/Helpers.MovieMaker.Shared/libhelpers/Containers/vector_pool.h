@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <vector>
 
+// Indices are reused without any check: index of removed value aliases the next pushed one.
+// Use slot_map when handles may outlive values.
 template<class T, class Alloc = std::allocator<T>>
 class vector_pool{
 public:
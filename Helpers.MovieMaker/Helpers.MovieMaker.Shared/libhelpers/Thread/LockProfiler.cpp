@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "LockProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <map>
+
+// LockProfilerHistogram=====================================================================
+void LockProfilerHistogram::Add(uint64_t ns) {
+    size_t bucket = 0;
+    while (bucket + 1 < BucketCount && (ns >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+
+    this->buckets[bucket]++;
+    this->count++;
+    this->totalNs += ns;
+    this->maxNs = (std::max)(this->maxNs, ns);
+}
+
+void LockProfilerHistogram::Merge(const LockProfilerHistogram &other) {
+    for (size_t i = 0; i < BucketCount; i++) {
+        this->buckets[i] += other.buckets[i];
+    }
+
+    this->count += other.count;
+    this->totalNs += other.totalNs;
+    this->maxNs = (std::max)(this->maxNs, other.maxNs);
+}
+
+uint64_t LockProfilerHistogram::PercentileNs(double percentile) const {
+    if (this->count == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(percentile * (this->count - 1)) + 1;
+    uint64_t accumulated = 0;
+
+    for (size_t i = 0; i < BucketCount; i++) {
+        accumulated += this->buckets[i];
+        if (accumulated >= target) {
+            return (std::min)((uint64_t(2) << i) - 1, this->maxNs);
+        }
+    }
+
+    return this->maxNs;
+}
+
+// LockProfiler=====================================================================
+LockProfiler *LockProfiler::Instance() {
+    static LockProfiler instance;
+    return &instance;
+}
+
+uint64_t LockProfiler::NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void LockProfiler::SetLockName(const void *lockAddress, const std::string &name) {
+    std::lock_guard<std::mutex> lk(this->registryMtx);
+    this->lockNames[lockAddress] = name;
+}
+
+void LockProfiler::RecordAcquire(const void *lockAddress, bool contended, uint64_t waitNs, const void *callSite) {
+    auto &buffer = this->CurrentThreadBuffer();
+    std::lock_guard<std::mutex> lk(buffer.mtx);
+    auto &lockData = buffer.locks[lockAddress];
+
+    lockData.acquireCount++;
+    if (contended) {
+        lockData.contentionCount++;
+        lockData.waitTime.Add(waitNs);
+
+        auto &callSiteData = lockData.callSites[callSite];
+        callSiteData.contentionCount++;
+        callSiteData.totalWaitNs += waitNs;
+    }
+}
+
+void LockProfiler::RecordHold(const void *lockAddress, uint64_t holdNs) {
+    auto &buffer = this->CurrentThreadBuffer();
+    std::lock_guard<std::mutex> lk(buffer.mtx);
+    buffer.locks[lockAddress].holdTime.Add(holdNs);
+}
+
+std::vector<LockProfilerLockStats> LockProfiler::Aggregate(size_t topCallSitesCount) {
+    std::map<const void *, LockData> merged;
+    std::lock_guard<std::mutex> registryLk(this->registryMtx);
+
+    for (auto &buffer : this->threadBuffers) {
+        std::lock_guard<std::mutex> bufferLk(buffer->mtx);
+
+        for (auto &lock : buffer->locks) {
+            auto &mergedLock = merged[lock.first];
+
+            mergedLock.acquireCount += lock.second.acquireCount;
+            mergedLock.contentionCount += lock.second.contentionCount;
+            mergedLock.waitTime.Merge(lock.second.waitTime);
+            mergedLock.holdTime.Merge(lock.second.holdTime);
+
+            for (auto &callSite : lock.second.callSites) {
+                auto &mergedCallSite = mergedLock.callSites[callSite.first];
+                mergedCallSite.contentionCount += callSite.second.contentionCount;
+                mergedCallSite.totalWaitNs += callSite.second.totalWaitNs;
+            }
+        }
+    }
+
+    std::vector<LockProfilerLockStats> result;
+
+    for (auto &lock : merged) {
+        LockProfilerLockStats stats;
+
+        stats.lockAddress = lock.first;
+        stats.acquireCount = lock.second.acquireCount;
+        stats.contentionCount = lock.second.contentionCount;
+        stats.waitTime = lock.second.waitTime;
+        stats.holdTime = lock.second.holdTime;
+
+        auto name = this->lockNames.find(lock.first);
+        if (name != this->lockNames.end()) {
+            stats.name = name->second;
+        }
+
+        for (auto &callSite : lock.second.callSites) {
+            LockProfilerCallSite site;
+            site.address = callSite.first;
+            site.contentionCount = callSite.second.contentionCount;
+            site.totalWaitNs = callSite.second.totalWaitNs;
+            stats.topCallSites.push_back(site);
+        }
+
+        std::sort(stats.topCallSites.begin(), stats.topCallSites.end(), [](const LockProfilerCallSite &a, const LockProfilerCallSite &b) {
+            return a.contentionCount > b.contentionCount;
+        });
+        if (stats.topCallSites.size() > topCallSitesCount) {
+            stats.topCallSites.resize(topCallSitesCount);
+        }
+
+        result.push_back(std::move(stats));
+    }
+
+    std::sort(result.begin(), result.end(), [](const LockProfilerLockStats &a, const LockProfilerLockStats &b) {
+        return a.waitTime.totalNs > b.waitTime.totalNs;
+    });
+
+    return result;
+}
+
+std::string LockProfiler::ReportJson(size_t topCallSitesCount) {
+    auto escape = [](const std::string &str) {
+        std::string escaped;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                escaped += ' ';
+            }
+            else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    };
+
+    auto writeHistogram = [](std::ostringstream &out, const LockProfilerHistogram &histogram) {
+        out << "{\"count\":" << histogram.count
+            << ",\"totalNs\":" << histogram.totalNs
+            << ",\"maxNs\":" << histogram.maxNs
+            << ",\"p50Ns\":" << histogram.PercentileNs(0.5)
+            << ",\"p99Ns\":" << histogram.PercentileNs(0.99)
+            << ",\"log2Buckets\":[";
+
+        size_t lastBucket = LockProfilerHistogram::BucketCount;
+        while (lastBucket > 0 && histogram.buckets[lastBucket - 1] == 0) {
+            lastBucket--;
+        }
+        for (size_t i = 0; i < lastBucket; i++) {
+            out << (i ? "," : "") << histogram.buckets[i];
+        }
+
+        out << "]}";
+    };
+
+    std::ostringstream out;
+    out << "{\"locks\":[";
+
+    bool firstLock = true;
+    for (auto &lock : this->Aggregate(topCallSitesCount)) {
+        out << (firstLock ? "" : ",")
+            << "{\"address\":\"" << lock.lockAddress << "\""
+            << ",\"name\":\"" << escape(lock.name) << "\""
+            << ",\"acquireCount\":" << lock.acquireCount
+            << ",\"contentionCount\":" << lock.contentionCount
+            << ",\"waitTime\":";
+        writeHistogram(out, lock.waitTime);
+        out << ",\"holdTime\":";
+        writeHistogram(out, lock.holdTime);
+        out << ",\"topCallSites\":[";
+
+        bool firstCallSite = true;
+        for (auto &callSite : lock.topCallSites) {
+            out << (firstCallSite ? "" : ",")
+                << "{\"address\":\"" << callSite.address << "\""
+                << ",\"contentionCount\":" << callSite.contentionCount
+                << ",\"totalWaitNs\":" << callSite.totalWaitNs << "}";
+            firstCallSite = false;
+        }
+
+        out << "]}";
+        firstLock = false;
+    }
+
+    out << "]}";
+    return out.str();
+}
+
+void LockProfiler::Reset() {
+    std::lock_guard<std::mutex> registryLk(this->registryMtx);
+
+    for (auto &buffer : this->threadBuffers) {
+        std::lock_guard<std::mutex> bufferLk(buffer->mtx);
+        buffer->locks.clear();
+    }
+
+    // buffers of exited threads are not referenced by anyone else
+    this->threadBuffers.erase(std::remove_if(this->threadBuffers.begin(), this->threadBuffers.end(), [](const std::shared_ptr<ThreadBuffer> &buffer) {
+        return buffer.use_count() == 1;
+    }), this->threadBuffers.end());
+}
+
+LockProfiler::LockProfiler() {
+}
+
+LockProfiler::ThreadBuffer &LockProfiler::CurrentThreadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+
+        std::lock_guard<std::mutex> lk(this->registryMtx);
+        this->threadBuffers.push_back(buffer);
+    }
+
+    return *buffer;
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <unordered_map>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+// Lock contention profiling: wait/hold time histograms, contention count and top contending call sites per lock.
+// Compiled out unless USE_LockProfiler is defined (thread::critical_section, QueuedLock and ProfiledMutex then have no overhead).
+//#define USE_LockProfiler
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LOCK_PROFILER_CALL_SITE() _ReturnAddress()
+#define LOCK_PROFILER_NOINLINE __declspec(noinline)
+#else
+#define LOCK_PROFILER_CALL_SITE() __builtin_return_address(0)
+#define LOCK_PROFILER_NOINLINE __attribute__((noinline))
+#endif
+
+// Bucket i counts values in [2^i, 2^(i + 1)) nanoseconds, bucket 0 also counts 0.
+struct LockProfilerHistogram {
+    static const size_t BucketCount = 40;
+
+    uint64_t buckets[BucketCount] = {};
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+
+    void Add(uint64_t ns);
+    void Merge(const LockProfilerHistogram &other);
+
+    // upper bound of the bucket where percentile falls, percentile in [0, 1]
+    uint64_t PercentileNs(double percentile) const;
+};
+
+struct LockProfilerCallSite {
+    const void *address = nullptr; // return address of the lock call, resolve with debugger/symbols
+    uint64_t contentionCount = 0;
+    uint64_t totalWaitNs = 0;
+};
+
+struct LockProfilerLockStats {
+    const void *lockAddress = nullptr;
+    std::string name;
+    uint64_t acquireCount = 0;
+    uint64_t contentionCount = 0;
+    LockProfilerHistogram waitTime; // contended acquisitions only
+    LockProfilerHistogram holdTime;
+    std::vector<LockProfilerCallSite> topCallSites; // by contention count
+};
+
+// Records go to per-thread buffers (uncontended lock each), Aggregate/ReportJson merge them on demand.
+// Locks are identified by address, SetLockName gives readable names in reports.
+class LockProfiler {
+public:
+    static LockProfiler *Instance();
+
+    static uint64_t NowNs();
+
+    void SetLockName(const void *lockAddress, const std::string &name);
+
+    void RecordAcquire(const void *lockAddress, bool contended, uint64_t waitNs, const void *callSite);
+    void RecordHold(const void *lockAddress, uint64_t holdNs);
+
+    // Sorted by total wait time, most expensive locks first.
+    std::vector<LockProfilerLockStats> Aggregate(size_t topCallSitesCount = 5);
+    std::string ReportJson(size_t topCallSitesCount = 5);
+    void Reset();
+
+    // Try lock first to detect contention, measure wait only when contended.
+    template<class TryLockFn, class LockFn>
+    uint64_t Lock(const void *lockAddress, const void *callSite, TryLockFn tryLock, LockFn lock) {
+        if (tryLock()) {
+            this->RecordAcquire(lockAddress, false, 0, callSite);
+        }
+        else {
+            uint64_t waitStartNs = NowNs();
+            lock();
+            this->RecordAcquire(lockAddress, true, NowNs() - waitStartNs, callSite);
+        }
+
+        return NowNs(); // acquired time for RecordHold
+    }
+
+private:
+    struct CallSiteData {
+        uint64_t contentionCount = 0;
+        uint64_t totalWaitNs = 0;
+    };
+
+    struct LockData {
+        uint64_t acquireCount = 0;
+        uint64_t contentionCount = 0;
+        LockProfilerHistogram waitTime;
+        LockProfilerHistogram holdTime;
+        std::unordered_map<const void *, CallSiteData> callSites;
+    };
+
+    struct ThreadBuffer {
+        std::mutex mtx; // contended only by Aggregate/Reset
+        std::unordered_map<const void *, LockData> locks;
+    };
+
+    std::mutex registryMtx;
+    std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers; // kept after thread exit until Reset
+    std::unordered_map<const void *, std::string> lockNames;
+
+    LockProfiler();
+
+    ThreadBuffer &CurrentThreadBuffer();
+};
+
+// Hold time of a lock, kept by the lock and touched only by its owner.
+// Recursive acquisitions (CRITICAL_SECTION, std::recursive_mutex) belong to the outer hold: it is recorded by the outermost unlock only.
+class LockProfilerHold {
+public:
+    void Acquired(uint64_t acquiredNs) {
+        if (this->depth++ == 0) {
+            this->acquiredNs = acquiredNs;
+        }
+    }
+
+    // Returns true if it was the outermost unlock.
+    bool Released(const void *lockAddress) {
+        if (--this->depth != 0) {
+            return false;
+        }
+
+        LockProfiler::Instance()->RecordHold(lockAddress, LockProfiler::NowNs() - this->acquiredNs);
+        return true;
+    }
+
+    // Condition variable wait releases the lock, sleep is not hold time.
+    void WaitBegin(const void *lockAddress) {
+        LockProfiler::Instance()->RecordHold(lockAddress, LockProfiler::NowNs() - this->acquiredNs);
+    }
+
+    void WaitEnd() {
+        this->acquiredNs = LockProfiler::NowNs();
+    }
+
+private:
+    uint64_t acquiredNs = 0;
+    uint32_t depth = 0;
+};
+
+// Lockable wrapper which reports to LockProfiler, e.g. ThreadSafeObject<ProfiledMutex<std::mutex>, T>.
+// Without USE_LockProfiler it's plain MutexT.
+template<class MutexT>
+class ProfiledMutex {
+public:
+    ProfiledMutex() = default;
+
+    explicit ProfiledMutex([[maybe_unused]] const std::string &name) {
+#ifdef USE_LockProfiler
+        LockProfiler::Instance()->SetLockName(this, name);
+#endif // USE_LockProfiler
+    }
+
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+#ifdef USE_LockProfiler
+    LOCK_PROFILER_NOINLINE void lock() {
+        this->hold.Acquired(LockProfiler::Instance()->Lock(this, LOCK_PROFILER_CALL_SITE(),
+            [this] { return this->mtx.try_lock(); },
+            [this] { this->mtx.lock(); }));
+    }
+
+    bool try_lock() {
+        if (!this->mtx.try_lock()) {
+            return false;
+        }
+
+        LockProfiler::Instance()->RecordAcquire(this, false, 0, nullptr);
+        this->hold.Acquired(LockProfiler::NowNs());
+        return true;
+    }
+
+    void unlock() {
+        this->hold.Released(this);
+        this->mtx.unlock();
+    }
+#else
+    void lock() {
+        this->mtx.lock();
+    }
+
+    bool try_lock() {
+        return this->mtx.try_lock();
+    }
+
+    void unlock() {
+        this->mtx.unlock();
+    }
+#endif // USE_LockProfiler
+
+private:
+    MutexT mtx;
+#ifdef USE_LockProfiler
+    LockProfilerHold hold;
+#endif // USE_LockProfiler
+};
\ No newline at end of file
@@ -7,14 +7,18 @@
 namespace thread {
 	QueuedLock::QueuedLock()
 		: curThreadId(0)
+#ifdef USE_LockProfiler
+		, profilerAcquiredNs(0)
+#endif // USE_LockProfiler
 	{}
 
 	QueuedLock::~QueuedLock() {}
 
 	void QueuedLock::Push(QueuedLockItem *item) {
 		thread::critical_section::scoped_lock lk(this->cs);
+		bool acquiredNow = this->items.empty();
 
-		if (this->items.empty()) {
+		if (acquiredNow) {
 			item->Acquired();
 		}
 
@@ -23,6 +27,17 @@ namespace thread {
 		}
 
 		this->items.push_back(item);
+
+#ifdef USE_LockProfiler
+		// wait time of queued item is measured until Pop of the previous owner passes lock to it
+		uint64_t nowNs = LockProfiler::NowNs();
+		this->profilerItems.push_back(ProfilerItem{ nowNs, LOCK_PROFILER_CALL_SITE() });
+
+		if (acquiredNow) {
+			LockProfiler::Instance()->RecordAcquire(this, false, 0, this->profilerItems.back().callSite);
+			this->profilerAcquiredNs = nowNs;
+		}
+#endif // USE_LockProfiler
 	}
 
 	void QueuedLock::Pop(QueuedLockItem *item) {
@@ -61,6 +76,12 @@ namespace thread {
 					this->items.pop_front();
 					this->curThreadId = 0;
 
+#ifdef USE_LockProfiler
+					uint64_t nowNs = LockProfiler::NowNs();
+					LockProfiler::Instance()->RecordHold(this, nowNs - this->profilerAcquiredNs);
+					this->profilerItems.pop_front();
+#endif // USE_LockProfiler
+
 					while (!this->items.empty() && !found) {
 						nextLock = this->items.front();
 
@@ -69,6 +90,11 @@ namespace thread {
 						if (nextLock && !nextLock->IsCancelled()) {
 							// Valid item found. Exit cycle
 							found = true;
+
+#ifdef USE_LockProfiler
+							LockProfiler::Instance()->RecordAcquire(this, true, nowNs - this->profilerItems.front().queuedNs, this->profilerItems.front().callSite);
+							this->profilerAcquiredNs = nowNs;
+#endif // USE_LockProfiler
 							break;
 						}
 						else {
@@ -78,6 +104,9 @@ namespace thread {
 							}*/
 
 							this->items.pop_front();
+#ifdef USE_LockProfiler
+							this->profilerItems.pop_front();
+#endif // USE_LockProfiler
 						}
 					}
 				}
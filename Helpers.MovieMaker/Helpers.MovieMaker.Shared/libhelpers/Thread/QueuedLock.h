@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "QueuedLockItem.h"
 #include "critical_section.h"
+#include "LockProfiler.h"
 
 #include <deque>
 
@@ -22,5 +23,15 @@ namespace thread {
 
 		DWORD curThreadId;
 		std::deque<QueuedLockItem *> items;
+
+#ifdef USE_LockProfiler
+		struct ProfilerItem {
+			uint64_t queuedNs;
+			const void *callSite;
+		};
+
+		std::deque<ProfilerItem> profilerItems; // parallel to items
+		uint64_t profilerAcquiredNs;
+#endif // USE_LockProfiler
 	};
 }
\ No newline at end of file
@@ -1,92 +1,333 @@
 #pragma once
 #include "ThreadTask.h"
-#include "..\Containers\ConcurrentQueue.h"
+#include <Helpers/WorkStealingScheduler.h>
 
 #include <memory>
 #include <thread>
 #include <mutex>
-#include <list>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <type_traits>
+#include <exception>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <limits>
 
+#if defined(_WIN32)
+#include <Helpers/HWindows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+enum class ThreadTaskPriority{
+	High,
+	Normal,
+	Low,
+};
+
+struct ThreadPoolOptions{
+	uint32_t threadCount = 0; // 0 - std::thread::hardware_concurrency()
+	std::vector<uint32_t> affinity; // worker i is bound to logical cpu affinity[i % size], empty - not bound
+};
+
+// Work-stealing thread pool, scheduling is done by HELPERS_NS::WorkStealingScheduler (shared with Async::ThreadPoolExecutor):
+// tasks submitted from worker go to its own deque per priority (no shared lock, LIFO order keeps data hot),
+// tasks from other threads go to global injection queue, idle workers steal from each other.
 class ThreadPool : public std::enable_shared_from_this<ThreadPool>{
 	class Worker;
 
 	struct this_is_private {
 	};
 public:
+	static constexpr size_t PriorityCount = 3;
+
 	static std::shared_ptr<ThreadPool> Make(){
-		return std::make_shared<ThreadPool>(this_is_private());
+		return std::make_shared<ThreadPool>(this_is_private(), ThreadPoolOptions());
 	}
 
 	static std::shared_ptr<ThreadPool> Make(uint32_t threadCount){
-		return std::make_shared<ThreadPool>(this_is_private(), threadCount);
-			}
+		ThreadPoolOptions options;
+		options.threadCount = threadCount;
+		return std::make_shared<ThreadPool>(this_is_private(), options);
+	}
 
-	explicit ThreadPool(const this_is_private &)
-		: wantExit(false){
-		uint32_t threadCount = std::thread::hardware_concurrency();
-		this->AddWorkers(threadCount);
+	static std::shared_ptr<ThreadPool> Make(const ThreadPoolOptions &options){
+		return std::make_shared<ThreadPool>(this_is_private(), options);
+	}
+
+	explicit ThreadPool(const this_is_private &, const ThreadPoolOptions &options)
+		: scheduler(ThreadCount(options)){
+		const uint32_t threadCount = ThreadCount(options);
+
+		for (uint32_t i = 0; i < threadCount; i++){
+			this->workers.push_back(std::make_unique<Worker>(this, i));
 		}
 
-	explicit ThreadPool(const this_is_private &, uint32_t threadCount)
-		: wantExit(false){
-		this->AddWorkers(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++){
+			if (options.affinity.empty()){
+				this->workers[i]->Run(nullptr);
+			}
+			else{
+				uint32_t cpu = options.affinity[i % options.affinity.size()];
+				this->workers[i]->Run(&cpu);
+			}
+		}
 	}
 
+	// Tasks which were not started are destroyed without running (futures get broken_promise).
 	~ThreadPool(){
-		this->wantExit = true;
-		this->taskQueue.StopWait();
+		this->scheduler.Stop();
+
+		for (auto &worker : this->workers){
+			worker->Join();
+		}
+		this->workers.clear();
+
+		this->scheduler.Drain([](ThreadTask *task){
+			delete task;
+		});
 	}
 
 	std::shared_ptr<ThreadPool> GetPtr() {
 		return shared_from_this();
 	}
 
-	void AddTask(std::unique_ptr<ThreadTask> &&task){
-		this->taskQueue.Push(std::move(task));
+	uint32_t GetWorkerCount() const{
+		return static_cast<uint32_t>(this->workers.size());
+	}
+
+	// true when called from worker of this pool
+	bool IsWorkerThread() const{
+		return CurrentWorker().pool == this;
+	}
+
+	void AddTask(std::unique_ptr<ThreadTask> &&task, ThreadTaskPriority priority = ThreadTaskPriority::Normal){
+		this->Schedule(task.release(), priority);
+	}
+
+	template<class F>
+	std::future<std::invoke_result_t<std::decay_t<F>>> Submit(F &&func, ThreadTaskPriority priority = ThreadTaskPriority::Normal){
+		using R = std::invoke_result_t<std::decay_t<F>>;
+
+		std::packaged_task<R()> packagedTask(std::forward<F>(func));
+		auto future = packagedTask.get_future();
+
+		this->Schedule(new FunctionTask<std::packaged_task<R()>>(std::move(packagedTask)), priority);
+		return future;
+	}
+
+	// Waits for future. Worker of this pool runs other tasks meanwhile, so waiting inside task can't deadlock the pool.
+	template<class R>
+	void Wait(const std::future<R> &future){
+		if (!this->IsWorkerThread()){
+			future.wait();
+			return;
+		}
+
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+			if (!this->TryRunPendingTask()){
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	// Runs one queued task on the calling thread, returns false if there was nothing to run.
+	bool TryRunPendingTask(){
+		ThreadTask *task = nullptr;
+
+		if (!this->scheduler.FindTask(this->CurrentWorkerIdx(), task)){
+			return false;
+		}
+
+		RunTask(task);
+		return true;
+	}
+
+	// Calls func(i) for every i in [begin, end). Range is split on chunks of grainSize items (0 - chosen by worker count),
+	// chunks are taken by workers and by the calling thread. First exception thrown by func is rethrown after all
+	// started chunks finished, not started chunks are skipped.
+	template<class Index, class F>
+	void ParallelFor(Index begin, Index end, F &&func, size_t grainSize = 0, ThreadTaskPriority priority = ThreadTaskPriority::Normal){
+		if (end <= begin){
+			return;
+		}
+
+		size_t count = static_cast<size_t>(end - begin);
+		if (grainSize == 0){
+			grainSize = (std::max)(count / (this->workers.size() * 4), size_t(1));
+		}
+
+		auto state = std::make_shared<ParallelForState>();
+		state->chunkCount = (count + grainSize - 1) / grainSize;
+		state->runChunk = [begin, end, grainSize, &func](size_t chunk){
+			Index from = begin + static_cast<Index>(chunk * grainSize);
+			Index to = (end - from) > static_cast<Index>(grainSize) ? from + static_cast<Index>(grainSize) : end;
+			for (Index i = from; i < to; i++){
+				func(i);
+			}
+		};
+
+		// helpers which start after all chunks were taken exit without touching func
+		size_t helperCount = (std::min)(this->workers.size(), state->chunkCount - 1);
+		for (size_t i = 0; i < helperCount; i++){
+			this->Schedule(new FunctionTask<std::function<void()>>([state](){
+				state->RunChunks();
+			}), priority);
+		}
+
+		state->RunChunks();
+
+		if (this->IsWorkerThread()){
+			while (state->doneCount.load(std::memory_order_acquire) != state->chunkCount){
+				if (!this->TryRunPendingTask()){
+					std::this_thread::yield();
+				}
+			}
+		}
+		else{
+			std::unique_lock<std::mutex> lk(state->mtx);
+			state->cv.wait(lk, [&](){
+				return state->doneCount.load(std::memory_order_acquire) == state->chunkCount;
+			});
+		}
+
+		if (state->error){
+			std::rethrow_exception(state->error);
+		}
 	}
+
 private:
-	ConcurrentQueue<std::unique_ptr<ThreadTask>> taskQueue;
-	std::mutex workersMtx;
-	std::list<std::unique_ptr<Worker>> workers;
-	bool wantExit;
+	template<class F>
+	class FunctionTask : public ThreadTask{
+	public:
+		explicit FunctionTask(F &&func)
+			: func(std::move(func)){
+		}
 
-	void AddWorkers(uint32_t count){
-		std::lock_guard<std::mutex> lk(this->workersMtx);
+		void Run() override{
+			this->func();
+		}
+	private:
+		F func;
+	};
 
-		for (uint32_t i = 0; i < count; i++){
-			std::unique_ptr<Worker> worker(new Worker(this));
-			worker->Run();
-			this->workers.push_back(std::move(worker));
+	struct ParallelForState{
+		size_t chunkCount = 0;
+		std::atomic<size_t> nextChunk = 0;
+		std::atomic<size_t> doneCount = 0;
+		std::atomic<bool> failed = false;
+		std::exception_ptr error;
+		std::function<void(size_t)> runChunk;
+		std::mutex mtx;
+		std::condition_variable cv;
+
+		void RunChunks(){
+			size_t chunk;
+			while ((chunk = this->nextChunk.fetch_add(1, std::memory_order_relaxed)) < this->chunkCount){
+				if (!this->failed.load(std::memory_order_relaxed)){
+					try{
+						this->runChunk(chunk);
+					}
+					catch (...){
+						std::lock_guard<std::mutex> lk(this->mtx);
+						if (!this->error){
+							this->error = std::current_exception();
+						}
+						this->failed = true;
+					}
+				}
+
+				if (this->doneCount.fetch_add(1, std::memory_order_acq_rel) + 1 == this->chunkCount){
+					std::lock_guard<std::mutex> lk(this->mtx);
+					this->cv.notify_all();
+				}
+			}
 		}
+	};
+
+	using Scheduler = HELPERS_NS::WorkStealingScheduler<ThreadTask *, PriorityCount>;
+
+	struct CurrentWorkerInfo{
+		const ThreadPool *pool = nullptr;
+		size_t workerIdx = 0;
+	};
+
+	Scheduler scheduler;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	static CurrentWorkerInfo &CurrentWorker(){
+		static thread_local CurrentWorkerInfo info;
+		return info;
+	}
+
+	static uint32_t ThreadCount(const ThreadPoolOptions &options){
+		return options.threadCount != 0 ? options.threadCount : (std::max)(std::thread::hardware_concurrency(), 1u);
+	}
+
+	size_t CurrentWorkerIdx() const{
+		return this->IsWorkerThread() ? CurrentWorker().workerIdx : Scheduler::noWorker;
+	}
+
+	static void RunTask(ThreadTask *task){
+		std::unique_ptr<ThreadTask> owned(task);
+		owned->Run();
+	}
+
+	void Schedule(ThreadTask *task, ThreadTaskPriority priority){
+		this->scheduler.Schedule(task, this->CurrentWorkerIdx(), static_cast<size_t>(priority));
 	}
 
 	class Worker{
 	public:
-		Worker(ThreadPool *parent)
-			: parent(parent){
+		Worker(ThreadPool *parent, uint32_t index)
+			: parent(parent), index(index){
 		}
 
 		~Worker(){
-			if (this->thread.joinable()){
-				this->thread.join();
-			}
+			this->Join();
 		}
 
-		void Run(){
-			this->thread = std::thread([=](){
-				while (!this->parent->wantExit){
-					std::unique_ptr<ThreadTask> task;
+		void Run(const uint32_t *cpu){
+			uint32_t cpuIdx = cpu ? *cpu : (std::numeric_limits<uint32_t>::max)();
 
-					if (this->parent->taskQueue.Pop(task, true)){
-						task->Run();
-					}
+			this->thread = std::thread([this, cpuIdx](){
+				if (cpuIdx != (std::numeric_limits<uint32_t>::max)()){
+					BindCurrentThread(cpuIdx);
 				}
+
+				CurrentWorker() = CurrentWorkerInfo{ this->parent, this->index };
+				this->parent->scheduler.RunWorker(this->index, RunTask);
+				CurrentWorker() = CurrentWorkerInfo();
 			});
 		}
+
+		void Join(){
+			if (this->thread.joinable()){
+				this->thread.join();
+			}
+		}
+
 	private:
 		ThreadPool *parent;
+		uint32_t index;
 		std::thread thread;
+
+		static void BindCurrentThread(uint32_t cpuIdx){
+#if defined(_WIN32)
+			SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (cpuIdx % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			CPU_SET(cpuIdx % CPU_SETSIZE, &cpuSet);
+			pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+		}
 	};
 };
\ No newline at end of file
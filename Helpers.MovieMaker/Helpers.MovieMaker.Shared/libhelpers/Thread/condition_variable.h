@@ -19,7 +19,14 @@ namespace thread {
 
         void wait(critical_section &cs, DWORD milliseconds = INFINITE) {
             LockInspector::Instance()->OnUnlock(&cs.cs);
+#ifdef USE_LockProfiler
+            // time spent in wait is not hold time, cs is reacquired without contention accounting
+            cs.profilerHold.WaitBegin(&cs.cs);
+#endif // USE_LockProfiler
             SleepConditionVariableCS(&this->cv, &cs.cs, milliseconds);
+#ifdef USE_LockProfiler
+            cs.profilerHold.WaitEnd();
+#endif // USE_LockProfiler
             LockInspector::Instance()->OnLock(&cs.cs);
         }
 
@@ -19,7 +19,13 @@ namespace thread {
 
     void critical_section::lock() {
         LockInspector::Instance()->OnLock(&this->cs);
+#ifdef USE_LockProfiler
+        this->profilerHold.Acquired(LockProfiler::Instance()->Lock(&this->cs, LOCK_PROFILER_CALL_SITE(),
+            [this] { return TryEnterCriticalSection(&this->cs) != FALSE; },
+            [this] { EnterCriticalSection(&this->cs); }));
+#else
         EnterCriticalSection(&this->cs);
+#endif // USE_LockProfiler
 #ifdef _DEBUG
         this->own();
 #endif // _DEBUG
@@ -29,6 +35,9 @@ namespace thread {
 #ifdef _DEBUG
         this->unown();
 #endif // _DEBUG
+#ifdef USE_LockProfiler
+        this->profilerHold.Released(&this->cs);
+#endif // USE_LockProfiler
         LeaveCriticalSection(&this->cs);
         LockInspector::Instance()->OnUnlock(&this->cs);
     }
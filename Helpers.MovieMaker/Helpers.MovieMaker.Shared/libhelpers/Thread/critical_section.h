@@ -1,6 +1,7 @@
 #pragma once
 #include "..\Macros.h"
 #include "LockInspector.h"
+#include "LockProfiler.h"
 
 #include <Windows.h>
 #include <chrono>
@@ -34,6 +35,10 @@ namespace thread {
         void unown();
 #endif // _DEBUG
 
+#ifdef USE_LockProfiler
+        LockProfilerHold profilerHold;
+#endif // USE_LockProfiler
+
         friend class condition_variable;
 
     public:
@@ -4,7 +4,10 @@
 #include <Helpers/Meta/FunctionTraits.h>
 #include <Helpers/Thread.h>
 #include <Helpers/Logger.h>
+#include <algorithm>
+#include <list>
 #include "Awaitables.h"
+#include "Executor.h"
 #include "CoTask.h"
 
 // Don't forget return original definitions for these macros at the end of file
@@ -35,6 +38,7 @@ namespace HELPERS_NS {
 			~AsyncTasks() {
 				LOG_FUNCTION_SCOPE_C("~AsyncTasks()");
 				Cancel();
+				DetachExecutorCallbacks();
 			}
 
 		private:
@@ -64,12 +68,34 @@ namespace HELPERS_NS {
 				std::chrono::milliseconds startAfter;
 			};
 
+			struct ConcurrentTask {
+				RootTask::Ret_t root;
+				std::shared_ptr<Task> task;
+				bool canceled = false;
+			};
+
+			// Shared with executor callbacks, they may be called after this object destroyed
+			struct ExecutorCallbacksState {
+				std::atomic<int> runningCount = 0;
+				std::atomic<bool> detached = false;
+			};
+
 		public:
 			void SetResumeCallback(std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback) {
 				LOG_FUNCTION_ENTER_C("SetResumeCallback(resumeCallback)");
 				this->resumeCallback = resumeCallback;
 			}
 
+			// With executor StartExecuting() starts all queued tasks at once on executor threads (each task still
+			// waits its startAfter), tasks added while executing are started immediately; resumeCallback is not used.
+			// Exception thrown by any task cancels all of them (like in sequential mode, where it breaks the tasks chain).
+			// NOTE: set it before StartExecuting()
+			void SetExecutor(std::shared_ptr<IExecutor> executor) {
+				LOG_FUNCTION_ENTER_C("SetExecutor(executor)");
+				std::unique_lock lk{ mx };
+				this->executor = executor;
+			}
+
 			template <
 				typename PromiseImplT,
 				typename... FnArgs,
@@ -83,7 +109,11 @@ namespace HELPERS_NS {
 				LOG_FUNCTION_ENTER_C("AddTaskFn(...)");
 				std::unique_lock lk{ mx };
 				tasks.push(TaskWrapper{ taskFn(std::forward<RealArgs&&>(args)...), startAfter });
-				return tasks.front().GetTask();
+				auto addedTask = tasks.front().GetTask();
+				lk.unlock();
+
+				StartQueuedTasksIfExecutingConcurrently();
+				return addedTask;
 			}
 
 			template <
@@ -100,7 +130,11 @@ namespace HELPERS_NS {
 				LOG_FUNCTION_ENTER_C("AddTaskFn(classPtr, ...)");
 				std::unique_lock lk{ mx };
 				tasks.push(TaskWrapper{ std::invoke(taskFn, classPtr, std::forward<RealArgs&&>(args)...), startAfter });
-				return tasks.front().GetTask();
+				auto addedTask = tasks.front().GetTask();
+				lk.unlock();
+
+				StartQueuedTasksIfExecutingConcurrently();
+				return addedTask;
 			}
 
 			template <
@@ -124,7 +158,11 @@ namespace HELPERS_NS {
 
 				std::unique_lock lk{ mx };
 				tasks.push(TaskWrapper{ LambdaBindCoro::Bind(LambdaBindCoroKey{}, std::move(lambda), std::move(args)...), startAfter });
-				return tasks.front().GetTask();
+				auto addedTask = tasks.front().GetTask();
+				lk.unlock();
+
+				StartQueuedTasksIfExecutingConcurrently();
+				return addedTask;
 			}
 
 			bool StartExecuting() {
@@ -132,6 +170,10 @@ namespace HELPERS_NS {
 				if (LOG_ASSERT(!executingStarted.exchange(true), "Executing of root coroutine already started!")) {
 					return false;
 				}
+				if (GetExecutor()) {
+					StartQueuedTasksConcurrently();
+					return true;
+				}
 				rootTask = StartExecutingCoroutine(L"rootTask", resumeCallback);
 				HELPERS_NS::Async::SafeResume(rootTask);
 				return true;
@@ -152,6 +194,7 @@ namespace HELPERS_NS {
 						task->cancel();
 					}
 				}
+				CancelConcurrentTasks();
 			}
 
 		private:
@@ -194,6 +237,156 @@ namespace HELPERS_NS {
 				co_return;
 			}
 
+			std::shared_ptr<IExecutor> GetExecutor() {
+				std::unique_lock lk{ mx };
+				return executor;
+			}
+
+			void StartQueuedTasksIfExecutingConcurrently() {
+				if (executingStarted && GetExecutor()) {
+					StartQueuedTasksConcurrently();
+				}
+			}
+
+			void StartQueuedTasksConcurrently() {
+				LOG_FUNCTION_SCOPE_C("StartQueuedTasksConcurrently()");
+				std::vector<RootTask::Ret_t> startedTasks;
+				{
+					std::unique_lock lk{ mx };
+					while (!tasks.empty()) {
+						auto taskWrapper = std::move(tasks.front());
+						tasks.pop();
+
+						auto root = ExecuteConcurrentTaskCoroutine(L"concurrentTask", MakeExecutorResumeCallback(), taskWrapper.GetTask(), taskWrapper.GetStartAfterTime());
+						concurrentTasks.push_back(ConcurrentTask{ root, taskWrapper.GetTask() });
+						startedTasks.push_back(root);
+					}
+					UpdateConcurrentExecutingState();
+				}
+
+				auto resumeOnExecutor = MakeExecutorResumeCallback();
+				for (auto& root : startedTasks) {
+					resumeOnExecutor(root);
+				}
+			}
+
+			// Every task has own root coroutine, so tasks don't wait each other.
+			RootTask::Ret_t ExecuteConcurrentTaskCoroutine(
+				std::wstring coroFrameName,
+				std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback,
+				std::shared_ptr<Task> task,
+				std::chrono::milliseconds startAfter
+			) {
+				LOG_FUNCTION_SCOPE_C("ExecuteConcurrentTaskCoroutine(...)");
+				if (startAfter.count() > 0) {
+					co_await ResumeAfter<RootTask::promise_type>(startAfter);
+				}
+
+				LOG_DEBUG_D("await co-task ...");
+				co_await *task;
+				LOG_DEBUG_D("co-task finished");
+
+				co_await ReleaseConcurrentTaskAwaitable{ this }; // never resumed, frame is released from executor
+			}
+
+			// Root coroutine can't destroy its own frame, so it suspends here and frame is destroyed by posted callback.
+			struct ReleaseConcurrentTaskAwaitable {
+				AsyncTasks* self;
+
+				bool await_ready() const noexcept {
+					return suspend::always;
+				}
+
+				void await_suspend(std::coroutine_handle<RootTask::promise_type> rootCoroutine) {
+					std::weak_ptr<CoTaskBase> rootWeak = rootCoroutine.promise().get_task();
+					self->GetExecutor()->Post([self = this->self, state = self->executorCallbacksState, rootWeak] {
+						RunExecutorCallback(state, [self, rootWeak] {
+							self->ReleaseConcurrentTask(rootWeak);
+							});
+						});
+				}
+
+				void await_resume() noexcept {
+				}
+			};
+
+			std::function<void(std::weak_ptr<CoTaskBase>)> MakeExecutorResumeCallback() {
+				return [self = this, executor = this->executor, state = this->executorCallbacksState](std::weak_ptr<CoTaskBase> taskWeak) {
+					executor->Post([self, state, taskWeak] {
+						RunExecutorCallback(state, [self, taskWeak] {
+							try {
+								if (auto task = taskWeak.lock()) { // keep task alive until it suspends
+									HELPERS_NS::Async::SafeResume(task);
+								}
+							}
+							catch (...) {
+								LOG_ERROR_D("Catch unhandled exception");
+								LOG_WARNING_D("cancel concurrent tasks");
+								self->OnConcurrentTaskFailed();
+							}
+							});
+						});
+				};
+			}
+
+			// Callback touches this object only if it is not destroyed yet, destructor waits for callbacks already running.
+			template <typename Fn>
+			static void RunExecutorCallback(const std::shared_ptr<ExecutorCallbacksState>& state, Fn callback) {
+				state->runningCount++;
+				if (!state->detached) {
+					callback();
+				}
+				state->runningCount--;
+			}
+
+			void DetachExecutorCallbacks() {
+				executorCallbacksState->detached = true;
+				while (executorCallbacksState->runningCount != 0) {
+					std::this_thread::yield();
+				}
+			}
+
+			void ReleaseConcurrentTask(std::weak_ptr<CoTaskBase> rootWeak) {
+				RootTask::Ret_t releasedRoot; // destroy coroutine frame outside the lock
+				std::unique_lock lk{ mx };
+				auto rootTask = rootWeak.lock();
+				auto it = std::find_if(concurrentTasks.begin(), concurrentTasks.end(), [&rootTask](const ConcurrentTask& concurrentTask) {
+					return concurrentTask.root == rootTask;
+					});
+				if (it != concurrentTasks.end()) {
+					releasedRoot = std::move(it->root);
+					concurrentTasks.erase(it);
+				}
+				rootTask = nullptr;
+				UpdateConcurrentExecutingState();
+			}
+
+			void OnConcurrentTaskFailed() {
+				std::unique_lock lk{ mx };
+				tasks = {}; // clear queue
+				CancelConcurrentTasks();
+				executingStarted = false;
+			}
+
+			// NOTE: mx must be locked
+			void CancelConcurrentTasks() {
+				for (auto& concurrentTask : concurrentTasks) {
+					concurrentTask.root->cancel();
+					concurrentTask.task->cancel();
+					concurrentTask.canceled = true; // canceled roots are never resumed, so they are released with this object
+				}
+			}
+
+			// NOTE: mx must be locked
+			void UpdateConcurrentExecutingState() {
+				bool anyRunning = std::any_of(concurrentTasks.begin(), concurrentTasks.end(), [](const ConcurrentTask& concurrentTask) {
+					return !concurrentTask.canceled;
+					});
+				if (!anyRunning) {
+					executingStarted = false;
+				}
+			}
+
 			TaskWrapper GetNextTask() {
 				LOG_FUNCTION_ENTER_C("GetNextTask()");
 				std::unique_lock lk{ mx };
@@ -211,6 +404,10 @@ namespace HELPERS_NS {
 			std::atomic<bool> executingStarted = false;
 			HELPERS_NS::Collection::iterable_queue<TaskWrapper> tasks;
 			std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback;
+
+			std::shared_ptr<IExecutor> executor;
+			std::list<ConcurrentTask> concurrentTasks;
+			std::shared_ptr<ExecutorCallbacksState> executorCallbacksState = std::make_shared<ExecutorCallbacksState>();
 		};
 	} // namespace Async
 } // namespace HELPERS_NS
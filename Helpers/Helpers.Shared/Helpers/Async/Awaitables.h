@@ -3,6 +3,7 @@
 #include "Helpers/Event/Signal.h"
 #include <Helpers/Logger.h>
 #include <Helpers/Time.h>
+#include "Executor.h"
 #include "CoTask.h"
 
 #include <coroutine>
@@ -52,8 +53,8 @@ namespace HELPERS_NS {
                         return;
                     }
 
-                    HELPERS_NS::Timer::Once(duration, [resumeCallback, coTaskWeak] {
-                        LOG_FUNCTION_SCOPE_VERBOSE("Timer::Once__lambda()");
+                    TimerService::GetDefault()->Schedule(duration, [resumeCallback, coTaskWeak] { // doesn't occupy thread per delay
+                        LOG_FUNCTION_SCOPE_VERBOSE("TimerService::Schedule__lambda()");
                         resumeCallback(coTaskWeak);
                         });
                 }
@@ -69,16 +70,40 @@ namespace HELPERS_NS {
             return Awaitable{ duration };
         }
 
+        // Signal finished after awaiting task was canceled (or destroyed) must not resume it.
+        inline bool IsWaitCanceled(const std::weak_ptr<CancellationToken>& cancellationTokenWeak) {
+            auto cancellationToken = cancellationTokenWeak.lock();
+            return !cancellationToken || cancellationToken->IsCanceled();
+        }
+
+        // Signal of the promise which resumes coroutine awaiting SignalAwaitable<ResultT> (void(ResultT) is ill-formed for void).
+        template<typename ResultT>
+        struct ResumeSignal {
+            using type = HELPERS_NS::Event::Signal<void(ResultT)>;
+        };
+
+        template<>
+        struct ResumeSignal<void> {
+            using type = HELPERS_NS::Event::Signal<void()>;
+        };
+
         template<typename ResultT>
         struct SignalAwaitableResult {
             template<typename ResumeSignalT>
-            void AddFinish(
+            auto AddFinish(
 				ResumeSignalT& resumeSignal,
 				std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback,
-				std::weak_ptr<CoTaskBase> coTaskWeak
+				std::weak_ptr<CoTaskBase> coTaskWeak,
+				std::weak_ptr<CancellationToken> cancellationTokenWeak
 			) {
-                resumeSignal->AddFinish([this, resumeCallback, coTaskWeak] (ResultT result) {
+                return resumeSignal->Subscribe([this, resumeCallback, coTaskWeak, cancellationTokenWeak] (ResultT result) {
                     LOG_FUNCTION_SCOPE_VERBOSE("SignalAwaitableResult<ResultT>::AddFinish__lambda()");
+                    if (IsWaitCanceled(cancellationTokenWeak)) {
+                        // awaiting coroutine frame may be already destroyed, don't touch 'this';
+                        // SafeResume doesn't resume canceled task but reports dropped resume (releases parked WhenAll / WhenAny child)
+                        SafeResume(coTaskWeak);
+                        return;
+                    }
                     this->result.emplace(std::move(result));
                     resumeCallback(coTaskWeak);
                     });
@@ -96,13 +121,18 @@ namespace HELPERS_NS {
         template<>
         struct SignalAwaitableResult<void> {
             template<typename ResumeSignalT>
-            void AddFinish(
+            auto AddFinish(
 				ResumeSignalT& resumeSignal,
 				std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback,
-				std::weak_ptr<CoTaskBase> coTaskWeak
+				std::weak_ptr<CoTaskBase> coTaskWeak,
+				std::weak_ptr<CancellationToken> cancellationTokenWeak
 			) {
-                resumeSignal->AddFinish([resumeCallback, coTaskWeak]() {
+                return resumeSignal->Subscribe([resumeCallback, coTaskWeak, cancellationTokenWeak]() {
                     LOG_FUNCTION_SCOPE_VERBOSE("SignalAwaitableResult<void>::AddFinish__lambda()");
+                    if (IsWaitCanceled(cancellationTokenWeak)) {
+                        SafeResume(coTaskWeak); // reports dropped resume, see SignalAwaitableResult<ResultT>
+                        return;
+                    }
                     resumeCallback(coTaskWeak);
                     });
             }
@@ -114,8 +144,10 @@ namespace HELPERS_NS {
 
         template<typename ResultT>
         struct SignalAwaitable : public SignalAwaitableResult<ResultT> {
+            using ResumeSignal_t = typename ResumeSignal<ResultT>::type;
+
             explicit SignalAwaitable(
-				std::function<void(std::weak_ptr<HELPERS_NS::Event::Signal<void(ResultT)>>)> asyncOperation
+				std::function<void(std::weak_ptr<ResumeSignal_t>)> asyncOperation
 			)
                 : asyncOperation{ asyncOperation } {
                 LOG_FUNCTION_ENTER_VERBOSE("Awaitable(asyncOperationTask)");
@@ -147,7 +179,7 @@ namespace HELPERS_NS {
                     return;
                 }
 
-                this->AddFinish(resumeSignal, resumeCallback, coTaskWeak);
+                this->resumeConnection = this->AddFinish(resumeSignal, resumeCallback, coTaskWeak, callerCoroutine.promise().get_cancellation_token());
 
                 asyncOperation(resumeSignalWeak);
             }
@@ -170,7 +202,7 @@ namespace HELPERS_NS {
                     return;
                 }
 
-                this->AddFinish(resumeSignal, resumeCallback, coTaskWeak);
+                this->resumeConnection = this->AddFinish(resumeSignal, resumeCallback, coTaskWeak, callerCoroutine.promise().get_cancellation_token());
 
                 asyncOperation(resumeSignalWeak);
             }
@@ -181,7 +213,9 @@ namespace HELPERS_NS {
             }
 
         private:
-            std::function<void(std::weak_ptr<HELPERS_NS::Event::Signal<void(ResultT)>>)> asyncOperation;
+            std::function<void(std::weak_ptr<ResumeSignal_t>)> asyncOperation;
+            // promise signal is reused by next awaits of the coroutine, so handler is connected only while this await lasts
+            typename ResumeSignal_t::ScopedConnection resumeConnection;
         };
 
         inline auto AsyncOperationWithResumeSignal(
@@ -233,7 +267,9 @@ auto operator co_await(std::chrono::duration<Rep, Period> duration) noexcept {
 
             HELPERS_NS::Timer::Once(duration, [coroHandle] {
                 LOG_FUNCTION_SCOPE_VERBOSE("Timer::Once__lambda()");
-                coroHandle.resume();
+                HELPERS_NS::Async::ThreadPoolExecutor::GetDefault()->Post([coroHandle] { // don't run coroutine on the timer thread
+                    coroHandle.resume();
+                    });
                 });
         }
 
@@ -3,10 +3,13 @@
 #include "Helpers/Event/Signal.h"
 #include <Helpers/Thread.h>
 #include <Helpers/Logger.h>
+#include <Helpers/CancellationToken.h>
+#include "FramePool.h"
 
 #include <type_traits>
 #include <coroutine>
 #include <optional>
+#include <mutex>
 
 // Don't forget return original definitions for these macros at the end of file
 #define LOG_FUNCTION_ENTER_VERBOSE(fmt, ...)
@@ -54,7 +57,7 @@ namespace HELPERS_NS {
 
         struct InstanceName {
             InstanceName(const wchar_t* name) : name(name) {}
-            InstanceName(std::wstring name) : name(name) {}
+            InstanceName(std::wstring name) : name(std::move(name)) {}
             std::wstring name;
         };
 
@@ -68,6 +71,8 @@ namespace HELPERS_NS {
 
         struct LambdaBindCoroKey {};
 
+        class PromiseJoin; // WhenAll / WhenAny helper coroutine (see WhenAll.h)
+
         template<typename ReturnT>
         class PromiseResult {
         public:
@@ -134,14 +139,14 @@ namespace HELPERS_NS {
             };
 
             // Used for non-class functions
-            Promise(InstanceName instanceName) {
+            Promise(const InstanceName& instanceName) {
                 this->SetFullClassNameSilent(instanceName.name);
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"Promise()");
             }
 
             // Used for Caller class methods
             template <typename Caller>
-            Promise(Caller&, InstanceName instanceName) {
+            Promise(Caller&, const InstanceName& instanceName) {
                 this->SetFullClassNameSilent(instanceName.name);
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"Promise(Caller)");
             }
@@ -150,9 +155,18 @@ namespace HELPERS_NS {
                 LOG_FUNCTION_ENTER_VERBOSE_C("~Promise()");
             }
 
+            // Coroutine frames are recycled by thread-local FramePool instead of heap allocation per task
+            static void* operator new(std::size_t size) {
+                return FramePool::Allocate(size);
+            }
+            static void operator delete(void* ptr, std::size_t size) noexcept {
+                FramePool::Deallocate(ptr, size);
+            }
+
             ObjectRet_t get_return_object() noexcept {
                 LOG_FUNCTION_SCOPE_VERBOSE_C("get_return_object()");
-                auto coTaskShared = std::make_shared<CoTask<PromiseImplT>>(
+                auto coTaskShared = std::allocate_shared<CoTask<PromiseImplT>>(
+                    FramePoolAllocator<CoTask<PromiseImplT>>{},
                     std::coroutine_handle<PromiseImplT>::from_promise(static_cast<PromiseImplT&>(*this)),
                     token,
                     this->GetFullClassNameW()
@@ -181,34 +195,51 @@ namespace HELPERS_NS {
             template <typename PromiseT>
             void remember_other_coroutine(std::coroutine_handle<PromiseT> otherCoroutine) {
                 this->resumeCallback = otherCoroutine.promise().get_resume_callback();
+                if constexpr (requires { otherCoroutine.promise().get_resume_dropped_callback(); }) {
+                    this->resumeDroppedCallback = otherCoroutine.promise().get_resume_dropped_callback();
+                }
                 this->previousCoroutine = otherCoroutine;
+                otherCoroutine.promise().get_cancellation_token()->AddChild(cancellationToken); // cancelled with caller
             }
 
             void cancel() {
-                canceled = true;
+                cancellationToken->Cancel();
             }
             bool is_canceled() {
-                return canceled;
+                return cancellationToken->IsCanceled();
             }
 
             std::function<void(std::weak_ptr<CoTaskBase>)> get_resume_callback() {
                 return resumeCallback;
             }
+            std::function<void()> get_resume_dropped_callback() {
+                return resumeDroppedCallback;
+            }
+            // Resume of canceled task was dropped, it will never run again.
+            void on_resume_dropped() {
+                if (resumeDroppedCallback) {
+                    resumeDroppedCallback();
+                }
+            }
             std::weak_ptr<CoTaskBase> get_task() {
                 return coTaskWeak;
             }
             std::weak_ptr<int> get_token() {
                 return token;
             }
+            std::shared_ptr<CancellationToken> get_cancellation_token() {
+                return cancellationToken;
+            }
 
         protected:
             std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback; // can be initialized in derived classes
 
         private:
-            std::atomic<bool> canceled = false;
+            std::function<void()> resumeDroppedCallback; // set by WhenAll / WhenAny join, inherited by awaited tasks
+            std::shared_ptr<CancellationToken> cancellationToken = std::allocate_shared<CancellationToken>(FramePoolAllocator<CancellationToken>{});
             std::coroutine_handle<> previousCoroutine;
             std::weak_ptr<CoTaskBase> coTaskWeak;
-            std::shared_ptr<int> token = std::make_shared<int>();
+            std::shared_ptr<int> token = std::allocate_shared<int>(FramePoolAllocator<int>{});
         };
 
 
@@ -227,7 +258,6 @@ namespace HELPERS_NS {
             template <typename... Args>
             PromiseDefault(InstanceName instanceName, Args&...)
                 : _MyBase(instanceName)
-                , resumeSignal{ std::make_shared<HELPERS_NS::Event::Signal<void()>>() }
             {
                 this->SetFullClassNameSilent(instanceName.name);
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"PromiseDefault()");
@@ -241,7 +271,6 @@ namespace HELPERS_NS {
             template <typename Caller, typename... Args>
             PromiseDefault(Caller& caller, InstanceName instanceName, Args&...)
                 : _MyBase(caller, instanceName)
-                , resumeSignal{ std::make_shared<HELPERS_NS::Event::Signal<void()>>() }
             {
                 this->SetFullClassNameSilent(instanceName.name);
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"PromiseDefault(Caller)");
@@ -251,17 +280,21 @@ namespace HELPERS_NS {
             template <typename LambdaT, typename... Args>
             PromiseDefault(LambdaBindCoroKey key, LambdaT& lambda, Args&...)
                 : _MyBase(L"LambdaBindCoroKey")
-                , resumeSignal{ std::make_shared<HELPERS_NS::Event::Signal<void()>>() }
             {
                 this->SetFullClassNameSilent(L"LambdaBindCoroKey");
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"PromiseDefault(LambdaCtorKey, LambdaT)");
             }
 
+            // NOTE: created on first request (most tasks never wait for signal), may be requested from any thread
             std::weak_ptr<HELPERS_NS::Event::Signal<void()>> get_resume_signal() {
+                std::call_once(resumeSignalCreated, [this] {
+                    resumeSignal = std::make_shared<HELPERS_NS::Event::Signal<void()>>();
+                    });
                 return resumeSignal;
             }
 
         private:
+            std::once_flag resumeSignalCreated;
             std::shared_ptr<HELPERS_NS::Event::Signal<void()>> resumeSignal;
         };
 
@@ -278,7 +311,6 @@ namespace HELPERS_NS {
             template <typename... Args>
             PromiseWithResult(InstanceName instanceName, Args&...)
                 : _MyBase(instanceName)
-                , resumeSignal{ std::make_shared<HELPERS_NS::Event::Signal<void(ReturnT)>>() }
             {
                 this->SetFullClassNameSilent(instanceName.name);
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"PromiseWithResult()");
@@ -292,7 +324,6 @@ namespace HELPERS_NS {
             template <typename Caller, typename... Args>
             PromiseWithResult(Caller& caller, InstanceName instanceName, Args&...)
                 : _MyBase(caller, instanceName)
-                , resumeSignal{ std::make_shared<HELPERS_NS::Event::Signal<void(ReturnT)>>() }
             {
                 this->SetFullClassNameSilent(instanceName.name);
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"PromiseWithResult(Caller)");
@@ -302,17 +333,21 @@ namespace HELPERS_NS {
             template <typename LambdaT, typename... Args>
             PromiseWithResult(LambdaBindCoroKey key, LambdaT& lambda, Args&...)
                 : _MyBase(L"LambdaBindCoroKey")
-                , resumeSignal{ std::make_shared<HELPERS_NS::Event::Signal<void(ReturnT)>>() }
             {
                 this->SetFullClassNameSilent(L"LambdaBindCoroKey");
                 LOG_FUNCTION_ENTER_VERBOSE_C(L"PromiseWithResult(LambdaCtorKey, LambdaT)");
             }
 
+            // NOTE: created on first request (most tasks never wait for signal), may be requested from any thread
             std::weak_ptr<HELPERS_NS::Event::Signal<void(ReturnT)>> get_resume_signal() {
+                std::call_once(resumeSignalCreated, [this] {
+                    resumeSignal = std::make_shared<HELPERS_NS::Event::Signal<void(ReturnT)>>();
+                    });
                 return resumeSignal;
             }
 
         private:
+            std::once_flag resumeSignalCreated;
             std::shared_ptr<HELPERS_NS::Event::Signal<void(ReturnT)>> resumeSignal;
         };
 
@@ -373,22 +408,31 @@ namespace HELPERS_NS {
                 LOG_FUNCTION_SCOPE_VERBOSE_C("await_suspend(coroutine_handle<PromiseRoot>)");
                 return await_suspend_internal<PromiseRoot>(callerCoroutine);
             }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseJoin> callerCoroutine) noexcept {
+                LOG_FUNCTION_SCOPE_VERBOSE_C("await_suspend(coroutine_handle<PromiseJoin>)");
+                return await_suspend_internal<PromiseJoin>(callerCoroutine);
+            }
             auto await_resume() {
                 LOG_FUNCTION_ENTER_VERBOSE_C("await_resume()");
                 return selfCoroutine.promise().detach_result();
             }
+            // Canceled task is not executed (and has no result), caller continues right away.
+            bool is_canceled() {
+                return selfCoroutine.promise().is_canceled();
+            }
 
         private:
             // NOTE: callerCoroutine associated with outter co-function context where called operator co_await CoTask{}
             template <typename PromiseT>
             std::coroutine_handle<> await_suspend_internal(std::coroutine_handle<PromiseT> callerCoroutine) noexcept {
                 LOG_FUNCTION_SCOPE_VERBOSE_C("await_suspend_internal(callerCoroutine)");
-                if (selfCoroutine.promise().is_canceled()) {
-                    return callerCoroutine; // continue caller coroutine
-                }
                 // 1. Remember callerCoroutine (it will resumed in Promise::FinalAwaiter when selfCoroutine finished)
+                //    and link selfCoroutine cancellation to the caller one (it may be already canceled)
                 // 2. Resume selfCoroutine
                 selfCoroutine.promise().remember_other_coroutine(callerCoroutine);
+                if (selfCoroutine.promise().is_canceled()) {
+                    return callerCoroutine; // continue caller coroutine
+                }
                 return selfCoroutine;
                 // 3. Control returned to callerCoroutine only when selfCoroutine finished;
                 //    if selfCoroutine has its own suspend points control returned to base resumer (previous stack frame)
@@ -409,7 +453,7 @@ namespace HELPERS_NS {
             CoTaskBase() { // In most cases default Ctor must not be called
                 LOG_FUNCTION_ENTER_VERBOSE("CoTaskBase()");
             }
-            CoTaskBase(std::coroutine_handle<> selfCoroutineBase, std::weak_ptr<int> promiseToken, InstanceName instanceName)
+            CoTaskBase(std::coroutine_handle<> selfCoroutineBase, std::weak_ptr<int> promiseToken, const InstanceName& instanceName)
                 : selfCoroutineBase{ selfCoroutineBase }
                 , promiseToken{ promiseToken }
             {
@@ -441,23 +485,25 @@ namespace HELPERS_NS {
 
         protected:
             virtual void cancelPromise() = 0;
+            virtual bool isPromiseCanceled() = 0;
+            virtual void notifyPromiseResumeDropped() = 0;
 
-            // You also can use std::noop_coroutine() instead unique_ptr
-            std::unique_ptr<std::coroutine_handle<>> get_coro_handle() {
+            // Empty handle if task can't be resumed.
+            std::coroutine_handle<> get_coro_handle() {
                 LOG_FUNCTION_SCOPE_VERBOSE_C("get_coro_handle()");
-                if (canceled) {
+                if (canceled || isPromiseCanceled()) { // promise is canceled together with the task awaiting it
                     LOG_WARNING_D("task canceled");
-                    return nullptr;
+                    return {};
                 }
                 if (promiseToken.expired()) {
                     LOG_WARNING_D("promiseToken expired!");
-                    return nullptr;
+                    return {};
                 }
                 if (!selfCoroutineBase) {
                     LOG_WARNING_D("selfCoroutineBase is empty!");
-                    return nullptr;
+                    return {};
                 }
-                return std::make_unique<std::coroutine_handle<>>(selfCoroutineBase);
+                return selfCoroutineBase;
             }
 
         protected:
@@ -470,14 +516,17 @@ namespace HELPERS_NS {
         // NOTE: we don't save shared_ptr<CoTaskBase>
         inline void SafeResume(std::weak_ptr<CoTaskBase> taskWeak) {
             LOG_FUNCTION_SCOPE_VERBOSE("SafeResume(taskWeak)");
-            std::unique_ptr<std::coroutine_handle<>> coroHandle;
+            std::coroutine_handle<> coroHandle;
 
             if (auto task = taskWeak.lock()) {
                 coroHandle = task->get_coro_handle();
+                if (!coroHandle && (task->canceled || task->isPromiseCanceled()) && !task->promiseToken.expired()) {
+                    task->notifyPromiseResumeDropped(); // WhenAll / WhenAny join releases frames of the parked task
+                }
             }
 
-            if (coroHandle) { // if task->get_coro_handle() return std::noop_coroutine() this condition not need
-                coroHandle->resume();
+            if (coroHandle) {
+                coroHandle.resume();
             }
         }
 
@@ -527,6 +576,14 @@ namespace HELPERS_NS {
                 LOG_FUNCTION_ENTER_VERBOSE_C("cancelPromise()");
                 selfCoroutine.promise().cancel();
             }
+            bool isPromiseCanceled() override {
+                return selfCoroutine && selfCoroutine.promise().is_canceled();
+            }
+            void notifyPromiseResumeDropped() override {
+                if (selfCoroutine) {
+                    selfCoroutine.promise().on_resume_dropped();
+                }
+            }
 
         private:
             CoHandle_t selfCoroutine;
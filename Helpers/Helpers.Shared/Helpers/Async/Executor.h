@@ -0,0 +1,247 @@
+#pragma once
+#include <Helpers/common.h>
+#include <Helpers/WorkStealingScheduler.h>
+#include <Helpers/MoveLambda.hpp>
+#include <Helpers/TimerService.h>
+#include <Helpers/Logger.h>
+#include "CoTask.h"
+
+#include <condition_variable>
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace HELPERS_NS {
+    namespace Async {
+        using ExecutorTask = HELPERS_NS::movable_function<void()>;
+
+        // Executor abstraction: something that runs posted work on its own threads.
+        // NOTE: executors must be owned by std::shared_ptr (delayed posts keep weak reference).
+        class IExecutor : public std::enable_shared_from_this<IExecutor> {
+        public:
+            virtual ~IExecutor() = default;
+
+            virtual void Post(ExecutorTask task) = 0;
+
+            // Posts task after delay without blocking any thread, dropped if executor was released meanwhile.
+            virtual void PostAfter(std::chrono::steady_clock::duration delay, ExecutorTask task) {
+                // TimerService callbacks are copyable std::function, move-only task is kept in shared_ptr
+                auto sharedTask = std::make_shared<ExecutorTask>(std::move(task));
+                TimerService::GetDefault()->Schedule(delay, [executorWeak = this->weak_from_this(), sharedTask] {
+                    if (auto executor = executorWeak.lock()) {
+                        executor->Post(std::move(*sharedTask));
+                    }
+                    });
+            }
+
+            // Executor which runs current thread or nullptr.
+            static std::shared_ptr<IExecutor> Current() {
+                auto executor = CurrentRef();
+                return executor ? executor->shared_from_this() : nullptr;
+            }
+
+        protected:
+            static IExecutor*& CurrentRef() {
+                static thread_local IExecutor* currentExecutor = nullptr;
+                return currentExecutor;
+            }
+        };
+
+
+        // Multi-threaded run loop with work stealing, scheduling is done by WorkStealingScheduler (shared with libhelpers ThreadPool):
+        // tasks posted from a worker go to its own deque (no shared lock, LIFO keeps coroutine frames hot),
+        // tasks posted from other threads go to the injection queue, idle workers steal from each other.
+        class ThreadPoolExecutor : public IExecutor {
+            CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(ThreadPoolExecutor);
+
+            using Scheduler = HELPERS_NS::WorkStealingScheduler<ExecutorTask*>;
+
+            // Shared with worker threads: worker detached by Stop (executor released by own task) keeps it alive.
+            struct State {
+                Scheduler scheduler;
+                std::vector<std::thread> threads;
+
+                explicit State(uint32_t threadCount)
+                    : scheduler{ threadCount }
+                {}
+
+                ~State() {
+                    this->scheduler.Drain([](ExecutorTask* task) {
+                        delete task;
+                        });
+                }
+            };
+
+            struct CurrentWorkerInfo {
+                const State* state = nullptr;
+                std::size_t workerIdx = 0;
+            };
+
+        public:
+            // threadCount = 0 - std::thread::hardware_concurrency()
+            explicit ThreadPoolExecutor(uint32_t threadCount = 0)
+                : state{ std::make_shared<State>(threadCount != 0 ? threadCount : (std::max)(std::thread::hardware_concurrency(), 1u)) }
+            {
+                LOG_FUNCTION_ENTER_C("ThreadPoolExecutor(threadCount = {})", threadCount);
+
+                for (std::size_t i = 0; i < this->state->scheduler.GetWorkerCount(); i++) {
+                    this->state->threads.emplace_back([this, state = this->state, i] {
+                        LOG_THREAD(L"ThreadPoolExecutor");
+                        RunLoop(state, i, this);
+                        });
+                }
+            }
+
+            ~ThreadPoolExecutor() {
+                LOG_FUNCTION_ENTER_C("~ThreadPoolExecutor()");
+                this->Stop();
+            }
+
+            // Shared pool with hardware_concurrency threads, lives until process exit.
+            static std::shared_ptr<ThreadPoolExecutor> GetDefault() {
+                static auto defaultExecutor = std::make_shared<ThreadPoolExecutor>();
+                return defaultExecutor;
+            }
+
+            void Post(ExecutorTask task) override {
+                auto& currentWorker = CurrentWorker();
+                const std::size_t workerIdx = currentWorker.state == this->state.get() ? currentWorker.workerIdx : Scheduler::noWorker;
+                this->state->scheduler.Schedule(new ExecutorTask(std::move(task)), workerIdx);
+            }
+
+            // Waits for running tasks, not started tasks are dropped.
+            void Stop() {
+                this->state->scheduler.Stop();
+
+                for (auto& thread : this->state->threads) {
+                    if (!thread.joinable()) {
+                        continue;
+                    }
+                    if (thread.get_id() == std::this_thread::get_id()) {
+                        thread.detach(); // last reference released by own task
+                        continue;
+                    }
+                    thread.join();
+                }
+            }
+
+            uint32_t GetThreadCount() const {
+                return static_cast<uint32_t>(this->state->scheduler.GetWorkerCount());
+            }
+
+        private:
+            static CurrentWorkerInfo& CurrentWorker() {
+                static thread_local CurrentWorkerInfo currentWorker;
+                return currentWorker;
+            }
+
+            static void RunLoop(const std::shared_ptr<State>& state, std::size_t workerIdx, IExecutor* executor) {
+                CurrentRef() = executor;
+                CurrentWorker() = CurrentWorkerInfo{ state.get(), workerIdx };
+
+                state->scheduler.RunWorker(workerIdx, [](ExecutorTask* task) {
+                    std::unique_ptr<ExecutorTask> ownedTask{ task };
+                    (*ownedTask)();
+                    });
+
+                CurrentWorker() = CurrentWorkerInfo{};
+                CurrentRef() = nullptr;
+            }
+
+        private:
+            std::shared_ptr<State> state;
+        };
+
+
+        // co_await ScheduleOn(executor) - continues coroutine on executor thread.
+        inline auto ScheduleOn(std::shared_ptr<IExecutor> executor) {
+            struct Awaitable {
+                std::shared_ptr<IExecutor> executor;
+
+                bool await_ready() const noexcept {
+                    return suspend::always;
+                }
+
+                void await_suspend(std::coroutine_handle<> coroHandle) {
+                    // coroutine may be resumed (and finished) on other thread before Post returns, don't touch *this after it
+                    auto executor = std::move(this->executor);
+                    executor->Post([coroHandle] {
+                        coroHandle.resume();
+                        });
+                }
+
+                void await_resume() noexcept {
+                }
+            };
+
+            return Awaitable{ std::move(executor) };
+        }
+
+        // co_await SleepFor(executor, duration) - resumes coroutine after duration, no thread is blocked while waiting.
+        // CoTask coroutines with resumeCallback are resumed through it (cancellation aware, on the thread resumeCallback chooses),
+        // other coroutines are resumed on executor (or on the timer thread if executor is null).
+        struct SleepForAwaitable {
+            SleepForAwaitable(std::shared_ptr<IExecutor> executor, std::chrono::steady_clock::duration duration)
+                : executor{ std::move(executor) }
+                , duration{ duration }
+            {}
+
+            bool await_ready() const noexcept {
+                return duration.count() <= 0;
+            }
+
+            template <typename PromiseT>
+            void await_suspend(std::coroutine_handle<PromiseT> coroHandle) {
+                auto executor = std::move(this->executor);
+                auto duration = this->duration;
+
+                if constexpr (requires { coroHandle.promise().get_resume_callback(); }) {
+                    auto resumeCallback = coroHandle.promise().get_resume_callback();
+                    if (resumeCallback) {
+                        std::weak_ptr<CoTaskBase> coTaskWeak = coroHandle.promise().get_task();
+                        TimerService::GetDefault()->Schedule(duration, [resumeCallback, coTaskWeak] {
+                            resumeCallback(coTaskWeak);
+                            });
+                        return;
+                    }
+                }
+
+                if (executor) {
+                    executor->PostAfter(duration, [coroHandle] {
+                        coroHandle.resume();
+                        });
+                }
+                else {
+                    TimerService::GetDefault()->Schedule(duration, [coroHandle] {
+                        coroHandle.resume();
+                        });
+                }
+            }
+
+            void await_resume() noexcept {
+            }
+
+        private:
+            std::shared_ptr<IExecutor> executor;
+            std::chrono::steady_clock::duration duration;
+        };
+
+        template <typename Rep, typename Period>
+        auto SleepFor(std::shared_ptr<IExecutor> executor, std::chrono::duration<Rep, Period> duration) {
+            return SleepForAwaitable{ std::move(executor), std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration) };
+        }
+
+        // Resumes on executor of the calling thread (see IExecutor::Current).
+        template <typename Rep, typename Period>
+        auto SleepFor(std::chrono::duration<Rep, Period> duration) {
+            return SleepFor(IExecutor::Current(), duration);
+        }
+    } // namespace Async
+} // namespace HELPERS_NS
@@ -0,0 +1,140 @@
+#pragma once
+#include <Helpers/common.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <new>
+
+namespace HELPERS_NS {
+    namespace Async {
+        // Thread-local cache of freed blocks by size classes for coroutine frames and small per-task objects
+        // (CoTask control blocks, tokens). Blocks come from global operator new and are recycled instead of being freed,
+        // block allocated on one thread may be freed to the cache of another one (executor threads), so no ownership checks needed.
+        class FramePool {
+        public:
+            static constexpr std::size_t granularity = 64;
+            static constexpr std::size_t classesCount = 32; // up to 2 KB, larger blocks go directly to operator new
+            static constexpr std::size_t maxCachedPerClass = 256;
+
+            static void* Allocate(std::size_t size) {
+                const std::size_t sizeClass = GetSizeClass(size);
+                if (sizeClass >= classesCount) {
+                    return ::operator new(size);
+                }
+                if (IsEnabled()) {
+                    if (auto cache = GetCache(); cache && cache->freeLists[sizeClass].head) {
+                        auto& freeList = cache->freeLists[sizeClass];
+                        auto block = freeList.head;
+                        freeList.head = block->next;
+                        freeList.count--;
+                        return block;
+                    }
+                }
+                return ::operator new((sizeClass + 1) * granularity); // whole class size, so the block can be cached when freed
+            }
+
+            // 'size' must be the same as passed to Allocate
+            static void Deallocate(void* ptr, std::size_t size) noexcept {
+                if (!ptr) {
+                    return;
+                }
+                const std::size_t sizeClass = GetSizeClass(size);
+                if (sizeClass < classesCount && IsEnabled()) {
+                    auto cache = GetCache();
+                    if (cache && cache->freeLists[sizeClass].count < maxCachedPerClass) {
+                        auto& freeList = cache->freeLists[sizeClass];
+                        freeList.head = new (ptr) FreeBlock{ freeList.head };
+                        freeList.count++;
+                        return;
+                    }
+                }
+                ::operator delete(ptr);
+            }
+
+            // Disabled pool allocates every block with operator new (used by benchmark and to catch use-after-free with sanitizers).
+            static void SetEnabled(bool enabled) {
+                EnabledRef().store(enabled, std::memory_order_relaxed);
+            }
+
+            static bool IsEnabled() {
+                return EnabledRef().load(std::memory_order_relaxed);
+            }
+
+        private:
+            struct FreeBlock {
+                FreeBlock* next;
+            };
+
+            struct FreeList {
+                FreeBlock* head = nullptr;
+                std::size_t count = 0;
+            };
+
+            struct Cache {
+                std::array<FreeList, classesCount> freeLists;
+
+                ~Cache() {
+                    Alive() = false; // frames destroyed later by other thread_local destructors go to operator delete
+                    for (auto& freeList : this->freeLists) {
+                        while (freeList.head) {
+                            auto block = freeList.head;
+                            freeList.head = block->next;
+                            ::operator delete(block);
+                        }
+                    }
+                }
+            };
+
+            static std::size_t GetSizeClass(std::size_t size) {
+                return size == 0 ? 0 : (size - 1) / granularity;
+            }
+
+            static Cache* GetCache() {
+                if (!Alive()) {
+                    return nullptr;
+                }
+                static thread_local Cache cache;
+                return &cache;
+            }
+
+            static bool& Alive() {
+                static thread_local bool alive = true; // trivially destructible, valid during thread_local destruction
+                return alive;
+            }
+
+            static std::atomic<bool>& EnabledRef() {
+                static std::atomic<bool> enabled = true;
+                return enabled;
+            }
+        };
+
+
+        // std allocator over FramePool for allocate_shared of per-task objects (CoTask with its control block etc.).
+        template <typename T>
+        struct FramePoolAllocator {
+            using value_type = T;
+
+            FramePoolAllocator() = default;
+
+            template <typename U>
+            FramePoolAllocator(const FramePoolAllocator<U>&) noexcept {
+            }
+
+            T* allocate(std::size_t n) {
+                static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned types are not supported");
+                return static_cast<T*>(FramePool::Allocate(n * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, std::size_t n) noexcept {
+                FramePool::Deallocate(ptr, n * sizeof(T));
+            }
+
+            template <typename U>
+            bool operator==(const FramePoolAllocator<U>&) const noexcept {
+                return true;
+            }
+        };
+    } // namespace Async
+} // namespace HELPERS_NS
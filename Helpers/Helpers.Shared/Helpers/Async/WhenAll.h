@@ -0,0 +1,448 @@
+#pragma once
+#include <Helpers/common.h>
+#include <Helpers/Logger.h>
+#include <Helpers/CancellationToken.h>
+#include "FramePool.h"
+#include "CoTask.h"
+
+#include <type_traits>
+#include <coroutine>
+#include <optional>
+#include <variant>
+#include <utility>
+#include <cstddef>
+#include <memory>
+#include <limits>
+#include <vector>
+#include <atomic>
+#include <tuple>
+
+namespace HELPERS_NS {
+    namespace Async {
+        class WhenJoinState;
+
+        struct JoinCoroutine {
+            using promise_type = PromiseJoin;
+            std::coroutine_handle<PromiseJoin> handle;
+        };
+
+        // Promise of helper coroutine which awaits one child task of WhenAll / WhenAny and reports when it finished.
+        // Child task is awaited as usual CoTask, so it gets resumeCallback and cancellation of the coroutine awaiting WhenAll / WhenAny.
+        class PromiseJoin {
+        public:
+            class FinalAwaiter {
+            public:
+                bool await_ready() noexcept {
+                    return suspend::always;
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseJoin> joinCoroutine) noexcept;
+
+                void await_resume() noexcept {
+                }
+            };
+
+            static void* operator new(std::size_t size) {
+                return FramePool::Allocate(size);
+            }
+            static void operator delete(void* ptr, std::size_t size) noexcept {
+                FramePool::Deallocate(ptr, size);
+            }
+
+            JoinCoroutine get_return_object() noexcept {
+                return JoinCoroutine{ std::coroutine_handle<PromiseJoin>::from_promise(*this) };
+            }
+            auto initial_suspend() const noexcept {
+                return std::suspend_always{}; // started by WhenJoinState when all joins are created
+            }
+            auto final_suspend() const noexcept {
+                return FinalAwaiter{}; // frame is destroyed by WhenJoinState
+            }
+            void return_void() {
+            }
+            void unhandled_exception() {
+                std::rethrow_exception(std::current_exception()); // "root resumer" must handle exceptions (like in Promise)
+            }
+
+            std::function<void(std::weak_ptr<CoTaskBase>)> get_resume_callback() {
+                return resumeCallback;
+            }
+            std::function<void()> get_resume_dropped_callback() {
+                return resumeDroppedCallback;
+            }
+            std::shared_ptr<CancellationToken> get_cancellation_token() {
+                return cancellationToken;
+            }
+
+        private:
+            friend class WhenJoinState;
+            template <typename PromiseImplT>
+            friend class WhenJoinAwaiter;
+
+            // Join keeps the state (and so frames of all joins) alive until it finished or parked after cancellation.
+            std::shared_ptr<WhenJoinState> state;
+            std::atomic<bool> stateReleased = false;
+            std::size_t index = 0;
+            std::function<void(std::weak_ptr<CoTaskBase>)> resumeCallback;
+            std::function<void()> resumeDroppedCallback;
+            std::shared_ptr<CancellationToken> cancellationToken = std::allocate_shared<CancellationToken>(FramePoolAllocator<CancellationToken>{});
+        };
+
+
+        // void results are stored as std::monostate
+        template <typename PromiseImplT>
+        using WhenValue_t = std::conditional_t<std::is_void_v<typename PromiseImplT::_ReturnT>, std::monostate, typename PromiseImplT::_ReturnT>;
+
+        enum class WhenMode {
+            All, // resume when all tasks finished
+            Any, // resume when first task finished, others are canceled
+        };
+
+
+        // Common part of WhenAll / WhenAny awaiters: joins fan out on the awaiting thread (no extra threads),
+        // every child runs until its first suspension, the last finished (or the first for WhenAny) resumes awaiting coroutine.
+        //
+        // Lifetime: state is shared by the awaiter and every join, it destroys frames of joins when the last reference is released.
+        // For WhenAny awaiting coroutine is resumed while canceled losers may still run on other threads, so each join holds
+        // the state until it finished (FinalAwaiter) or parked: SafeResume dropped resume of its canceled task, nothing of the join
+        // runs anymore. Only the winner stores its result, losers don't touch the awaiter.
+        // NOTE: loser parked inside nested WhenAll / WhenAny releases only the nested join, frames of the outer one are kept.
+        class WhenJoinState : public std::enable_shared_from_this<WhenJoinState> {
+        public:
+            static constexpr std::size_t noWinner = (std::numeric_limits<std::size_t>::max)();
+
+            explicit WhenJoinState(WhenMode mode)
+                : mode{ mode }
+            {}
+
+            ~WhenJoinState() {
+                for (auto& join : this->joins) {
+                    join.destroy();
+                }
+            }
+
+            WhenJoinState(const WhenJoinState&) = delete;
+            WhenJoinState& operator=(const WhenJoinState&) = delete;
+
+            void AddJoin(JoinCoroutine joinCoroutine) {
+                auto& joinPromise = joinCoroutine.handle.promise();
+                joinPromise.state = this->shared_from_this();
+                joinPromise.index = this->joins.size();
+                this->joins.push_back(joinCoroutine.handle);
+            }
+
+            // Returns false if all joins already finished and caller continues right away.
+            template <typename CallerPromiseT>
+            bool Start(std::coroutine_handle<CallerPromiseT> callerCoroutine) {
+                this->continuation = callerCoroutine;
+
+                auto resumeCallback = callerCoroutine.promise().get_resume_callback();
+                auto callerCancellationToken = callerCoroutine.promise().get_cancellation_token();
+                std::weak_ptr<WhenJoinState> stateWeak = this->weak_from_this();
+                for (auto& join : this->joins) {
+                    join.promise().resumeCallback = resumeCallback;
+                    join.promise().resumeDroppedCallback = [stateWeak, index = join.promise().index] {
+                        if (auto state = stateWeak.lock()) {
+                            state->ReleaseJoin(index);
+                        }
+                        };
+                    callerCancellationToken->AddChild(join.promise().get_cancellation_token());
+                }
+
+                for (auto& join : this->joins) {
+                    if (this->winner.load() != noWinner) {
+                        this->ReleaseJoin(join.promise().index); // others are canceled, no need to start them
+                        continue;
+                    }
+                    join.resume();
+                }
+
+                return this->pending.fetch_sub(1) != 1;
+            }
+
+            std::size_t GetWinner() const {
+                return this->winner.load();
+            }
+
+            // Awaiter is destroyed: either caller already resumed or its frame is destroyed while suspended (canceled).
+            void Detach() {
+                this->completed.exchange(true);
+            }
+
+        private:
+            friend class PromiseJoin::FinalAwaiter;
+            template <typename PromiseImplT>
+            friend class WhenJoinAwaiter;
+
+            // Child finished not canceled, returns false if its result must be dropped (WhenAny already has a winner).
+            bool OnJoinCompleted(std::size_t index) {
+                if (this->mode == WhenMode::All) {
+                    return true;
+                }
+
+                std::size_t expected = noWinner;
+                if (!this->winner.compare_exchange_strong(expected, index)) {
+                    return false;
+                }
+                for (auto& join : this->joins) {
+                    if (join.promise().index != index) {
+                        join.promise().get_cancellation_token()->Cancel();
+                    }
+                }
+                return true;
+            }
+
+            std::coroutine_handle<> OnJoinFinished(std::size_t index) {
+                if (this->mode == WhenMode::Any && this->winner.load() == index) {
+                    return this->Complete();
+                }
+
+                if (this->finishedCount.fetch_add(1) + 1 == this->joins.size()) {
+                    return this->Complete();
+                }
+                return std::noop_coroutine();
+            }
+
+            std::coroutine_handle<> Complete() {
+                if (this->completed.exchange(true)) {
+                    return std::noop_coroutine();
+                }
+                // Start() holds one more reference until all joins are started
+                if (this->pending.fetch_sub(1) == 1) {
+                    return this->continuation;
+                }
+                return std::noop_coroutine();
+            }
+
+            // Returns the state reference of the join once (finished or parked), it may be the last one.
+            std::shared_ptr<WhenJoinState> ReleaseJoin(std::size_t index) {
+                auto& joinPromise = this->joins[index].promise();
+                if (joinPromise.stateReleased.exchange(true)) {
+                    return nullptr;
+                }
+                return std::move(joinPromise.state);
+            }
+
+        private:
+            const WhenMode mode;
+            std::vector<std::coroutine_handle<PromiseJoin>> joins;
+            std::coroutine_handle<> continuation;
+            std::atomic<std::size_t> finishedCount = 0;
+            std::atomic<std::size_t> winner = noWinner;
+            std::atomic<bool> completed = false;
+            std::atomic<int> pending = 2; // completion + Start()
+        };
+
+        template <typename ResultsT>
+        struct WhenAnyResult {
+            static constexpr std::size_t none = WhenJoinState::noWinner; // all tasks were canceled
+
+            std::size_t index = none; // first finished task
+            ResultsT results; // only results[index] is set
+        };
+
+        inline std::coroutine_handle<> PromiseJoin::FinalAwaiter::await_suspend(std::coroutine_handle<PromiseJoin> joinCoroutine) noexcept {
+            auto& joinPromise = joinCoroutine.promise();
+            if (joinPromise.stateReleased.exchange(true)) {
+                return std::noop_coroutine(); // already released as parked
+            }
+            auto state = std::move(joinPromise.state);
+            return state->OnJoinFinished(joinPromise.index); // state released after it may destroy this frame, don't touch it
+        }
+
+
+        template <typename PromiseImplT>
+        class WhenJoinAwaiter {
+        public:
+            WhenJoinAwaiter(CoTask<PromiseImplT>& task, std::optional<WhenValue_t<PromiseImplT>>& result)
+                : taskAwaiter{ task.operator co_await() }
+                , result{ result }
+            {}
+
+            bool await_ready() noexcept {
+                return this->taskAwaiter.await_ready();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseJoin> joinCoroutine) noexcept {
+                this->joinPromise = &joinCoroutine.promise();
+                return this->taskAwaiter.await_suspend(joinCoroutine);
+            }
+
+            void await_resume() {
+                if (this->taskAwaiter.is_canceled()) {
+                    return;
+                }
+                if constexpr (std::is_void_v<typename PromiseImplT::_ReturnT>) {
+                    this->taskAwaiter.await_resume();
+                    if (this->joinPromise->state->OnJoinCompleted(this->joinPromise->index)) {
+                        this->result.emplace();
+                    }
+                }
+                else {
+                    auto value = this->taskAwaiter.await_resume();
+                    if (this->joinPromise->state->OnJoinCompleted(this->joinPromise->index)) {
+                        this->result.emplace(std::move(value));
+                    }
+                }
+            }
+
+        private:
+            AwaiterBase<PromiseImplT> taskAwaiter;
+            std::optional<WhenValue_t<PromiseImplT>>& result;
+            PromiseJoin* joinPromise = nullptr;
+        };
+
+        template <typename PromiseImplT>
+        JoinCoroutine MakeJoinCoroutine(std::shared_ptr<CoTask<PromiseImplT>> task, std::optional<WhenValue_t<PromiseImplT>>* result) {
+            co_await WhenJoinAwaiter<PromiseImplT>{ *task, *result };
+        }
+
+
+        template <WhenMode Mode, typename PromiseImplT>
+        class WhenRangeAwaiter {
+        public:
+            using Results_t = std::vector<std::optional<WhenValue_t<PromiseImplT>>>;
+
+            explicit WhenRangeAwaiter(std::vector<std::shared_ptr<CoTask<PromiseImplT>>> tasks)
+                : tasks{ std::move(tasks) }
+                , results(this->tasks.size())
+            {}
+
+            ~WhenRangeAwaiter() {
+                if (this->state) {
+                    this->state->Detach();
+                }
+            }
+
+            WhenRangeAwaiter(const WhenRangeAwaiter&) = delete;
+            WhenRangeAwaiter& operator=(const WhenRangeAwaiter&) = delete;
+
+            bool await_ready() const noexcept {
+                return this->tasks.empty();
+            }
+
+            template <typename CallerPromiseT>
+            bool await_suspend(std::coroutine_handle<CallerPromiseT> callerCoroutine) {
+                this->state = std::make_shared<WhenJoinState>(Mode);
+                for (std::size_t i = 0; i < this->tasks.size(); i++) {
+                    this->state->AddJoin(MakeJoinCoroutine(this->tasks[i], &this->results[i]));
+                }
+                return this->state->Start(callerCoroutine);
+            }
+
+            auto await_resume() {
+                if constexpr (Mode == WhenMode::All) {
+                    return std::move(this->results);
+                }
+                else {
+                    return WhenAnyResult<Results_t>{ this->state ? this->state->GetWinner() : WhenJoinState::noWinner, std::move(this->results) };
+                }
+            }
+
+        private:
+            std::vector<std::shared_ptr<CoTask<PromiseImplT>>> tasks;
+            Results_t results;
+            std::shared_ptr<WhenJoinState> state;
+        };
+
+        template <WhenMode Mode, typename... PromiseImplT>
+        class WhenTupleAwaiter {
+        public:
+            using Results_t = std::tuple<std::optional<WhenValue_t<PromiseImplT>>...>;
+
+            explicit WhenTupleAwaiter(std::shared_ptr<CoTask<PromiseImplT>>... tasks)
+                : tasks{ std::move(tasks)... }
+            {}
+
+            ~WhenTupleAwaiter() {
+                if (this->state) {
+                    this->state->Detach();
+                }
+            }
+
+            WhenTupleAwaiter(const WhenTupleAwaiter&) = delete;
+            WhenTupleAwaiter& operator=(const WhenTupleAwaiter&) = delete;
+
+            bool await_ready() const noexcept {
+                return sizeof...(PromiseImplT) == 0;
+            }
+
+            template <typename CallerPromiseT>
+            bool await_suspend(std::coroutine_handle<CallerPromiseT> callerCoroutine) {
+                this->state = std::make_shared<WhenJoinState>(Mode);
+                this->AddJoins(std::index_sequence_for<PromiseImplT...>{});
+                return this->state->Start(callerCoroutine);
+            }
+
+            auto await_resume() {
+                if constexpr (Mode == WhenMode::All) {
+                    return std::move(this->results);
+                }
+                else {
+                    return WhenAnyResult<Results_t>{ this->state ? this->state->GetWinner() : WhenJoinState::noWinner, std::move(this->results) };
+                }
+            }
+
+        private:
+            template <std::size_t... I>
+            void AddJoins(std::index_sequence<I...>) {
+                (this->state->AddJoin(MakeJoinCoroutine(std::get<I>(this->tasks), &std::get<I>(this->results))), ...);
+            }
+
+        private:
+            std::tuple<std::shared_ptr<CoTask<PromiseImplT>>...> tasks;
+            Results_t results;
+            std::shared_ptr<WhenJoinState> state;
+        };
+
+
+        // auto [a, b] = co_await WhenAll(taskA, taskB); - results are std::optional (empty if task was canceled), void -> std::monostate.
+        // Tasks must not be started yet (CoTask is lazy), they run interleaved on the awaiting thread and thread their resumes
+        // through resumeCallback of awaiting coroutine. Cancelling awaiting coroutine cancels all of them.
+        template <typename... PromiseImplT>
+        auto WhenAll(std::shared_ptr<CoTask<PromiseImplT>>... tasks) {
+            return WhenTupleAwaiter<WhenMode::All, PromiseImplT...>{ std::move(tasks)... };
+        }
+
+        template <typename PromiseImplT>
+        auto WhenAll(std::vector<std::shared_ptr<CoTask<PromiseImplT>>> tasks) {
+            return WhenRangeAwaiter<WhenMode::All, PromiseImplT>{ std::move(tasks) };
+        }
+
+        // auto result = co_await WhenAny(taskA, taskB); - result.index is the first finished task, others are canceled.
+        template <typename... PromiseImplT>
+        auto WhenAny(std::shared_ptr<CoTask<PromiseImplT>>... tasks) {
+            return WhenTupleAwaiter<WhenMode::Any, PromiseImplT...>{ std::move(tasks)... };
+        }
+
+        template <typename PromiseImplT>
+        auto WhenAny(std::vector<std::shared_ptr<CoTask<PromiseImplT>>> tasks) {
+            return WhenRangeAwaiter<WhenMode::Any, PromiseImplT>{ std::move(tasks) };
+        }
+
+
+        struct CancellationTokenAwaitable {
+            bool await_ready() const noexcept {
+                return suspend::always;
+            }
+
+            template <typename PromiseT>
+            bool await_suspend(std::coroutine_handle<PromiseT> callerCoroutine) noexcept {
+                this->cancellationToken = callerCoroutine.promise().get_cancellation_token();
+                return false; // continue right away
+            }
+
+            std::shared_ptr<CancellationToken> await_resume() noexcept {
+                return std::move(this->cancellationToken);
+            }
+
+        private:
+            std::shared_ptr<CancellationToken> cancellationToken;
+        };
+
+        // auto cancellationToken = co_await GetCancellationToken(); - token of the calling coroutine,
+        // long synchronous work can check it or register callback to abort pending operation.
+        inline auto GetCancellationToken() {
+            return CancellationTokenAwaitable{};
+        }
+    } // namespace Async
+} // namespace HELPERS_NS
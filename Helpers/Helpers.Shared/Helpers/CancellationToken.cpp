@@ -1,13 +1,81 @@
 #include "CancellationToken.h"
 
-bool CancellationToken::IsCanceled() {
-	return cancelled;
+bool CancellationToken::IsCanceled() const {
+	return cancelled.load(std::memory_order_acquire);
 }
 
 void CancellationToken::Cancel() {
-	cancelled = true;
+	std::vector<std::shared_ptr<CancellationToken>> childrenToCancel;
+	std::vector<std::pair<uint64_t, std::function<void()>>> callbacksToCall;
+	{
+		std::lock_guard lk{ mx };
+		if (cancelled.exchange(true, std::memory_order_acq_rel)) {
+			return;
+		}
+		for (auto& childWeak : children) {
+			if (auto child = childWeak.lock()) {
+				childrenToCancel.push_back(std::move(child));
+			}
+		}
+		children.clear();
+		callbacksToCall = std::move(callbacks);
+		callbacks.clear();
+	}
+
+	// outside the lock: callbacks may touch this token again
+	for (auto& [id, callback] : callbacksToCall) {
+		callback();
+	}
+	for (auto& child : childrenToCancel) {
+		child->Cancel();
+	}
 }
 
 void CancellationToken::Reset() {
 	cancelled = false;
+}
+
+void CancellationToken::AddChild(std::shared_ptr<CancellationToken> child) {
+	if (!child || child.get() == this) {
+		return;
+	}
+	{
+		std::lock_guard lk{ mx };
+		if (!cancelled.load(std::memory_order_relaxed)) {
+			// long living parent awaits many short children one by one, drop finished ones
+			if (children.size() == children.capacity()) {
+				std::erase_if(children, [](const std::weak_ptr<CancellationToken>& childWeak) {
+					return childWeak.expired();
+					});
+			}
+			children.push_back(std::move(child));
+			return;
+		}
+	}
+	child->Cancel();
+}
+
+std::shared_ptr<CancellationToken> CancellationToken::MakeChild() {
+	auto child = std::make_shared<CancellationToken>();
+	AddChild(child);
+	return child;
+}
+
+uint64_t CancellationToken::AddCallback(std::function<void()> callback) {
+	{
+		std::lock_guard lk{ mx };
+		if (!cancelled.load(std::memory_order_relaxed)) {
+			callbacks.emplace_back(++lastCallbackId, std::move(callback));
+			return lastCallbackId;
+		}
+	}
+	callback();
+	return 0;
+}
+
+void CancellationToken::RemoveCallback(uint64_t callbackId) {
+	std::lock_guard lk{ mx };
+	std::erase_if(callbacks, [callbackId](const std::pair<uint64_t, std::function<void()>>& item) {
+		return item.first == callbackId;
+		});
 }
\ No newline at end of file
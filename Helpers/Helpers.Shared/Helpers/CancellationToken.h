@@ -1,21 +1,42 @@
 #pragma once
 #include "common.h"
+#include <functional>
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <vector>
 #include <atomic>
+#include <mutex>
 
+// Hierarchical cancellation: Cancel() cancels the token, all its children (recursively) and calls registered callbacks.
+// Every coroutine promise (Async::CoTask) owns a token, awaited CoTask (and WhenAll / WhenAny children) token becomes child of caller token,
+// so cancelling a task cancels the whole tree of tasks it is waiting for.
 class CancellationToken {
 public:
 	CancellationToken() = default;
 	~CancellationToken() = default;
-	CancellationToken(CancellationToken&&) = default;
-	CancellationToken& operator=(CancellationToken&& other) = default;
-	
+
 	CancellationToken(const CancellationToken&) = delete;
 	CancellationToken& operator=(const CancellationToken& other) = delete;
 
-	bool IsCanceled();
+	bool IsCanceled() const;
 	void Cancel();
-	void Reset();
+	void Reset(); // children and callbacks are not restored
+
+	// Child is canceled immediately if this token is already canceled.
+	// NOTE: children are referenced weakly, they are owned by their promises.
+	void AddChild(std::shared_ptr<CancellationToken> child);
+	std::shared_ptr<CancellationToken> MakeChild();
+
+	// Callback is called once on the thread calling Cancel() (or right here if already canceled).
+	// Returns id for RemoveCallback (0 if callback was already called).
+	uint64_t AddCallback(std::function<void()> callback);
+	void RemoveCallback(uint64_t callbackId);
 
 private:
+	std::mutex mx;
 	std::atomic<bool> cancelled = false;
+	std::vector<std::weak_ptr<CancellationToken>> children;
+	std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+	uint64_t lastCallbackId = 0;
 };
\ No newline at end of file
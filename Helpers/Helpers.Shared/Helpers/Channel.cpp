@@ -1,5 +1,5 @@
 #include "Channel.h"
-#if COMPILE_FOR_DESKTOP
+#if COMPILE_FOR_DESKTOP && defined(_WIN32)
 #include "Time.h"
 #include <assert.h>
 #include <chrono>
@@ -4,68 +4,41 @@
 #include "HWindows.h"
 #include <MagicEnum/MagicEnum.h>
 
+#include "UnixSocketTransport.h"
+#include "ChannelTransport.h"
+#include "FramedReadBuffer.h"
+#include "ChannelLanes.h"
 #include "ConcurrentQueue.h"
-#include "LocalPtr.hpp"
-#include "Helpers.h"
 #include "Logger.h"
 #include "Thread.h"
+
+#ifdef _WIN32
+#include "LocalPtr.hpp"
+#include "Helpers.h"
 #include "File.h"
 #include "Time.h"
+#include <sddl.h>
+#endif
 
 #include <condition_variable>
 #include <functional>
+#include <type_traits>
+#include <optional>
+#include <limits>
+#include <cstring>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <thread>
-#include <sddl.h>
 #include <queue>
 
 namespace HELPERS_NS {
-#define BUFFER_PIPE READ_FILE_BUFFER_SIZE_DEFAULT
-
-    enum class PipeConnectionStatus {
-        Error,
-        Stopped,
-        TimeoutConnection,
-        Connected,
-    };
-
-    enum class PipeError {
-        InvalidHandle,
-        WriteError,
-        ReadError,
-    };
-
+#ifdef _WIN32
     PipeConnectionStatus WaitConnectPipe(IN HANDLE hPipe, const std::atomic<bool>& stop, int timeout = 0);
     PipeConnectionStatus WaitOpenPipe(OUT HANDLE& hPipe, const std::wstring& pipeName, const std::atomic<bool>& stop, int timeout = 0);
 
 
-    template <typename T = uint8_t>
-    void ReadFromPipeAsync(HANDLE hNamedPipe, const std::atomic<bool>& stop, std::vector<T>& outBuffer) {
-        try {
-            HELPERS_NS::ReadFileAsync<T>(hNamedPipe, stop, outBuffer, BUFFER_PIPE);
-        }
-        catch (const std::exception& ex) {
-            LOG_ERROR_D("Catch ReadFileAsync exception = {}", ex.what());
-            throw PipeError::ReadError;
-        }
-    }
-
-    template <typename T = uint8_t>
-    void WriteToPipeAsync(HANDLE hNamedPipe, const std::atomic<bool>& stop, std::span<T> writeData) {
-        if (writeData.empty())
-            return;
-
-        try {
-            HELPERS_NS::WriteFileAsync<T>(hNamedPipe, stop, writeData);
-        }
-        catch (const std::exception& ex) {
-            LOG_ERROR_D("Catch WriteFileAsync exception = {}", ex.what());
-            throw PipeError::WriteError;
-        }
-    }
-
-
     template<typename T>
     HELPERS_NS::LocalPtr<T> GetTokenInfo(HANDLE hToken, TOKEN_INFORMATION_CLASS typeInfo) {
         DWORD dwSize = 0;
@@ -81,44 +54,71 @@ namespace HELPERS_NS {
 
         return nullptr;
     }
+#endif
 
 
 
     // NOTE: EnumMsg must contain "Connect" msg and first "None" msg (fix in future)
     // TODO: Add guard for multiple calls pulbic methods and for usage in them in multithreading
     // TODO: fix when interrupt connection -> not process "None" msg (??? CHECK)
+    // NOTE: Named pipes are served by dedicated threads (read / channel / connect / interrupt),
+    //       event driven transports (see UnixSocketTransport) are served by a shared reactor thread,
+    //       so listenHandler / connectHandler / interruptHandler must not block it for a long time.
+    //       Writing from listenHandler to a peer served by the same reactor may block when socket buffer is full
+    //       (use separate reactors for both ends of in-process loopback).
     template<typename EnumMsg, typename T = uint8_t>
     class Channel : public HELPERS_NS::IThread {
         CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(Channel);
+        static_assert(std::is_enum_v<EnumMsg>, "EnumMsg must be an enum");
 
     public:
+        // 2 - 'type' is limited to 8 bits and validated on write (version 1 silently truncated it).
+        // Peers must use the same version: version 0 frames had 'uint32_t type' here (read as version 0),
+        // so frames of any other version are rejected instead of being misread.
+        static constexpr uint8_t wireVersion = 2;
+
 #pragma pack(push, 1)
         struct MessageDescriptor {
             uint32_t size = 0;
-            uint32_t type = 0;
+            uint8_t type = 0;
+            uint8_t version = wireVersion;
+            uint8_t lane = 0;
+            uint8_t flags = 0;
         };
 #pragma pack(pop)
 
+        enum DescriptorFlags : uint8_t {
+            ControlFrame = 0x01, // internal frame, 'type' is ControlType
+        };
+
+        enum class ControlType : uint8_t {
+            CreditGrant = 1, // payload is ChannelCreditGrant
+        };
+
         struct Message {
             EnumMsg type;
             std::vector<T> payload;
+            uint8_t lane = 0;
         };
 
-        struct MessageInternal {
-            MessageDescriptor descriptor;
-            Message message;
-            uint32_t processedBytes = 0;
+        // View over the channel read buffer, valid only inside the handler call.
+        struct MessageView {
+            EnumMsg type;
+            std::span<const T> payload;
+            uint8_t lane = 0;
         };
 
 
         using Msg_t = std::shared_ptr<Message>;
         using WriteFunc = std::function<void(EnumMsg, std::vector<T>&&)>;
+        using ListenHandler = std::function<bool(Msg_t, WriteFunc)>;
+        using MessageViewHandler = std::function<bool(const MessageView&, WriteFunc)>;
+        using Transport_t = std::shared_ptr<IChannelTransport<T>>;
 
         Channel()
             : messagesQueue{ std::make_shared<HELPERS_NS::ConcurrentQueue<Msg_t>>() }
         {
             LOG_FUNCTION_ENTER("Channel()");
-            this->readStreamBuffer.reserve(BUFFER_PIPE * 2); // reserve double size
         }
 
         ~Channel() {
@@ -126,6 +126,7 @@ namespace HELPERS_NS {
             this->StopChannel();
         }
 
+#ifdef _WIN32
         // Make security attributes to connect admin & user pipe
         void CreateForAdmin(const std::wstring& pipeName, std::function<bool(Msg_t, WriteFunc)> listenHandler, int timeout = 0) {
             LOG_FUNCTION_ENTER(L"CreateForAdmin(pipeName = {}, ...)", pipeName);
@@ -175,24 +176,27 @@ namespace HELPERS_NS {
             LOG_FUNCTION_ENTER(L"Create(pipeName = {}, listenHandler, timeout = {})", pipeName, timeout);
             this->pipeName = pipeName;
 
-            this->hNamedPipe = CreateNamedPipeW(
+            HANDLE hNamedPipe = CreateNamedPipeW(
                 pipeName.c_str(),
                 PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
                 PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
                 PIPE_UNLIMITED_INSTANCES,
                 BUFFER_PIPE * sizeof(T), BUFFER_PIPE * sizeof(T), 5000, pSecurityAttributes.get());
 
-            if (this->hNamedPipe == INVALID_HANDLE_VALUE) {
+            if (hNamedPipe == INVALID_HANDLE_VALUE) {
                 throw PipeError::InvalidHandle;
             }
 
+            auto pipeTransport = std::make_shared<NamedPipeTransport<T>>(hNamedPipe);
+            this->transport = pipeTransport;
+
             this->closeChannel = false;
-            this->threadChannel = std::thread([this, listenHandler, timeout, pipeName] {
+            this->threadChannel = std::thread([this, listenHandler, timeout, pipeName, pipeTransport] {
                 LOG_THREAD(this->pipeName + L" threadChannel Create");
 
                 while (!this->closeChannel) {
                     LOG_DEBUG("Waiting for connect...");
-                    auto status = WaitConnectPipe(this->hNamedPipe, this->closeChannel, timeout);
+                    auto status = WaitConnectPipe(pipeTransport->GetHandle(), this->closeChannel, timeout);
                     LOG_DEBUG("WaitConnectPipe status = {}", magic_enum::enum_name(status));
 
                     switch (status) {
@@ -209,7 +213,7 @@ namespace HELPERS_NS {
                     }
 
                     this->StopSecondThreads();
-                    DisconnectNamedPipe(hNamedPipe);
+                    DisconnectNamedPipe(pipeTransport->GetHandle());
                 }
                 });
         }
@@ -219,7 +223,8 @@ namespace HELPERS_NS {
             this->pipeName = pipeName;
 
             this->closeChannel = false;
-            auto status = WaitOpenPipe(this->hNamedPipe, pipeName, this->closeChannel, timeout);
+            HANDLE hNamedPipe = nullptr;
+            auto status = WaitOpenPipe(hNamedPipe, pipeName, this->closeChannel, timeout);
             LOG_DEBUG("WaitOpenPipe status = {}", magic_enum::enum_name(status));
 
             switch (status) {
@@ -233,8 +238,23 @@ namespace HELPERS_NS {
                 break;
             }
 
+            this->Listen(std::make_shared<NamedPipeTransport<T>>(hNamedPipe), listenHandler);
+        }
+#endif
+
+        // Start exchanging messages over already connected transport (socketpair, accepted socket, opened pipe, ...).
+        void Listen(Transport_t transport, ListenHandler listenHandler) {
+            LOG_FUNCTION_ENTER_C("Listen(transport, listenHandler)");
+            this->transport = transport;
+            this->closeChannel = false;
+
+            if (this->transport->IsEventDriven()) {
+                this->ListenEventDriven(listenHandler);
+                return;
+            }
+
             this->threadChannel = std::thread([this, listenHandler] {
-                LOG_THREAD(this->pipeName + L" threadChannel Open");
+                LOG_THREAD(this->pipeName + L" threadChannel Listen");
                 this->ListenRoutine(listenHandler);
                 });
         }
@@ -256,10 +276,10 @@ namespace HELPERS_NS {
                 this->threadChannel.join();
 
             this->StopSecondThreads();
+            this->WaitFinishEventDrivenListening();
 
-            if (this->hNamedPipe) {
-                CloseHandle(this->hNamedPipe);
-                this->hNamedPipe = nullptr;
+            if (this->transport) {
+                this->transport->Close();
             }
         }
 
@@ -275,27 +295,98 @@ namespace HELPERS_NS {
             this->connectHandler = handler;
         }
 
+        // If set, incoming messages are passed to this handler instead of listenHandler as views over the read buffer
+        // right on the reading thread (threadRead or reactor thread), without per message allocations and copies.
+        // Returning 'false' stops listening (like listenHandler). Must be set before Create / Open / Listen.
+        void SetMessageViewHandler(MessageViewHandler handler) {
+            this->messageViewHandler = handler;
+        }
+
+        // Max payload size (in T elements) of incoming messages, bigger message stops listening as a read error.
+        // Must be called before Create / Open / Listen.
+        void SetMaxMessageSize(std::size_t maxPayloadSize) {
+            LOG_FUNCTION_ENTER_C("SetMaxMessageSize(maxPayloadSize = {})", maxPayloadSize);
+            this->readBuffer.SetMaxPayloadSize(maxPayloadSize);
+        }
+
         void StopChannel() {
             LOG_FUNCTION_ENTER_C("StopChannel()");
             this->NotifyAboutStop();
             this->WaitingFinishThreads();
         }
 
+        // Configures lane (both sides must configure the same lanes, receiveWindow is advertised to the peer on connect).
+        // Write sends to lane 0, internal messages (Connect) are sent to lane 0 too. Must be called before Create / Open / Listen.
+        // With lanes the single writer sends queued messages of all lanes by weighted round-robin (coalescing is not used),
+        // so Write may return before the message was sent. Writer blocks while lane queue is full (out of peer credit),
+        // except writes from the reading thread (handlers), they are queued over capacity to not block receiving credits.
+        void SetLane(uint8_t lane, const ChannelLaneOptions& options) {
+            LOG_FUNCTION_ENTER_C("SetLane(lane = {}, weight = {}, queueCapacity = {}, receiveWindow = {})", lane, options.weight, options.queueCapacity, options.receiveWindow);
+            std::lock_guard lk{ mxLanes };
+            this->lanes.Configure(lane, options);
+            this->lanesEnabled = true;
+        }
+
         void Write(EnumMsg type, std::vector<T>&& writeData = {}) {
+            this->WriteToLane(0, type, std::move(writeData));
+        }
+
+        // Throws PipeError::WriteError if 'type' doesn't fit in MessageDescriptor::type (8 bits).
+        void WriteToLane(uint8_t lane, EnumMsg type, std::vector<T>&& writeData = {}) {
+            if (!IsWireMessageType(type)) {
+                LOG_ERROR_D("Message type = {} doesn't fit in descriptor", static_cast<int64_t>(type));
+                throw PipeError::WriteError;
+            }
+
             std::unique_lock lk{ mxWrite };
-            Message message{ type, std::move(writeData) };
+            Message message{ type, std::move(writeData), lane };
 
             if (!this->connected) {
                 this->pendingMessages.push_back(std::move(message));
                 return;
             }
 
+            if (this->lanesEnabled) {
+                lk.unlock(); // lanes writer locks mxWrite itself
+                this->EnqueueToLane(std::move(message));
+                this->WriteLanes();
+                return;
+            }
+
+            if (this->coalescingMaxBytes > 0) {
+                lk.unlock(); // batch flusher locks mxWrite itself
+                this->WriteCoalesced(message);
+                return;
+            }
+
             this->WriteInternal(message);
         }
 
+        // Opt-in: messages written concurrently (or during maxDelay) are coalesced and sent with one transport write
+        // up to maxBatchBytes (0 - disable). In this mode Write may return before the message was sent,
+        // use WaitFinishSendingMessage to wait for a specific message.
+        void SetWriteCoalescing(std::size_t maxBatchBytes, std::chrono::microseconds maxDelay = std::chrono::microseconds{ 0 }) {
+            LOG_FUNCTION_ENTER_C("SetWriteCoalescing(maxBatchBytes = {}, maxDelay = {}us)", maxBatchBytes, maxDelay.count());
+            std::lock_guard lk{ mxBatch };
+            this->coalescingMaxBytes = maxBatchBytes;
+            this->coalescingMaxDelay = maxDelay;
+        }
+
         void WritePendingMessages() {
             LOG_FUNCTION_ENTER_C("WritePendingMessages()");
-            std::lock_guard lk{ mxWrite };
+            std::unique_lock lk{ mxWrite };
+            if (this->lanesEnabled) {
+                auto messages = std::move(this->pendingMessages);
+                this->pendingMessages.clear();
+                lk.unlock();
+
+                for (auto& message : messages) {
+                    this->EnqueueToLane(std::move(message));
+                    this->WriteLanes();
+                }
+                return;
+            }
+
             for (auto& message : this->pendingMessages) {
                 if (!this->WriteInternal(message))
                     break;
@@ -318,8 +409,8 @@ namespace HELPERS_NS {
             );
             std::unique_lock lk{ mxWrite };
 
-            if (this->hNamedPipe == INVALID_HANDLE_VALUE) {
-                LOG_ERROR_D("hNamedPipe == INVALID_HANDLE_VALUE");
+            if (!this->transport || !this->transport->IsValid()) {
+                LOG_ERROR_D("transport is not valid");
                 return;
             }
 
@@ -330,6 +421,97 @@ namespace HELPERS_NS {
         }
 
     private:
+        void ListenEventDriven(ListenHandler listenHandler) {
+            LOG_FUNCTION_ENTER_C("ListenEventDriven(listenHandler)");
+
+            this->eventDrivenListenHandler = listenHandler;
+            this->listeningFinishedToken = std::make_shared<std::atomic<bool>>(false);
+            {
+                std::lock_guard lk{ mxListening };
+                this->eventDriven = true;
+                this->listeningFinished = false;
+            }
+
+            this->connected = true;
+            this->stopSignal = false;
+
+            this->transport->Post([this] { // Not block current thread to avoid deadlock
+                this->connectHandler();
+                });
+
+            this->AdvertiseReceiveWindows();
+            this->Write(EnumMsg::Connect);
+
+            this->transport->StartReading(
+                [this] {
+                    this->ReadEventDriven();
+                },
+                [this] {
+                    LOG_DEBUG_D("Transport closed, stop listening.");
+                    this->StopListening();
+                });
+        }
+
+        void ReadEventDriven() {
+            if (this->stopSignal) {
+                return;
+            }
+
+            try {
+                this->ReadMessages();
+            }
+            catch (PipeError error) {
+                LOG_ERROR_D("Catch PipeError = {}", magic_enum::enum_name(error));
+                this->StopListening();
+            }
+        }
+
+        // Unsubscribe from reactor and notify about interrupt on the reactor thread,
+        // because caller may hold mxWrite (WriteInternal) or be inside reactor handler.
+        void FinishEventDrivenListening() {
+            auto finishToken = this->listeningFinishedToken;
+            this->transport->Post([this, finishToken] {
+                if (finishToken->exchange(true)) {
+                    return; // already finished (or channel destroyed from reactor thread)
+                }
+                this->FinishEventDrivenListeningInternal();
+                });
+        }
+
+        void FinishEventDrivenListeningInternal() {
+            LOG_FUNCTION_ENTER_C("FinishEventDrivenListeningInternal()");
+            this->transport->StopReading();
+            this->interruptHandler();
+
+            LOG_DEBUG_D("Notify cvFinishSendingMessage");
+            this->cvFinishSendingMessage.notify_all();
+            this->connected = false;
+
+            std::lock_guard lk{ mxListening };
+            this->listeningFinished = true;
+            this->cvListeningFinished.notify_all();
+        }
+
+        void WaitFinishEventDrivenListening() {
+            if (!this->eventDriven) {
+                return;
+            }
+
+            if (this->transport->IsReactorThread()) {
+                // Posted finish callback can't be executed while we block reactor thread, so finish here
+                if (!this->listeningFinishedToken->exchange(true)) {
+                    this->FinishEventDrivenListeningInternal();
+                }
+            }
+            else {
+                std::unique_lock lk{ mxListening };
+                this->cvListeningFinished.wait(lk, [this] {
+                    return this->listeningFinished;
+                    });
+            }
+            this->eventDriven = false;
+        }
+
         void ListenRoutine(std::function<bool(Msg_t, WriteFunc)> listenHandler) {
             LOG_FUNCTION_ENTER_C("ListenRoutine(listenHandler)");
 
@@ -342,6 +524,7 @@ namespace HELPERS_NS {
                 this->connectHandler();
                 });
 
+            this->AdvertiseReceiveWindows();
             this->Write(EnumMsg::Connect);
 
             this->threadRead = std::thread([this] {
@@ -356,6 +539,7 @@ namespace HELPERS_NS {
                             this->StopListening();
                             LOG_DEBUG_D("listenHandler returned 'false', stop listening.");
                         }
+                        this->OnMessageConsumed(msg->lane, msg->payload.size());
                     }
                 }
             }
@@ -373,37 +557,12 @@ namespace HELPERS_NS {
 
         void ReadRoutine() {
             LOG_FUNCTION_ENTER_C("ReadRoutine()");
-            MessageInternal messageInternal;
+            this->readBuffer.Clear();
+            this->readThreadId = std::this_thread::get_id();
 
             try {
                 while (!this->stopSignal) {
-                    bool clearStreamBuffer = true;
-                    ReadFromPipeAsync<T>(this->hNamedPipe, this->stopSignal, this->readStreamBuffer);
-
-                    uint32_t processedBytes = 0;
-
-                    // TODO: Write tests for cases when 'while' really need (mb remove?) 
-                    while (processedBytes < this->readStreamBuffer.size()) {
-                        if (!this->ParseMessage(this->readStreamBuffer, processedBytes, messageInternal)) {
-                            clearStreamBuffer = false;
-                            break; // need more data to read descriptor (keep bytes in readStreamBuffer)
-                        }
-                        if (messageInternal.processedBytes == sizeof(MessageDescriptor) + messageInternal.descriptor.size) { // if message completed
-                            this->messagesQueue->Push(std::make_shared<Message>(Message{
-                                .type = static_cast<EnumMsg>(messageInternal.descriptor.type),
-                                .payload = std::move(messageInternal.message.payload)
-                                }));
-
-                            messageInternal = {};
-                        }
-                    }
-
-                    if (clearStreamBuffer) {
-                        // readStreamBuffer does not contain part of the next message
-                        // (even if it resized inside ReadFromPipeAsync), so cleansing is safe. 
-                        LOG_ASSERT(processedBytes == this->readStreamBuffer.size());
-                        this->readStreamBuffer.clear(); // can clear buffer because payload was saved/moved in messagesQueue
-                    }
+                    this->ReadMessages();
                 }
             }
             catch (PipeError error) {
@@ -418,58 +577,306 @@ namespace HELPERS_NS {
             }
         }
 
-        bool ParseMessage(std::vector<T>& readStreamBuffer, uint32_t& totalProcessedBytes, MessageInternal& messageInternal) {
-            bool descriptorWasRead = messageInternal.processedBytes >= sizeof(MessageDescriptor);
-            bool payloadWasRead = descriptorWasRead && messageInternal.processedBytes == sizeof(MessageDescriptor) + messageInternal.descriptor.size;
+        // Reads next chunk from transport and dispatches all completed messages.
+        void ReadMessages() {
+            this->transport->Read(this->stopSignal, this->readBuffer.PrepareForRead());
 
-            if (!descriptorWasRead) {
-                auto restStreamBytes = readStreamBuffer.size() - totalProcessedBytes;
-                if (restStreamBytes < sizeof(MessageDescriptor)) {
-                    readStreamBuffer.erase(readStreamBuffer.begin(), readStreamBuffer.begin() + totalProcessedBytes);
-                    totalProcessedBytes = readStreamBuffer.size();
-                    assert(restStreamBytes == totalProcessedBytes);
-                    return false;
+            // Incomplete message stays in readBuffer until the next read
+            while (auto frame = this->readBuffer.NextFrame()) {
+                if (frame->descriptor.version != wireVersion) {
+                    LOG_ERROR_D("Unsupported wire version = {} (expected {})", frame->descriptor.version, wireVersion);
+                    throw PipeError::ReadError;
+                }
+
+                if (frame->descriptor.flags & DescriptorFlags::ControlFrame) {
+                    this->HandleControlFrame(frame->descriptor, frame->payload);
+                    continue;
                 }
 
-                messageInternal.descriptor = *reinterpret_cast<MessageDescriptor*>(readStreamBuffer.data() + totalProcessedBytes);
-                messageInternal.processedBytes += sizeof(MessageDescriptor);
-                totalProcessedBytes += sizeof(MessageDescriptor);
+                this->DispatchMessage(MessageView{
+                    .type = static_cast<EnumMsg>(frame->descriptor.type),
+                    .payload = frame->payload,
+                    .lane = frame->descriptor.lane
+                    });
+
+                if (this->stopSignal) {
+                    break;
+                }
+            }
+
+            if (this->readBuffer.HasOversizedFrame()) {
+                LOG_ERROR_D("Message size exceeds max = {}", this->readBuffer.GetMaxPayloadSize());
+                throw PipeError::ReadError;
+            }
+        }
+
+        void DispatchMessage(const MessageView& messageView) {
+            if (this->messageViewHandler) {
+                if (this->messageViewHandler(messageView, this->bindedWriteFunc) == false) {
+                    LOG_DEBUG_D("messageViewHandler returned 'false', stop listening.");
+                    this->StopListening();
+                }
+                this->OnMessageConsumed(messageView.lane, messageView.payload.size());
+                return;
             }
 
-            if (!payloadWasRead) {
-                if (messageInternal.descriptor.size > 0) {
-                    auto remainingPayloadBytes = messageInternal.descriptor.size - messageInternal.message.payload.size();
-                    auto restStreamBytes = readStreamBuffer.size() - totalProcessedBytes;
-                    auto startIt = readStreamBuffer.begin() + totalProcessedBytes;
+            auto msg = std::make_shared<Message>(Message{
+                .type = messageView.type,
+                .payload = std::vector<T>(messageView.payload.begin(), messageView.payload.end()),
+                .lane = messageView.lane
+                });
+
+            if (!this->eventDriven) {
+                this->messagesQueue->Push(std::move(msg)); // consumed after listenHandler in ListenRoutine
+                return;
+            }
 
-                    auto readPayloadBytes = restStreamBytes < remainingPayloadBytes ? restStreamBytes : remainingPayloadBytes;
+            if (this->eventDrivenListenHandler(msg, this->bindedWriteFunc) == false) {
+                LOG_DEBUG_D("listenHandler returned 'false', stop listening.");
+                this->StopListening();
+            }
+            this->OnMessageConsumed(msg->lane, msg->payload.size());
+        }
 
-                    messageInternal.message.payload.insert(messageInternal.message.payload.end(), startIt, startIt + readPayloadBytes);
-                    messageInternal.processedBytes += readPayloadBytes;
-                    totalProcessedBytes += readPayloadBytes;
+        void HandleControlFrame(const MessageDescriptor& descriptor, std::span<const T> payload) {
+            switch (static_cast<ControlType>(descriptor.type)) {
+            case ControlType::CreditGrant: {
+                ChannelCreditGrant grant;
+                if (payload.size() * sizeof(T) < sizeof(grant)) {
+                    LOG_ERROR_D("Invalid credit grant frame");
+                    throw PipeError::ReadError;
+                }
+                std::memcpy(&grant, payload.data(), sizeof(grant));
+                {
+                    std::lock_guard lk{ mxLanes };
+                    this->lanes.OnCreditGranted(descriptor.lane, grant.limit);
                 }
+                this->WriteLanes(); // send messages waited for credit
+                break;
             }
 
-            return true;
+            default:
+                LOG_WARNING_D("Unknown control frame type = {}, skip", descriptor.type);
+                break;
+            }
+        }
+
+        static constexpr bool IsWireMessageType(EnumMsg type) {
+            using Underlying_t = std::underlying_type_t<EnumMsg>;
+            const auto value = static_cast<Underlying_t>(type);
+            if constexpr (std::is_signed_v<Underlying_t>) {
+                if (value < 0) {
+                    return false;
+                }
+            }
+            return static_cast<std::make_unsigned_t<Underlying_t>>(value) <= (std::numeric_limits<uint8_t>::max)();
+        }
+
+        // Wire format: [MessageDescriptor][payload]
+        void EncodeDescriptor(T(&descriptorBuffer)[sizeof(MessageDescriptor)], const MessageDescriptor& descriptor) {
+            std::memset(descriptorBuffer, 0, sizeof(descriptorBuffer));
+            std::memcpy(descriptorBuffer, &descriptor, sizeof(MessageDescriptor));
+        }
+
+        void EncodeDescriptor(T(&descriptorBuffer)[sizeof(MessageDescriptor)], const Message& message) {
+            this->EncodeDescriptor(descriptorBuffer, MessageDescriptor{
+                .size = static_cast<uint32_t>(message.payload.size()),
+                .type = static_cast<uint8_t>(message.type),
+                .lane = message.lane
+                });
         }
 
+        // Descriptor and payload are sent with one gather write, so they can't interleave with other writes.
         bool WriteInternal(Message& message) {
-            try {
-                MessageDescriptor msgDecriptor{ message.payload.size(), static_cast<uint8_t>(message.type) };
-                T messageSizeBuffer[sizeof(uint32_t)];
-                T messageTypeBuffer[sizeof(uint32_t)];
-                std::memcpy(&messageSizeBuffer, &msgDecriptor.size, sizeof(uint32_t));
-                std::memcpy(&messageTypeBuffer, &msgDecriptor.type, sizeof(uint32_t));
-
-                WriteToPipeAsync<T>(hNamedPipe, stopSignal, messageSizeBuffer);
-                WriteToPipeAsync<T>(hNamedPipe, stopSignal, messageTypeBuffer);
-                WriteToPipeAsync<T>(hNamedPipe, stopSignal, message.payload);
-
-                if (this->waitedMessage != EnumMsg::None && this->waitedMessage == message.type) {
-                    LOG_DEBUG_D("Notify cvFinishSendingMessage");
-                    this->cvFinishSendingMessage.notify_all();
+            T descriptorBuffer[sizeof(MessageDescriptor)];
+            this->EncodeDescriptor(descriptorBuffer, message);
+
+            const std::span<T> buffers[] = { descriptorBuffer, message.payload };
+            if (!this->WriteToTransport(buffers)) {
+                return false;
+            }
+
+            this->NotifyMessageSent(message.type);
+            return true;
+        }
+
+        // The first writer becomes flusher: it (optionally) lingers for coalescingMaxDelay and writes the whole batch,
+        // other writers just append their messages to the next batch meanwhile.
+        void WriteCoalesced(Message& message) {
+            std::unique_lock lk{ mxBatch };
+            const std::size_t frameSize = sizeof(MessageDescriptor) + message.payload.size();
+
+            // batchBuffer holds T elements, coalescingMaxBytes is in bytes
+            this->cvBatch.wait(lk, [this, frameSize] {
+                return this->stopSignal || this->batchBuffer.empty() || (this->batchBuffer.size() + frameSize) * sizeof(T) <= this->coalescingMaxBytes;
+                });
+            if (this->stopSignal) {
+                return;
+            }
+
+            T descriptorBuffer[sizeof(MessageDescriptor)];
+            this->EncodeDescriptor(descriptorBuffer, message);
+            this->batchBuffer.insert(this->batchBuffer.end(), std::begin(descriptorBuffer), std::end(descriptorBuffer));
+            this->batchBuffer.insert(this->batchBuffer.end(), message.payload.begin(), message.payload.end());
+            this->batchTypes.push_back(message.type);
+
+            if (this->batchFlushing) {
+                this->cvBatch.notify_all(); // wake up lingering flusher if batch is full
+                return;
+            }
+
+            this->batchFlushing = true;
+            if (this->coalescingMaxDelay.count() > 0) {
+                this->cvBatch.wait_for(lk, this->coalescingMaxDelay, [this] {
+                    return this->stopSignal || this->batchBuffer.size() * sizeof(T) >= this->coalescingMaxBytes;
+                    });
+            }
+
+            while (!this->batchBuffer.empty() && !this->stopSignal) {
+                std::swap(this->batchBuffer, this->flushingBuffer); // swap to reuse capacity of both buffers
+                std::swap(this->batchTypes, this->flushingTypes);
+                this->cvBatch.notify_all(); // batch is free again
+                lk.unlock();
+                {
+                    std::lock_guard lkWrite{ mxWrite };
+                    const std::span<T> buffers[] = { this->flushingBuffer };
+                    if (this->WriteToTransport(buffers)) {
+                        for (auto type : this->flushingTypes) {
+                            this->NotifyMessageSent(type);
+                        }
+                    }
+                }
+                this->flushingBuffer.clear();
+                this->flushingTypes.clear();
+                lk.lock();
+            }
+
+            if (this->stopSignal) {
+                this->batchBuffer.clear();
+                this->batchTypes.clear();
+            }
+            this->batchFlushing = false;
+        }
+
+        bool IsReadingThread() {
+            return std::this_thread::get_id() == this->readThreadId || (this->eventDriven && this->transport->IsReactorThread());
+        }
+
+        void EnqueueToLane(Message&& message) {
+            std::unique_lock lk{ mxLanes };
+            const bool readingThread = this->IsReadingThread();
+
+            this->cvLanes.wait(lk, [this, &message, readingThread] {
+                return this->stopSignal || readingThread || !this->lanes.IsFull(message.lane);
+                });
+            if (this->stopSignal) {
+                return;
+            }
+
+            const uint64_t cost = sizeof(MessageDescriptor) + message.payload.size();
+            this->lanes.Push(std::move(message), cost);
+        }
+
+        // Only one thread writes lanes at a time, others just return (their messages are sent by it).
+        // Messages picked by round-robin are sent in groups with one gather write.
+        void WriteLanes() {
+            static constexpr std::size_t maxGroupSize = 8;
+
+            std::unique_lock lk{ mxLanes };
+            if (this->lanesWriting) {
+                return;
+            }
+            this->lanesWriting = true;
+
+            std::vector<Message> messages;
+            while (!this->stopSignal) {
+                while (messages.size() < maxGroupSize) {
+                    auto message = this->lanes.PopNext();
+                    if (!message) {
+                        break;
+                    }
+                    messages.push_back(std::move(*message));
+                }
+                if (messages.empty()) {
+                    break;
                 }
 
+                this->cvLanes.notify_all(); // lanes have free space
+                lk.unlock();
+                {
+                    T descriptorBuffers[maxGroupSize][sizeof(MessageDescriptor)];
+                    std::span<T> buffers[maxGroupSize * 2];
+                    for (std::size_t i = 0; i < messages.size(); i++) {
+                        this->EncodeDescriptor(descriptorBuffers[i], messages[i]);
+                        buffers[i * 2] = descriptorBuffers[i];
+                        buffers[i * 2 + 1] = messages[i].payload;
+                    }
+
+                    std::lock_guard lkWrite{ mxWrite };
+                    if (this->WriteToTransport(std::span{ buffers, messages.size() * 2 })) {
+                        for (auto& message : messages) {
+                            this->NotifyMessageSent(message.type);
+                        }
+                    }
+                }
+                messages.clear();
+                lk.lock();
+            }
+            this->lanesWriting = false;
+        }
+
+        void AdvertiseReceiveWindows() {
+            if (!this->lanesEnabled) {
+                return;
+            }
+
+            std::vector<std::pair<uint8_t, uint64_t>> grants;
+            {
+                std::lock_guard lk{ mxLanes };
+                grants = this->lanes.ResetFlowControl();
+            }
+            for (auto& [lane, limit] : grants) {
+                this->WriteCreditGrant(lane, limit);
+            }
+        }
+
+        void OnMessageConsumed(uint8_t lane, std::size_t payloadSize) {
+            if (!this->lanesEnabled) {
+                return;
+            }
+
+            std::optional<uint64_t> limit;
+            {
+                std::lock_guard lk{ mxLanes };
+                limit = this->lanes.OnConsumed(lane, sizeof(MessageDescriptor) + payloadSize);
+            }
+            if (limit) {
+                this->WriteCreditGrant(lane, *limit);
+            }
+        }
+
+        // Control frames bypass lanes and credits.
+        void WriteCreditGrant(uint8_t lane, uint64_t limit) {
+            ChannelCreditGrant grant{ limit };
+            std::vector<T> payload((sizeof(grant) + sizeof(T) - 1) / sizeof(T));
+            std::memcpy(payload.data(), &grant, sizeof(grant));
+
+            T descriptorBuffer[sizeof(MessageDescriptor)];
+            this->EncodeDescriptor(descriptorBuffer, MessageDescriptor{
+                .size = static_cast<uint32_t>(payload.size()),
+                .type = static_cast<uint8_t>(ControlType::CreditGrant),
+                .lane = lane,
+                .flags = DescriptorFlags::ControlFrame
+                });
+
+            const std::span<T> buffers[] = { descriptorBuffer, payload };
+            std::lock_guard lk{ mxWrite };
+            this->WriteToTransport(buffers);
+        }
+
+        bool WriteToTransport(std::span<const std::span<T>> buffers) {
+            try {
+                this->transport->WriteGather(this->stopSignal, buffers);
                 return true;
             }
             catch (PipeError error) {
@@ -486,10 +893,31 @@ namespace HELPERS_NS {
             }
         }
 
+        // mxWrite must be locked
+        void NotifyMessageSent(EnumMsg type) {
+            if (this->waitedMessage != EnumMsg::None && this->waitedMessage == type) {
+                LOG_DEBUG_D("Notify cvFinishSendingMessage");
+                this->cvFinishSendingMessage.notify_all();
+            }
+        }
+
         void StopListening() {
             LOG_FUNCTION_ENTER_C("StopListening()");
             this->stopSignal = true;
             this->messagesQueue->StopWork();
+            {
+                std::lock_guard lk{ mxBatch }; // don't lose wakeup of writers waiting for batch space
+            }
+            this->cvBatch.notify_all();
+            {
+                std::lock_guard lk{ mxLanes };
+                this->lanes.Clear(); // messages not sent until disconnect are dropped like in-flight ones
+            }
+            this->cvLanes.notify_all();
+
+            if (this->eventDriven) {
+                this->FinishEventDrivenListening();
+            }
         }
 
         void StopSecondThreads() {
@@ -506,7 +934,7 @@ namespace HELPERS_NS {
 
     private:
         std::mutex mxWrite;
-        HANDLE hNamedPipe = nullptr;
+        Transport_t transport;
         std::thread threadRead;
         std::thread threadChannel;
         std::thread threadConnect;
@@ -518,11 +946,41 @@ namespace HELPERS_NS {
         std::function<void()> connectHandler = []() {};
         std::function<void()> interruptHandler = []() {};
         std::vector<Message> pendingMessages;
-        std::vector<T> readStreamBuffer;
+        FramedReadBuffer<T, MessageDescriptor> readBuffer{ BUFFER_PIPE * 2 }; // reserve double size
+        MessageViewHandler messageViewHandler;
 
         std::atomic<EnumMsg> waitedMessage = EnumMsg::None;
         std::condition_variable cvFinishSendingMessage;
+#ifdef _WIN32
         std::unique_ptr<SECURITY_ATTRIBUTES> pSecurityAttributes;
+#endif
+
+        // Write coalescing state
+        std::atomic<std::size_t> coalescingMaxBytes = 0;
+        std::chrono::microseconds coalescingMaxDelay{ 0 };
+        std::mutex mxBatch;
+        std::condition_variable cvBatch;
+        std::vector<T> batchBuffer;
+        std::vector<EnumMsg> batchTypes;
+        std::vector<T> flushingBuffer;
+        std::vector<EnumMsg> flushingTypes;
+        bool batchFlushing = false;
+
+        // Lanes state (see SetLane)
+        std::mutex mxLanes;
+        std::condition_variable cvLanes;
+        ChannelLanes<Message> lanes;
+        std::atomic<bool> lanesEnabled = false;
+        bool lanesWriting = false;
+        std::atomic<std::thread::id> readThreadId;
+
+        // Event driven transport state
+        std::atomic<bool> eventDriven = false;
+        ListenHandler eventDrivenListenHandler;
+        std::shared_ptr<std::atomic<bool>> listeningFinishedToken = std::make_shared<std::atomic<bool>>(true);
+        std::mutex mxListening;
+        std::condition_variable cvListeningFinished;
+        bool listeningFinished = true;
 
         const WriteFunc bindedWriteFunc = std::bind(&Channel::Write, this, std::placeholders::_1, std::placeholders::_2);
 
@@ -0,0 +1,144 @@
+#pragma once
+#include "common.h"
+#include <optional>
+#include <cstdint>
+#include <utility>
+#include <limits>
+#include <vector>
+#include <deque>
+
+namespace HELPERS_NS {
+    struct ChannelLaneOptions {
+        uint32_t weight = 1; // messages sent from the lane per round-robin round
+        std::size_t queueCapacity = 0; // max queued messages, writer blocks when reached (0 - unbounded)
+        // Max not consumed data (in T elements) peer may send to this lane (0 - no flow control).
+        // Both sides configure the same lanes, so it is also the initial send window until the peer's first grant.
+        uint64_t receiveWindow = 0;
+    };
+
+#pragma pack(push, 1)
+    // Payload of credit control frame: sender may start new message on the lane while its total sent data < limit.
+    struct ChannelCreditGrant {
+        uint64_t limit = 0;
+    };
+#pragma pack(pop)
+
+
+    // Send queues, weighted round-robin scheduling and credit accounting of Channel lanes.
+    // Messages of one lane are sent in FIFO order, lanes are served by turn (up to 'weight' messages per turn),
+    // so a long bulk transfer can't starve control messages of another lane.
+    // Not thread safe, Channel guards it with its own mutex.
+    template <typename MessageT>
+    class ChannelLanes {
+    public:
+        static constexpr uint64_t unlimited = (std::numeric_limits<uint64_t>::max)();
+
+        ChannelLanes()
+            : lanes(1) // lane 0 always exists
+        {}
+
+        void Configure(uint8_t laneId, const ChannelLaneOptions& options) {
+            auto& lane = this->GetLane(laneId);
+            lane.options = options;
+            if (lane.options.weight == 0) {
+                lane.options.weight = 1;
+            }
+        }
+
+        bool IsFull(uint8_t laneId) {
+            auto& lane = this->GetLane(laneId);
+            return lane.options.queueCapacity != 0 && lane.queue.size() >= lane.options.queueCapacity;
+        }
+
+        // 'cost' - frame size accounted by credits.
+        void Push(MessageT&& message, uint64_t cost) {
+            this->GetLane(message.lane).queue.emplace_back(std::move(message), cost);
+        }
+
+        // Returns next message allowed to be sent or nullopt if all lanes are empty or out of credit.
+        std::optional<MessageT> PopNext() {
+            for (std::size_t scanned = 0; scanned <= this->lanes.size(); scanned++) {
+                auto& lane = this->lanes[this->currentLane];
+                // Message started with any credit left may overrun the limit, so messages larger than window don't stuck
+                if (this->roundQuota > 0 && !lane.queue.empty() && lane.sent < lane.sendLimit) {
+                    this->roundQuota--;
+                    auto [message, cost] = std::move(lane.queue.front());
+                    lane.queue.pop_front();
+                    lane.sent += cost;
+                    return std::move(message);
+                }
+
+                this->currentLane = (this->currentLane + 1) % this->lanes.size();
+                this->roundQuota = this->lanes[this->currentLane].options.weight;
+            }
+            return std::nullopt;
+        }
+
+        void Clear() {
+            for (auto& lane : this->lanes) {
+                lane.queue.clear();
+            }
+        }
+
+        // Sender side: the peer granted credit for the lane.
+        void OnCreditGranted(uint8_t laneId, uint64_t limit) {
+            this->GetLane(laneId).sendLimit = limit;
+        }
+
+        // Receiver side: returns new limit which must be advertised to the peer (when half of window was consumed).
+        std::optional<uint64_t> OnConsumed(uint8_t laneId, uint64_t cost) {
+            auto& lane = this->GetLane(laneId);
+            lane.consumed += cost;
+
+            const uint64_t window = lane.options.receiveWindow;
+            if (window == 0 || lane.advertisedLimit - (std::min)(lane.consumed, lane.advertisedLimit) > window / 2) {
+                return std::nullopt;
+            }
+            lane.advertisedLimit = lane.consumed + window;
+            return lane.advertisedLimit;
+        }
+
+        // Resets counters of both sides on (re)connect and returns initial grants [lane, limit] for the peer.
+        std::vector<std::pair<uint8_t, uint64_t>> ResetFlowControl() {
+            std::vector<std::pair<uint8_t, uint64_t>> grants;
+            for (std::size_t i = 0; i < this->lanes.size(); i++) {
+                auto& lane = this->lanes[i];
+                lane.sent = 0;
+                // Don't send unlimited until the first grant: the peer advertises the same window on connect
+                lane.sendLimit = lane.options.receiveWindow != 0 ? lane.options.receiveWindow : unlimited;
+                lane.consumed = 0;
+                lane.advertisedLimit = lane.options.receiveWindow;
+                if (lane.options.receiveWindow != 0) {
+                    grants.emplace_back(static_cast<uint8_t>(i), lane.advertisedLimit);
+                }
+            }
+            return grants;
+        }
+
+    private:
+        struct Lane {
+            ChannelLaneOptions options;
+            std::deque<std::pair<MessageT, uint64_t>> queue;
+
+            // send side
+            uint64_t sent = 0;
+            uint64_t sendLimit = unlimited;
+
+            // receive side
+            uint64_t consumed = 0;
+            uint64_t advertisedLimit = 0;
+        };
+
+        Lane& GetLane(uint8_t laneId) {
+            if (laneId >= this->lanes.size()) {
+                this->lanes.resize(laneId + 1);
+            }
+            return this->lanes[laneId];
+        }
+
+    private:
+        std::vector<Lane> lanes;
+        std::size_t currentLane = 0;
+        uint32_t roundQuota = 0;
+    };
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include "common.h"
+#include "HWindows.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#include "File.h"
+#define BUFFER_PIPE READ_FILE_BUFFER_SIZE_DEFAULT
+#else
+#define BUFFER_PIPE 1024
+#endif
+
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <span>
+
+namespace HELPERS_NS {
+    enum class PipeConnectionStatus {
+        Error,
+        Stopped,
+        TimeoutConnection,
+        Connected,
+    };
+
+    enum class PipeError {
+        InvalidHandle,
+        WriteError,
+        ReadError,
+    };
+
+
+    // Byte stream used by Channel to exchange framed messages.
+    // Read / Write may be called concurrently from different threads (one reader and one writer),
+    // all errors are reported by throwing PipeError.
+    template <typename T = uint8_t>
+    class IChannelTransport {
+    public:
+        virtual ~IChannelTransport() = default;
+
+        virtual bool IsValid() = 0;
+
+        // Appends received data to outBuffer. Blocks until some data arrived or 'stop' was set.
+        virtual void Read(const std::atomic<bool>& stop, std::vector<T>& outBuffer) = 0;
+        virtual void Write(const std::atomic<bool>& stop, std::span<T> writeData) = 0;
+        virtual void Close() = 0;
+
+        // Writes all buffers as one piece (one syscall / one pipe message / one seqpacket record if transport supports it).
+        virtual void WriteGather(const std::atomic<bool>& stop, std::span<const std::span<T>> buffers) {
+            std::size_t totalSize = 0;
+            for (auto& buffer : buffers) {
+                totalSize += buffer.size();
+            }
+
+            std::vector<T> joinedBuffer;
+            joinedBuffer.reserve(totalSize);
+            for (auto& buffer : buffers) {
+                joinedBuffer.insert(joinedBuffer.end(), buffer.begin(), buffer.end());
+            }
+            this->Write(stop, joinedBuffer);
+        }
+
+        // Event driven transports notify about incoming data from a shared reactor thread,
+        // so Channel does not spawn read / listen / connect / interrupt threads for them.
+        // Read called inside 'readableHandler' must not block.
+        virtual bool IsEventDriven() {
+            return false;
+        }
+
+        virtual void StartReading(std::function<void()> /*readableHandler*/, std::function<void()> /*closedHandler*/) {
+        }
+
+        // After return 'readableHandler' is not executing anymore (except when called from the handler itself).
+        virtual void StopReading() {
+        }
+
+        // Executes callback on the transport's reactor thread (used to not block caller and avoid reentrance).
+        virtual void Post(std::function<void()> callback) {
+            callback();
+        }
+
+        virtual bool IsReactorThread() {
+            return false;
+        }
+    };
+
+
+#ifdef _WIN32
+    template <typename T = uint8_t>
+    void ReadFromPipeAsync(HANDLE hNamedPipe, const std::atomic<bool>& stop, std::vector<T>& outBuffer) {
+        try {
+            HELPERS_NS::ReadFileAsync<T>(hNamedPipe, stop, outBuffer, BUFFER_PIPE);
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR_D("Catch ReadFileAsync exception = {}", ex.what());
+            throw PipeError::ReadError;
+        }
+    }
+
+    template <typename T = uint8_t>
+    void WriteToPipeAsync(HANDLE hNamedPipe, const std::atomic<bool>& stop, std::span<T> writeData) {
+        if (writeData.empty())
+            return;
+
+        try {
+            HELPERS_NS::WriteFileAsync<T>(hNamedPipe, stop, writeData);
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR_D("Catch WriteFileAsync exception = {}", ex.what());
+            throw PipeError::WriteError;
+        }
+    }
+
+
+    // Overlapped named pipe (server or client side). Owns the handle.
+    template <typename T = uint8_t>
+    class NamedPipeTransport : public IChannelTransport<T> {
+    public:
+        NamedPipeTransport(HANDLE hNamedPipe)
+            : hNamedPipe{ hNamedPipe }
+        {}
+
+        ~NamedPipeTransport() {
+            this->Close();
+        }
+
+        NamedPipeTransport(const NamedPipeTransport&) = delete;
+        NamedPipeTransport& operator=(const NamedPipeTransport&) = delete;
+
+        HANDLE GetHandle() {
+            return this->hNamedPipe;
+        }
+
+        bool IsValid() override {
+            return this->hNamedPipe && this->hNamedPipe != INVALID_HANDLE_VALUE;
+        }
+
+        void Read(const std::atomic<bool>& stop, std::vector<T>& outBuffer) override {
+            ReadFromPipeAsync<T>(this->hNamedPipe, stop, outBuffer);
+        }
+
+        void Write(const std::atomic<bool>& stop, std::span<T> writeData) override {
+            WriteToPipeAsync<T>(this->hNamedPipe, stop, writeData);
+        }
+
+        void Close() override {
+            if (this->IsValid()) {
+                CloseHandle(this->hNamedPipe);
+            }
+            this->hNamedPipe = nullptr;
+        }
+
+    private:
+        HANDLE hNamedPipe = nullptr;
+    };
+#endif
+}
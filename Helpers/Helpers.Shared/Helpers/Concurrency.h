@@ -8,15 +8,34 @@
 #include <optional>
 #include <utility>
 #include <cassert>
+#include <cstddef>
 #include <chrono>
+#include <thread>
 #include <mutex>
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 namespace CV {
     inline constexpr bool WAIT = false;
     inline constexpr bool NO_WAIT = true;
 }
 
 namespace HELPERS_NS {
+    // Fixed instead of std::hardware_destructive_interference_size, which differs between compilers (ABI warning).
+    inline constexpr std::size_t cacheLineSize = 64;
+
+    // Hint for busy-wait loops (lets sibling hyper-thread run, lowers power).
+    inline void CpuRelax() {
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+
     namespace detail {
         template <typename Callback>
         using CallbackResultT = std::invoke_result_t<Callback&>;
@@ -5,7 +5,19 @@
 #include "Logger.h"
 
 #include <condition_variable>
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <cstdint>
+#include <utility>
+#include <limits>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
 #include <queue>
+#include <new>
 #include <mutex>
 
 namespace HELPERS_NS {
@@ -20,7 +32,13 @@ namespace HELPERS_NS {
 		SkipWhenQueueSizeGreaterThanOrEqualBuffer,
 	};
 
-	template<class T>
+	enum class ConcurrentQueueImpl {
+		Mutex, // std::queue guarded by mutex
+		LockFreeRing, // bounded MPMC ring with per slot sequences (D. Vyukov), see specialization below
+		SpscRing, // bounded wait-free ring for one producer and one consumer thread
+	};
+
+	template<class T, ConcurrentQueueImpl impl = ConcurrentQueueImpl::Mutex>
 	class ConcurrentQueue {
 		CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(ConcurrentQueue);
 
@@ -105,9 +123,59 @@ namespace HELPERS_NS {
 			return res;
 		}
 
+		// Items are moved from the range, lock is taken and consumers are notified once per batch instead of once per item.
+		template <typename InputIt>
+		void PushRange(InputIt first, InputIt last) {
+			std::unique_lock lk(mx);
+			while (first != last && working) {
+				if (IsQueueBufferExceeded()) {
+					if (behaviour == ConcurrentQueueBehaviour::SkipWhenQueueSizeGreaterThanOrEqualBuffer) {
+						break; // ignore the rest of range
+					}
+					cv.notify_all(); // let consumers take already pushed part
+					cv.wait(lk, [this] {
+						return !working || !IsQueueBufferExceeded();
+						});
+					continue;
+				}
+
+				items.push(std::move(*first));
+				++first;
+			}
+			lk.unlock();
+			cv.notify_all(); // cv is shared by producers and consumers, so notify_one may wake wrong side
+		}
+
+		// Waits up to 'timeout' for at least one item and appends up to 'maxCount' items to 'out'.
+		// Returns count of popped items (0 - timeout or work was stopped).
+		template <typename Rep, typename Period>
+		std::size_t PopBulk(std::vector<T>& out, std::size_t maxCount, std::chrono::duration<Rep, Period> timeout) {
+			std::unique_lock lk(mx);
+			cv.wait_for(lk, timeout, [this] {
+				return !working || !items.empty();
+				});
+
+			std::size_t count = 0;
+			while (working && count < maxCount && !items.empty()) {
+				out.push_back(std::move(items.front()));
+				items.pop();
+				count++;
+			}
+			lk.unlock();
+
+			if (count > 0) {
+				cv.notify_all(); // signal to can push several items if queue was overflow before
+			}
+			return count;
+		}
+
 		void StopWork() {
-			working = false;
-			cv.notify_one();
+			{
+				// under lock: waiter may check 'working' in predicate and block right after we notified
+				std::lock_guard lk(mx);
+				working = false;
+			}
+			cv.notify_all(); // wake all consumers and producers
 		}
 
 		void StartWork() {
@@ -147,4 +215,444 @@ namespace HELPERS_NS {
 		uint32_t bufferSize = 200000;
 		ConcurrentQueueBehaviour behaviour = ConcurrentQueueBehaviour::WaitWhenQueueSizeGreaterThanOrEqualBuffer;
 	};
+
+
+	namespace details {
+		// Threads of one side (producers or consumers) park here until the other side makes progress.
+		// Parked thread rechecks state after it was counted, and the other side checks the counter after
+		// its change (fence in WakeOne), so one of them sees the other and wakeup can't be lost.
+		// Mutex is touched only when somebody is parked, so it doesn't slow down lock-free fast path.
+		// Only one wakeup is in flight at a time (like glibc condition_variable), so a burst of pushes
+		// doesn't issue a syscall per item, woken thread passes wakeup on if there is more work.
+		class ParkingSpot {
+		public:
+			template <typename ReadyPredicate>
+			void Park(ReadyPredicate ready, std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt) {
+				this->state.fetch_add(1);
+				{
+					std::unique_lock lk{ mx };
+					auto observedEpoch = this->epoch;
+					if (!ready()) {
+						auto epochChanged = [this, observedEpoch] {
+							return this->epoch != observedEpoch;
+						};
+						if (deadline) {
+							this->cv.wait_until(lk, *deadline, epochChanged);
+						}
+						else {
+							this->cv.wait(lk, epochChanged);
+						}
+					}
+				}
+
+				// Leave and clear pending wakeup together, so it can't be set after we left with nobody to clear it
+				uint32_t current = this->state.load();
+				while (!this->state.compare_exchange_weak(current, (current & ~wakePendingBit) - 1)) {
+				}
+			}
+
+			void WakeOne() {
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				uint32_t current = this->state.load();
+				while ((current & ~wakePendingBit) != 0 && (current & wakePendingBit) == 0) {
+					if (this->state.compare_exchange_weak(current, current | wakePendingBit)) {
+						this->Notify(false);
+						return;
+					}
+				}
+			}
+
+			void WakeAll() {
+				this->Notify(true);
+			}
+
+		private:
+			void Notify(bool all) {
+				{
+					std::lock_guard lk{ mx };
+					this->epoch++;
+				}
+				if (all) {
+					this->cv.notify_all();
+				}
+				else {
+					this->cv.notify_one();
+				}
+			}
+
+		private:
+			static constexpr uint32_t wakePendingBit = 1u << 31;
+
+			std::atomic<uint32_t> state = 0; // parked threads count | wakePendingBit
+			std::mutex mx;
+			std::condition_variable cv;
+			uint32_t epoch = 0;
+		};
+
+
+		// Blocking part of ring based queues (Wait / Skip behaviour, spin then park) built on Derived non-blocking primitives:
+		//   std::size_t TryPushRange(InputIt& first, std::size_t count) - moves up to 'count' items, advances 'first'
+		//   std::size_t TryPopRange(OutputIt& out, std::size_t maxCount)
+		//   bool CanPush(), bool CanPop(), int ItemsCount(), void Allocate(uint32_t size)
+		// NOTE: capacity is bufferSize rounded up to power of two and preallocated,
+		//       so SetBufferSize must be called while queue is not used by other threads.
+		template <typename Derived, typename T>
+		class RingQueueBase {
+		public:
+			static constexpr uint32_t defaultBufferSize = 4096;
+			static constexpr int spinCount = 128; // on single core spinning only delays the thread we are waiting for
+
+			void Push(T&& item) {
+				if constexpr (std::is_same_v<T, TaskItemWithDescription>) {
+					LOG_FUNCTION_ENTER_S(this->Self().__LgCtx(), "Push(item) <{}>", item.descrtiption);
+				}
+				T* first = &item;
+				this->PushRangeInternal(first, 1);
+			}
+
+			// Items are moved from the range, consumers are woken once per batch instead of once per item.
+			template <typename InputIt>
+			void PushRange(InputIt first, InputIt last) {
+				this->PushRangeInternal(first, static_cast<std::size_t>(std::distance(first, last)));
+			}
+
+			T Pop() {
+				T item{};
+				T* out = &item;
+				this->PopRangeInternal(out, 1, std::nullopt);
+
+				if constexpr (std::is_same_v<T, TaskItemWithDescription>) {
+					LOG_FUNCTION_ENTER_S(this->Self().__LgCtx(), "Pop() <{}>", item.descrtiption);
+				}
+				return item; // default T{} if work was stopped
+			}
+
+			// Waits up to 'timeout' for at least one item and appends up to 'maxCount' items to 'out'.
+			// Returns count of popped items (0 - timeout or work was stopped).
+			template <typename Rep, typename Period>
+			std::size_t PopBulk(std::vector<T>& out, std::size_t maxCount, std::chrono::duration<Rep, Period> timeout) {
+				auto outIt = std::back_inserter(out);
+				if (timeout.count() <= 0) {
+					return this->PopRangeInternal(outIt, maxCount, std::chrono::steady_clock::now());
+				}
+				return this->PopRangeInternal(outIt, maxCount, std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+			}
+
+			void StopWork() {
+				this->working = false;
+				this->consumers.WakeAll();
+				this->producers.WakeAll();
+			}
+
+			void StartWork() {
+				this->working = true;
+			}
+
+			bool IsWorking() {
+				return this->working;
+			}
+
+			bool HasItems() {
+				return this->Self().ItemsCount() > 0;
+			}
+
+			// Queued items are kept (if they fit new capacity).
+			void SetBufferSize(const uint32_t size, ConcurrentQueueBehaviour behaviour = ConcurrentQueueBehaviour::WaitWhenQueueSizeGreaterThanOrEqualBuffer) {
+				this->behaviour = behaviour;
+
+				std::vector<T> items;
+				auto itemsIt = std::back_inserter(items);
+				while (this->Self().TryPopRange(itemsIt, (std::numeric_limits<std::size_t>::max)()) > 0) {
+				}
+
+				this->Self().Allocate(size);
+				auto first = items.begin();
+				this->Self().TryPushRange(first, items.size());
+			}
+
+		protected:
+			Derived& Self() {
+				return static_cast<Derived&>(*this);
+			}
+
+			template <typename InputIt>
+			void PushRangeInternal(InputIt& first, std::size_t count) {
+				bool wasParked = false;
+				for (int spin = 0; this->working && count > 0; spin++) {
+					if (std::size_t pushed = this->Self().TryPushRange(first, count)) {
+						count -= pushed;
+						spin = 0;
+						this->consumers.WakeOne();
+						continue;
+					}
+
+					if (this->behaviour == ConcurrentQueueBehaviour::SkipWhenQueueSizeGreaterThanOrEqualBuffer) {
+						return; // ignore push (the rest of range)
+					}
+
+					if (spin < this->maxSpins) {
+						HELPERS_NS::CpuRelax();
+						continue;
+					}
+					this->producers.Park([this] {
+						return !this->working || this->Self().CanPush();
+						});
+					wasParked = true;
+				}
+
+				if (wasParked && this->Self().CanPush()) {
+					this->producers.WakeOne(); // pass wakeup on, other slots may be freed while we were waking up
+				}
+			}
+
+			template <typename OutputIt>
+			std::size_t PopRangeInternal(OutputIt& out, std::size_t maxCount, std::optional<std::chrono::steady_clock::time_point> deadline) {
+				bool wasParked = false;
+				for (int spin = 0; this->working; spin++) {
+					if (std::size_t popped = this->Self().TryPopRange(out, maxCount)) {
+						this->producers.WakeOne();
+						if (wasParked && this->Self().CanPop()) {
+							this->consumers.WakeOne(); // pass wakeup on, other items may be pushed while we were waking up
+						}
+						return popped;
+					}
+
+					if (spin < this->maxSpins) {
+						HELPERS_NS::CpuRelax();
+						continue;
+					}
+					if (deadline && std::chrono::steady_clock::now() >= *deadline) {
+						break;
+					}
+					this->consumers.Park([this] {
+						return !this->working || this->Self().CanPop();
+						}, deadline);
+					wasParked = true;
+				}
+				return 0;
+			}
+
+		protected:
+			std::atomic<bool> working = true;
+			ConcurrentQueueBehaviour behaviour = ConcurrentQueueBehaviour::WaitWhenQueueSizeGreaterThanOrEqualBuffer;
+			const int maxSpins = std::thread::hardware_concurrency() > 1 ? spinCount : 0;
+
+			alignas(HELPERS_NS::cacheLineSize) ParkingSpot consumers;
+			alignas(HELPERS_NS::cacheLineSize) ParkingSpot producers;
+		};
+	}
+
+
+	// Lock-free MPMC variant: Push / Pop claims ring positions with one CAS per batch plus handoff through slot sequences, without allocations.
+	template<class T>
+	class ConcurrentQueue<T, ConcurrentQueueImpl::LockFreeRing> : public details::RingQueueBase<ConcurrentQueue<T, ConcurrentQueueImpl::LockFreeRing>, T> {
+		CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(ConcurrentQueue);
+		friend details::RingQueueBase<ConcurrentQueue, T>;
+
+	public:
+		ConcurrentQueue() {
+			this->Allocate(this->defaultBufferSize);
+		}
+		~ConcurrentQueue() {
+			this->DestroyItems();
+		}
+
+		ConcurrentQueue(const ConcurrentQueue& other) = delete;
+
+		// Approximate when queue is used concurrently.
+		int ItemsCount() {
+			auto dequeuePos = this->dequeuePos.load(std::memory_order_relaxed);
+			auto enqueuePos = this->enqueuePos.load(std::memory_order_relaxed);
+			return enqueuePos > dequeuePos ? static_cast<int>(enqueuePos - dequeuePos) : 0;
+		}
+
+	private:
+		struct Cell {
+			std::atomic<std::size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			T* Item() {
+				return std::launder(reinterpret_cast<T*>(this->storage));
+			}
+		};
+
+		void Allocate(uint32_t size) {
+			std::size_t capacity = 1;
+			while (capacity < size) {
+				capacity <<= 1;
+			}
+
+			this->cells = std::make_unique<Cell[]>(capacity);
+			for (std::size_t i = 0; i < capacity; i++) {
+				this->cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			this->mask = capacity - 1;
+			this->enqueuePos.store(0, std::memory_order_relaxed);
+			this->dequeuePos.store(0, std::memory_order_relaxed);
+		}
+
+		void DestroyItems() {
+			T item{};
+			for (T* out = &item; this->TryPopRange(out, 1) > 0; out = &item) {
+			}
+		}
+
+		// Batch is claimed with one CAS of enqueuePos, then items are moved in and published cell by cell.
+		template <typename InputIt>
+		std::size_t TryPushRange(InputIt& first, std::size_t count) {
+			auto [pos, claimed] = this->ClaimRange(this->enqueuePos, count, 0);
+			for (std::size_t i = 0; i < claimed; i++, ++first) {
+				Cell& cell = this->cells[(pos + i) & this->mask];
+				new (cell.storage) T(std::move(*first));
+				cell.sequence.store(pos + i + 1, std::memory_order_release);
+			}
+			return claimed;
+		}
+
+		template <typename OutputIt>
+		std::size_t TryPopRange(OutputIt& out, std::size_t maxCount) {
+			auto [pos, claimed] = this->ClaimRange(this->dequeuePos, maxCount, 1);
+			for (std::size_t i = 0; i < claimed; i++, ++out) {
+				Cell& cell = this->cells[(pos + i) & this->mask];
+				*out = std::move(*cell.Item());
+				cell.Item()->~T();
+				cell.sequence.store(pos + i + this->mask + 1, std::memory_order_release); // free for the next lap
+			}
+			return claimed;
+		}
+
+		// Slot is free for position 'pos' when its sequence == pos, and filled when sequence == pos + 1.
+		// Claims up to 'maxCount' consecutive positions whose cells are ready (sequence == pos + readyOffset)
+		// and returns [first position, count], count == 0 - ring is full (push) / empty (pop).
+		// Ready cells after the first one can be taken only by the owner of their position, and nobody owns them
+		// while 'position' == pos, so the count checked before CAS is still valid when CAS succeeds.
+		std::pair<std::size_t, std::size_t> ClaimRange(std::atomic<std::size_t>& position, std::size_t maxCount, std::size_t readyOffset) {
+			std::size_t pos = position.load(std::memory_order_relaxed);
+			while (maxCount > 0) {
+				auto diff = static_cast<std::intptr_t>(this->cells[pos & this->mask].sequence.load(std::memory_order_acquire)) - static_cast<std::intptr_t>(pos + readyOffset);
+				if (diff < 0) {
+					break;
+				}
+				if (diff > 0) {
+					pos = position.load(std::memory_order_relaxed); // 'pos' was claimed by other thread
+					continue;
+				}
+
+				std::size_t count = 1;
+				while (count < maxCount && this->cells[(pos + count) & this->mask].sequence.load(std::memory_order_acquire) == pos + count + readyOffset) {
+					count++;
+				}
+				if (position.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+					return { pos, count };
+				}
+			}
+			return { pos, 0 };
+		}
+
+		bool CanPush() {
+			std::size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+			return this->cells[pos & this->mask].sequence.load(std::memory_order_acquire) >= pos;
+		}
+
+		bool CanPop() {
+			std::size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+			return this->cells[pos & this->mask].sequence.load(std::memory_order_acquire) >= pos + 1;
+		}
+
+	private:
+		std::unique_ptr<Cell[]> cells;
+		std::size_t mask = 0;
+
+		alignas(HELPERS_NS::cacheLineSize) std::atomic<std::size_t> enqueuePos = 0;
+		alignas(HELPERS_NS::cacheLineSize) std::atomic<std::size_t> dequeuePos = 0;
+	};
+
+
+	// Wait-free single producer / single consumer variant: each side owns its index (on separate cache lines)
+	// and keeps a cached copy of the other side index, which is reloaded only when ring looks full / empty.
+	// Ranges are published with one index store.
+	// NOTE: only one thread may push and only one thread may pop at a time.
+	template<class T>
+	class ConcurrentQueue<T, ConcurrentQueueImpl::SpscRing> : public details::RingQueueBase<ConcurrentQueue<T, ConcurrentQueueImpl::SpscRing>, T> {
+		CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(ConcurrentQueue);
+		friend details::RingQueueBase<ConcurrentQueue, T>;
+
+	public:
+		ConcurrentQueue() {
+			this->Allocate(this->defaultBufferSize);
+		}
+		~ConcurrentQueue() = default;
+
+		ConcurrentQueue(const ConcurrentQueue& other) = delete;
+
+		// Approximate when queue is used concurrently.
+		int ItemsCount() {
+			auto head = this->head.load(std::memory_order_relaxed);
+			auto tail = this->tail.load(std::memory_order_relaxed);
+			return tail > head ? static_cast<int>(tail - head) : 0;
+		}
+
+	private:
+		void Allocate(uint32_t size) {
+			std::size_t capacity = 1;
+			while (capacity < size) {
+				capacity <<= 1;
+			}
+
+			this->slots = std::make_unique<T[]>(capacity);
+			this->mask = capacity - 1;
+			this->head.store(0, std::memory_order_relaxed);
+			this->tail.store(0, std::memory_order_relaxed);
+			this->producerCachedHead = 0;
+			this->consumerCachedTail = 0;
+		}
+
+		template <typename InputIt>
+		std::size_t TryPushRange(InputIt& first, std::size_t count) {
+			const std::size_t tail = this->tail.load(std::memory_order_relaxed);
+			if (this->mask + 1 - (tail - this->producerCachedHead) < count) {
+				this->producerCachedHead = this->head.load(std::memory_order_acquire);
+			}
+
+			std::size_t pushCount = (std::min)(count, this->mask + 1 - (tail - this->producerCachedHead));
+			for (std::size_t i = 0; i < pushCount; i++, ++first) {
+				this->slots[(tail + i) & this->mask] = std::move(*first);
+			}
+			this->tail.store(tail + pushCount, std::memory_order_release);
+			return pushCount;
+		}
+
+		template <typename OutputIt>
+		std::size_t TryPopRange(OutputIt& out, std::size_t maxCount) {
+			const std::size_t head = this->head.load(std::memory_order_relaxed);
+			if (this->consumerCachedTail - head < maxCount) {
+				this->consumerCachedTail = this->tail.load(std::memory_order_acquire);
+			}
+
+			std::size_t popCount = (std::min)(maxCount, this->consumerCachedTail - head);
+			for (std::size_t i = 0; i < popCount; i++, ++out) {
+				*out = std::move(this->slots[(head + i) & this->mask]);
+			}
+			this->head.store(head + popCount, std::memory_order_release);
+			return popCount;
+		}
+
+		bool CanPush() {
+			return this->tail.load(std::memory_order_relaxed) - this->head.load(std::memory_order_acquire) <= this->mask;
+		}
+
+		bool CanPop() {
+			return this->tail.load(std::memory_order_acquire) != this->head.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::unique_ptr<T[]> slots;
+		std::size_t mask = 0;
+
+		alignas(HELPERS_NS::cacheLineSize) std::atomic<std::size_t> tail = 0; // written by producer
+		std::size_t producerCachedHead = 0;
+
+		alignas(HELPERS_NS::cacheLineSize) std::atomic<std::size_t> head = 0; // written by consumer
+		std::size_t consumerCachedTail = 0;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "EpollReactor.h"
+#if defined(__linux__)
+#include "Logger.h"
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+
+namespace HELPERS_NS {
+    EpollReactor::EpollReactor() {
+        this->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (this->epollFd < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+
+        this->wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (this->wakeupFd < 0) {
+            auto err = errno;
+            ::close(this->epollFd);
+            throw std::system_error(err, std::generic_category(), "eventfd");
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = this->wakeupFd;
+        ::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->wakeupFd, &ev);
+
+        this->reactorThread = std::thread([this] {
+            // set by the thread itself, handlers may run (and call IsReactorThread) before std::thread ctor returns
+            this->reactorThreadId = std::this_thread::get_id();
+            LOG_THREAD(L"EpollReactor");
+            this->Run();
+            });
+    }
+
+    EpollReactor::~EpollReactor() {
+        this->stop = true;
+        this->Wakeup();
+        LOG_ASSERT(!this->IsReactorThread(), "Reactor must not be released from its own handler");
+        if (this->reactorThread.joinable()) {
+            this->reactorThread.join();
+        }
+        ::close(this->wakeupFd);
+        ::close(this->epollFd);
+    }
+
+    std::shared_ptr<EpollReactor> EpollReactor::GetDefault() {
+        static auto defaultReactor = std::make_shared<EpollReactor>(); // lives until process exit
+        return defaultReactor;
+    }
+
+    void EpollReactor::Add(int fd, uint32_t events, Handler handler) {
+        std::lock_guard lk{ mx };
+        this->handlers[fd] = std::make_shared<Handler>(std::move(handler));
+
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            auto err = errno;
+            this->handlers.erase(fd);
+            throw std::system_error(err, std::generic_category(), "epoll_ctl(EPOLL_CTL_ADD)");
+        }
+    }
+
+    void EpollReactor::Remove(int fd) {
+        std::unique_lock lk{ mx };
+        if (this->handlers.erase(fd) == 0) {
+            return;
+        }
+        ::epoll_ctl(this->epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+        if (!this->IsReactorThread()) {
+            this->cvDispatchFinished.wait(lk, [this, fd] {
+                return this->dispatchingFd != fd;
+                });
+        }
+    }
+
+    void EpollReactor::Post(std::function<void()> callback) {
+        {
+            std::lock_guard lk{ mx };
+            this->postedCallbacks.push_back(std::move(callback));
+        }
+        this->Wakeup();
+    }
+
+    bool EpollReactor::IsReactorThread() const {
+        return std::this_thread::get_id() == this->reactorThreadId;
+    }
+
+
+    void EpollReactor::Run() {
+        constexpr int maxEvents = 64;
+        epoll_event events[maxEvents];
+
+        while (!this->stop) {
+            int count = ::epoll_wait(this->epollFd, events, maxEvents, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERROR_D("epoll_wait error = {}", errno);
+                break;
+            }
+
+            for (int i = 0; i < count && !this->stop; i++) {
+                int fd = events[i].data.fd;
+                if (fd == this->wakeupFd) {
+                    uint64_t counter = 0;
+                    while (::read(this->wakeupFd, &counter, sizeof(counter)) > 0) {
+                    }
+                    continue;
+                }
+
+                std::shared_ptr<Handler> handler;
+                {
+                    std::lock_guard lk{ mx };
+                    auto it = this->handlers.find(fd);
+                    if (it == this->handlers.end()) {
+                        continue; // removed while we were dispatching previous events
+                    }
+                    handler = it->second;
+                    this->dispatchingFd = fd;
+                }
+
+                (*handler)(events[i].events);
+
+                {
+                    std::lock_guard lk{ mx };
+                    this->dispatchingFd = -1;
+                }
+                this->cvDispatchFinished.notify_all();
+            }
+
+            this->ExecutePostedCallbacks();
+        }
+    }
+
+    void EpollReactor::Wakeup() {
+        uint64_t one = 1;
+        [[maybe_unused]] auto res = ::write(this->wakeupFd, &one, sizeof(one));
+    }
+
+    void EpollReactor::ExecutePostedCallbacks() {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard lk{ mx };
+            callbacks.swap(this->postedCallbacks);
+        }
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+}
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+#include "common.h"
+#if defined(__linux__)
+#include <unordered_map>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+namespace HELPERS_NS {
+    // Single thread epoll loop that multiplexes many file descriptors.
+    // Handlers are executed on the reactor thread, so they must not block for a long time
+    // (create several reactors to shard connections if needed).
+    class EpollReactor {
+    public:
+        using Handler = std::function<void(uint32_t events)>;
+
+        EpollReactor();
+        ~EpollReactor();
+
+        EpollReactor(const EpollReactor&) = delete;
+        EpollReactor& operator=(const EpollReactor&) = delete;
+
+        // Process wide reactor shared by all event driven transports by default.
+        static std::shared_ptr<EpollReactor> GetDefault();
+
+        // fd must be non-blocking, 'events' is EPOLLIN / EPOLLOUT / ... mask.
+        void Add(int fd, uint32_t events, Handler handler);
+
+        // When called outside of the reactor thread waits until handler of this fd finishes.
+        void Remove(int fd);
+
+        // Executes callback on the reactor thread after the current dispatch iteration.
+        void Post(std::function<void()> callback);
+
+        bool IsReactorThread() const;
+
+    private:
+        void Run();
+        void Wakeup();
+        void ExecutePostedCallbacks();
+
+    private:
+        int epollFd = -1;
+        int wakeupFd = -1;
+
+        std::mutex mx;
+        std::condition_variable cvDispatchFinished;
+        std::unordered_map<int, std::shared_ptr<Handler>> handlers;
+        std::vector<std::function<void()>> postedCallbacks;
+        int dispatchingFd = -1;
+
+        std::atomic<bool> stop = false;
+        std::atomic<std::thread::id> reactorThreadId;
+        std::thread reactorThread;
+    };
+}
+#endif
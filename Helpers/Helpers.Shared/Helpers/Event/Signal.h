@@ -3,12 +3,13 @@
 #include "Helpers/TokenContext.hpp"
 #include "IEvent.h"
 
-#include <unordered_map>
-#include <unordered_set>
 #include <type_traits>
 #include <functional>
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <vector>
+#include <atomic>
 #include <mutex>
 
 namespace HELPERS_NS {
@@ -26,7 +27,7 @@ namespace HELPERS_NS {
 			using HandlerFunc_t = typename MyBase_t::HandlerFunc_t;
 
 			// Обьявляем Connection тут же, т.к. dynamic_cast требует чтоб тип был уже известен.
-			class Connection: public ISubscriptionToken{
+			class Connection: public ISubscriptionToken, public std::enable_shared_from_this<Connection>{
 			public:
 				Connection(typename HELPERS_NS::TokenContext<Signal_t>::Weak ctx)
 					: ctx{ ctx }
@@ -37,7 +38,7 @@ namespace HELPERS_NS {
 					if (this->ctx.token.expired()) {
 						return;
 					}
-					this->ctx.data->RemoveHandler(this);
+					this->ctx.data->RemoveHandler(this->weak_from_this());
 					this->isConnected = false;
 				}
 
@@ -82,33 +83,16 @@ namespace HELPERS_NS {
 				}
 			}
 
-			// Invoke — чистим «мертвые» токены и выполняем снапшот
+			// Invoke — no mutex and no allocations: iterates the published immutable handler list
+			// (Subscribe / Disconnect copy the list and publish the new one, handlers removed meanwhile may be called once more).
 			void Invoke(const TArgs&... args) override {
-				std::vector<HandlerFunc_t> handlersSnapshot{};
-				std::vector<ISubscriptionToken*> subscriptionTokensToErase{};
-
-				{
-					std::scoped_lock lock{ this->mx };
-					handlersSnapshot.reserve(this->mapTokenToHandlerFunc.size());
-
-					for (auto& [subscriptionTokenPtr, handler] : this->mapTokenToHandlerFunc) {
-						Connection* connection = dynamic_cast<Connection*>(subscriptionTokenPtr);
-
-						if (connection == nullptr || !connection->IsConnected()) {
-							subscriptionTokensToErase.push_back(connection);
-							continue;
-						}
-
-						handlersSnapshot.push_back(handler);
-					}
-
-					for (auto* subscriptionTokenPtr : subscriptionTokensToErase) {
-						this->mapTokenToHandlerFunc.erase(subscriptionTokenPtr);
-					}
+				const std::shared_ptr<const HandlerList_t> handlersSnapshot = this->handlers.load(std::memory_order_acquire);
+				if (!handlersSnapshot) {
+					return;
 				}
 
-				for (auto& fn : handlersSnapshot) {
-					fn(args...);
+				for (auto& handlerEntry : *handlersSnapshot) {
+					(*handlerEntry.handler)(args...);
 				}
 			}
 
@@ -134,38 +118,71 @@ namespace HELPERS_NS {
 			};
 
 			void DisconnectAll() {
-				// To avoid deadlock first collect tokens, then disconnect them.
-				std::vector<ISubscriptionToken*> subscriptionTokens{};
+				// To avoid deadlock first unpublish handlers, then mark connections disconnected.
+				std::shared_ptr<const HandlerList_t> removedHandlers;
 				{
 					std::scoped_lock lock{ this->mx };
-					for (auto& [subscriptionTokenPtr, handler] : this->mapTokenToHandlerFunc) {
-						subscriptionTokens.push_back(subscriptionTokenPtr);
-					}
+					removedHandlers = this->handlers.exchange(nullptr, std::memory_order_acq_rel);
+				}
+				if (!removedHandlers) {
+					return;
 				}
 
-				for (auto subscriptionTokenPtr : subscriptionTokens) {
-					if (auto connection = dynamic_cast<Connection*>(subscriptionTokenPtr)) {
+				for (auto& handlerEntry : *removedHandlers) {
+					if (auto connection = handlerEntry.connectionWeak.lock()) {
 						connection->Disconnect();
 					}
 				}
 			}
 
 		private:
+			struct HandlerEntry {
+				std::weak_ptr<Connection> connectionWeak; // identity of the handler, connection may be released by subscriber without Disconnect
+				std::shared_ptr<const HandlerFunc_t> handler; // shared, so copying the list doesn't copy handlers
+			};
+			using HandlerList_t = std::vector<HandlerEntry>;
+
 			std::shared_ptr<Connection> AddHandler(HandlerFunc_t handlerFunction) {
-				std::scoped_lock lock{ this->mx };
 				auto connection = std::make_shared<Connection>(this->ctx.GetWeak());
-				this->mapTokenToHandlerFunc.emplace(connection.get(), std::move(handlerFunction));
+				auto handler = std::make_shared<const HandlerFunc_t>(std::move(handlerFunction));
+
+				std::scoped_lock lock{ this->mx };
+				const auto currentHandlers = this->handlers.load(std::memory_order_relaxed);
+				auto updatedHandlers = currentHandlers ? std::make_shared<HandlerList_t>(*currentHandlers) : std::make_shared<HandlerList_t>();
+				updatedHandlers->push_back(HandlerEntry{ connection, std::move(handler) });
+				this->handlers.store(std::move(updatedHandlers), std::memory_order_release);
 				return connection;
 			}
 
-			void RemoveHandler(ISubscriptionToken* subscriptionTokenPtr) {
+			// Matches by control block, not by address: address of released connection may be reused by a new one.
+			void RemoveHandler(const std::weak_ptr<Connection>& connectionWeak) {
 				std::scoped_lock lock{ this->mx };
-				this->mapTokenToHandlerFunc.erase(subscriptionTokenPtr);
+				const auto currentHandlers = this->handlers.load(std::memory_order_relaxed);
+				if (!currentHandlers) {
+					return;
+				}
+
+				auto it = std::find_if(currentHandlers->begin(), currentHandlers->end(), [&connectionWeak](const HandlerEntry& handlerEntry) {
+					return !handlerEntry.connectionWeak.owner_before(connectionWeak) && !connectionWeak.owner_before(handlerEntry.connectionWeak);
+					});
+				if (it == currentHandlers->end()) {
+					return;
+				}
+
+				if (currentHandlers->size() == 1) {
+					this->handlers.store(nullptr, std::memory_order_release);
+					return;
+				}
+				auto updatedHandlers = std::make_shared<HandlerList_t>();
+				updatedHandlers->reserve(currentHandlers->size() - 1);
+				updatedHandlers->insert(updatedHandlers->end(), currentHandlers->begin(), it);
+				updatedHandlers->insert(updatedHandlers->end(), std::next(it), currentHandlers->end());
+				this->handlers.store(std::move(updatedHandlers), std::memory_order_release);
 			}
 
 		private:
-			std::mutex mx;
-			std::unordered_map<ISubscriptionToken*, HandlerFunc_t> mapTokenToHandlerFunc;
+			std::mutex mx; // serializes writers only, Invoke doesn't lock
+			std::atomic<std::shared_ptr<const HandlerList_t>> handlers; // copy-on-write, nullptr if no handlers
 			const HELPERS_NS::TokenContext<Signal_t> ctx;
 		};
 
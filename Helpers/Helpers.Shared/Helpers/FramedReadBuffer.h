@@ -0,0 +1,107 @@
+#pragma once
+#include "common.h"
+#include <cstring>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <span>
+
+namespace HELPERS_NS {
+    // Accumulates stream data and splits it on frames [DescriptorT][payload of DescriptorT::size elements].
+    // Frames are returned as views over the internal buffer, so payload is never copied; consumed bytes
+    // are not erased one by one but skipped with read offset, only the tail of incomplete frame is moved
+    // to the front before the next read (amortized O(1) per byte).
+    // NOTE: returned payload view is valid until the next NextFrame() / PrepareForRead() call.
+    // Frame size comes from the peer, so it is checked against maxPayloadSize before any memory is reserved for it;
+    // oversized frame stops parsing (NextFrame returns nullopt) until Clear(), check it with HasOversizedFrame().
+    template <typename T, typename DescriptorT>
+    class FramedReadBuffer {
+    public:
+        static constexpr std::size_t descriptorSize = sizeof(DescriptorT); // in T elements (like Channel wire format)
+        static constexpr std::size_t defaultMaxPayloadSize = 64 * 1024 * 1024; // in T elements
+
+        struct Frame {
+            DescriptorT descriptor;
+            std::span<T> payload;
+        };
+
+        FramedReadBuffer(std::size_t initialCapacity = 0, std::size_t maxPayloadSize = defaultMaxPayloadSize)
+            : maxPayloadSize{ maxPayloadSize }
+        {
+            this->buffer.reserve(initialCapacity);
+        }
+
+        // Applies to frames that are not parsed yet.
+        void SetMaxPayloadSize(std::size_t size) {
+            this->maxPayloadSize = size;
+        }
+
+        std::size_t GetMaxPayloadSize() const {
+            return this->maxPayloadSize;
+        }
+
+        bool HasOversizedFrame() const {
+            return this->oversizedFrame;
+        }
+
+        // Returns buffer to which new data must be appended (don't touch existing elements).
+        std::vector<T>& PrepareForRead() {
+            if (this->readPos == this->buffer.size()) {
+                this->buffer.clear();
+                this->readPos = 0;
+            }
+            else if (this->readPos > 0) {
+                std::size_t restSize = this->buffer.size() - this->readPos;
+                std::memmove(this->buffer.data(), this->buffer.data() + this->readPos, restSize * sizeof(T));
+                this->buffer.resize(restSize);
+                this->readPos = 0;
+            }
+            return this->buffer;
+        }
+
+        std::optional<Frame> NextFrame() {
+            std::size_t available = this->buffer.size() - this->readPos;
+            if (this->oversizedFrame || available < descriptorSize) {
+                return std::nullopt;
+            }
+
+            DescriptorT descriptor;
+            std::memcpy(&descriptor, this->buffer.data() + this->readPos, sizeof(DescriptorT));
+
+            if (descriptor.size > this->maxPayloadSize) {
+                this->oversizedFrame = true;
+                return std::nullopt;
+            }
+
+            std::size_t frameSize = descriptorSize + descriptor.size;
+            if (available < frameSize) {
+                // Grow once for the whole frame instead of several reallocations in the next reads
+                if (this->buffer.capacity() < frameSize) {
+                    this->PrepareForRead();
+                    this->buffer.reserve(frameSize);
+                }
+                return std::nullopt;
+            }
+
+            Frame frame{ descriptor, std::span<T>{ this->buffer.data() + this->readPos + descriptorSize, descriptor.size } };
+            this->readPos += frameSize;
+            return frame;
+        }
+
+        std::size_t PendingSize() const {
+            return this->buffer.size() - this->readPos;
+        }
+
+        void Clear() {
+            this->buffer.clear();
+            this->readPos = 0;
+            this->oversizedFrame = false;
+        }
+
+    private:
+        std::vector<T> buffer;
+        std::size_t readPos = 0;
+        std::size_t maxPayloadSize;
+        bool oversizedFrame = false;
+    };
+}
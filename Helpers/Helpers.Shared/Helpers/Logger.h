@@ -39,5 +39,13 @@
 #define LOG_FUNCTION_SCOPE_C(fmt, ...)
 #define LOG_FUNCTION_SCOPE(fmt, ...)
 
+#define LOG_EVERY_N(n, logCall)
+#define LOG_FIRST_N(n, logCall)
+#define LOG_RATE_LIMITED(perSecond, logCall)
+
 #define CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(className)
+
+// headers below have their own no-spdlog fallbacks
+#include "LoggingAssert.h"
+#include "LoggingThread.h"
 #endif
\ No newline at end of file
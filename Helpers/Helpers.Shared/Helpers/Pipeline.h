@@ -1,7 +1,17 @@
 #pragma once
 #include "common.h"
 #include "Meta/FunctionTraits.h"
+#include "Async/Executor.h"
+#include <condition_variable>
 #include <system_error>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <span>
 
 namespace HELPERS_NS {
@@ -50,6 +60,14 @@ namespace HELPERS_NS {
 	};
 
 
+	// Timings of the last Pipeline::RunParallel (stepTimes are in GetPipelineGraph() order, zero for not executed steps).
+	struct PipelineRunStats {
+		std::vector<std::chrono::nanoseconds> stepTimes;
+		std::chrono::nanoseconds criticalPath{ 0 }; // longest chain of dependent steps (lower bound of wall time)
+		std::chrono::nanoseconds wallTime{ 0 };
+	};
+
+
 	template <typename TDerived>
 	class Pipeline {
 	public:
@@ -71,5 +89,212 @@ namespace HELPERS_NS {
 			}
 			return {};
 		}
+
+		// Graph mode (opt-in): step runs when all its dependencies completed, independent steps run concurrently.
+		struct GraphStep {
+			StepFn_t stepFn;
+			std::vector<StepFn_t> dependsOn;
+		};
+
+		virtual std::span<const GraphStep> GetPipelineGraph() const {
+			return {};
+		}
+
+		// Runs GetPipelineGraph() on executor (ThreadPoolExecutor::GetDefault() if null), calling thread also executes
+		// ready steps while waiting, so it is safe to call from the executor thread. Falls back to Run() if graph is empty.
+		// EarlyExit / Failed stops starting new steps (running ones are waited, they may check IsPipelineStopped()),
+		// error of the first failed step is returned. Unknown or cyclic dependencies - std::errc::invalid_argument.
+		std::error_code RunParallel(std::shared_ptr<Async::IExecutor> executor = nullptr) {
+			const std::span<const GraphStep> graphSteps = this->GetPipelineGraph();
+			if (graphSteps.empty()) {
+				return this->Run();
+			}
+
+			auto graphRun = std::make_shared<GraphRun>();
+			if (!graphRun->Build(graphSteps)) {
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+			if (!executor) {
+				executor = Async::ThreadPoolExecutor::GetDefault();
+			}
+			graphRun->executor = executor;
+			this->lastGraphRun = graphRun;
+
+			const auto timeStart = std::chrono::steady_clock::now();
+			const size_t rootStepsCount = graphRun->ready.size(); // runners start popping 'ready' right after Post
+			for (size_t i = 0; i < rootStepsCount; i++) {
+				this->PostGraphRunner(graphRun, graphSteps);
+			}
+
+			std::unique_lock lk{ graphRun->mx };
+
+			while (true) {
+				if (!graphRun->ready.empty() && !graphRun->stopped) {
+					this->RunReadyGraphStep(lk, graphRun, graphSteps);
+					continue;
+				}
+				if (graphRun->runningCount == 0) {
+					break; // all steps completed or stopped and nothing is running
+				}
+				graphRun->cv.wait(lk);
+			}
+			graphRun->ready.clear(); // late runners find nothing to do
+
+			this->lastRunStats.stepTimes = graphRun->stepTimes;
+			this->lastRunStats.criticalPath = *std::max_element(graphRun->criticalPaths.begin(), graphRun->criticalPaths.end());
+			this->lastRunStats.wallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeStart);
+
+			if (graphRun->exception) {
+				std::rethrow_exception(graphRun->exception);
+			}
+			return graphRun->errorCode;
+		}
+
+		const PipelineRunStats& GetLastRunStats() const {
+			return this->lastRunStats;
+		}
+
+	protected:
+		// For long graph steps: other branch failed or exited early, remaining work is not needed.
+		bool IsPipelineStopped() const {
+			auto graphRun = this->lastGraphRun;
+			return graphRun && graphRun->stopped;
+		}
+
+	private:
+		struct GraphRun {
+			std::mutex mx;
+			std::condition_variable cv;
+			std::shared_ptr<Async::IExecutor> executor; // late runner may release it on its own thread (executor detaches it)
+			std::vector<size_t> remainingDeps;
+			std::vector<std::vector<size_t>> dependents;
+			std::deque<size_t> ready;
+			size_t runningCount = 0;
+			std::atomic<bool> stopped = false;
+			std::error_code errorCode;
+			std::exception_ptr exception;
+			std::vector<std::chrono::nanoseconds> stepTimes;
+			std::vector<std::chrono::nanoseconds> criticalPaths; // longest dependent chain ending with the step
+
+			bool Build(std::span<const GraphStep> graphSteps) {
+				const size_t stepsCount = graphSteps.size();
+				this->remainingDeps.assign(stepsCount, 0);
+				this->dependents.assign(stepsCount, {});
+				this->stepTimes.assign(stepsCount, std::chrono::nanoseconds{ 0 });
+				this->criticalPaths.assign(stepsCount, std::chrono::nanoseconds{ 0 });
+
+				for (size_t i = 0; i < stepsCount; i++) {
+					for (StepFn_t depFn : graphSteps[i].dependsOn) {
+						auto it = std::find_if(graphSteps.begin(), graphSteps.end(), [depFn](const GraphStep& step) {
+							return step.stepFn == depFn;
+							});
+						if (it == graphSteps.end()) {
+							return false;
+						}
+						this->dependents[it - graphSteps.begin()].push_back(i);
+						this->remainingDeps[i]++;
+					}
+				}
+
+				// Kahn's pass: every step must be reachable, otherwise there is a cycle
+				std::vector<size_t> remaining = this->remainingDeps;
+				std::vector<size_t> queue;
+				for (size_t i = 0; i < stepsCount; i++) {
+					if (remaining[i] == 0) {
+						queue.push_back(i);
+						this->ready.push_back(i);
+					}
+				}
+				for (size_t q = 0; q < queue.size(); q++) {
+					for (size_t dependent : this->dependents[queue[q]]) {
+						if (--remaining[dependent] == 0) {
+							queue.push_back(dependent);
+						}
+					}
+				}
+				return queue.size() == stepsCount;
+			}
+		};
+
+		void PostGraphRunner(std::shared_ptr<GraphRun> graphRun, std::span<const GraphStep> graphSteps) {
+			graphRun->executor->Post([this, graphRun, graphSteps] {
+				std::unique_lock lk{ graphRun->mx };
+				if (!graphRun->ready.empty() && !graphRun->stopped) {
+					this->RunReadyGraphStep(lk, graphRun, graphSteps); // caller waits while step is running, so 'this' is alive
+				}
+				});
+		}
+
+		// Called under lock, returns with lock held.
+		void RunReadyGraphStep(std::unique_lock<std::mutex>& lk, const std::shared_ptr<GraphRun>& graphRunPtr, std::span<const GraphStep> graphSteps) {
+			TDerived* castToDerived = static_cast<TDerived*>(this);
+			GraphRun& graphRun = *graphRunPtr;
+
+			const size_t stepIdx = graphRun.ready.front();
+			graphRun.ready.pop_front();
+			graphRun.runningCount++;
+			lk.unlock();
+
+			const auto timeStart = std::chrono::steady_clock::now();
+			PipelineResult res = PipelineResult::Continue();
+			std::exception_ptr exception;
+			try {
+				res = (castToDerived->*graphSteps[stepIdx].stepFn)();
+			}
+			catch (...) {
+				exception = std::current_exception();
+			}
+			const auto stepTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeStart);
+
+			lk.lock();
+			graphRun.stepTimes[stepIdx] = stepTime;
+
+			std::chrono::nanoseconds longestDepPath{ 0 };
+			for (StepFn_t depFn : graphSteps[stepIdx].dependsOn) {
+				for (size_t i = 0; i < graphSteps.size(); i++) {
+					if (graphSteps[i].stepFn == depFn) {
+						longestDepPath = (std::max)(longestDepPath, graphRun.criticalPaths[i]);
+					}
+				}
+			}
+			graphRun.criticalPaths[stepIdx] = longestDepPath + stepTime;
+
+			if (exception || res.IsFailed() || res.IsEarlyExit()) {
+				if (!graphRun.stopped) {
+					graphRun.exception = exception;
+					graphRun.errorCode = res.GetErrorCode();
+				}
+				graphRun.stopped = true;
+				graphRun.ready.clear();
+				graphRun.runningCount--;
+				graphRun.cv.notify_all();
+				return;
+			}
+
+			size_t newReadyCount = 0;
+			for (size_t dependent : graphRun.dependents[stepIdx]) {
+				if (--graphRun.remainingDeps[dependent] == 0) {
+					graphRun.ready.push_back(dependent);
+					newReadyCount++;
+				}
+			}
+
+			// one runner per ready step (the step is executed either by runner or by waiting caller),
+			// the step stays running until runners are posted, so the caller doesn't return while 'this' is used here
+			if (newReadyCount > 0) {
+				graphRun.cv.notify_all();
+				lk.unlock();
+				for (size_t i = 0; i < newReadyCount; i++) {
+					this->PostGraphRunner(graphRunPtr, graphSteps);
+				}
+				lk.lock();
+			}
+			graphRun.runningCount--;
+			graphRun.cv.notify_all();
+		}
+
+	private:
+		std::shared_ptr<GraphRun> lastGraphRun;
+		PipelineRunStats lastRunStats;
 	};
 };
\ No newline at end of file
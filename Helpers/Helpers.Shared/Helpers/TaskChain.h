@@ -2,12 +2,20 @@
 #include "common.h"
 #include "FunctionTraits.hpp"
 #include "Logger.h"
+#include "Async/Executor.h"
 
+#include <condition_variable>
 #include <functional>
-#include <ppltasks.h>
+#include <exception>
+#include <thread>
+#include <memory>
+#include <deque>
 #include <mutex>
 
 namespace HELPERS_NS {
+    // Ordered chain of tasks: appended tasks run one after another on executor (ThreadPoolExecutor::GetDefault() by default).
+    // Task appended when all previous tasks already completed runs inline on the appending thread.
+    // Exception thrown by a task or CancelAndWait() drops all not started tasks (the running one is waited).
     // NOTE: DerivedClass must implement BeforeStartCallback(...) and AfterFinishCallback()
     template <typename DerivedClass, typename... Args>
     class _TaskChainBase {
@@ -23,6 +31,14 @@ namespace HELPERS_NS {
         }
 
     public:
+        // NOTE: executor must not drop posted tasks while chain is alive (chain waits for them in CancelAndWait)
+        void SetExecutor(std::shared_ptr<Async::IExecutor> executor) {
+            LOG_FUNCTION_ENTER_C("SetExecutor(executor)");
+
+            std::lock_guard lk{ mx };
+            this->executor = executor;
+        }
+
         bool Reset() {
             LOG_FUNCTION_ENTER_C("Reset()");
 
@@ -38,8 +54,21 @@ namespace HELPERS_NS {
         void Append(std::function<void()> taskLambda) {
             LOG_FUNCTION_ENTER_C("Append(taskLambda)");
 
-            std::lock_guard lk{ mx };
-            task = task.then(taskLambda); // when completion event set all previous and next tasks execute immediatly
+            std::unique_lock lk{ mx };
+            if (canceled || failed) {
+                LOG_WARNING_D("task chain canceled or failed, ignore task");
+                return;
+            }
+
+            pending.push_back(std::move(taskLambda));
+            if (!executing || running) {
+                return; // will be executed after previous tasks
+            }
+
+            // all previous tasks completed: run inline instead of scheduling
+            running = true;
+            lk.unlock();
+            RunPendingTasks();
         }
 
         void StartExecuting(Args... args) {
@@ -55,7 +84,19 @@ namespace HELPERS_NS {
             static_cast<DerivedClass*>(this)->BeforeStartCallback(std::forward<Args&&>(args)...);
 
             LOG_DEBUG("start executing task chain");
-            taskCompletedEvent.set(); // at this point tasks start executing in some thread via task scheduler
+            if (pending.empty()) {
+                return;
+            }
+
+            running = true;
+            postedRun = std::make_shared<PostedRunState>();
+            auto chainExecutor = executor ? executor : Async::ThreadPoolExecutor::GetDefault();
+            chainExecutor->Post([this, postedRun = postedRun] {
+                if (!postedRun->TryStart()) {
+                    return; // revoked by CancelAndWait, chain may be already destroyed
+                }
+                RunPendingTasks();
+                });
         }
 
         void CancelAndWait() {
@@ -63,52 +104,123 @@ namespace HELPERS_NS {
             CancelAndWaitInternal();
 
             static_cast<DerivedClass*>(this)->AfterFinishCallback();
+
+            std::lock_guard lk{ mx };
             ResetInternal();
             canReset = true;
         }
 
     private:
+        // Run posted by StartExecuting: either it starts or CancelAndWait revokes it (then it never touches the chain).
+        struct PostedRunState {
+            enum class Status {
+                Posted,
+                Started,
+                Revoked,
+            };
+            std::atomic<Status> status = Status::Posted;
+
+            bool TryStart() {
+                auto expected = Status::Posted;
+                return status.compare_exchange_strong(expected, Status::Started);
+            }
+            bool TryRevoke() {
+                auto expected = Status::Posted;
+                return status.compare_exchange_strong(expected, Status::Revoked);
+            }
+        };
+
+        // Runs tasks one by one until queue is empty (only one thread at a time, see 'running').
+        void RunPendingTasks() {
+            LOG_FUNCTION_SCOPE_C("RunPendingTasks()");
+
+            std::unique_lock lk{ mx };
+            runningThreadId = std::this_thread::get_id();
+
+            while (!pending.empty() && !canceled && !failed) {
+                auto taskLambda = std::move(pending.front());
+                pending.pop_front();
+                lk.unlock();
+
+                try {
+                    taskLambda();
+                }
+                catch (const std::exception& ex) {
+                    LOG_ERROR_D("Catch st::exception: {}", ex.what());
+                    lk.lock();
+                    failed = true;
+                    continue;
+                }
+                catch (...) {
+                    LOG_ERROR_D("Catch unrecognized exception !!!");
+                    lk.lock();
+                    failed = true;
+                    continue;
+                }
+
+                lk.lock();
+            }
+
+            if (canceled || failed) {
+                pending.clear(); // next tasks may depend on not completed ones
+            }
+            runningThreadId = {};
+            running = false;
+            runningFinished.notify_all();
+        }
+
         void CancelAndWaitInternal() {
             LOG_FUNCTION_ENTER_C("CancelAndWaitInternal()");
 
-            std::lock_guard lk{ mx };
+            std::unique_lock lk{ mx };
             if (!executing.exchange(false)) {
                 LOG_WARNING_D("already finished, ignore");
                 return; // return if previous value == false
             }
 
-            if (task.is_done()) {
+            if (!running) {
                 LOG_DEBUG_D("no need wait, last task already completed");
             }
 
-            cancelationToken.cancel();
+            canceled = true;
+            pending.clear();
 
-            try {
-                task.wait();
+            // Posted run not started yet: don't wait for it, called on executor thread (e.g. the only worker) it would never start.
+            if (postedRun && postedRun->TryRevoke()) {
+                LOG_DEBUG_D("posted run revoked before start");
+                running = false;
             }
-            catch (const std::exception& ex) {
-                LOG_ERROR_D("Catch st::exception: {}", ex.what());
-            }
-            catch (...) {
-                LOG_ERROR_D("Catch unrecognized exception !!!");
+            postedRun = nullptr;
+
+            if (runningThreadId == std::this_thread::get_id()) {
+                LOG_WARNING_D("called from running task, can't wait itself");
+                return;
             }
+            runningFinished.wait(lk, [this] {
+                return !running;
+                });
         }
 
         void ResetInternal() {
             LOG_FUNCTION_ENTER_C("ResetInternal()");
-            cancelationToken = {};
-            taskCompletedEvent = {};
-            task = Concurrency::task<void>(taskCompletedEvent, cancelationToken.get_token());
+            pending.clear();
+            canceled = false;
+            failed = false;
         }
 
     private:
         std::mutex mx;
+        std::condition_variable runningFinished;
         std::atomic<bool> canReset = true;
         std::atomic<bool> executing = false;
 
-        Concurrency::cancellation_token_source cancelationToken;
-        Concurrency::task_completion_event<void> taskCompletedEvent;
-        Concurrency::task<void> task = Concurrency::task<void>(taskCompletedEvent, cancelationToken.get_token()); // must be created after completionEvent and token
+        std::shared_ptr<Async::IExecutor> executor;
+        std::shared_ptr<PostedRunState> postedRun;
+        std::deque<std::function<void()>> pending;
+        bool running = false; // some thread runs pending tasks
+        bool canceled = false;
+        bool failed = false;
+        std::thread::id runningThreadId;
     };
 
 
@@ -158,4 +270,4 @@ namespace HELPERS_NS {
         void BeforeStartCallback() {}
         void AfterFinishCallback() {}
     };
-}
\ No newline at end of file
+}
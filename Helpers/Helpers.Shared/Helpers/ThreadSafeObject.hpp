@@ -1,11 +1,41 @@
 #pragma once
 #include <Helpers/common.h>
 #include <Helpers/Com/ComMutex.h>
+#include <Helpers/Concurrency.h>
+#ifdef _WIN32
 #include <Helpers/System.h>
+#endif
+#include <shared_mutex>
+#include <type_traits>
 #include <string_view>
+#include <typeinfo>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <array>
 #include <mutex>
 
+#ifndef _Acquires_lock_ // SAL annotations are MSVC only
+#define _Acquires_lock_(lock)
+#define _Releases_lock_(lock)
+#endif
+
 namespace HELPERS_NS {
+    // Bookkeeping of exclusive locks, updated by LockedObj... while the mutex is held.
+    struct LockOwnerInfo {
+        std::thread::id threadId;
+        std::atomic<uint64_t> exclusiveLocksCount = 0; // Snapshot() is valid until next exclusive lock
+    };
+
+    template <typename MutexT>
+    concept SharedLockable = requires(MutexT & mx) {
+        mx.lock_shared();
+        mx.unlock_shared();
+    };
+
+
     //
     // LockedObjBase
     // NOTE: CreatorT::MutexT must be declared as mutable. 
@@ -24,12 +54,13 @@ namespace HELPERS_NS {
         static constexpr std::string_view templateNotes = "Specialized for <CreatorT<MutexT, ObjT, CustomLockableT>";
         
         _Acquires_lock_(this->lk) // suppress warning - "C26115: Falling release lock 'mx'"
-        LockedObjBase(MutexT& mx, const ObjT& obj, const CreatorT<MutexT, ObjT, CustomLockableT>* creator, int& ownerThreadId)
+        LockedObjBase(MutexT& mx, const ObjT& obj, const CreatorT<MutexT, ObjT, CustomLockableT>* creator, LockOwnerInfo& ownerInfo)
             : lk{ mx }
             , creator{ creator }
             , customLockableObj{ obj }
         {
-            ownerThreadId = ::GetCurrentThreadId();
+            ownerInfo.threadId = std::this_thread::get_id();
+            ownerInfo.exclusiveLocksCount.fetch_add(1, std::memory_order_release);
         }
 
         _Releases_lock_(this->lk)
@@ -51,11 +82,12 @@ namespace HELPERS_NS {
     struct LockedObjBase<CreatorT<MutexT, ObjT, void>>
     {
         static constexpr std::string_view templateNotes = "Specialized for <CreatorT<MutexT, ObjT, void>";
-        LockedObjBase(MutexT& mx, const ObjT& /*obj*/, const CreatorT<MutexT, ObjT, void>* creator, int& ownerThreadId)
+        LockedObjBase(MutexT& mx, const ObjT& /*obj*/, const CreatorT<MutexT, ObjT, void>* creator, LockOwnerInfo& ownerInfo)
             : lk{ mx }
             , creator{ creator }
         {
-            ownerThreadId = ::GetCurrentThreadId();
+            ownerInfo.threadId = std::this_thread::get_id();
+            ownerInfo.exclusiveLocksCount.fetch_add(1, std::memory_order_release);
         }
 
         ~LockedObjBase() {
@@ -91,8 +123,8 @@ namespace HELPERS_NS {
             MutexT& mx,
             const ObjT& obj,
             const CreatorT<MutexT, ObjT, CustomLockableT>* creator,
-            int& ownerThreadId)
-            : _MyBase(mx, obj, creator, ownerThreadId)
+            LockOwnerInfo& ownerInfo)
+            : _MyBase(mx, obj, creator, ownerInfo)
             , obj{ const_cast<ObjT&>(obj) } // [by design]
         {}
 
@@ -122,8 +154,8 @@ namespace HELPERS_NS {
             MutexT& mx,
             const std::unique_ptr<ObjT, Args...>& obj,
             const CreatorT<MutexT, std::unique_ptr<ObjT, Args...>, CustomLockableT>* creator,
-            int& ownerThreadId)
-            : _MyBase(mx, obj, creator, ownerThreadId)
+            LockOwnerInfo& ownerInfo)
+            : _MyBase(mx, obj, creator, ownerInfo)
             , obj{ const_cast<std::unique_ptr<ObjT, Args...>&>(obj) } // [by design]
         {}
 
@@ -135,7 +167,10 @@ namespace HELPERS_NS {
             if (auto objCasted = dynamic_cast<InterfaceT*>(this->obj.get())) {
                 return objCasted;
             }
+#ifdef _WIN32
             HELPERS_NS::System::ThrowIfFailed(E_NOINTERFACE);
+#endif
+            throw std::bad_cast{};
         }
 
         std::unique_ptr<ObjT, Args...>& operator->() const {
@@ -150,6 +185,29 @@ namespace HELPERS_NS {
     };
 
 
+    //
+    // LockedSharedObj - const view of the object under shared lock
+    //
+    template <typename MutexT, typename ObjT>
+    struct LockedSharedObj {
+        LockedSharedObj(MutexT& mx, const ObjT& obj)
+            : lk{ mx }
+            , obj{ obj }
+        {}
+
+        const ObjT* operator->() const {
+            return &this->obj;
+        }
+        const ObjT& Get() const {
+            return this->obj;
+        }
+
+    private:
+        std::shared_lock<MutexT> lk;
+        const ObjT& obj;
+    };
+
+
     //
     // ThreadSafeObject
     //
@@ -158,6 +216,7 @@ namespace HELPERS_NS {
     public:
         static constexpr std::string_view templateNotes = "Primary temlpate";
         using _Locked = LockedObj<ThreadSafeObject<MutexT, ObjT, CustomLockableT>>;
+        using _LockedShared = LockedSharedObj<MutexT, ObjT>;
 
         ThreadSafeObject()
             : obj{}
@@ -185,21 +244,62 @@ namespace HELPERS_NS {
         ThreadSafeObject& operator=(OtherT&& otherObj) {
             if (&this->obj != &otherObj) {
                 this->obj = std::move(otherObj);
+                this->ownerInfo.exclusiveLocksCount++;
             }
             return *this;
         }
 
         _Locked Lock() const {
-            return _Locked{ this->mx, this->obj, this, this->ownerThreadId };
+            return _Locked{ this->mx, this->obj, this, this->ownerInfo };
         }
 
         std::unique_ptr<_Locked> LockUniq() const {
-            return std::make_unique<_Locked>(this->mx, this->obj, this, this->ownerThreadId);
+            return std::make_unique<_Locked>(this->mx, this->obj, this, this->ownerInfo);
+        }
+
+        // Readers don't block each other, MutexT must be shared mutex (e.g. std::shared_mutex).
+        _LockedShared LockShared() const requires SharedLockable<MutexT> {
+            return _LockedShared{ this->mx, this->obj };
+        }
+
+        // Immutable copy of the object (RCU-style). Copy is made once after every exclusive Lock(),
+        // readers between writes share it without locking, so prefer it for objects read much more often than written.
+        std::shared_ptr<const ObjT> Snapshot() const requires std::is_copy_constructible_v<ObjT> {
+            auto cachedSnapshot = this->snapshot.load(std::memory_order_acquire);
+            if (cachedSnapshot && cachedSnapshot->version == this->ownerInfo.exclusiveLocksCount.load(std::memory_order_acquire)) {
+                return std::shared_ptr<const ObjT>(cachedSnapshot, &cachedSnapshot->obj);
+            }
+
+            auto makeSnapshot = [this] {
+                auto newSnapshot = std::make_shared<const SnapshotEntry>(this->ownerInfo.exclusiveLocksCount.load(std::memory_order_relaxed), this->obj);
+                this->snapshot.store(newSnapshot, std::memory_order_release);
+                return std::shared_ptr<const ObjT>(newSnapshot, &newSnapshot->obj);
+            };
+
+            if constexpr (SharedLockable<MutexT>) {
+                std::shared_lock lk{ this->mx };
+                return makeSnapshot();
+            }
+            else {
+                std::unique_lock lk{ this->mx };
+                return makeSnapshot();
+            }
         }
 
     private:
+        struct SnapshotEntry {
+            SnapshotEntry(uint64_t version, const ObjT& obj)
+                : version{ version }
+                , obj{ obj }
+            {}
+
+            const uint64_t version; // exclusiveLocksCount when copy was made
+            const ObjT obj;
+        };
+
         mutable MutexT mx;
-        mutable int ownerThreadId = -1;
+        mutable LockOwnerInfo ownerInfo;
+        mutable std::atomic<std::shared_ptr<const SnapshotEntry>> snapshot;
         ObjT obj;
     };
 
@@ -241,16 +341,16 @@ namespace HELPERS_NS {
         }
 
         _Locked Lock() const {
-            return _Locked{ this->mx, this->obj, this, this->ownerThreadId };
+            return _Locked{ this->mx, this->obj, this, this->ownerInfo };
         }
 
         std::unique_ptr<_Locked> LockUniq() const {
-            return std::make_unique<_Locked>(this->mx, this->obj, this, this->ownerThreadId);
+            return std::make_unique<_Locked>(this->mx, this->obj, this, this->ownerInfo);
         }
 
     private:
         mutable MutexT mx;
-        mutable int ownerThreadId = -1;
+        mutable LockOwnerInfo ownerInfo;
         std::unique_ptr<ObjT> obj;
     };
 
@@ -296,21 +396,117 @@ namespace HELPERS_NS {
         }
 
         _Locked Lock() const {
-            return _Locked{ this->mx, this->obj, this, this->ownerThreadId };
+            return _Locked{ this->mx, this->obj, this, this->ownerInfo };
         }
 
         std::unique_ptr<_Locked> LockUniq() const {
-            return std::make_unique<_Locked>(this->mx, this->obj, this, this->ownerThreadId);
+            return std::make_unique<_Locked>(this->mx, this->obj, this, this->ownerInfo);
         }
 
     private:
         mutable HELPERS_NS::Com::Mutex mx;
-        mutable int ownerThreadId = -1;
+        mutable LockOwnerInfo ownerInfo;
         std::unique_ptr<ObjT> obj;
     };
 
 
 
+    // MutexT for seqlock mode of ThreadSafeObject (trivially copyable ObjT only): writers are serialized by mutex
+    // and bump sequence counter, readers copy the object optimistically and retry if write overlapped.
+    // Readers never block writers and don't write shared memory, so reads scale with reader threads.
+    struct SeqLock {};
+
+    template <typename ObjT>
+    class ThreadSafeObject<SeqLock, ObjT, void> {
+        static_assert(std::is_trivially_copyable_v<ObjT>, "seqlock mode requires trivially copyable ObjT");
+    public:
+        static constexpr std::string_view templateNotes = "Specialized for <SeqLock, ObjT>";
+
+        ThreadSafeObject()
+            : ThreadSafeObject(ObjT{})
+        {}
+
+        explicit ThreadSafeObject(const ObjT& obj) {
+            this->StoreWords(obj);
+        }
+
+        ThreadSafeObject(ThreadSafeObject& other) = delete;
+        ThreadSafeObject& operator=(ThreadSafeObject& other) = delete;
+
+        ObjT Load() const {
+            while (true) {
+                const uint64_t sequenceBefore = this->sequence.load(std::memory_order_acquire);
+                if (sequenceBefore & 1) {
+                    HELPERS_NS::CpuRelax(); // write in progress
+                    continue;
+                }
+
+                ObjT obj = this->LoadWords();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (this->sequence.load(std::memory_order_relaxed) == sequenceBefore) {
+                    return obj;
+                }
+            }
+        }
+
+        void Store(const ObjT& obj) {
+            std::lock_guard lk{ this->mx };
+            this->BeginWrite();
+            this->StoreWords(obj);
+            this->EndWrite();
+        }
+
+        // Read-modify-write under writers mutex: updateFn(ObjT&).
+        template <typename UpdateFn>
+        void Update(UpdateFn&& updateFn) {
+            std::lock_guard lk{ this->mx };
+            ObjT obj = this->LoadWords();
+            updateFn(obj);
+            this->BeginWrite();
+            this->StoreWords(obj);
+            this->EndWrite();
+        }
+
+    private:
+        using Word_t = uintptr_t;
+        static constexpr size_t wordsCount = (sizeof(ObjT) + sizeof(Word_t) - 1) / sizeof(Word_t);
+
+        // Object is stored as relaxed atomic words: racing reads are well defined, torn copies are rejected by sequence check.
+        ObjT LoadWords() const {
+            std::array<Word_t, wordsCount> buffer;
+            for (size_t i = 0; i < wordsCount; i++) {
+                buffer[i] = this->words[i].load(std::memory_order_relaxed);
+            }
+            ObjT obj;
+            std::memcpy(&obj, buffer.data(), sizeof(ObjT));
+            return obj;
+        }
+
+        void StoreWords(const ObjT& obj) {
+            std::array<Word_t, wordsCount> buffer{};
+            std::memcpy(buffer.data(), &obj, sizeof(ObjT));
+            for (size_t i = 0; i < wordsCount; i++) {
+                this->words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+        }
+
+        void BeginWrite() {
+            this->sequence.store(this->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void EndWrite() {
+            this->sequence.store(this->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        std::mutex mx;
+        std::atomic<uint64_t> sequence = 0; // odd while write is in progress
+        std::array<std::atomic<Word_t>, wordsCount> words{};
+    };
+
+
+
     // TODO: overload for ENSURE_METHOD_IS_GUARDED(lockClass) and ENSURE_METHOD_IS_GUARDED(lockClass, mutexClass)
     //#define ENSURE_METHOD_IS_GUARDED std::lock_guard<std::mutex>&
 
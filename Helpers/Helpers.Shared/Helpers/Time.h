@@ -1,10 +1,11 @@
 #pragma once
 #include "common.h"
 #include "Rational.h"
-#include <condition_variable>
+#include "TimerService.h"
 #include <functional>
+#include <utility>
 #include <chrono>
-#include <thread>
+#include <memory>
 #include <future>
 
 namespace HELPERS_NS {
@@ -87,14 +88,12 @@ namespace HELPERS_NS {
 	} // inline namespace Literals
 
 
+	// Timers are served by shared TimerService thread (see TimerService.h), so callbacks must be short.
 	class Timer	{
 	public:
 		template <typename Duration>
 		static void Once(Duration timeout, std::function<void()> callback) { // Not thread safe callback call
-			std::thread([=] {
-				std::this_thread::sleep_for(timeout);
-				callback();
-				}).detach();
+			TimerService::GetDefault()->Schedule(timeout, std::move(callback));
 		}
 
 		template <typename Duration>
@@ -102,11 +101,14 @@ namespace HELPERS_NS {
 			if (futureToken)
 				return false; // Guard from double set. Don't init new future until previous not finished.
 
-			futureToken = std::make_unique<std::future<void>>(std::async(std::launch::async, [&futureToken, timeout, callback] {
-				std::this_thread::sleep_for(timeout);
+			auto promise = std::make_shared<std::promise<void>>();
+			futureToken = std::make_unique<std::future<void>>(promise->get_future());
+
+			TimerService::GetDefault()->Schedule(timeout, [&futureToken, promise, callback] {
 				callback();
+				promise->set_value();
 				futureToken = nullptr;
-				}));
+				});
 
 			return true;
 		}
@@ -117,66 +119,53 @@ namespace HELPERS_NS {
 			Start(timeout, callback, autoRestart);
 		}
 		~Timer() {
-			StopThread();
+			Stop();
 		}
 
 		void Start(std::chrono::milliseconds timeout, std::function<void()> callback, bool autoRestart = false) {
-			StopThread();
-			{
-				std::lock_guard lk1{ mx };
-				this->timeout = timeout;
-				this->callback = callback;
-				this->autoRestart = autoRestart;
-			}
-			StartThread();
+			Stop();
+
+			std::lock_guard lk{ mx };
+			this->timeout = timeout;
+			this->callback = callback;
+			this->autoRestart = autoRestart;
+			ScheduleInternal();
 		}
 		void Stop() {
-			StopThread();
+			TimerHandle handleToCancel;
+			{
+				std::lock_guard lk{ mx };
+				handleToCancel = std::exchange(this->timerHandle, {});
+			}
+			this->timerService->CancelAndWait(handleToCancel); // callback may use this timer owner, wait it
 		}
 
 		void Reset(std::chrono::milliseconds timeout) {
-			StopThread();
-			StartThread();
-		}
+			Stop();
 
-	private:
-		void StopThread() {
-			stop = true;
-			cv.notify_all();
-			if (threadTimer.joinable())
-				threadTimer.join();
+			std::lock_guard lk{ mx };
+			this->timeout = timeout;
+			ScheduleInternal();
 		}
 
-		void StartThread() {
-			stop = false;
-			threadTimer = std::thread([this] {
-				std::lock_guard lk1{ mx }; // guard from changing timeout and callback
-				while (!stop) {
-					std::mutex tmpMx;
-					std::unique_lock lk2{ tmpMx };
-					if (!cv.wait_for(lk2, timeout, [this] { return static_cast<bool>(stop); })) {
-						if (callback) {
-							callback();
-						}
-					}
-					if (!autoRestart) {
-						stop = true;
-						break;
-					}
-				}
-				});
+	private:
+		void ScheduleInternal() {
+			if (this->autoRestart) {
+				this->timerHandle = this->timerService->SchedulePeriodic(this->timeout, this->callback);
+			}
+			else {
+				this->timerHandle = this->timerService->Schedule(this->timeout, this->callback);
+			}
 		}
 	
 	private:
 		std::mutex mx;
-		std::thread threadTimer;
-		std::condition_variable cv;
+		std::shared_ptr<TimerService> timerService = TimerService::GetDefault();
+		TimerHandle timerHandle;
 
 		std::function<void()> callback;
-		std::chrono::milliseconds timeout;
-
-		std::atomic<bool> stop = false;
-		std::atomic<bool> autoRestart = false;
+		std::chrono::milliseconds timeout{ 0 };
+		bool autoRestart = false;
 	};
 
 
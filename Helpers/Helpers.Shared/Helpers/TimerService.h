@@ -0,0 +1,395 @@
+#pragma once
+#include "common.h"
+#include "Logger.h"
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <bit>
+
+namespace HELPERS_NS {
+	// Identifies scheduled timer, stays invalid after timer fired or canceled (slots are reused with new generation).
+	struct TimerHandle {
+		static constexpr uint32_t invalidIndex = (std::numeric_limits<uint32_t>::max)();
+
+		uint32_t index = invalidIndex;
+		uint32_t generation = 0;
+
+		explicit operator bool() const {
+			return index != invalidIndex;
+		}
+	};
+
+
+	// One thread serves all timers with hierarchical timing wheel (4 levels x 256 slots, 1ms tick, ~49 days range).
+	// Schedule / Cancel are O(1): timer nodes live in pooled array and are linked into wheel slots intrusively.
+	// Slack lets timers with close deadlines fire on the same tick (deadline is rounded up to multiple of slack).
+	// NOTE: callbacks are called on the timer thread one by one, so they must be short (post long work to executor).
+	class TimerService {
+		CLASS_FULLNAME_LOGGING_INLINE_IMPLEMENTATION(TimerService);
+	public:
+		using Clock = std::chrono::steady_clock;
+		using Tick = std::chrono::milliseconds;
+		using Callback = std::function<void()>;
+
+		TimerService()
+			: timeStart{ Clock::now() }
+		{
+			LOG_FUNCTION_ENTER_C("TimerService()");
+			for (auto& level : this->slotHeads) {
+				level.fill(invalidNode);
+			}
+			this->timerThread = std::thread([this] {
+				LOG_THREAD(L"TimerService");
+				this->Run();
+				});
+		}
+
+		~TimerService() {
+			LOG_FUNCTION_ENTER_C("~TimerService()");
+			{
+				std::lock_guard lk{ mx };
+				this->stop = true;
+			}
+			this->cv.notify_all();
+			this->timerThread.join();
+		}
+
+		TimerService(const TimerService&) = delete;
+		TimerService& operator=(const TimerService&) = delete;
+
+		static std::shared_ptr<TimerService> GetDefault() {
+			static auto defaultTimerService = std::make_shared<TimerService>(); // lives until process exit
+			return defaultTimerService;
+		}
+
+		template <typename Rep, typename Period>
+		TimerHandle Schedule(std::chrono::duration<Rep, Period> delay, Callback callback, Clock::duration slack = {}) {
+			return this->ScheduleInternal(std::chrono::duration_cast<Clock::duration>(delay), Clock::duration::zero(), slack, std::move(callback));
+		}
+
+		// Fires every period after first one (next deadline is counted from previous one, so it doesn't drift).
+		template <typename Rep, typename Period>
+		TimerHandle SchedulePeriodic(std::chrono::duration<Rep, Period> period, Callback callback, Clock::duration slack = {}) {
+			auto periodClock = std::chrono::duration_cast<Clock::duration>(period);
+			return this->ScheduleInternal(periodClock, (std::max)(periodClock, Clock::duration{ Tick{ 1 } }), slack, std::move(callback));
+		}
+
+		// Returns true if timer was pending. Doesn't wait for callback running right now (see CancelAndWait).
+		bool Cancel(TimerHandle handle) {
+			std::lock_guard lk{ mx };
+			return this->CancelInternal(handle);
+		}
+
+		// Also waits for running callback of this timer (doesn't wait if called from the callback itself).
+		bool CancelAndWait(TimerHandle handle) {
+			std::unique_lock lk{ mx };
+			const bool canceled = this->CancelInternal(handle);
+			if (std::this_thread::get_id() != this->timerThread.get_id()) {
+				this->callbackFinished.wait(lk, [this, handle] {
+					return this->firingIndex != handle.index || this->firingGeneration != handle.generation;
+					});
+			}
+			return canceled;
+		}
+
+		size_t GetPendingCount() {
+			std::lock_guard lk{ mx };
+			return this->pendingCount;
+		}
+
+	private:
+		static constexpr uint32_t invalidNode = TimerHandle::invalidIndex;
+		static constexpr uint32_t levelBits = 8;
+		static constexpr uint32_t slotsPerLevel = 1u << levelBits;
+		static constexpr uint32_t levelsCount = 4;
+		static constexpr uint64_t slotMask = slotsPerLevel - 1;
+
+		enum class NodeState : uint8_t {
+			Free,
+			Pending,
+			Firing,
+			CanceledWhileFiring,
+		};
+
+		struct Node {
+			uint64_t expiryTick = 0;
+			uint64_t periodTicks = 0; // 0 - one shot
+			uint64_t slackTicks = 0;
+			uint32_t generation = 0;
+			uint32_t prev = invalidNode;
+			uint32_t next = invalidNode; // also links free nodes
+			uint16_t slot = 0; // level * slotsPerLevel + slot index
+			NodeState state = NodeState::Free;
+			Callback callback;
+		};
+
+		TimerHandle ScheduleInternal(Clock::duration delay, Clock::duration period, Clock::duration slack, Callback callback) {
+			const uint64_t expiryTick = this->ToTickCeil(Clock::now() - this->timeStart + (std::max)(delay, Clock::duration::zero()));
+			const uint64_t slackTicks = static_cast<uint64_t>(std::chrono::duration_cast<Tick>(slack).count());
+
+			bool wakeUp = false;
+			TimerHandle handle;
+			{
+				std::lock_guard lk{ mx };
+				const uint32_t nodeIdx = this->AllocateNode();
+				Node& node = this->nodes[nodeIdx];
+				node.periodTicks = static_cast<uint64_t>(std::chrono::duration_cast<Tick>(period).count());
+				node.slackTicks = slackTicks;
+				node.expiryTick = ApplySlack(expiryTick, slackTicks);
+				node.state = NodeState::Pending;
+				node.callback = std::move(callback);
+				this->LinkNode(nodeIdx);
+				this->pendingCount++;
+
+				wakeUp = node.expiryTick < this->sleepUntilTick;
+				handle = TimerHandle{ nodeIdx, node.generation };
+			}
+			if (wakeUp) {
+				this->cv.notify_one(); // timer thread sleeps until later tick
+			}
+			return handle;
+		}
+
+		bool CancelInternal(TimerHandle handle) {
+			if (!handle || handle.index >= this->nodes.size()) {
+				return false;
+			}
+			Node& node = this->nodes[handle.index];
+			if (node.generation != handle.generation) {
+				return false;
+			}
+
+			switch (node.state) {
+			case NodeState::Pending:
+				this->UnlinkNode(handle.index);
+				this->FreeNode(handle.index);
+				this->pendingCount--;
+				return true;
+
+			case NodeState::Firing: // periodic timer in callback: timer thread frees it when callback returns
+				node.state = NodeState::CanceledWhileFiring;
+				return true;
+
+			default:
+				return false;
+			}
+		}
+
+		void Run() {
+			std::unique_lock lk{ mx };
+			while (!this->stop) {
+				const uint64_t nowTick = this->ToTickFloor(Clock::now() - this->timeStart);
+				while (this->currentTick < nowTick && !this->stop) {
+					this->AdvanceTo((std::min)(this->NextEventTick(), nowTick), lk);
+				}
+				if (this->stop) {
+					break; // stop was requested while callback was running (lock released), its notify is already lost
+				}
+
+				if (this->pendingCount == 0) {
+					this->sleepUntilTick = (std::numeric_limits<uint64_t>::max)();
+					this->cv.wait(lk);
+				}
+				else {
+					this->sleepUntilTick = this->NextEventTick();
+					this->cv.wait_until(lk, this->timeStart + Tick{ this->sleepUntilTick });
+				}
+			}
+		}
+
+		// Nearest tick which needs processing: occupied slot of level 0 or next cascade of higher levels.
+		uint64_t NextEventTick() const {
+			const uint64_t nextCascadeTick = (this->currentTick | slotMask) + 1;
+			for (uint64_t tick = this->currentTick + 1; tick < nextCascadeTick; ) {
+				const uint64_t slotIdx = tick & slotMask;
+				const uint64_t bits = this->level0Bitmap[slotIdx / 64] >> (slotIdx % 64);
+				if (bits) {
+					return tick + std::countr_zero(bits);
+				}
+				tick += 64 - slotIdx % 64;
+			}
+			return nextCascadeTick;
+		}
+
+		// Skips empty ticks up to targetTick, cascades higher levels and fires expired timers of targetTick.
+		void AdvanceTo(uint64_t targetTick, std::unique_lock<std::mutex>& lk) {
+			this->currentTick = targetTick;
+
+			if ((targetTick & slotMask) == 0) {
+				// cascade from the highest level down, so timers moved from upper level get to level 0 on the same tick
+				uint32_t levelsToCascade = 1;
+				while (levelsToCascade < levelsCount - 1 && ((targetTick >> (levelBits * levelsToCascade)) & slotMask) == 0) {
+					levelsToCascade++;
+				}
+				for (uint32_t level = levelsToCascade; level >= 1; level--) {
+					this->CascadeSlot(level, (targetTick >> (levelBits * level)) & slotMask);
+				}
+			}
+
+			const uint16_t slot = static_cast<uint16_t>(targetTick & slotMask);
+			while (this->slotHeads[0][slot] != invalidNode && !this->stop) {
+				const uint32_t nodeIdx = this->slotHeads[0][slot];
+				this->UnlinkNode(nodeIdx);
+				this->FireNode(nodeIdx, lk);
+			}
+		}
+
+		void CascadeSlot(uint32_t level, uint64_t slotIdx) {
+			uint32_t nodeIdx = this->slotHeads[level][slotIdx];
+			this->slotHeads[level][slotIdx] = invalidNode;
+			while (nodeIdx != invalidNode) {
+				const uint32_t nextIdx = this->nodes[nodeIdx].next;
+				this->LinkNode(nodeIdx);
+				nodeIdx = nextIdx;
+			}
+		}
+
+		// Called under lock with unlinked node, returns with lock held.
+		void FireNode(uint32_t nodeIdx, std::unique_lock<std::mutex>& lk) {
+			Callback callback = std::move(this->nodes[nodeIdx].callback);
+			const bool periodic = this->nodes[nodeIdx].periodTicks != 0;
+			this->firingIndex = nodeIdx;
+			this->firingGeneration = this->nodes[nodeIdx].generation;
+
+			if (periodic) {
+				this->nodes[nodeIdx].state = NodeState::Firing;
+			}
+			else {
+				this->FreeNode(nodeIdx);
+				this->pendingCount--;
+			}
+
+			lk.unlock();
+			if (callback) {
+				callback();
+			}
+			lk.lock();
+
+			this->firingIndex = invalidNode;
+			this->callbackFinished.notify_all();
+
+			if (periodic) {
+				Node& node = this->nodes[nodeIdx]; // nodes may be reallocated while callback was running
+				if (node.state == NodeState::CanceledWhileFiring) {
+					this->FreeNode(nodeIdx);
+					this->pendingCount--;
+					return;
+				}
+				node.state = NodeState::Pending;
+				node.callback = std::move(callback);
+				node.expiryTick = ApplySlack((std::max)(node.expiryTick + node.periodTicks, this->currentTick + 1), node.slackTicks);
+				this->LinkNode(nodeIdx);
+			}
+		}
+
+		void LinkNode(uint32_t nodeIdx) {
+			Node& node = this->nodes[nodeIdx];
+			const uint64_t expiryTick = (std::max)(node.expiryTick, this->currentTick + 1);
+			const uint64_t delta = expiryTick - this->currentTick;
+
+			uint32_t level = 0;
+			while (level < levelsCount - 1 && delta >= (uint64_t{ 1 } << (levelBits * (level + 1)))) {
+				level++;
+			}
+			// beyond the wheel range: park in the farthest slot of the top level, it is relinked on cascade
+			const uint64_t maxDelta = (uint64_t{ 1 } << (levelBits * levelsCount)) - 1;
+			const uint64_t slotTick = delta > maxDelta ? this->currentTick + maxDelta : expiryTick;
+			const uint64_t slotIdx = (slotTick >> (levelBits * level)) & slotMask;
+
+			node.slot = static_cast<uint16_t>(level * slotsPerLevel + slotIdx);
+			node.prev = invalidNode;
+			node.next = this->slotHeads[level][slotIdx];
+			if (node.next != invalidNode) {
+				this->nodes[node.next].prev = nodeIdx;
+			}
+			this->slotHeads[level][slotIdx] = nodeIdx;
+			if (level == 0) {
+				this->level0Bitmap[slotIdx / 64] |= uint64_t{ 1 } << (slotIdx % 64);
+			}
+		}
+
+		void UnlinkNode(uint32_t nodeIdx) {
+			Node& node = this->nodes[nodeIdx];
+			const uint32_t level = node.slot / slotsPerLevel;
+			const uint32_t slotIdx = node.slot % slotsPerLevel;
+
+			if (node.prev != invalidNode) {
+				this->nodes[node.prev].next = node.next;
+			}
+			else {
+				this->slotHeads[level][slotIdx] = node.next;
+			}
+			if (node.next != invalidNode) {
+				this->nodes[node.next].prev = node.prev;
+			}
+			node.prev = invalidNode;
+			node.next = invalidNode;
+
+			if (level == 0 && this->slotHeads[0][slotIdx] == invalidNode) {
+				this->level0Bitmap[slotIdx / 64] &= ~(uint64_t{ 1 } << (slotIdx % 64));
+			}
+		}
+
+		uint32_t AllocateNode() {
+			if (this->freeHead != invalidNode) {
+				const uint32_t nodeIdx = this->freeHead;
+				this->freeHead = this->nodes[nodeIdx].next;
+				return nodeIdx;
+			}
+			this->nodes.emplace_back();
+			return static_cast<uint32_t>(this->nodes.size() - 1);
+		}
+
+		void FreeNode(uint32_t nodeIdx) {
+			Node& node = this->nodes[nodeIdx];
+			node.generation++; // invalidates handles
+			node.state = NodeState::Free;
+			node.callback = nullptr;
+			node.next = this->freeHead;
+			this->freeHead = nodeIdx;
+		}
+
+		static uint64_t ApplySlack(uint64_t tick, uint64_t slackTicks) {
+			if (slackTicks <= 1) {
+				return tick;
+			}
+			return (tick + slackTicks - 1) / slackTicks * slackTicks;
+		}
+
+		static uint64_t ToTickFloor(Clock::duration sinceStart) {
+			return static_cast<uint64_t>(std::chrono::duration_cast<Tick>(sinceStart).count());
+		}
+
+		static uint64_t ToTickCeil(Clock::duration sinceStart) {
+			return static_cast<uint64_t>(std::chrono::ceil<Tick>(sinceStart).count());
+		}
+
+	private:
+		const Clock::time_point timeStart;
+		std::mutex mx;
+		std::condition_variable cv;
+		std::condition_variable callbackFinished;
+
+		std::vector<Node> nodes;
+		uint32_t freeHead = invalidNode;
+		std::array<std::array<uint32_t, slotsPerLevel>, levelsCount> slotHeads;
+		std::array<uint64_t, slotsPerLevel / 64> level0Bitmap{};
+		size_t pendingCount = 0;
+
+		uint64_t currentTick = 0; // all timers with expiryTick <= currentTick are fired
+		uint64_t sleepUntilTick = 0;
+		uint32_t firingIndex = invalidNode;
+		uint32_t firingGeneration = 0;
+
+		bool stop = false;
+		std::thread timerThread;
+	};
+}
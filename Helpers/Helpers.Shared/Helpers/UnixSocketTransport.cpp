@@ -0,0 +1,170 @@
+#include "UnixSocketTransport.h"
+#if defined(__linux__)
+#include <sys/un.h>
+#include <fcntl.h>
+#include <cstring>
+#include <thread>
+
+namespace HELPERS_NS {
+    namespace details {
+        namespace {
+            constexpr int pollIntervalMs = 50;
+
+            bool MakeUnixSocketAddress(const std::string& path, sockaddr_un& addr) {
+                addr = {};
+                addr.sun_family = AF_UNIX;
+                if (path.size() >= sizeof(addr.sun_path)) {
+                    LOG_ERROR_D("Unix socket path is too long '{}'", path);
+                    return false;
+                }
+                std::memcpy(addr.sun_path, path.c_str(), path.size());
+                return true;
+            }
+        }
+
+        std::pair<int, int> CreateUnixSocketPair(UnixSocketType type) {
+            int fds[2] = { -1, -1 };
+            if (::socketpair(AF_UNIX, static_cast<int>(type) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+                LOG_ERROR_D("socketpair error = {}", errno);
+                return { -1, -1 };
+            }
+            return { fds[0], fds[1] };
+        }
+
+        int ConnectUnixSocket(const std::string& path, UnixSocketType type, std::chrono::milliseconds timeout, const std::atomic<bool>& stop) {
+            LOG_FUNCTION_ENTER("ConnectUnixSocket(path = {}, timeout = {})", path, timeout.count());
+
+            sockaddr_un addr;
+            if (!MakeUnixSocketAddress(path, addr)) {
+                return -1;
+            }
+
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (!stop) {
+                int fd = ::socket(AF_UNIX, static_cast<int>(type) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                if (fd < 0) {
+                    LOG_ERROR_D("socket error = {}", errno);
+                    return -1;
+                }
+
+                if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+                    return fd;
+                }
+
+                auto err = errno;
+                if (err == EINPROGRESS) {
+                    // the result is known when the socket becomes writable
+                    if (!PollFd(fd, POLLOUT, stop)) {
+                        ::close(fd);
+                        return -1;
+                    }
+                    int soError = 0;
+                    socklen_t soErrorSize = sizeof(soError);
+                    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &soError, &soErrorSize) < 0) {
+                        soError = errno;
+                    }
+                    if (soError == 0) {
+                        return fd;
+                    }
+                    err = soError;
+                }
+                ::close(fd);
+
+                // Server not created yet or its backlog is full (EAGAIN), wait like WaitOpenPipe does
+                if (err != ENOENT && err != ECONNREFUSED && err != EAGAIN) {
+                    LOG_ERROR_D("connect error = {}", err);
+                    return -1;
+                }
+                if (timeout.count() != 0 && std::chrono::steady_clock::now() >= deadline) { // 0 - infinity wait
+                    LOG_ERROR_D("connect timeout");
+                    return -1;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+            }
+
+            return -1;
+        }
+
+        int ListenUnixSocket(const std::string& path, UnixSocketType type, int backlog) {
+            LOG_FUNCTION_ENTER("ListenUnixSocket(path = {}, backlog = {})", path, backlog);
+
+            sockaddr_un addr;
+            if (!MakeUnixSocketAddress(path, addr)) {
+                return -1;
+            }
+
+            int fd = ::socket(AF_UNIX, static_cast<int>(type) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                LOG_ERROR_D("socket error = {}", errno);
+                return -1;
+            }
+
+            ::unlink(path.c_str()); // remove stale socket file left after previous process
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, backlog) < 0) {
+                LOG_ERROR_D("bind / listen error = {}", errno);
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        int AcceptUnixSocket(int listenFd) {
+            while (true) {
+                int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0 && errno == EINTR) {
+                    continue;
+                }
+                return fd;
+            }
+        }
+
+        bool PollFd(int fd, short events, const std::atomic<bool>& stop) {
+            pollfd pfd{ fd, events, 0 };
+            while (!stop) {
+                int res = ::poll(&pfd, 1, pollIntervalMs);
+                if (res > 0) {
+                    return (pfd.revents & events) != 0;
+                }
+                if (res < 0 && errno != EINTR) {
+                    LOG_ERROR_D("poll error = {}", errno);
+                    return false;
+                }
+            }
+            return false;
+        }
+    }
+
+
+    UnixSocketListener::UnixSocketListener(const std::string& path, UnixSocketType type, AcceptHandler acceptHandler, std::shared_ptr<EpollReactor> reactor)
+        : path{ path }
+        , type{ type }
+        , acceptHandler{ std::move(acceptHandler) }
+        , reactor{ std::move(reactor) }
+    {
+        LOG_FUNCTION_ENTER("UnixSocketListener(path = {})", path);
+
+        this->listenFd = details::ListenUnixSocket(path, type, SOMAXCONN);
+        if (this->listenFd < 0) {
+            throw PipeError::InvalidHandle;
+        }
+
+        this->reactor->Add(this->listenFd, EPOLLIN, [this](uint32_t) {
+            this->OnAcceptReady();
+            });
+    }
+
+    UnixSocketListener::~UnixSocketListener() {
+        LOG_FUNCTION_ENTER("~UnixSocketListener()");
+        this->reactor->Remove(this->listenFd);
+        ::close(this->listenFd);
+        ::unlink(this->path.c_str());
+    }
+
+    void UnixSocketListener::OnAcceptReady() {
+        int fd = -1;
+        while ((fd = details::AcceptUnixSocket(this->listenFd)) >= 0) {
+            this->acceptHandler(std::make_shared<UnixSocketTransport<uint8_t>>(fd, this->type, this->reactor));
+        }
+    }
+}
+#endif
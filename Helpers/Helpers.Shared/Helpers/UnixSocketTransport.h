@@ -0,0 +1,313 @@
+#pragma once
+#include "common.h"
+#if defined(__linux__)
+#include "ChannelTransport.h"
+#include "EpollReactor.h"
+#include "Logger.h"
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+
+#include <type_traits>
+#include <functional>
+#include <utility>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <mutex>
+
+namespace HELPERS_NS {
+    enum class UnixSocketType {
+        Stream = SOCK_STREAM,
+        SeqPacket = SOCK_SEQPACKET, // preserves message boundaries, every Write is delivered as one record
+    };
+
+    namespace details {
+        // All returned descriptors are non-blocking and close-on-exec, -1 on error.
+        std::pair<int, int> CreateUnixSocketPair(UnixSocketType type);
+        int ConnectUnixSocket(const std::string& path, UnixSocketType type, std::chrono::milliseconds timeout, const std::atomic<bool>& stop);
+        int ListenUnixSocket(const std::string& path, UnixSocketType type, int backlog);
+        int AcceptUnixSocket(int listenFd);
+
+        // Waits until fd ready for 'events' or 'stop' was set (checked every pollInterval).
+        bool PollFd(int fd, short events, const std::atomic<bool>& stop);
+    }
+
+
+    // AF_UNIX socket transport driven by EpollReactor. Owns the descriptor.
+    template <typename T = uint8_t>
+    class UnixSocketTransport : public IChannelTransport<T> {
+    public:
+        UnixSocketTransport(int fd, UnixSocketType type, std::shared_ptr<EpollReactor> reactor = EpollReactor::GetDefault())
+            : fd{ fd }
+            , type{ type }
+            , reactor{ std::move(reactor) }
+        {}
+
+        ~UnixSocketTransport() {
+            this->Close();
+        }
+
+        UnixSocketTransport(const UnixSocketTransport&) = delete;
+        UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+
+        static std::pair<std::shared_ptr<UnixSocketTransport>, std::shared_ptr<UnixSocketTransport>> CreatePair(
+            UnixSocketType type = UnixSocketType::SeqPacket,
+            std::shared_ptr<EpollReactor> reactor = EpollReactor::GetDefault())
+        {
+            auto [fdA, fdB] = details::CreateUnixSocketPair(type);
+            if (fdA < 0) {
+                throw PipeError::InvalidHandle;
+            }
+            return {
+                std::make_shared<UnixSocketTransport>(fdA, type, reactor),
+                std::make_shared<UnixSocketTransport>(fdB, type, reactor)
+            };
+        }
+
+        static std::shared_ptr<UnixSocketTransport> Connect(
+            const std::string& path,
+            UnixSocketType type = UnixSocketType::SeqPacket,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds{ 10'000 },
+            std::shared_ptr<EpollReactor> reactor = EpollReactor::GetDefault())
+        {
+            std::atomic<bool> stop = false;
+            int fd = details::ConnectUnixSocket(path, type, timeout, stop);
+            if (fd < 0) {
+                throw PipeError::InvalidHandle;
+            }
+            return std::make_shared<UnixSocketTransport>(fd, type, reactor);
+        }
+
+        int GetFd() {
+            return this->fd;
+        }
+
+        bool IsValid() override {
+            return this->fd >= 0;
+        }
+
+        void Read(const std::atomic<bool>& stop, std::vector<T>& outBuffer) override {
+            std::size_t outBufferOldSize = outBuffer.size();
+
+            while (!stop) {
+                std::size_t bytesToRead = BUFFER_PIPE * sizeof(T);
+                ssize_t res = 1;
+                if (this->type == UnixSocketType::SeqPacket) {
+                    // MSG_TRUNC with zero sized buffer returns the real record size (record must be read at once).
+                    // Don't fall back to default size on error: record arrived after peek would be truncated.
+                    res = ::recv(this->fd, nullptr, 0, MSG_PEEK | MSG_TRUNC);
+                    if (res > 0) {
+                        bytesToRead = static_cast<std::size_t>(res);
+                    }
+                }
+
+                if (res > 0) {
+                    std::size_t outBufferSize = outBuffer.size();
+                    outBuffer.resize(outBufferSize + (bytesToRead + sizeof(T) - 1) / sizeof(T));
+
+                    res = ::recv(this->fd, reinterpret_cast<uint8_t*>(outBuffer.data() + outBufferSize), bytesToRead, 0);
+                    if (res > 0) {
+                        outBuffer.resize(outBufferSize + res / sizeof(T));
+                        continue; // drain socket until EAGAIN
+                    }
+                    outBuffer.resize(outBufferSize);
+                }
+
+                if (res == 0) {
+                    LOG_DEBUG_D("Other side closed connection");
+                    throw PipeError::ReadError;
+                }
+
+                switch (errno) {
+                case EINTR:
+                    continue;
+
+                case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+#endif
+                    if (outBuffer.size() > outBufferOldSize) {
+                        return;
+                    }
+                    if (this->IsEventDriven() && this->reading) {
+                        return; // spurious wakeup, wait next EPOLLIN
+                    }
+                    if (!details::PollFd(this->fd, POLLIN, stop)) {
+                        throw PipeError::ReadError;
+                    }
+                    continue;
+
+                default:
+                    LOG_ERROR_D("recv error = {}", errno);
+                    throw PipeError::ReadError;
+                }
+            }
+
+            throw PipeError::ReadError; // was stopped
+        }
+
+        void Write(const std::atomic<bool>& stop, std::span<T> writeData) override {
+            auto pData = reinterpret_cast<const uint8_t*>(writeData.data());
+            std::size_t remainingBytes = writeData.size() * sizeof(T);
+
+            if (remainingBytes == 0) {
+                return; // zero sized record can't be distinguished from closed connection on receiver side
+            }
+
+            do {
+                auto res = ::send(this->fd, pData, remainingBytes, MSG_NOSIGNAL);
+                if (res >= 0) {
+                    pData += res;
+                    remainingBytes -= res;
+                    continue;
+                }
+
+                switch (errno) {
+                case EINTR:
+                    continue;
+
+                case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+#endif
+                    if (!details::PollFd(this->fd, POLLOUT, stop)) {
+                        throw PipeError::WriteError;
+                    }
+                    continue;
+
+                default:
+                    LOG_ERROR_D("send error = {}", errno);
+                    throw PipeError::WriteError;
+                }
+            } while (remainingBytes > 0);
+        }
+
+        void WriteGather(const std::atomic<bool>& stop, std::span<const std::span<T>> buffers) override {
+            constexpr std::size_t maxIovCount = 16;
+            if (buffers.size() > maxIovCount) {
+                IChannelTransport<T>::WriteGather(stop, buffers);
+                return;
+            }
+
+            iovec iov[maxIovCount];
+            std::size_t iovCount = 0;
+            for (auto& buffer : buffers) {
+                if (!buffer.empty()) {
+                    iov[iovCount++] = iovec{ const_cast<std::remove_const_t<T>*>(buffer.data()), buffer.size() * sizeof(T) };
+                }
+            }
+
+            std::size_t iovIdx = 0;
+            while (iovIdx < iovCount) {
+                msghdr msg{};
+                msg.msg_iov = iov + iovIdx;
+                msg.msg_iovlen = iovCount - iovIdx;
+
+                auto res = ::sendmsg(this->fd, &msg, MSG_NOSIGNAL);
+                if (res < 0) {
+                    switch (errno) {
+                    case EINTR:
+                        continue;
+
+                    case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                    case EWOULDBLOCK:
+#endif
+                        if (!details::PollFd(this->fd, POLLOUT, stop)) {
+                            throw PipeError::WriteError;
+                        }
+                        continue;
+
+                    default:
+                        LOG_ERROR_D("sendmsg error = {}", errno);
+                        throw PipeError::WriteError;
+                    }
+                }
+
+                // Partial write is possible only for SOCK_STREAM, skip sent bytes and send the rest
+                std::size_t sentBytes = static_cast<std::size_t>(res);
+                while (iovIdx < iovCount && sentBytes >= iov[iovIdx].iov_len) {
+                    sentBytes -= iov[iovIdx].iov_len;
+                    iovIdx++;
+                }
+                if (iovIdx < iovCount) {
+                    iov[iovIdx].iov_base = static_cast<uint8_t*>(iov[iovIdx].iov_base) + sentBytes;
+                    iov[iovIdx].iov_len -= sentBytes;
+                }
+            }
+        }
+
+        void Close() override {
+            this->StopReading();
+            if (this->fd >= 0) {
+                ::close(this->fd);
+                this->fd = -1;
+            }
+        }
+
+        bool IsEventDriven() override {
+            return this->reactor != nullptr;
+        }
+
+        void StartReading(std::function<void()> readableHandler, std::function<void()> closedHandler) override {
+            this->reading = true;
+            this->reactor->Add(this->fd, EPOLLIN | EPOLLRDHUP, [readableHandler, closedHandler](uint32_t events) {
+                if (events & EPOLLIN) {
+                    readableHandler(); // read pending data first, it may contain last messages before EPOLLRDHUP
+                }
+                else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    closedHandler();
+                }
+                });
+        }
+
+        void StopReading() override {
+            if (this->reading.exchange(false)) {
+                this->reactor->Remove(this->fd);
+            }
+        }
+
+        void Post(std::function<void()> callback) override {
+            this->reactor->Post(std::move(callback));
+        }
+
+        bool IsReactorThread() override {
+            return this->reactor && this->reactor->IsReactorThread();
+        }
+
+    private:
+        int fd = -1;
+        UnixSocketType type;
+        std::atomic<bool> reading = false;
+        std::shared_ptr<EpollReactor> reactor;
+    };
+
+
+    // Accepts AF_UNIX connections on the reactor thread and hands every peer over as separate transport.
+    class UnixSocketListener {
+    public:
+        using AcceptHandler = std::function<void(std::shared_ptr<UnixSocketTransport<uint8_t>>)>;
+
+        UnixSocketListener(const std::string& path, UnixSocketType type, AcceptHandler acceptHandler, std::shared_ptr<EpollReactor> reactor = EpollReactor::GetDefault());
+        ~UnixSocketListener();
+
+        UnixSocketListener(const UnixSocketListener&) = delete;
+        UnixSocketListener& operator=(const UnixSocketListener&) = delete;
+
+    private:
+        void OnAcceptReady();
+
+    private:
+        int listenFd = -1;
+        std::string path;
+        UnixSocketType type;
+        AcceptHandler acceptHandler;
+        std::shared_ptr<EpollReactor> reactor;
+    };
+}
+#endif
@@ -2,19 +2,41 @@
 #include "common.h"
 #include "IWeakEvent.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <vector>
+#include <atomic>
+#include <array>
 #include <mutex>
-#include <algorithm>
 
 namespace HELPERS_NS {
+    // Subscribers are kept in slot array, freed slots are reused (slot generation changes on every reuse).
+    // Expired subscribers are reclaimed lazily: by dispatch in batches of reclaimBatchSize and by Subscribe before growing the array
+    // when it doubled since the previous scan (so subscribing stays amortized O(1)).
+    // Dispatch locks subscribers into stack buffer (heap is used only above inlineDispatchCount subscribers),
+    // so steady state operator() doesn't allocate.
+    // NOTE: handlers order is subscription order only until some slot is reused.
     template<typename ...Args>
     class WeakEvent final : public IWeakEvent<Args...> {
     public:
         using typename IWeakEvent<Args...>::Handler;
 
+        static constexpr size_t inlineDispatchCount = 16;
+        static constexpr size_t reclaimBatchSize = 8;
+
         void Subscribe(Handler handler, IWeakEventToken token) override {
+            auto handlerPtr = std::make_unique<const Handler>(std::move(handler)); // stable address for dispatch
+
             auto lock = std::lock_guard(this->mx);
-            this->callbacks.emplace_back(std::move(token), std::move(handler));
+            if (this->freeHead == invalidSlot && this->slots.size() >= this->nextReclaimSize) {
+                this->ReclaimExpiredSlots(); // before growing the array
+                this->nextReclaimSize = (std::max)(reclaimBatchSize, this->slots.size() * 2);
+            }
+            const uint32_t slotIdx = this->AllocateSlot();
+            this->slots[slotIdx].token = std::move(token);
+            this->slots[slotIdx].handler = std::move(handlerPtr);
         }
 
         void Unsubscribe(IWeakEventToken token) override {
@@ -24,44 +46,150 @@ namespace HELPERS_NS {
             }
 
             auto lock = std::lock_guard(this->mx);
-            auto it = std::find_if(this->callbacks.begin(), this->callbacks.end(),
-                [&lockedToken](const HandlerItem& item)
-                {
-                    return lockedToken == item.token.lock();
-                });
-            if (it != this->callbacks.end()) {
-                this->callbacks.erase(it);
+            for (uint32_t slotIdx = 0; slotIdx < this->slots.size(); slotIdx++) {
+                if (this->slots[slotIdx].handler && lockedToken == this->slots[slotIdx].token.lock()) {
+                    this->FreeSlot(slotIdx);
+                    return;
+                }
             }
         }
 
         void operator()(Args... args) {
-            std::vector<HandlerItem> tmp;
+            DispatchBuffer dispatchBuffer;
+            std::array<SlotRef, reclaimBatchSize> expiredSlots;
+            size_t expiredCount = 0;
             {
                 auto lock = std::lock_guard(this->mx);
+                this->dispatchDepth++;
+                for (uint32_t slotIdx = 0; slotIdx < this->slots.size(); slotIdx++) {
+                    auto& slot = this->slots[slotIdx];
+                    if (!slot.handler) {
+                        continue;
+                    }
+                    if (auto lockedToken = slot.token.lock()) {
+                        dispatchBuffer.Push(DispatchItem{ std::move(lockedToken), slot.handler.get() });
+                    }
+                    else if (expiredCount < expiredSlots.size()) {
+                        expiredSlots[expiredCount++] = SlotRef{ slotIdx, slot.generation };
+                    }
+                }
+            }
 
-                std::erase_if(this->callbacks,
-                    [](const HandlerItem& item)
-                    {
-                        return item.token.expired();
-                    });
-
-                tmp = callbacks;
+            for (size_t i = 0; i < dispatchBuffer.Size(); i++) {
+                (*dispatchBuffer[i].handler)(args...); // not forwarded: every handler gets the same arguments
             }
 
-            for (auto& item : tmp) {
-                if (auto locked = item.token.lock()) {
-                    item.handler(std::forward<Args>(args)...);
+            // Expired slots are rare and cheap to skip, so they are reclaimed only when the batch is full
+            // (or nobody is alive anymore). Handlers above may reuse freed slots, generation guards from freeing new subscriber.
+            const bool reclaimExpired = expiredCount == reclaimBatchSize || (expiredCount > 0 && dispatchBuffer.Size() == 0);
+            if (this->dispatchDepth.fetch_sub(1) == 1 && this->hasRetiredHandlers) {
+                auto lock = std::lock_guard(this->mx);
+                this->ReleaseRetiredHandlers();
+            }
+            if (reclaimExpired) {
+                auto lock = std::lock_guard(this->mx);
+                for (size_t i = 0; i < expiredCount; i++) {
+                    const auto& expiredSlot = expiredSlots[i];
+                    if (this->slots[expiredSlot.index].generation == expiredSlot.generation && this->slots[expiredSlot.index].handler) {
+                        this->FreeSlot(expiredSlot.index);
+                    }
                 }
             }
         }
 
     private:
-        struct HandlerItem {
+        static constexpr uint32_t invalidSlot = (std::numeric_limits<uint32_t>::max)();
+
+        struct Slot {
             IWeakEventToken token;
-            Handler handler;
+            std::unique_ptr<const Handler> handler; // nullptr - free slot
+            uint32_t generation = 0;
+            uint32_t nextFree = invalidSlot;
+        };
+
+        struct SlotRef {
+            uint32_t index = invalidSlot;
+            uint32_t generation = 0;
+        };
+
+        struct DispatchItem {
+            std::shared_ptr<void> lockedToken; // keeps subscriber alive during its handler call
+            const Handler* handler; // valid until dispatch ends (see retiredHandlers)
+        };
+
+        // Small buffer for dispatch: first inlineDispatchCount items on stack, the rest in heap.
+        class DispatchBuffer {
+        public:
+            void Push(DispatchItem&& item) {
+                if (this->inlineCount < this->inlineItems.size()) {
+                    this->inlineItems[this->inlineCount++] = std::move(item);
+                }
+                else {
+                    this->overflowItems.push_back(std::move(item));
+                }
+            }
+
+            size_t Size() const {
+                return this->inlineCount + this->overflowItems.size();
+            }
+
+            DispatchItem& operator[](size_t idx) {
+                return idx < this->inlineCount ? this->inlineItems[idx] : this->overflowItems[idx - this->inlineCount];
+            }
+
+        private:
+            std::array<DispatchItem, inlineDispatchCount> inlineItems;
+            size_t inlineCount = 0;
+            std::vector<DispatchItem> overflowItems;
         };
 
+        uint32_t AllocateSlot() {
+            if (this->freeHead != invalidSlot) {
+                const uint32_t slotIdx = this->freeHead;
+                this->freeHead = this->slots[slotIdx].nextFree;
+                this->slots[slotIdx].nextFree = invalidSlot;
+                return slotIdx;
+            }
+            this->slots.emplace_back();
+            return static_cast<uint32_t>(this->slots.size() - 1);
+        }
+
+        void ReclaimExpiredSlots() {
+            for (uint32_t slotIdx = 0; slotIdx < this->slots.size(); slotIdx++) {
+                if (this->slots[slotIdx].handler && this->slots[slotIdx].token.expired()) {
+                    this->FreeSlot(slotIdx);
+                }
+            }
+        }
+
+        void FreeSlot(uint32_t slotIdx) {
+            auto& slot = this->slots[slotIdx];
+            slot.token.reset();
+            if (this->dispatchDepth > 0) {
+                this->retiredHandlers.push_back(std::move(slot.handler)); // may be in dispatch buffer of running operator()
+                this->hasRetiredHandlers = true;
+            }
+            slot.handler.reset();
+            slot.generation++;
+            slot.nextFree = this->freeHead;
+            this->freeHead = slotIdx;
+        }
+
+        void ReleaseRetiredHandlers() {
+            if (this->dispatchDepth == 0) { // other dispatch could start meanwhile
+                this->retiredHandlers.clear();
+                this->hasRetiredHandlers = false;
+            }
+        }
+
+    private:
         std::mutex mx;
-        std::vector<HandlerItem> callbacks;
+        std::vector<Slot> slots;
+        uint32_t freeHead = invalidSlot;
+        size_t nextReclaimSize = reclaimBatchSize; // Subscribe scans for expired slots only when array reached this size
+
+        std::atomic<uint32_t> dispatchDepth = 0; // incremented under lock, so retired handlers are released only when nobody uses them
+        std::atomic<bool> hasRetiredHandlers = false;
+        std::vector<std::unique_ptr<const Handler>> retiredHandlers;
     };
 }
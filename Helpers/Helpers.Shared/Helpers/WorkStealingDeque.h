@@ -0,0 +1,139 @@
+#pragma once
+#include "common.h"
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace HELPERS_NS {
+    // Chase-Lev work-stealing deque ("Correct and Efficient Work-Stealing for Weak Memory Models", Le et al.).
+    // Owner thread pushes and pops at the bottom (LIFO, hot in cache), other threads steal from the top (FIFO).
+    // Only the last item is contended, all other operations of the owner are free of atomic read-modify-write.
+    // T must be trivially copyable (usually pointer).
+    template <typename T>
+    class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(std::size_t initialCapacity = 256) {
+            std::size_t capacity = 2;
+            while (capacity < initialCapacity) {
+                capacity <<= 1;
+            }
+
+            this->buffers.push_back(std::make_unique<Buffer>(capacity));
+            this->buffer.store(this->buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        // Owner thread only.
+        void Push(T value) {
+            int64_t b = this->bottom.load(std::memory_order_relaxed);
+            int64_t t = this->top.load(std::memory_order_acquire);
+            Buffer* buf = this->buffer.load(std::memory_order_relaxed);
+
+            if (b - t > static_cast<int64_t>(buf->mask)) {
+                buf = this->Grow(buf, t, b);
+            }
+
+            buf->Put(b, value);
+            this->bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // Owner thread only.
+        bool Pop(T& value) {
+            int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* buf = this->buffer.load(std::memory_order_relaxed);
+
+            // seq_cst store/load pair orders bottom against thieves reading top (Dekker)
+            this->bottom.store(b, std::memory_order_seq_cst);
+            int64_t t = this->top.load(std::memory_order_seq_cst);
+
+            if (t > b) {
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            value = buf->Get(b);
+            if (t == b) {
+                // last item, thieves may take it too
+                bool won = this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        // Any thread. Returns false when deque is empty or another thread took the item first.
+        bool Steal(T& value) {
+            int64_t t = this->top.load(std::memory_order_seq_cst);
+            int64_t b = this->bottom.load(std::memory_order_seq_cst);
+
+            if (t >= b) {
+                return false;
+            }
+
+            Buffer* buf = this->buffer.load(std::memory_order_acquire);
+            T item = buf->Get(t);
+            if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return false;
+            }
+
+            value = item;
+            return true;
+        }
+
+        // Approximate when called concurrently with Push / Pop / Steal.
+        std::size_t Size() const {
+            int64_t b = this->bottom.load(std::memory_order_relaxed);
+            int64_t t = this->top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<std::size_t>(b - t) : 0;
+        }
+
+        bool Empty() const {
+            return this->Size() == 0;
+        }
+
+    private:
+        struct Buffer {
+            std::size_t mask;
+            std::unique_ptr<std::atomic<T>[]> items;
+
+            explicit Buffer(std::size_t capacity)
+                : mask{ capacity - 1 }
+                , items{ new std::atomic<T>[capacity] }
+            {}
+
+            void Put(int64_t idx, T value) {
+                this->items[static_cast<std::size_t>(idx) & this->mask].store(value, std::memory_order_relaxed);
+            }
+
+            T Get(int64_t idx) const {
+                return this->items[static_cast<std::size_t>(idx) & this->mask].load(std::memory_order_relaxed);
+            }
+        };
+
+        Buffer* Grow(Buffer* old, int64_t t, int64_t b) {
+            auto grown = std::make_unique<Buffer>((old->mask + 1) * 2);
+            for (int64_t i = t; i < b; i++) {
+                grown->Put(i, old->Get(i));
+            }
+
+            Buffer* buf = grown.get();
+            this->buffers.push_back(std::move(grown));
+            this->buffer.store(buf, std::memory_order_release);
+            return buf;
+        }
+
+    private:
+        alignas(64) std::atomic<int64_t> top = 0;
+        alignas(64) std::atomic<int64_t> bottom = 0;
+        std::atomic<Buffer*> buffer = nullptr;
+
+        // Replaced buffers are kept until destruction: thief may still read the old one.
+        // Capacity doubles, so all of them take less memory than the current one.
+        std::vector<std::unique_ptr<Buffer>> buffers;
+    };
+}
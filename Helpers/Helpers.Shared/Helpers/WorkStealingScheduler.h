@@ -0,0 +1,222 @@
+#pragma once
+#include "common.h"
+#include "WorkStealingDeque.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <limits>
+#include <vector>
+#include <deque>
+#include <array>
+#include <mutex>
+
+namespace HELPERS_NS {
+    // Scheduling core of work-stealing pools (libhelpers ThreadPool, Async::ThreadPoolExecutor), pools own threads and tasks.
+    // Every worker has WorkStealingDeque per priority: tasks scheduled from worker go to its own deque
+    // (no shared lock, LIFO order keeps data hot), tasks from other threads go to global injection queue.
+    // Idle worker takes highest priority task in order: own deque, injection queue, steal from other workers,
+    // and sleeps when there is nothing to do.
+    // T must be trivially copyable (usually pointer to task), tasks not started until Stop are returned by Drain.
+    template <typename T, std::size_t PriorityCount = 1>
+    class WorkStealingScheduler {
+    public:
+        static constexpr std::size_t noWorker = (std::numeric_limits<std::size_t>::max)(); // caller is not a worker
+
+        explicit WorkStealingScheduler(std::size_t workerCount) {
+            for (auto& count : this->injectedCounts) {
+                count = 0;
+            }
+
+            // all workers must exist before the first of them starts stealing
+            for (std::size_t i = 0; i < workerCount; i++) {
+                this->workers.push_back(std::make_unique<WorkerQueues>(static_cast<uint32_t>(i) * 2654435761u + 1));
+            }
+        }
+
+        WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+        WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+        std::size_t GetWorkerCount() const {
+            return this->workers.size();
+        }
+
+        // workerIdx - index of the calling worker or noWorker.
+        void Schedule(T task, std::size_t workerIdx, std::size_t priorityIdx = 0) {
+            if (workerIdx != noWorker) {
+                this->workers[workerIdx]->deques[priorityIdx].Push(task);
+            }
+            else {
+                std::lock_guard lk{ this->mxInjected };
+                this->injected[priorityIdx].push_back(task);
+                this->injectedCounts[priorityIdx].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            this->NotifyWork();
+        }
+
+        // Any thread, workerIdx - index of the calling worker or noWorker.
+        bool FindTask(std::size_t workerIdx, T& task) {
+            WorkerQueues* self = workerIdx != noWorker ? this->workers[workerIdx].get() : nullptr;
+
+            for (std::size_t priorityIdx = 0; priorityIdx < PriorityCount; priorityIdx++) {
+                if (self && self->deques[priorityIdx].Pop(task)) {
+                    return true;
+                }
+                if (this->PopInjected(priorityIdx, task)) {
+                    return true;
+                }
+                if (this->Steal(self, priorityIdx, task)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Loop of worker thread: runs found tasks with run(task) until Stop, sleeps while there is no work.
+        template <typename RunF>
+        void RunWorker(std::size_t workerIdx, RunF&& run) {
+            const uint32_t spinCount = std::thread::hardware_concurrency() > 1 ? 64 : 0;
+
+            while (!this->stopped.load(std::memory_order_relaxed)) {
+                const uint64_t epoch = this->workEpoch.load(std::memory_order_seq_cst);
+
+                T task{};
+                if (this->FindTask(workerIdx, task)) {
+                    run(task);
+                    continue;
+                }
+
+                bool found = false;
+                for (uint32_t i = 0; i < spinCount && !found; i++) {
+                    std::this_thread::yield();
+                    found = this->workEpoch.load(std::memory_order_relaxed) != epoch;
+                }
+
+                if (!found) {
+                    this->Sleep(epoch);
+                }
+            }
+        }
+
+        // RunWorker returns after the current task, not started tasks stay queued (see Drain).
+        void Stop() {
+            {
+                std::lock_guard lk{ this->mxIdle }; // sleeping worker can't miss it between check and wait
+                this->stopped = true;
+            }
+            this->cvIdle.notify_all();
+        }
+
+        bool IsStopped() const {
+            return this->stopped;
+        }
+
+        // Calls func(task) for every not started task and removes it. Workers must be finished.
+        template <typename F>
+        void Drain(F&& func) {
+            T task{};
+            for (auto& worker : this->workers) {
+                for (auto& deque : worker->deques) {
+                    while (deque.Pop(task)) {
+                        func(task);
+                    }
+                }
+            }
+
+            std::lock_guard lk{ this->mxInjected };
+            for (std::size_t priorityIdx = 0; priorityIdx < PriorityCount; priorityIdx++) {
+                for (T injectedTask : this->injected[priorityIdx]) {
+                    func(injectedTask);
+                }
+                this->injected[priorityIdx].clear();
+                this->injectedCounts[priorityIdx] = 0;
+            }
+        }
+
+    private:
+        struct WorkerQueues {
+            std::array<WorkStealingDeque<T>, PriorityCount> deques;
+            uint32_t victimSeed;
+
+            explicit WorkerQueues(uint32_t victimSeed)
+                : victimSeed{ victimSeed }
+            {}
+
+            std::size_t NextVictim() {
+                // xorshift, spreads thieves over victims
+                this->victimSeed ^= this->victimSeed << 13;
+                this->victimSeed ^= this->victimSeed >> 17;
+                this->victimSeed ^= this->victimSeed << 5;
+                return this->victimSeed;
+            }
+        };
+
+        void NotifyWork() {
+            // pairs with Sleep: either worker sees the new epoch or we see it sleeping
+            this->workEpoch.fetch_add(1, std::memory_order_seq_cst);
+            if (this->sleepingCount.load(std::memory_order_seq_cst) != 0) {
+                {
+                    std::lock_guard lk{ this->mxIdle };
+                }
+                this->cvIdle.notify_one();
+            }
+        }
+
+        void Sleep(uint64_t epoch) {
+            std::unique_lock lk{ this->mxIdle };
+            this->sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+            this->cvIdle.wait(lk, [this, epoch] {
+                return this->stopped || this->workEpoch.load(std::memory_order_seq_cst) != epoch;
+                });
+            this->sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        bool PopInjected(std::size_t priorityIdx, T& task) {
+            if (this->injectedCounts[priorityIdx].load(std::memory_order_relaxed) == 0) {
+                return false; // lets workers skip the lock when queue is empty
+            }
+
+            std::lock_guard lk{ this->mxInjected };
+            auto& queue = this->injected[priorityIdx];
+            if (queue.empty()) {
+                return false;
+            }
+
+            task = queue.front();
+            queue.pop_front();
+            this->injectedCounts[priorityIdx].fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool Steal(WorkerQueues* self, std::size_t priorityIdx, T& task) {
+            const std::size_t workerCount = this->workers.size();
+            const std::size_t start = self ? self->NextVictim() : 0;
+
+            for (std::size_t i = 0; i < workerCount; i++) {
+                WorkerQueues* victim = this->workers[(start + i) % workerCount].get();
+                if (victim != self && victim->deques[priorityIdx].Steal(task)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    private:
+        std::vector<std::unique_ptr<WorkerQueues>> workers;
+
+        std::mutex mxInjected;
+        std::array<std::deque<T>, PriorityCount> injected;
+        std::array<std::atomic<std::size_t>, PriorityCount> injectedCounts;
+
+        std::mutex mxIdle;
+        std::condition_variable cvIdle;
+        std::atomic<bool> stopped = false;
+        std::atomic<uint64_t> workEpoch = 0;
+        std::atomic<uint32_t> sleepingCount = 0;
+    };
+}
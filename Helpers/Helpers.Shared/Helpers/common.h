@@ -77,6 +77,8 @@ namespace STD_EXT_NS {}
 #define COMPILE_FOR_CLR 0
 #define COMPILE_FOR_CX 0
 
+#include <cstdint>
+
 using HRESULT = std::int32_t;
 
 constexpr HRESULT S_OK   = 0;
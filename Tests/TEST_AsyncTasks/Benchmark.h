@@ -0,0 +1,42 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Shared timing helpers of *Benchmark tests.
+// Benchmarks are DISABLED_ so regular test runs stay fast, run them explicitly:
+//   TEST_AsyncTasks.exe --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+namespace Benchmark {
+    // Runs 'func' once and returns elapsed seconds.
+    template <typename F>
+    double MeasureSeconds(F&& func) {
+        const auto timeStart = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - timeStart).count();
+    }
+
+    template <typename F>
+    double MeasureNsPerOp(uint64_t opsCount, F&& func) {
+        return MeasureSeconds(std::forward<F>(func)) * 1e9 / opsCount;
+    }
+
+    template <typename F>
+    double MeasureOpsPerSec(uint64_t opsCount, F&& func) {
+        return opsCount / MeasureSeconds(std::forward<F>(func));
+    }
+
+    // Prints "<name>: <value> <unit>", rates are printed without fraction.
+    inline void Report(std::string_view name, double value, std::string_view unit) {
+        std::cout << "  " << name << ": ";
+        if (value >= 1000.0) {
+            std::cout << static_cast<uint64_t>(value);
+        }
+        else {
+            std::cout << value;
+        }
+        std::cout << " " << unit << std::endl;
+    }
+}
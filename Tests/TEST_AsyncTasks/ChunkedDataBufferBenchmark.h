@@ -0,0 +1,97 @@
+#pragma once
+#include "Benchmark.h"
+#include <libhelpers/Containers/ChunkedDataBuffer.h>
+
+#include <vector>
+#include <cstdint>
+
+struct ChunkedDataBufferThroughputResult {
+    size_t blockSize = 0; // samples pushed and popped per call
+    double perElementSamplesPerSec = 0; // PushBack(v) + Front() + PopFront()
+    double bulkSamplesPerSec = 0; // PushBack(ptr, count) + Pop(ptr, count)
+    double spanSamplesPerSec = 0; // PushBack(ptr, count) + PeekSpans + PopFront(count)
+    bool dataValid = false; // all modes returned pushed samples in order
+};
+
+// Audio-like workload: float samples go through the buffer in blocks, buffer keeps 'latencyBlocks' blocks of lag.
+inline std::vector<ChunkedDataBufferThroughputResult> ChunkedDataBufferThroughputBenchmark(size_t totalSamples = 16 * 1024 * 1024, size_t latencyBlocks = 4) {
+    const size_t blockSizes[] = { 64, 480, 4096, 16384 };
+    std::vector<ChunkedDataBufferThroughputResult> results;
+
+    for (size_t blockSize : blockSizes) {
+        ChunkedDataBufferThroughputResult result;
+        result.blockSize = blockSize;
+        result.dataValid = true;
+
+        const size_t blockCount = totalSamples / blockSize;
+        std::vector<float> input(blockSize);
+        std::vector<float> output(blockSize);
+
+        auto measure = [&](auto pushBlock, auto popBlock) {
+            ChunkedDataBuffer<float> buffer;
+            float nextIn = 0;
+            float nextOut = 0;
+
+            const double samplesPerSec = Benchmark::MeasureOpsPerSec(blockCount * blockSize, [&] {
+                for (size_t block = 0; block < blockCount + latencyBlocks; block++) {
+                    if (block < blockCount) {
+                        for (auto& sample : input) {
+                            sample = nextIn++;
+                        }
+                        pushBlock(buffer);
+                    }
+
+                    if (block >= latencyBlocks) {
+                        popBlock(buffer);
+                        result.dataValid = result.dataValid && output.front() == nextOut && output.back() == nextOut + (blockSize - 1);
+                        nextOut += blockSize;
+                    }
+                }
+                });
+
+            result.dataValid = result.dataValid && buffer.Empty();
+            return samplesPerSec;
+        };
+
+        result.perElementSamplesPerSec = measure(
+            [&](ChunkedDataBuffer<float>& buffer) {
+                for (float sample : input) {
+                    buffer.PushBack(sample);
+                }
+            },
+            [&](ChunkedDataBuffer<float>& buffer) {
+                for (auto& sample : output) {
+                    sample = buffer.Front();
+                    buffer.PopFront();
+                }
+            });
+
+        result.bulkSamplesPerSec = measure(
+            [&](ChunkedDataBuffer<float>& buffer) {
+                buffer.PushBack(input.data(), input.size());
+            },
+            [&](ChunkedDataBuffer<float>& buffer) {
+                buffer.Pop(output.data(), output.size());
+            });
+
+        result.spanSamplesPerSec = measure(
+            [&](ChunkedDataBuffer<float>& buffer) {
+                buffer.PushBack(input.data(), input.size());
+            },
+            [&](ChunkedDataBuffer<float>& buffer) {
+                // consumer reads samples in place, e.g. mixes them into its own buffer
+                size_t outIdx = 0;
+                buffer.PeekSpans(blockSize, [&](const ChunkedDataBuffer<float>::span& piece) {
+                    for (size_t i = 0; i < piece.size; i++) {
+                        output[outIdx++] = piece.data[i];
+                    }
+                    return true;
+                    });
+                buffer.PopFront(blockSize);
+            });
+
+        results.push_back(result);
+    }
+
+    return results;
+}
@@ -0,0 +1,31 @@
+#define LOGGER_ACTIVE_LEVEL SPDLOG_LEVEL_INFO // NOTE: Must be defined before the logger headers, that's why these tests are not in main.cpp.
+#include <Helpers/Logger.h>
+
+#include <gtest/gtest.h> // GoogleTest: https://google.github.io/googletest/primer.html
+#include <type_traits>
+
+//
+// Compile-time log level
+//
+// Tests that debug scope macros below LOGGER_ACTIVE_LEVEL become '(void)0', so neither the logger nor the arguments are evaluated
+TEST(LoggerActiveLevelTest, ScopeMacrosCompiledOut) {
+    static_assert(LOGGER_ACTIVE_LEVEL > SPDLOG_LEVEL_DEBUG);
+
+    int evaluated = 0;
+    auto argument = [&evaluated] {
+        return ++evaluated;
+    };
+    auto logger = [&evaluated] {
+        ++evaluated;
+        return lg::DefaultLoggers::FuncLogger();
+    };
+
+    static_assert(std::is_void_v<decltype(LOG_FUNCTION_SCOPE("Scope({})", argument()))>);
+    static_assert(std::is_void_v<decltype(LOG_SCOPED(logger(), Func, lg::nullctx, "Scoped({})", argument()))>);
+
+    {
+        LOG_FUNCTION_SCOPE("Scope({})", argument());
+        LOG_SCOPED(logger(), Func, lg::nullctx, "Scoped({})", argument()); // both in one scope: no variables are declared
+    }
+    EXPECT_EQ(evaluated, 0);
+}
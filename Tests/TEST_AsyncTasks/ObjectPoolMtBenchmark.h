@@ -0,0 +1,111 @@
+#pragma once
+#include "Benchmark.h"
+#include <libhelpers/Containers/ObjectPoolMt.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+struct ObjectPoolMtScalingResult {
+    uint32_t threadCount = 0;
+    double poolOpsPerSec = 0; // get + return pairs per second with ObjectPoolMt
+    double lockedOpsPerSec = 0; // the same with single mutex + vector pool (previous ObjectPoolMt design)
+};
+
+// Every thread borrows 'borrowCount' buffers at once and returns them, repeated 'iterations' times.
+// Runs thread counts 1, 2, 4 .. maxThreadCount, pools are pre-filled so nobody blocks.
+inline std::vector<ObjectPoolMtScalingResult> ObjectPoolMtScalingBenchmark(uint32_t maxThreadCount = 16, uint32_t iterations = 200000, uint32_t borrowCount = 4) {
+    using Buffer = std::unique_ptr<uint8_t[]>;
+
+    class LockedPool {
+    public:
+        void Add(Buffer&& obj) {
+            std::lock_guard<std::mutex> lk(this->mtx);
+            this->pool.push_back(std::move(obj));
+        }
+
+        Buffer Get() {
+            std::lock_guard<std::mutex> lk(this->mtx);
+            Buffer obj = std::move(this->pool.back());
+            this->pool.pop_back();
+            return obj;
+        }
+
+    private:
+        std::mutex mtx;
+        std::vector<Buffer> pool;
+    };
+
+    auto runThreads = [iterations](uint32_t threadCount, auto threadFn) {
+        std::atomic<bool> start = false;
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&start, &threadFn] {
+                while (!start) {
+                    std::this_thread::yield();
+                }
+                threadFn();
+            });
+        }
+
+        return Benchmark::MeasureOpsPerSec(static_cast<uint64_t>(threadCount) * iterations, [&] {
+            start = true;
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            });
+    };
+
+    std::vector<ObjectPoolMtScalingResult> results;
+
+    for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2) {
+        ObjectPoolMtScalingResult result;
+        result.threadCount = threadCount;
+        const uint32_t objCount = threadCount * borrowCount;
+
+        {
+            containers::ObjectPoolMt<Buffer> pool(containers::ObjectPoolMtPolicy::GrowOnEmpty, [] { return std::make_unique<uint8_t[]>(64); });
+            for (uint32_t i = 0; i < objCount; i++) {
+                pool.Add(std::make_unique<uint8_t[]>(64));
+            }
+
+            result.poolOpsPerSec = runThreads(threadCount, [&pool, iterations, borrowCount] {
+                std::vector<containers::ObjectPoolMt<Buffer>::UsageScope> borrowed;
+                for (uint32_t it = 0; it < iterations; it++) {
+                    borrowed.push_back(pool.Get());
+                    if (borrowed.size() == borrowCount) {
+                        borrowed.clear(); // returns all to pool
+                    }
+                }
+            });
+        }
+
+        {
+            LockedPool pool;
+            for (uint32_t i = 0; i < objCount; i++) {
+                pool.Add(std::make_unique<uint8_t[]>(64));
+            }
+
+            result.lockedOpsPerSec = runThreads(threadCount, [&pool, iterations, borrowCount] {
+                std::vector<Buffer> borrowed;
+                for (uint32_t it = 0; it < iterations; it++) {
+                    borrowed.push_back(pool.Get());
+                    if (borrowed.size() == borrowCount) {
+                        for (auto& obj : borrowed) {
+                            pool.Add(std::move(obj));
+                        }
+                        borrowed.clear();
+                    }
+                }
+            });
+        }
+
+        results.push_back(result);
+    }
+
+    return results;
+}
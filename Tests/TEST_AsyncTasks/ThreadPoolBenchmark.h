@@ -0,0 +1,72 @@
+#pragma once
+#include "Benchmark.h"
+#include <libhelpers/Thread/ThreadPool.h>
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+struct ThreadPoolScalingResult {
+    uint32_t threadCount = 0;
+    double parallelForItemsPerSec = 0; // ParallelFor over CPU bound items
+    double submitTasksPerSec = 0; // small tasks spawned from workers (exercises local deques and stealing)
+    double speedup = 0; // parallelForItemsPerSec relative to the 1 thread run
+};
+
+// Runs the same workloads on pools with 1..maxThreadCount workers.
+// itemCost - iterations of busy loop per item, keep it large enough to hide scheduling overhead.
+inline std::vector<ThreadPoolScalingResult> ThreadPoolScalingBenchmark(uint32_t maxThreadCount = 0, size_t itemCount = 200000, uint32_t itemCost = 2000) {
+    if (maxThreadCount == 0) {
+        maxThreadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+    }
+
+    std::vector<ThreadPoolScalingResult> results;
+
+    for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount++) {
+        auto pool = ThreadPool::Make(threadCount);
+        ThreadPoolScalingResult result;
+        result.threadCount = threadCount;
+
+        std::atomic<uint64_t> checksum = 0;
+        auto busyItem = [&checksum, itemCost](size_t i) {
+            uint64_t v = i;
+            for (uint32_t k = 0; k < itemCost; k++) {
+                v = v * 6364136223846793005ull + 1442695040888963407ull;
+            }
+            checksum.fetch_add(v & 1, std::memory_order_relaxed);
+        };
+
+        result.parallelForItemsPerSec = Benchmark::MeasureOpsPerSec(itemCount, [&] {
+            pool->ParallelFor(size_t(0), itemCount, busyItem);
+            });
+
+        // every root task fans out leaf tasks from the worker thread
+        const size_t rootCount = threadCount * 16;
+        const size_t leafCount = itemCount / rootCount;
+
+        result.submitTasksPerSec = Benchmark::MeasureOpsPerSec(rootCount * leafCount, [&] {
+            std::vector<std::future<void>> roots;
+            for (size_t r = 0; r < rootCount; r++) {
+                roots.push_back(pool->Submit([&pool, &busyItem, leafCount]() {
+                    std::vector<std::future<void>> leaves;
+                    for (size_t l = 0; l < leafCount; l++) {
+                        leaves.push_back(pool->Submit([&busyItem, l]() {
+                            busyItem(l);
+                            }));
+                    }
+                    for (auto& leaf : leaves) {
+                        pool->Wait(leaf);
+                    }
+                    }));
+            }
+            for (auto& root : roots) {
+                root.get();
+            }
+            });
+
+        result.speedup = results.empty() ? 1.0 : result.parallelForItemsPerSec / results.front().parallelForItemsPerSec;
+        results.push_back(result);
+    }
+
+    return results;
+}
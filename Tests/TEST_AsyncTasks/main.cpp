@@ -4,12 +4,41 @@
 #define TEST_AsyncTasks_FirendWrapper AsyncTasks_Test
 
 #include <Helpers/Async/AsyncTasks.h>
+#include <Helpers/Async/WhenAll.h>
 #include <Helpers/ConcurrentQueue.h>
+#include <Helpers/ChannelLanes.h>
+#include <Helpers/FramedReadBuffer.h>
 #include <Helpers/Signal.h>
+#include <Helpers/TaskChain.h>
+#include <Helpers/Pipeline.h>
+#include <Helpers/TimerService.h>
+#include <Helpers/WeakEvent.h>
+#include <Helpers/ThreadSafeObject.hpp>
 #include <Helpers/Logger.h>
+#include <libhelpers/Thread/LockProfiler.h>
+#include <libhelpers/Thread/QueuedLock.h>
+#include <libhelpers/Containers/slot_map.h>
+#include <libhelpers/Thread/ThreadPool.h>
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include "Benchmark.h"
+#include "ThreadPoolBenchmark.h"
+#include "ObjectPoolMtBenchmark.h"
+#include "ChunkedDataBufferBenchmark.h"
 
 #include <gtest/gtest.h> // GoogleTest: https://google.github.io/googletest/primer.html
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <latch>
+#include <numeric>
+#include <deque>
+#include <future>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include <mutex>
 
 
 namespace HELPERS_NS {
@@ -36,7 +65,7 @@ namespace HELPERS_NS {
         });
 
 
-void SomeAsyncOperationWithResumeSignal(std::chrono::milliseconds duration, std::weak_ptr<H::Signal<void()>> resumeSignalWeak) {
+void SomeAsyncOperationWithResumeSignal(std::chrono::milliseconds duration, std::weak_ptr<H::Event::Signal<void()>> resumeSignalWeak) {
     LOG_FUNCTION_SCOPE(L"SomeAsyncOperationWithResumeSignal()");
 
     H::Timer::Once(duration, [resumeSignalWeak] { // (1)
@@ -45,7 +74,7 @@ void SomeAsyncOperationWithResumeSignal(std::chrono::milliseconds duration, std:
             LOG_ERROR_D("resumeSignal expired");
             return;
         }
-        (*resumeSignal)(); // (2)
+        resumeSignal->Invoke(); // (2)
         NOOP;
         });
 }
@@ -58,7 +87,7 @@ public:
 
     H::Async::CoTask<H::Async::PromiseDefault>::Ret_t TaskMethod() {
         LOG_FUNCTION_SCOPE(L"TaskMethod()");
-        co_await H::Async::AsyncOperationWithResumeSignal([](std::weak_ptr<H::Signal<void()>> resumeSignalWeak) {
+        co_await H::Async::AsyncOperationWithResumeSignal([](std::weak_ptr<H::Event::Signal<void()>> resumeSignalWeak) {
             //SomeAsyncOperationWithResumeSignal(resumeSignalWeak);
             });
         co_return;
@@ -141,7 +170,7 @@ TEST_F(WorkQueueCoroutineTest, AsyncLambdaCalledInWorkQueueAfterShowEvent) {
         LOG_FUNCTION_SCOPE(L"TaskLambda()");
                 
         auto timePointA = std::chrono::high_resolution_clock::now();
-        co_await H::Async::AsyncOperationWithResumeSignal([&](std::weak_ptr<H::Signal<void()>> resumeSignalWeak) {
+        co_await H::Async::AsyncOperationWithResumeSignal([&](std::weak_ptr<H::Event::Signal<void()>> resumeSignalWeak) {
             SomeAsyncOperationWithResumeSignal(someAsyncOperation_duration, resumeSignalWeak);
             });
         auto timePointB = std::chrono::high_resolution_clock::now();
@@ -226,6 +255,2773 @@ TEST_F(WorkQueueCoroutineTest, AsyncLambdaCapturedArgsIsValid) {
 
 
 
+
+// Multi-producer contention benchmark: the same workload for both ConcurrentQueue implementations.
+template <H::ConcurrentQueueImpl impl>
+double MeasureConcurrentQueueThroughput(int producersCount, int consumersCount, uint32_t bufferSize) {
+    constexpr uint64_t itemsPerProducer = 200'000;
+    constexpr uint64_t stopItem = ~0ull; // each consumer exits on its own stop item (0 is returned for stopped queue)
+
+    H::ConcurrentQueue<uint64_t, impl> queue;
+    queue.SetBufferSize(bufferSize);
+
+    std::atomic<uint64_t> poppedSum = 0;
+    std::atomic<uint64_t> poppedCount = 0;
+
+    const double itemsPerSec = Benchmark::MeasureOpsPerSec(producersCount * itemsPerProducer, [&] {
+        std::vector<std::thread> consumers;
+        for (int i = 0; i < consumersCount; i++) {
+            consumers.emplace_back([&] {
+                uint64_t sum = 0;
+                uint64_t count = 0;
+                for (auto item = queue.Pop(); item != stopItem; item = queue.Pop()) {
+                    sum += item;
+                    count++;
+                }
+                poppedSum += sum;
+                poppedCount += count;
+                });
+        }
+
+        std::vector<std::thread> producers;
+        for (int i = 0; i < producersCount; i++) {
+            producers.emplace_back([&] {
+                for (uint64_t item = 1; item <= itemsPerProducer; item++) {
+                    queue.Push(uint64_t{ item });
+                }
+                });
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        for (int i = 0; i < consumersCount; i++) {
+            queue.Push(uint64_t{ stopItem });
+        }
+        for (auto& consumer : consumers) {
+            consumer.join();
+        }
+        });
+
+    EXPECT_EQ(poppedCount, producersCount * itemsPerProducer);
+    EXPECT_EQ(poppedSum, producersCount * itemsPerProducer * (itemsPerProducer + 1) / 2);
+    return itemsPerSec;
+}
+
+TEST(ConcurrentQueueBenchmark, DISABLED_MultiProducerContention) {
+    for (uint32_t bufferSize : { 1024u, 65536u }) {
+        for (int producersCount : { 1, 2, 4, 8 }) {
+            const std::string name = "bufferSize = " + std::to_string(bufferSize) + ", producers = " + std::to_string(producersCount) + ", consumers = 2, ";
+            Benchmark::Report(name + "Mutex", MeasureConcurrentQueueThroughput<H::ConcurrentQueueImpl::Mutex>(producersCount, 2, bufferSize), "items/s");
+            Benchmark::Report(name + "LockFreeRing", MeasureConcurrentQueueThroughput<H::ConcurrentQueueImpl::LockFreeRing>(producersCount, 2, bufferSize), "items/s");
+        }
+    }
+}
+
+TEST(ConcurrentQueueTest, LockFreeRingKeepsSkipBehaviour) {
+    H::ConcurrentQueue<int, H::ConcurrentQueueImpl::LockFreeRing> queue;
+    queue.SetBufferSize(4, H::ConcurrentQueueBehaviour::SkipWhenQueueSizeGreaterThanOrEqualBuffer);
+
+    for (int i = 1; i <= 10; i++) {
+        queue.Push(int{ i });
+    }
+    EXPECT_EQ(queue.ItemsCount(), 4);
+    for (int i = 1; i <= 4; i++) {
+        EXPECT_EQ(queue.Pop(), i);
+    }
+}
+
+TEST(ConcurrentQueueTest, LockFreeRingPopReturnsAfterStopWork) {
+    H::ConcurrentQueue<int, H::ConcurrentQueueImpl::LockFreeRing> queue;
+
+    std::thread stopThread([&] {
+        std::this_thread::sleep_for(50ms);
+        queue.StopWork();
+        });
+
+    EXPECT_EQ(queue.Pop(), 0); // parked on empty queue until StopWork
+    EXPECT_FALSE(queue.IsWorking());
+    stopThread.join();
+}
+
+// Single producer / single consumer: cost per item when items are moved by PushRange / PopBulk batches.
+template <H::ConcurrentQueueImpl impl>
+double MeasureConcurrentQueueNsPerItem(std::size_t batchSize) {
+    constexpr uint64_t itemsCount = 2'000'000;
+
+    H::ConcurrentQueue<uint64_t, impl> queue;
+    queue.SetBufferSize(4096);
+
+    uint64_t poppedSum = 0;
+
+    const double nsPerItem = Benchmark::MeasureNsPerOp(itemsCount, [&] {
+        std::thread consumer([&] {
+            std::vector<uint64_t> batch;
+            batch.reserve(batchSize);
+            for (uint64_t popped = 0; popped < itemsCount;) {
+                batch.clear();
+                popped += queue.PopBulk(batch, batchSize, 500ms);
+                for (auto item : batch) {
+                    poppedSum += item;
+                }
+            }
+            });
+
+        std::vector<uint64_t> batch(batchSize);
+        for (uint64_t item = 1; item <= itemsCount;) {
+            std::size_t count = static_cast<std::size_t>((std::min)(uint64_t{ batchSize }, itemsCount - item + 1));
+            for (std::size_t i = 0; i < count; i++) {
+                batch[i] = item++;
+            }
+            queue.PushRange(batch.begin(), batch.begin() + count);
+        }
+        consumer.join();
+        });
+
+    EXPECT_EQ(poppedSum, itemsCount * (itemsCount + 1) / 2);
+    return nsPerItem;
+}
+
+TEST(ConcurrentQueueBenchmark, DISABLED_BatchSizes) {
+    for (std::size_t batchSize : { 1, 16, 256 }) {
+        const std::string name = "batchSize = " + std::to_string(batchSize) + ", ";
+        Benchmark::Report(name + "Mutex", MeasureConcurrentQueueNsPerItem<H::ConcurrentQueueImpl::Mutex>(batchSize), "ns/item");
+        Benchmark::Report(name + "LockFreeRing", MeasureConcurrentQueueNsPerItem<H::ConcurrentQueueImpl::LockFreeRing>(batchSize), "ns/item");
+        Benchmark::Report(name + "SpscRing", MeasureConcurrentQueueNsPerItem<H::ConcurrentQueueImpl::SpscRing>(batchSize), "ns/item");
+    }
+}
+
+TEST(ConcurrentQueueTest, PopBulkReturnsOnTimeout) {
+    H::ConcurrentQueue<int, H::ConcurrentQueueImpl::SpscRing> queue;
+    std::vector<int> items;
+
+    EXPECT_EQ(queue.PopBulk(items, 16, 20ms), 0);
+
+    std::vector<int> input = { 1, 2, 3 };
+    queue.PushRange(input.begin(), input.end());
+    EXPECT_EQ(queue.PopBulk(items, 2, 20ms), 2);
+    EXPECT_EQ(queue.PopBulk(items, 16, 20ms), 1);
+    EXPECT_EQ(items, input);
+}
+
+// Tests that batches claimed by concurrent producers / consumers don't lose, duplicate or reorder items of one producer
+TEST(ConcurrentQueueTest, LockFreeRingBatchesKeepProducerOrder) {
+    constexpr int producersCount = 3;
+    constexpr int consumersCount = 2;
+    constexpr uint64_t itemsPerProducer = 100'000;
+
+    H::ConcurrentQueue<uint64_t, H::ConcurrentQueueImpl::LockFreeRing> queue;
+    queue.SetBufferSize(64); // small ring: batches wrap around and are claimed partially
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < producersCount; producer++) {
+        producers.emplace_back([&queue, producer] {
+            std::vector<uint64_t> batch;
+            for (uint64_t item = 0; item < itemsPerProducer;) {
+                batch.clear();
+                for (std::size_t i = 0; i < 1 + item % 37 && item < itemsPerProducer; i++) {
+                    batch.push_back((static_cast<uint64_t>(producer) << 32) | item++);
+                }
+                queue.PushRange(batch.begin(), batch.end());
+            }
+            });
+    }
+
+    std::atomic<uint64_t> poppedCount = 0;
+    std::atomic<bool> orderBroken = false;
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < consumersCount; i++) {
+        consumers.emplace_back([&] {
+            std::vector<int64_t> lastItem(producersCount, -1);
+            std::vector<uint64_t> batch;
+            while (poppedCount < producersCount * itemsPerProducer) {
+                batch.clear();
+                queue.PopBulk(batch, 16, 10ms);
+                for (auto value : batch) {
+                    auto& last = lastItem[value >> 32];
+                    const auto item = static_cast<int64_t>(value & 0xFFFFFFFF);
+                    if (item <= last) {
+                        orderBroken = true; // each consumer must see items of one producer in increasing order
+                    }
+                    last = item;
+                }
+                poppedCount += batch.size();
+            }
+            });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    EXPECT_EQ(poppedCount, producersCount * itemsPerProducer);
+    EXPECT_FALSE(orderBroken);
+    EXPECT_EQ(queue.ItemsCount(), 0);
+}
+
+
+
+// Returns time elapsed until all started tasks finished (or timeout expired).
+std::chrono::duration<double, std::milli> WaitAsyncTasksFinished(H::Async::AsyncTasks& asyncTasks, std::chrono::high_resolution_clock::time_point timeStart, std::chrono::milliseconds timeout) {
+    while (asyncTasks.IsExecutingStarted() && std::chrono::high_resolution_clock::now() - timeStart < timeout) {
+        std::this_thread::sleep_for(1ms);
+    }
+    return std::chrono::high_resolution_clock::now() - timeStart;
+}
+
+// Tests that tasks queued with executor don't wait each other
+TEST(AsyncTasksExecutorTest, IndependentTasksRunConcurrently) {
+    constexpr int tasksCount = 8;
+
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(2));
+
+    // every task finishes only after all of them started, one after another the first one would never finish
+    std::latch allStarted{ tasksCount };
+    std::atomic<int> finishedCount = 0;
+    for (int i = 0; i < tasksCount; i++) {
+        asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+            allStarted.count_down();
+            while (!allStarted.try_wait()) {
+                co_await H::Async::SleepFor(1ms);
+            }
+            finishedCount++;
+            co_return;
+            });
+    }
+
+    EXPECT_TRUE(asyncTasks.StartExecuting());
+    WaitAsyncTasksFinished(asyncTasks, std::chrono::high_resolution_clock::now(), 5000ms); // timeout only guards against hang
+
+    EXPECT_EQ(finishedCount, tasksCount);
+}
+
+// Tests that sleeping tasks don't occupy executor threads
+TEST(AsyncTasksExecutorTest, SleepForDoesNotBlockThread) {
+    constexpr int tasksCount = 100;
+
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(1));
+
+    // all tasks must be sleeping at once on the only thread, blocking sleep would never let the rest start
+    std::latch allSleeping{ tasksCount };
+    std::atomic<int> finishedCount = 0;
+    for (int i = 0; i < tasksCount; i++) {
+        asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+            allSleeping.count_down();
+            do {
+                co_await H::Async::SleepFor(1ms);
+            } while (!allSleeping.try_wait());
+            finishedCount++;
+            co_return;
+            });
+    }
+
+    asyncTasks.StartExecuting();
+    WaitAsyncTasksFinished(asyncTasks, std::chrono::high_resolution_clock::now(), 5000ms); // timeout only guards against hang
+
+    EXPECT_EQ(finishedCount, tasksCount);
+}
+
+// Tests that coroutine continues on the executor passed to ScheduleOn
+TEST(AsyncTasksExecutorTest, ScheduleOnSwitchesExecutor) {
+    auto tasksExecutor = std::make_shared<H::Async::ThreadPoolExecutor>(1);
+    auto otherExecutor = std::make_shared<H::Async::ThreadPoolExecutor>(1);
+
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(tasksExecutor);
+
+    std::shared_ptr<H::Async::IExecutor> executorBefore;
+    std::shared_ptr<H::Async::IExecutor> executorAfter;
+    asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+        executorBefore = H::Async::IExecutor::Current();
+        co_await H::Async::ScheduleOn(otherExecutor);
+        executorAfter = H::Async::IExecutor::Current();
+        co_return;
+        });
+
+    auto timeStart = std::chrono::high_resolution_clock::now();
+    asyncTasks.StartExecuting();
+    WaitAsyncTasksFinished(asyncTasks, timeStart, 5000ms);
+
+    EXPECT_TRUE(executorBefore == tasksExecutor);
+    EXPECT_TRUE(executorAfter == otherExecutor);
+}
+
+// CPU bound tasks: throughput must grow with executor threads (up to cores count).
+TEST(AsyncTasksExecutorBenchmark, DISABLED_ParallelThroughput) {
+    constexpr int tasksCount = 2000;
+    constexpr int iterationsPerStep = 20'000;
+
+    auto busyWork = [] {
+        volatile uint64_t value = 0;
+        for (int i = 0; i < iterationsPerStep; i++) {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+        }
+    };
+
+    for (uint32_t threadCount : { 1u, 2u, 4u, 8u }) {
+        auto executor = std::make_shared<H::Async::ThreadPoolExecutor>(threadCount);
+        H::Async::AsyncTasks asyncTasks;
+        asyncTasks.SetExecutor(executor);
+
+        std::atomic<int> finishedCount = 0;
+        for (int i = 0; i < tasksCount; i++) {
+            asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+                busyWork();
+                co_await H::Async::ScheduleOn(executor); // every task is split on two steps
+                busyWork();
+                finishedCount++;
+                co_return;
+                });
+        }
+
+        const double tasksPerSec = Benchmark::MeasureOpsPerSec(tasksCount, [&] {
+            asyncTasks.StartExecuting();
+            WaitAsyncTasksFinished(asyncTasks, std::chrono::high_resolution_clock::now(), 60'000ms);
+            });
+
+        EXPECT_EQ(finishedCount, tasksCount);
+        Benchmark::Report("threads = " + std::to_string(threadCount), tasksPerSec, "tasks/s");
+    }
+}
+
+
+
+
+H::Async::AsyncTasks::Task::Ret_t SleepTask(std::chrono::milliseconds duration, std::atomic<int>& finishedCount) {
+    co_await H::Async::SleepFor(duration);
+    finishedCount++;
+}
+
+H::Async::CoTask<H::Async::PromiseWithResult<int>>::Ret_t SleepValueTask(std::chrono::milliseconds duration, int value) {
+    co_await H::Async::SleepFor(duration);
+    co_return value;
+}
+
+// Tests that WhenAll children overlap and caller continues after the last of them
+TEST(WhenAllTest, TasksOverlap) {
+    constexpr std::chrono::milliseconds taskDuration = 200ms;
+
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(1));
+
+    std::atomic<int> finishedCount = 0;
+    std::atomic<int> finishedCountAfterWhenAll = 0;
+    asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+        co_await H::Async::WhenAll(
+            SleepTask(taskDuration, finishedCount),
+            SleepTask(taskDuration, finishedCount),
+            SleepTask(taskDuration, finishedCount));
+        finishedCountAfterWhenAll = finishedCount.load();
+        co_return;
+        });
+
+    auto timeStart = std::chrono::high_resolution_clock::now();
+    asyncTasks.StartExecuting();
+    auto elapsed = WaitAsyncTasksFinished(asyncTasks, timeStart, 5000ms);
+
+    EXPECT_EQ(finishedCountAfterWhenAll, 3);
+    EXPECT_TRUE(elapsed < taskDuration * 2); // one after another they take 3 * taskDuration
+}
+
+// Tests results of WhenAll over the range of tasks
+TEST(WhenAllTest, RangeReturnsResultsInOrder) {
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(2));
+
+    std::vector<int> values;
+    asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+        std::vector<std::shared_ptr<H::Async::CoTask<H::Async::PromiseWithResult<int>>>> tasks;
+        for (int i = 0; i < 5; i++) {
+            tasks.push_back(SleepValueTask(std::chrono::milliseconds(100 - i * 20), i)); // the last finishes first
+        }
+        for (auto& result : co_await H::Async::WhenAll(std::move(tasks))) {
+            values.push_back(result.value_or(-1));
+        }
+        co_return;
+        });
+
+    auto timeStart = std::chrono::high_resolution_clock::now();
+    asyncTasks.StartExecuting();
+    WaitAsyncTasksFinished(asyncTasks, timeStart, 5000ms);
+
+    EXPECT_EQ(values, (std::vector<int>{ 0, 1, 2, 3, 4 }));
+}
+
+// Tests that WhenAny returns the first finished task and cancels the others
+TEST(WhenAnyTest, FirstFinishedWinsOthersCanceled) {
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(2));
+
+    std::atomic<int> slowFinishedCount = 0;
+    std::size_t winnerIndex = 0;
+    int winnerValue = 0;
+    asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+        auto result = co_await H::Async::WhenAny(
+            SleepTask(300ms, slowFinishedCount),
+            SleepValueTask(50ms, 42));
+        winnerIndex = result.index;
+        winnerValue = std::get<1>(result.results).value_or(0);
+        co_return;
+        });
+
+    auto timeStart = std::chrono::high_resolution_clock::now();
+    asyncTasks.StartExecuting();
+    auto elapsed = WaitAsyncTasksFinished(asyncTasks, timeStart, 5000ms);
+    std::this_thread::sleep_for(400ms); // the slow task must not be resumed after its deadline
+
+    EXPECT_EQ(winnerIndex, 1);
+    EXPECT_EQ(winnerValue, 42);
+    EXPECT_EQ(slowFinishedCount, 0);
+    EXPECT_TRUE(elapsed < 300ms);
+}
+
+H::Async::CoTask<H::Async::PromiseWithResult<int>>::Ret_t CountedSleepValueTask(std::chrono::milliseconds duration, int value, std::atomic<int>& aliveCount) {
+    aliveCount++;
+    struct AliveGuard {
+        std::atomic<int>& aliveCount;
+        ~AliveGuard() {
+            aliveCount--;
+        }
+    } aliveGuard{ aliveCount };
+
+    co_await H::Async::SleepFor(duration);
+    co_return value;
+}
+
+// Resumed by signal of async operation instead of SleepFor timer.
+H::Async::AsyncTasks::Task::Ret_t CountedSignalTask(std::chrono::milliseconds duration, std::atomic<int>& aliveCount) {
+    aliveCount++;
+    struct AliveGuard {
+        std::atomic<int>& aliveCount;
+        ~AliveGuard() {
+            aliveCount--;
+        }
+    } aliveGuard{ aliveCount };
+
+    co_await H::Async::AsyncOperationWithResumeSignal([duration](std::weak_ptr<H::Event::Signal<void()>> resumeSignalWeak) {
+        SomeAsyncOperationWithResumeSignal(duration, resumeSignalWeak);
+        });
+}
+
+// Tests that losers finishing on other threads together with the winner (or parked after cancellation) are released
+TEST(WhenAnyTest, LosersReleasedWhenFinishedOrParked) {
+    constexpr int iterations = 200;
+
+    std::atomic<int> aliveCount = 0;
+    std::atomic<int> finishedCount = 0;
+    {
+        H::Async::AsyncTasks asyncTasks;
+        asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(4));
+
+        for (int i = 0; i < iterations; i++) {
+            asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+                auto result = co_await H::Async::WhenAny(
+                    CountedSleepValueTask(1ms, 0, aliveCount),
+                    CountedSleepValueTask(1ms, 1, aliveCount),
+                    CountedSleepValueTask(1ms, 2, aliveCount),
+                    CountedSleepValueTask(100ms, 3, aliveCount),
+                    CountedSignalTask(100ms, aliveCount)); // parked until its signal fires
+                if (result.index < 3) {
+                    finishedCount++;
+                }
+                co_return;
+                });
+        }
+
+        auto timeStart = std::chrono::high_resolution_clock::now();
+        asyncTasks.StartExecuting();
+        WaitAsyncTasksFinished(asyncTasks, timeStart, 10000ms);
+        std::this_thread::sleep_for(300ms); // slow losers are parked when their timers (signals) fire
+    }
+
+    EXPECT_EQ(finishedCount, iterations);
+    EXPECT_EQ(aliveCount, 0);
+}
+
+H::Async::AsyncTasks::Task::Ret_t CancelObservedSleepTask(std::chrono::milliseconds duration, std::atomic<int>& finishedCount, std::atomic<int>& canceledCount) {
+    auto cancellationToken = co_await H::Async::GetCancellationToken(); // token of this (awaited) task
+    cancellationToken->AddCallback([&canceledCount] {
+        canceledCount++;
+        });
+    co_await H::Async::SleepFor(duration);
+    finishedCount++;
+}
+
+// Tests that cancelling a task stops the whole tree of tasks it awaits (not only the top one)
+TEST(CancellationTest, CancelPropagatesToAwaitedTasks) {
+    H::Async::AsyncTasks asyncTasks;
+    asyncTasks.SetExecutor(std::make_shared<H::Async::ThreadPoolExecutor>(1));
+
+    std::atomic<int> finishedCount = 0;
+    std::atomic<int> childrenCanceledCount = 0;
+    asyncTasks.AddTaskLambda(0ms, [&]() -> H::Async::AsyncTasks::Task::Ret_t {
+        co_await H::Async::WhenAll(
+            CancelObservedSleepTask(200ms, finishedCount, childrenCanceledCount),
+            CancelObservedSleepTask(200ms, finishedCount, childrenCanceledCount));
+        finishedCount++;
+        co_return;
+        });
+
+    asyncTasks.StartExecuting();
+    std::this_thread::sleep_for(50ms);
+    asyncTasks.Cancel();
+    std::this_thread::sleep_for(300ms);
+
+    EXPECT_EQ(childrenCanceledCount, 2);
+    EXPECT_EQ(finishedCount, 0);
+}
+
+// Tests that child token is canceled together with parent and callbacks of canceled token are called right away
+TEST(CancellationTest, TokenHierarchy) {
+    auto parent = std::make_shared<CancellationToken>();
+    auto child = parent->MakeChild();
+    auto grandChild = child->MakeChild();
+
+    int callbacksCalled = 0;
+    auto callbackId = grandChild->AddCallback([&] { callbacksCalled++; });
+    grandChild->AddCallback([&] { callbacksCalled++; });
+    grandChild->RemoveCallback(callbackId);
+
+    parent->Cancel();
+    EXPECT_TRUE(child->IsCanceled());
+    EXPECT_TRUE(grandChild->IsCanceled());
+    EXPECT_EQ(callbacksCalled, 1);
+
+    grandChild->AddCallback([&] { callbacksCalled++; });
+    EXPECT_EQ(callbacksCalled, 2);
+    EXPECT_TRUE(parent->MakeChild()->IsCanceled());
+}
+
+
+
+// Create + resume + destroy cost of short CoTask: coroutine frame and per-task objects with FramePool and with plain heap.
+H::Async::AsyncTasks::Task::Ret_t IncrementTask(int& counter) {
+    counter++;
+    co_return;
+}
+
+double MeasureCoTaskNsPerTask(bool framePoolEnabled) {
+    constexpr int tasksCount = 200'000;
+
+    H::Async::FramePool::SetEnabled(framePoolEnabled);
+    int counter = 0;
+    const double nsPerTask = Benchmark::MeasureNsPerOp(tasksCount, [&] {
+        for (int i = 0; i < tasksCount; i++) {
+            auto task = IncrementTask(counter);
+            H::Async::SafeResume(task);
+        }
+        });
+    H::Async::FramePool::SetEnabled(true);
+
+    EXPECT_EQ(counter, tasksCount);
+    return nsPerTask;
+}
+
+TEST(CoTaskBenchmark, DISABLED_CreateResumeDestroy) {
+    MeasureCoTaskNsPerTask(true); // warm up thread-local cache
+    Benchmark::Report("heap", MeasureCoTaskNsPerTask(false), "ns/task");
+    Benchmark::Report("frame pool", MeasureCoTaskNsPerTask(true), "ns/task");
+}
+
+
+
+// Tests that tasks appended before start run in append order on the executor
+TEST(TaskChainTest, TasksRunInAppendOrder) {
+    H::TaskChain<void> taskChain;
+    auto executor = std::make_shared<H::Async::ThreadPoolExecutor>(2);
+    taskChain.SetExecutor(executor);
+
+    std::vector<int> order;
+    std::promise<void> lastTaskDone;
+    for (int i = 0; i < 100; i++) {
+        taskChain.Append([&order, i] {
+            order.push_back(i);
+            });
+    }
+    taskChain.Append([&] {
+        EXPECT_TRUE(H::Async::IExecutor::Current() == executor);
+        lastTaskDone.set_value();
+        });
+
+    taskChain.StartExecuting();
+    EXPECT_TRUE(lastTaskDone.get_future().wait_for(5s) == std::future_status::ready);
+
+    std::vector<int> expected(100);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(order, expected);
+}
+
+// Tests that task appended after all previous completed runs inline without scheduling
+TEST(TaskChainTest, AppendAfterCompletionRunsInline) {
+    H::TaskChain<int> taskChain;
+    taskChain.StartExecuting(42);
+
+    std::thread::id taskThreadId;
+    int startResult = 0;
+    taskChain.Append([&] {
+        taskThreadId = std::this_thread::get_id();
+        startResult = taskChain.GetStartResult();
+        });
+
+    EXPECT_TRUE(taskThreadId == std::this_thread::get_id());
+    EXPECT_EQ(startResult, 42);
+}
+
+// Tests that CancelAndWait waits for the running task and drops not started ones
+TEST(TaskChainTest, CancelAndWaitDropsPendingTasks) {
+    H::TaskChain<void> taskChain;
+
+    std::atomic<int> finishedCount = 0;
+    std::promise<void> firstTaskStarted;
+    taskChain.Append([&] {
+        firstTaskStarted.set_value();
+        std::this_thread::sleep_for(100ms);
+        finishedCount++;
+        });
+    for (int i = 0; i < 10; i++) {
+        taskChain.Append([&] {
+            finishedCount++;
+            });
+    }
+
+    taskChain.StartExecuting();
+    firstTaskStarted.get_future().wait();
+    taskChain.CancelAndWait();
+    EXPECT_EQ(finishedCount, 1);
+
+    // chain is reusable after CancelAndWait
+    std::promise<void> nextTaskDone;
+    taskChain.Append([&] {
+        finishedCount++;
+        nextTaskDone.set_value();
+        });
+    taskChain.StartExecuting();
+    EXPECT_TRUE(nextTaskDone.get_future().wait_for(5s) == std::future_status::ready);
+    taskChain.CancelAndWait();
+    EXPECT_EQ(finishedCount, 2);
+}
+
+// Tests that CancelAndWait called on the only thread of chain executor doesn't wait for the run queued behind it
+TEST(TaskChainTest, CancelAndWaitOnExecutorThread) {
+    auto executor = std::make_shared<H::Async::ThreadPoolExecutor>(1);
+    H::TaskChain<void> taskChain;
+    taskChain.SetExecutor(executor);
+
+    std::atomic<int> finishedCount = 0;
+    taskChain.Append([&] {
+        finishedCount++;
+        });
+
+    std::promise<void> canceled;
+    executor->Post([&] {
+        taskChain.StartExecuting(); // posts the run behind this task
+        taskChain.CancelAndWait();
+        canceled.set_value();
+        });
+
+    EXPECT_TRUE(canceled.get_future().wait_for(5s) == std::future_status::ready);
+    EXPECT_EQ(finishedCount, 0);
+}
+
+// Tests that exception breaks the chain: next tasks may depend on the failed one
+TEST(TaskChainTest, ExceptionStopsNextTasks) {
+    H::TaskChain<void> taskChain;
+    taskChain.StartExecuting();
+
+    bool nextTaskExecuted = false;
+    taskChain.Append([] {
+        throw std::runtime_error("task failed");
+        });
+    taskChain.Append([&] {
+        nextTaskExecuted = true;
+        });
+
+    taskChain.CancelAndWait();
+    EXPECT_FALSE(nextTaskExecuted);
+}
+
+
+
+
+class InitPipeline : public H::Pipeline<InitPipeline> {
+public:
+    std::span<const StepFn_t> GetPipelineSteps() const override {
+        return {};
+    }
+
+    std::span<const GraphStep> GetPipelineGraph() const override {
+        static const std::vector<GraphStep> graph = {
+            { &InitPipeline::LoadConfig, {} },
+            { &InitPipeline::OpenStorage, {} },
+            { &InitPipeline::StartServices, { &InitPipeline::LoadConfig, &InitPipeline::OpenStorage } },
+        };
+        return graph;
+    }
+
+    H::PipelineResult LoadConfig() {
+        std::this_thread::sleep_for(100ms);
+        configLoaded = true;
+        return H::PipelineResult::Continue();
+    }
+
+    H::PipelineResult OpenStorage() {
+        std::this_thread::sleep_for(100ms);
+        if (storageError) {
+            return H::PipelineResult::Failed(storageError);
+        }
+        storageOpened = true;
+        return H::PipelineResult::Continue();
+    }
+
+    H::PipelineResult StartServices() {
+        servicesStarted = configLoaded && storageOpened;
+        return H::PipelineResult::Continue();
+    }
+
+public:
+    std::error_code storageError;
+    std::atomic<bool> configLoaded = false;
+    std::atomic<bool> storageOpened = false;
+    std::atomic<bool> servicesStarted = false;
+};
+
+// Tests that independent graph steps run concurrently and dependent step waits for them
+TEST(PipelineTest, IndependentStepsRunConcurrently) {
+    InitPipeline pipeline;
+    auto executor = std::make_shared<H::Async::ThreadPoolExecutor>(2);
+
+    EXPECT_FALSE(pipeline.RunParallel(executor));
+    EXPECT_TRUE(pipeline.servicesStarted);
+
+    const auto& stats = pipeline.GetLastRunStats();
+    ASSERT_EQ(stats.stepTimes.size(), 3);
+    EXPECT_TRUE(stats.criticalPath >= 100ms);
+    EXPECT_TRUE(stats.wallTime < 190ms); // sequential run takes 200ms
+}
+
+// Tests that failed step stops not started dependent steps and its error is returned
+TEST(PipelineTest, FailedStepStopsDependents) {
+    InitPipeline pipeline;
+    pipeline.storageError = std::make_error_code(std::errc::io_error);
+
+    EXPECT_EQ(pipeline.RunParallel(), std::make_error_code(std::errc::io_error));
+    EXPECT_TRUE(pipeline.configLoaded);
+    EXPECT_FALSE(pipeline.servicesStarted);
+    EXPECT_TRUE(pipeline.GetLastRunStats().stepTimes[2] == 0ns);
+}
+
+
+
+
+// Tests that one-shot timer fires not earlier than its delay
+TEST(TimerServiceTest, OneShotFiresAfterDelay) {
+    auto timerService = std::make_shared<H::TimerService>();
+
+    std::promise<std::chrono::steady_clock::time_point> firedPromise;
+    const auto timeStart = std::chrono::steady_clock::now();
+    timerService->Schedule(50ms, [&firedPromise] {
+        firedPromise.set_value(std::chrono::steady_clock::now());
+        });
+
+    auto firedFuture = firedPromise.get_future();
+    ASSERT_EQ(firedFuture.wait_for(5s), std::future_status::ready);
+    EXPECT_TRUE(firedFuture.get() - timeStart >= 50ms);
+    EXPECT_EQ(timerService->GetPendingCount(), 0);
+}
+
+// Tests that timer beyond the first wheel level (256 ticks) is cascaded and fired
+TEST(TimerServiceTest, LongDelayCascades) {
+    auto timerService = std::make_shared<H::TimerService>();
+
+    std::promise<std::chrono::steady_clock::time_point> firedPromise;
+    const auto timeStart = std::chrono::steady_clock::now();
+    timerService->Schedule(300ms, [&firedPromise] {
+        firedPromise.set_value(std::chrono::steady_clock::now());
+        });
+
+    auto firedFuture = firedPromise.get_future();
+    ASSERT_EQ(firedFuture.wait_for(5s), std::future_status::ready);
+    EXPECT_TRUE(firedFuture.get() - timeStart >= 300ms);
+}
+
+// Tests that canceled timer is not fired and its handle becomes invalid
+TEST(TimerServiceTest, CancelPreventsCallback) {
+    auto timerService = std::make_shared<H::TimerService>();
+
+    std::atomic<bool> fired = false;
+    auto handle = timerService->Schedule(50ms, [&fired] {
+        fired = true;
+        });
+
+    EXPECT_TRUE(timerService->Cancel(handle));
+    EXPECT_FALSE(timerService->Cancel(handle));
+    std::this_thread::sleep_for(100ms);
+    EXPECT_FALSE(fired);
+}
+
+// Tests that periodic timer fires repeatedly and CancelAndWait stops it
+TEST(TimerServiceTest, PeriodicFiresUntilCanceled) {
+    auto timerService = std::make_shared<H::TimerService>();
+
+    std::atomic<int> firedCount = 0;
+    auto handle = timerService->SchedulePeriodic(10ms, [&firedCount] {
+        firedCount++;
+        });
+
+    std::this_thread::sleep_for(105ms);
+    EXPECT_TRUE(timerService->CancelAndWait(handle));
+    const int firedCountAfterCancel = firedCount;
+    EXPECT_TRUE(firedCountAfterCancel >= 3 && firedCountAfterCancel <= 10);
+
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(firedCount, firedCountAfterCancel);
+    EXPECT_EQ(timerService->GetPendingCount(), 0);
+}
+
+// Tests that timers with close deadlines and slack fire on the same tick
+TEST(TimerServiceTest, SlackCoalescesDeadlines) {
+    auto timerService = std::make_shared<H::TimerService>();
+
+    std::mutex mx;
+    std::vector<std::chrono::steady_clock::time_point> firedTimes;
+    for (int i = 1; i <= 10; i++) {
+        timerService->Schedule(std::chrono::milliseconds{ i }, [&] {
+            std::lock_guard lk{ mx };
+            firedTimes.push_back(std::chrono::steady_clock::now());
+            }, 50ms);
+    }
+
+    std::this_thread::sleep_for(150ms);
+    std::lock_guard lk{ mx };
+    ASSERT_EQ(firedTimes.size(), 10);
+    auto [minIt, maxIt] = std::minmax_element(firedTimes.begin(), firedTimes.end());
+    EXPECT_TRUE(*maxIt - *minIt < 5ms); // one or two batches of 1ms tick (deadlines may cross slack boundary)
+}
+
+// Tests that Timer::Start with autoRestart fires periodically until Stop
+TEST(TimerServiceTest, TimerAutoRestartAndStop) {
+    std::atomic<int> firedCount = 0;
+    H::Timer timer;
+    timer.Start(10ms, [&firedCount] {
+        firedCount++;
+        }, true);
+
+    std::this_thread::sleep_for(65ms);
+    timer.Stop();
+    const int firedCountAfterStop = firedCount;
+    EXPECT_TRUE(firedCountAfterStop >= 2);
+
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(firedCount, firedCountAfterStop);
+}
+
+// Schedules and cancels one million timers (thread per timer approach can't do this at all)
+TEST(TimerServiceBenchmark, DISABLED_ScheduleCancelMillion) {
+    auto timerService = std::make_shared<H::TimerService>();
+    constexpr int timersCount = 1'000'000;
+
+    std::vector<H::TimerHandle> handles;
+    handles.reserve(timersCount);
+
+    Benchmark::Report("schedule", Benchmark::MeasureNsPerOp(timersCount, [&] {
+        for (int i = 0; i < timersCount; i++) {
+            handles.push_back(timerService->Schedule(std::chrono::milliseconds{ 1'000 + i % 100'000 }, [] {}));
+        }
+        }), "ns/timer");
+    Benchmark::Report("cancel", Benchmark::MeasureNsPerOp(timersCount, [&] {
+        for (auto& handle : handles) {
+            timerService->Cancel(handle);
+        }
+        }), "ns/timer");
+
+    EXPECT_EQ(timerService->GetPendingCount(), 0);
+}
+
+
+
+
+// Tests that handler may disconnect itself and subscribe other handler while signal is invoked
+TEST(SignalTest, ModifyHandlersDuringInvoke) {
+    H::Event::Signal<void(int)> signal;
+
+    int firstCalls = 0;
+    int secondCalls = 0;
+    std::shared_ptr<H::Event::Signal<void(int)>::Connection> firstConnection;
+    std::shared_ptr<H::Event::Signal<void(int)>::Connection> secondConnection;
+    firstConnection = signal.Subscribe([&](int) {
+        firstCalls++;
+        firstConnection->Disconnect();
+        secondConnection = signal.Subscribe([&](int) {
+            secondCalls++;
+            });
+        });
+
+    signal.Invoke(1); // snapshot is taken before the handler modifies the list
+    EXPECT_EQ(firstCalls, 1);
+    EXPECT_EQ(secondCalls, 0);
+    EXPECT_FALSE(firstConnection->IsConnected());
+
+    signal.Invoke(2);
+    EXPECT_EQ(firstCalls, 1);
+    EXPECT_EQ(secondCalls, 1);
+
+    signal.DisconnectAll();
+    signal.Invoke(3);
+    EXPECT_EQ(secondCalls, 1);
+    EXPECT_FALSE(secondConnection->IsConnected());
+}
+
+// Tests that Disconnect removes only own handler, not the one whose connection was released without Disconnect
+TEST(SignalTest, DisconnectMatchesOwnConnection) {
+    H::Event::Signal<void(int)> signal;
+
+    int firstCalls = 0;
+    int secondCalls = 0;
+    signal.Subscribe([&](int) {
+        firstCalls++;
+        }); // connection released without Disconnect, handler stays
+
+    auto secondConnection = signal.Subscribe([&](int) {
+        secondCalls++;
+        });
+    secondConnection->Disconnect();
+
+    signal.Invoke(1);
+    EXPECT_EQ(firstCalls, 1);
+    EXPECT_EQ(secondCalls, 0);
+}
+
+// Emit cost for different handlers count (Invoke doesn't lock or allocate)
+TEST(SignalBenchmark, DISABLED_EmitCost) {
+    constexpr int emitsCount = 200'000;
+
+    for (int handlersCount : { 0, 1, 8, 64 }) {
+        H::Event::Signal<void(int)> signal;
+        std::vector<std::shared_ptr<H::Event::Signal<void(int)>::Connection>> connections;
+        int64_t sum = 0;
+        for (int i = 0; i < handlersCount; i++) {
+            connections.push_back(signal.Subscribe([&sum](int value) {
+                sum += value;
+                }));
+        }
+
+        const double nsPerEmit = Benchmark::MeasureNsPerOp(emitsCount, [&] {
+            for (int i = 0; i < emitsCount; i++) {
+                signal.Invoke(1);
+            }
+            });
+
+        EXPECT_EQ(sum, int64_t{ handlersCount } * emitsCount);
+        Benchmark::Report(std::to_string(handlersCount) + " handlers", nsPerEmit, "ns/emit");
+    }
+}
+
+
+
+
+// Tests that expired subscribers are skipped and their slots are reused by new subscribers
+TEST(WeakEventTest, ExpiredSubscribersAreSkippedAndReclaimed) {
+    H::WeakEvent<int> weakEvent;
+
+    int callsSum = 0;
+    std::vector<std::shared_ptr<int>> subscribers;
+    for (int i = 0; i < 20; i++) { // more than inlineDispatchCount
+        subscribers.push_back(std::make_shared<int>(i));
+        weakEvent.Subscribe([&callsSum](int value) {
+            callsSum += value;
+            }, subscribers.back());
+    }
+
+    weakEvent(1);
+    EXPECT_EQ(callsSum, 20);
+
+    subscribers.resize(10); // expire half of subscribers
+    weakEvent(1);
+    EXPECT_EQ(callsSum, 30);
+
+    auto lateSubscriber = std::make_shared<int>(100);
+    weakEvent.Subscribe([&callsSum](int value) {
+        callsSum += 100 * value;
+        }, lateSubscriber);
+    weakEvent(1);
+    EXPECT_EQ(callsSum, 140);
+
+    weakEvent.Unsubscribe(lateSubscriber);
+    weakEvent(1);
+    EXPECT_EQ(callsSum, 150);
+}
+
+// Tests that handler may unsubscribe itself and subscribe other handler during dispatch
+TEST(WeakEventTest, ModifySubscribersDuringDispatch) {
+    H::WeakEvent<> weakEvent;
+
+    auto firstSubscriber = std::make_shared<int>(1);
+    auto secondSubscriber = std::make_shared<int>(2);
+    int firstCalls = 0;
+    int secondCalls = 0;
+    weakEvent.Subscribe([&] {
+        firstCalls++;
+        weakEvent.Unsubscribe(firstSubscriber);
+        weakEvent.Subscribe([&secondCalls] {
+            secondCalls++;
+            }, secondSubscriber);
+        }, firstSubscriber);
+
+    weakEvent();
+    weakEvent();
+    EXPECT_EQ(firstCalls, 1);
+    EXPECT_EQ(secondCalls, 1);
+}
+
+// Dispatch cost with 8 alive subscribers (steady state doesn't allocate)
+TEST(WeakEventBenchmark, DISABLED_DispatchCost) {
+    constexpr int dispatchCount = 200'000;
+    H::WeakEvent<int> weakEvent;
+
+    int64_t sum = 0;
+    std::vector<std::shared_ptr<int>> subscribers;
+    for (int i = 0; i < 8; i++) {
+        subscribers.push_back(std::make_shared<int>(i));
+        weakEvent.Subscribe([&sum](int value) {
+            sum += value;
+            }, subscribers.back());
+    }
+
+    const double nsPerDispatch = Benchmark::MeasureNsPerOp(dispatchCount, [&] {
+        for (int i = 0; i < dispatchCount; i++) {
+            weakEvent(1);
+        }
+        });
+
+    EXPECT_EQ(sum, int64_t{ 8 } * dispatchCount);
+    Benchmark::Report("8 subscribers", nsPerDispatch, "ns/dispatch");
+}
+
+// Subscribe cost when most subscribers expire right away (expired slots scan must stay amortized)
+TEST(WeakEventBenchmark, DISABLED_SubscribeCost) {
+    constexpr int subscribeCount = 100'000;
+    H::WeakEvent<int> weakEvent;
+
+    int64_t sum = 0;
+    std::vector<std::shared_ptr<int>> subscribers;
+    const double nsPerSubscribe = Benchmark::MeasureNsPerOp(subscribeCount, [&] {
+        for (int i = 0; i < subscribeCount; i++) {
+            auto subscriber = std::make_shared<int>(i);
+            weakEvent.Subscribe([&sum](int value) {
+                sum += value;
+                }, subscriber);
+            if (i % 10 == 0) {
+                subscribers.push_back(std::move(subscriber)); // every 10th stays alive
+            }
+        }
+        });
+
+    weakEvent(1);
+    EXPECT_EQ(sum, subscribeCount / 10);
+    Benchmark::Report(std::to_string(subscribeCount) + " subscribes", nsPerSubscribe, "ns/subscribe");
+}
+
+
+
+
+// Tests that LockShared readers hold the lock together while exclusive Lock waits for them
+TEST(ThreadSafeObjectTest, LockSharedAllowsConcurrentReaders) {
+    H::ThreadSafeObject<std::shared_mutex, std::vector<int>> numbers{ std::vector<int>{ 1, 2, 3 } };
+
+    auto firstReader = numbers.LockShared();
+    std::thread secondReaderThread([&numbers] {
+        auto secondReader = numbers.LockShared(); // would deadlock if readers were exclusive
+        EXPECT_EQ(secondReader->size(), 3);
+        });
+    secondReaderThread.join();
+
+    std::atomic<bool> writerDone = false;
+    std::thread writerThread([&numbers, &writerDone] {
+        numbers.Lock()->push_back(4);
+        writerDone = true;
+        });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(writerDone.load()); // waits for firstReader
+    EXPECT_EQ(firstReader->size(), 3);
+
+    { auto releaseReader = std::move(firstReader); }
+    writerThread.join();
+    EXPECT_EQ(numbers.LockShared()->size(), 4);
+}
+
+// Tests that Snapshot is reused between writes and rebuilt after exclusive Lock
+TEST(ThreadSafeObjectTest, SnapshotIsRebuiltAfterWrite) {
+    H::ThreadSafeObject<std::mutex, std::vector<int>> numbers{ std::vector<int>{ 1, 2, 3 } };
+
+    auto firstSnapshot = numbers.Snapshot();
+    auto secondSnapshot = numbers.Snapshot();
+    EXPECT_EQ(firstSnapshot.get(), secondSnapshot.get()); // no writes - the same copy
+    EXPECT_EQ(firstSnapshot->size(), 3);
+
+    numbers.Lock()->push_back(4);
+    auto thirdSnapshot = numbers.Snapshot();
+    EXPECT_TRUE(thirdSnapshot.get() != firstSnapshot.get());
+    EXPECT_EQ(thirdSnapshot->size(), 4);
+    EXPECT_EQ(firstSnapshot->size(), 3); // old readers keep their copy
+
+    numbers = std::vector<int>{ 5 };
+    EXPECT_EQ(numbers.Snapshot()->size(), 1);
+}
+
+// Tests that seqlock readers never observe torn object while writer updates it
+TEST(ThreadSafeObjectTest, SeqLockReadersSeeConsistentObject) {
+    struct Pair {
+        uint64_t first;
+        uint64_t second;
+        uint64_t sum;
+    };
+    H::ThreadSafeObject<H::SeqLock, Pair> seqPair{ Pair{ 0, 0, 0 } };
+
+    std::atomic<bool> stop = false;
+    std::atomic<int> tornReads = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; i++) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                auto pair = seqPair.Load();
+                if (pair.first != pair.second || pair.sum != pair.first + pair.second) {
+                    tornReads++;
+                }
+            }
+            });
+    }
+
+    for (uint64_t i = 1; i <= 20'000; i++) {
+        if (i % 2) {
+            seqPair.Store(Pair{ i, i, 2 * i });
+        }
+        else {
+            seqPair.Update([](Pair& pair) {
+                pair.first++;
+                pair.second++;
+                pair.sum += 2;
+                });
+        }
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(tornReads.load(), 0);
+    EXPECT_EQ(seqPair.Load().first, 20'000);
+}
+
+// Read-heavy benchmark: readers sum a small config while one writer updates it every ~100us.
+// Compares exclusive Lock, LockShared, Snapshot and seqlock reads per second.
+TEST(ThreadSafeObjectBenchmark, DISABLED_ReadHeavyContention) {
+    struct Config {
+        int values[8];
+    };
+    constexpr int readersCount = 4;
+    constexpr auto benchDuration = 200ms;
+
+    auto runBench = [&](const char* name, auto readFn, auto writeFn) {
+        std::atomic<bool> stop = false;
+        std::atomic<uint64_t> readsCount = 0;
+        std::atomic<int> checksumSink = 0; // keeps reads from being optimized out
+        std::vector<std::thread> readers;
+        for (int i = 0; i < readersCount; i++) {
+            readers.emplace_back([&] {
+                uint64_t localReads = 0;
+                int checksum = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    checksum += readFn();
+                    localReads++;
+                }
+                readsCount += localReads;
+                checksumSink += checksum;
+                });
+        }
+        std::thread writer([&] {
+            for (int i = 0; !stop; i++) {
+                writeFn(i);
+                std::this_thread::sleep_for(100us);
+            }
+            });
+
+        std::this_thread::sleep_for(benchDuration);
+        stop = true;
+        writer.join();
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        Benchmark::Report(name, readsCount.load() / std::chrono::duration<double>(benchDuration).count(), "reads/s");
+        EXPECT_TRUE(readsCount.load() > 0);
+    };
+
+    auto sumConfig = [](const Config& config) {
+        return std::accumulate(std::begin(config.values), std::end(config.values), 0);
+    };
+
+    H::ThreadSafeObject<std::mutex, Config> mutexConfig{ Config{} };
+    runBench("Lock (std::mutex)",
+        [&] { return sumConfig(mutexConfig.Lock().Get()); },
+        [&](int i) { mutexConfig.Lock()->values[i % 8] = i; });
+
+    H::ThreadSafeObject<std::shared_mutex, Config> sharedConfig{ Config{} };
+    runBench("LockShared (std::shared_mutex)",
+        [&] { return sumConfig(sharedConfig.LockShared().Get()); },
+        [&](int i) { sharedConfig.Lock()->values[i % 8] = i; });
+
+    H::ThreadSafeObject<std::shared_mutex, Config> snapshotConfig{ Config{} };
+    runBench("Snapshot",
+        [&] { return sumConfig(*snapshotConfig.Snapshot()); },
+        [&](int i) { snapshotConfig.Lock()->values[i % 8] = i; });
+
+    H::ThreadSafeObject<H::SeqLock, Config> seqConfig{ Config{} };
+    runBench("SeqLock",
+        [&] { return sumConfig(seqConfig.Load()); },
+        [&](int i) { seqConfig.Update([i](Config& config) { config.values[i % 8] = i; }); });
+}
+
+
+
+
+//
+// AsyncLogWriter
+//
+TEST(AsyncLogWriterTest, OverflowPoliciesCountDroppedMessages) {
+    auto logger = std::make_shared<spdlog::logger>("async_test_logger", std::make_shared<spdlog::sinks::null_sink_mt>());
+    constexpr size_t messagesCount = 2000;
+
+    for (auto policy : { lg::AsyncOverflowPolicy::Block, lg::AsyncOverflowPolicy::DropNewest, lg::AsyncOverflowPolicy::DropOldest }) {
+        std::mutex mx;
+        std::vector<size_t> written;
+        lg::AsyncLogWriter writer([&](const lg::AsyncLogRecord& record) {
+            std::this_thread::sleep_for(std::chrono::microseconds(20)); // slow sink, buffer overflows
+            std::lock_guard lk{ mx };
+            written.push_back(std::stoul(record.payload));
+            });
+
+        lg::AsyncLoggingOptions options;
+        options.threadBufferCapacity = 16;
+        options.overflowPolicy = policy;
+        writer.Start(options);
+
+        for (size_t i = 0; i < messagesCount; i++) {
+            lg::AsyncLogRecord record;
+            record.logger = logger;
+            record.level = i == messagesCount / 2 ? spdlog::level::err : spdlog::level::debug;
+            record.payload = std::to_string(i);
+            writer.Push(std::move(record));
+        }
+        writer.Flush();
+
+        auto stats = writer.GetStats();
+        std::lock_guard lk{ mx };
+        EXPECT_TRUE(std::is_sorted(written.begin(), written.end()));
+        EXPECT_NE(std::find(written.begin(), written.end(), messagesCount / 2), written.end()); // sync level is never dropped
+        EXPECT_EQ(stats.written, written.size());
+        EXPECT_EQ(stats.enqueued + stats.droppedNewest, messagesCount);
+        EXPECT_EQ(stats.written + stats.droppedOldest, stats.enqueued);
+
+        switch (policy) {
+        case lg::AsyncOverflowPolicy::Block:
+            EXPECT_EQ(written.size(), messagesCount);
+            break;
+        case lg::AsyncOverflowPolicy::DropNewest:
+            EXPECT_GT(stats.droppedNewest, 0u);
+            break;
+        case lg::AsyncOverflowPolicy::DropOldest:
+            EXPECT_GT(stats.droppedOldest, 0u);
+            EXPECT_EQ(written.back(), messagesCount - 1);
+            break;
+        }
+    }
+}
+
+TEST(AsyncLogWriterTest, StopWritesStagedMessagesInOrder) {
+    auto logger = std::make_shared<spdlog::logger>("async_test_logger", std::make_shared<spdlog::sinks::null_sink_mt>());
+    constexpr size_t threadsCount = 4;
+    constexpr size_t messagesCount = 20'000;
+
+    std::mutex mx;
+    std::vector<std::vector<size_t>> written(threadsCount);
+    lg::AsyncLogWriter writer([&](const lg::AsyncLogRecord& record) {
+        std::lock_guard lk{ mx };
+        written[record.threadId].push_back(std::stoul(record.payload));
+        });
+
+    lg::AsyncLoggingOptions options;
+    options.threadBufferCapacity = 64;
+    writer.Start(options);
+
+    std::vector<std::thread> producers;
+    for (size_t t = 0; t < threadsCount; t++) {
+        producers.emplace_back([&, t] {
+            for (size_t i = 0; i < messagesCount; i++) {
+                lg::AsyncLogRecord record;
+                record.logger = logger;
+                record.level = spdlog::level::debug;
+                record.threadId = t;
+                record.payload = std::to_string(i);
+                writer.Push(std::move(record));
+            }
+            });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    writer.Stop(); // producers continue with sync dispatch
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    for (auto& threadMessages : written) {
+        ASSERT_EQ(threadMessages.size(), messagesCount);
+        for (size_t i = 0; i < messagesCount; i++) {
+            ASSERT_EQ(threadMessages[i], i);
+        }
+    }
+}
+
+
+// Tests that a sink logging from the writer thread (even sync level, into a full ring) is written inline instead of deadlocking,
+// and that restart with other options works while other threads keep pushing
+TEST(AsyncLogWriterTest, PushFromWriterThreadAndRestart) {
+    auto logger = std::make_shared<spdlog::logger>("async_test_logger", std::make_shared<spdlog::sinks::null_sink_mt>());
+    constexpr size_t messagesCount = 100;
+
+    std::mutex mx;
+    std::vector<std::string> written;
+    lg::AsyncLogWriter* writerPtr = nullptr;
+    lg::AsyncLogWriter writer([&](const lg::AsyncLogRecord& record) {
+        {
+            std::lock_guard lk{ mx };
+            written.push_back(record.payload);
+        }
+
+        if (record.payload.rfind("sink", 0) != 0) {
+            // e.g. sink reports its own error
+            lg::AsyncLogRecord sinkRecord;
+            sinkRecord.logger = record.logger;
+            sinkRecord.level = spdlog::level::err;
+            sinkRecord.payload = "sink " + record.payload;
+            writerPtr->Push(std::move(sinkRecord));
+            writerPtr->Flush();
+        }
+        });
+    writerPtr = &writer;
+
+    lg::AsyncLoggingOptions options;
+    options.threadBufferCapacity = 2;
+    writer.Start(options);
+
+    std::atomic<bool> stopProducer = false;
+    std::thread producerThread([&] {
+        for (size_t i = 0; !stopProducer; i++) {
+            lg::AsyncLogRecord record;
+            record.logger = logger;
+            record.level = spdlog::level::debug;
+            record.payload = "producer";
+            writer.Push(std::move(record));
+        }
+        });
+
+    for (size_t i = 0; i < messagesCount; i++) {
+        lg::AsyncLogRecord record;
+        record.logger = logger;
+        record.level = i % 10 == 0 ? spdlog::level::err : spdlog::level::debug;
+        record.payload = std::to_string(i);
+        writer.Push(std::move(record));
+
+        if (i == messagesCount / 2) {
+            writer.Stop();
+            options.threadBufferCapacity = 8;
+            options.overflowPolicy = lg::AsyncOverflowPolicy::DropNewest;
+            writer.Start(options);
+        }
+    }
+    writer.Flush();
+
+    stopProducer = true;
+    producerThread.join();
+    writer.Stop();
+
+    std::lock_guard lk{ mx };
+    for (size_t i = 0; i < messagesCount; i++) {
+        auto it = std::find(written.begin(), written.end(), std::to_string(i));
+        if (i <= messagesCount / 2 || i % 10 == 0) { // Block policy before restart, sync level is never dropped
+            ASSERT_TRUE(it != written.end());
+            EXPECT_TRUE(std::find(it, written.end(), "sink " + std::to_string(i)) != written.end());
+        }
+    }
+}
+
+
+
+//
+// SharedFileSink
+//
+namespace {
+    std::vector<std::string> ReadLogLines(const std::filesystem::path& path) {
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Nothing reaches the file unless it's flushed explicitly, by size or by level.
+    constexpr lg::FileFlushPolicy manualFlushPolicy{ std::chrono::hours(1), 1024 * 1024, spdlog::level::err };
+}
+
+// Tests that lines of all formatter variants keep the logging order in the shared file
+TEST(SharedFileSinkTest, FiveSinksKeepOrderInOneFile) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "SharedFileSinkTest";
+    std::filesystem::create_directories(logsDir);
+    const auto logPath = logsDir / "order.log";
+
+    constexpr int sinksCount = 5;
+    constexpr int linesCount = 1000;
+    {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(logPath.native(), true, manualFlushPolicy);
+        std::vector<std::shared_ptr<spdlog::logger>> loggers;
+        for (int i = 0; i < sinksCount; i++) {
+            auto logger = std::make_shared<spdlog::logger>("shared_sink_" + std::to_string(i), fileWriter->CreateSink());
+            logger->set_pattern("[sink " + std::to_string(i) + "] %v");
+            loggers.push_back(logger);
+        }
+
+        for (int i = 0; i < linesCount; i++) {
+            loggers[i % sinksCount]->info("{}", i);
+        }
+    }
+
+    const auto lines = ReadLogLines(logPath);
+    ASSERT_EQ(lines.size(), size_t(linesCount));
+    for (int i = 0; i < linesCount; i++) {
+        EXPECT_EQ(lines[i], "[sink " + std::to_string(i % sinksCount) + "] " + std::to_string(i));
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that buffered lines stay in memory until a line of flush level is logged
+TEST(SharedFileSinkTest, ErrorLevelReachesFileImmediately) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "SharedFileSinkTest";
+    std::filesystem::create_directories(logsDir);
+    const auto logPath = logsDir / "error.log";
+
+    {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(logPath.native(), true, manualFlushPolicy);
+        auto logger = std::make_shared<spdlog::logger>("shared_sink", fileWriter->CreateSink());
+        logger->set_pattern("%v");
+        logger->flush_on(manualFlushPolicy.flushLevel); // as DefaultLoggers sets it up
+
+        logger->info("info line");
+        EXPECT_EQ(std::filesystem::file_size(logPath), 0u);
+        EXPECT_GT(fileWriter->FileSize(), 0u);
+
+        logger->error("error line");
+        EXPECT_EQ(ReadLogLines(logPath), (std::vector<std::string>{ "info line", "error line" }));
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that the buffer is written when it exceeds bufferSize and when the flush interval passes
+TEST(SharedFileSinkTest, IntervalAndSizeFlushesFire) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "SharedFileSinkTest";
+    std::filesystem::create_directories(logsDir);
+    const auto logPath = logsDir / "flush.log";
+
+    {
+        auto flushPolicy = manualFlushPolicy;
+        flushPolicy.bufferSize = 1024;
+
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(logPath.native(), true, flushPolicy);
+        auto logger = std::make_shared<spdlog::logger>("shared_sink", fileWriter->CreateSink());
+        logger->set_pattern("%v");
+
+        logger->info("short line");
+        EXPECT_EQ(std::filesystem::file_size(logPath), 0u);
+
+        for (int i = 0; i < 100; i++) {
+            logger->info("line {} long enough to fill the buffer", i);
+        }
+        EXPECT_GE(std::filesystem::file_size(logPath), flushPolicy.bufferSize);
+    }
+    {
+        auto flushPolicy = manualFlushPolicy;
+        flushPolicy.interval = 20ms;
+
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(logPath.native(), true, flushPolicy);
+        auto logger = std::make_shared<spdlog::logger>("shared_sink", fileWriter->CreateSink());
+        logger->set_pattern("%v");
+
+        logger->info("interval line");
+        const auto timeStart = std::chrono::steady_clock::now();
+        while (std::filesystem::file_size(logPath) == 0 && std::chrono::steady_clock::now() - timeStart < 5s) {
+            std::this_thread::sleep_for(5ms);
+        }
+        EXPECT_EQ(ReadLogLines(logPath), std::vector<std::string>{ "interval line" });
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that FlushOnCrash writes the pending buffer, also when the crash happens on the thread which holds the writer lock
+TEST(SharedFileSinkTest, FlushOnCrashWritesPendingBuffer) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "SharedFileSinkTest";
+    std::filesystem::create_directories(logsDir);
+    const auto logPath = logsDir / "crash.log";
+
+    auto fileWriter = std::make_shared<lg::SharedFileWriter>(logPath.native(), true, manualFlushPolicy);
+    auto logger = std::make_shared<spdlog::logger>("shared_sink", fileWriter->CreateSink());
+    logger->set_pattern("%v");
+
+    logger->info("before crash");
+    EXPECT_EQ(std::filesystem::file_size(logPath), 0u);
+
+    fileWriter->FlushOnCrash();
+    EXPECT_EQ(ReadLogLines(logPath), std::vector<std::string>{ "before crash" });
+
+    fileWriter->Append([&](spdlog::memory_buf_t& buffer) {
+        const std::string_view line = "inside write\n";
+        buffer.append(line.data(), line.data() + line.size());
+        fileWriter->FlushOnCrash(); // "crashed" under the writer lock, must not wait for it
+        }, false);
+    EXPECT_EQ(ReadLogLines(logPath), (std::vector<std::string>{ "before crash", "inside write" }));
+
+    logger.reset();
+    fileWriter.reset();
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Five formatter variants logging into one file: separate file sinks flushing every line (previous setup)
+// vs one SharedFileWriter buffering all variants.
+TEST(SharedFileSinkBenchmark, DISABLED_LinesPerSecond) {
+    constexpr size_t linesCount = 200'000;
+    const auto logsDir = std::filesystem::temp_directory_path() / "SharedFileSinkBenchmark";
+    std::filesystem::create_directories(logsDir);
+
+    auto runBench = [&](const char* name, std::vector<std::shared_ptr<spdlog::logger>> loggers) {
+        Benchmark::Report(name, Benchmark::MeasureOpsPerSec(linesCount, [&] {
+            for (size_t i = 0; i < linesCount; i++) {
+                loggers[i % loggers.size()]->info("benchmark line {} with some payload {}", i, 3.14);
+            }
+            for (auto& logger : loggers) {
+                logger->flush();
+            }
+            }), "lines/s");
+    };
+
+    {
+        const auto filename = (logsDir / "file_sinks.log").native();
+        std::vector<std::shared_ptr<spdlog::logger>> loggers;
+        for (int i = 0; i < 5; i++) {
+            auto logger = std::make_shared<spdlog::logger>("bench_file_sink", std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename, i == 0));
+            logger->flush_on(spdlog::level::trace);
+            loggers.push_back(logger);
+        }
+        runBench("basic_file_sink_mt x5, flush every line", std::move(loggers));
+    }
+    {
+        const auto filename = (logsDir / "shared_sink.log").native();
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(filename, true);
+        std::vector<std::shared_ptr<spdlog::logger>> loggers;
+        for (int i = 0; i < 5; i++) {
+            auto logger = std::make_shared<spdlog::logger>("bench_shared_sink", fileWriter->CreateSink());
+            logger->flush_on(spdlog::level::err);
+            loggers.push_back(logger);
+        }
+        runBench("SharedFileWriter x5 sinks, buffered", std::move(loggers));
+        EXPECT_GT(fileWriter->FileSize(), linesCount * 40);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+
+
+
+//
+// BinaryLog
+//
+TEST(BinaryLogTest, DecodedLinesMatchFormattedText) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "BinaryLogTest";
+    std::filesystem::create_directories(logsDir);
+    const auto binaryLogPath = logsDir / "main.binlog";
+    const auto textLogPath = logsDir / "main.log";
+
+    std::vector<std::string> expectedPayloads;
+    {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(binaryLogPath.native(), true);
+        lg::BinaryLogWriter binaryWriter(fileWriter, spdlog::level::err);
+        spdlog::logger logger("logger");
+
+        const std::string name = "item";
+        const std::wstring className = L"BinaryLogTest";
+        for (int i = 0; i < 3; i++) {
+            binaryWriter.Write<char>(logger, LOG_CTX, spdlog::level::info, "{} #{:03} = {:.2f} ({}, {:x})", lg::BinaryLogClassName{}, name, i, i * 1.5, i % 2 == 0, 255u);
+            expectedPayloads.push_back(fmt::format("{} #{:03} = {:.2f} ({}, {:x})", name, i, i * 1.5, i % 2 == 0, 255u));
+        }
+        binaryWriter.Write<wchar_t>(logger, LOG_CTX, spdlog::level::err, L"wide {} {}", lg::BinaryLogClassName{ lg::BinaryLogClassContext::Instance, className }, std::wstring(L"text"), -7);
+        expectedPayloads.push_back("BinaryLogTest] wide text -7");
+    }
+
+    lg::DefaultLoggers::DecodeBinaryLog(binaryLogPath, textLogPath);
+
+    std::ifstream textLog(textLogPath);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(textLog, line);) {
+        lines.push_back(line);
+    }
+
+    ASSERT_EQ(lines.size(), expectedPayloads.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        EXPECT_NE(lines[i].find(expectedPayloads[i]), std::string::npos);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that a rotated binary log is decoded from all its segments (each starts with its own header and call sites)
+TEST(BinaryLogTest, DecodeMultipleSegments) {
+    constexpr int linesCount = 8'000;
+    constexpr uint32_t segmentsCount = 8;
+    const auto logsDir = std::filesystem::temp_directory_path() / "BinaryLogSegmentsTest";
+    std::filesystem::remove_all(logsDir);
+    std::filesystem::create_directories(logsDir);
+    const auto binaryLogPath = logsDir / "main.binlog";
+    const auto textLogPath = logsDir / "main.log";
+
+    {
+        // big enough limit: nothing is deleted, so every line must be decoded
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(binaryLogPath.native(), true, lg::FileFlushPolicy{},
+            2 * segmentsCount * lg::SegmentedLogFile::minSegmentSize, lg::FileRotationPolicy{ segmentsCount, false });
+        lg::BinaryLogWriter binaryWriter(fileWriter, spdlog::level::err);
+        spdlog::logger logger("logger");
+
+        const std::string name = "segment line";
+        for (int i = 0; i < linesCount; i++) {
+            if (i % 2 == 0) {
+                binaryWriter.Write<char>(logger, LOG_CTX, spdlog::level::info, "{} #{} {:.1f}", lg::BinaryLogClassName{}, name, i, i / 2.0);
+            }
+            else {
+                binaryWriter.Write<wchar_t>(logger, LOG_CTX, spdlog::level::debug, L"wide {} #{}", lg::BinaryLogClassName{}, std::wstring(L"segment line"), i);
+            }
+        }
+    }
+
+    ASSERT_GT(lg::SegmentedLogFile::ListSegments(binaryLogPath).size(), 2u);
+
+    lg::DefaultLoggers::DecodeBinaryLog(binaryLogPath, textLogPath);
+
+    std::ifstream textLog(textLogPath);
+    int lineIdx = 0;
+    for (std::string line; std::getline(textLog, line); lineIdx++) {
+        const auto expected = lineIdx % 2 == 0
+            ? fmt::format("segment line #{} {:.1f}", lineIdx, lineIdx / 2.0)
+            : fmt::format("wide segment line #{}", lineIdx);
+        ASSERT_NE(line.find(expected), std::string::npos);
+    }
+    EXPECT_EQ(lineIdx, linesCount);
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that reopening a binary log with an entry torn by the previous process cuts it off instead of appending after it
+TEST(BinaryLogTest, AppendAfterTornEntry) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "BinaryLogTornTest";
+    std::filesystem::remove_all(logsDir);
+    std::filesystem::create_directories(logsDir);
+    const auto binaryLogPath = logsDir / "main.binlog";
+
+    auto writeSession = [&](bool truncate, int from, int to) {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(binaryLogPath.native(), truncate);
+        lg::BinaryLogWriter binaryWriter(fileWriter, spdlog::level::err);
+        spdlog::logger logger("logger");
+
+        for (int i = from; i < to; i++) {
+            binaryWriter.Write<char>(logger, LOG_CTX, spdlog::level::info, "line {}", lg::BinaryLogClassName{}, i);
+        }
+    };
+
+    writeSession(true, 0, 3);
+    const auto completeSize = std::filesystem::file_size(binaryLogPath);
+    {
+        // message entry cut off in the middle of its call site id
+        std::ofstream tornTail(binaryLogPath, std::ios::binary | std::ios::app);
+        const char tornEntry[] = { static_cast<char>(lg::BinaryLogEntry::Message), 0x00, 0x00 };
+        tornTail.write(tornEntry, sizeof(tornEntry));
+    }
+    EXPECT_EQ(lg::BinaryLogReader::CompleteSize(binaryLogPath), completeSize);
+
+    writeSession(false, 3, 5);
+
+    int sessionsCount = 0;
+    std::vector<std::string> payloads;
+    lg::BinaryLogReader::Read(binaryLogPath,
+        [&](const lg::BinaryLogSession&) {
+            sessionsCount++;
+        },
+        [&](const lg::BinaryLogMessage& message) {
+            payloads.push_back(message.payload);
+        });
+
+    EXPECT_EQ(sessionsCount, 2);
+    EXPECT_EQ(payloads, (std::vector<std::string>{ "line 0", "line 1", "line 2", "line 3", "line 4" }));
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that call sites of runtime format strings are matched by the text, not by the buffer address
+TEST(BinaryLogTest, RuntimeFormatCallSiteKeyedByText) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "BinaryLogRuntimeFormatTest";
+    std::filesystem::remove_all(logsDir);
+    std::filesystem::create_directories(logsDir);
+    const auto binaryLogPath = logsDir / "main.binlog";
+
+    {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>(binaryLogPath.native(), true);
+        lg::BinaryLogWriter binaryWriter(fileWriter, spdlog::level::err);
+        spdlog::logger logger("logger");
+        const auto location = LOG_CTX;
+
+        for (int i = 0; i < 4; i++) {
+            const std::string format = i % 2 == 0 ? "even {}" : "odd {}"; // the same buffer address for both texts
+            binaryWriter.Write<char>(logger, location, spdlog::level::info, fmt::string_view(format), lg::BinaryLogClassName{}, i);
+        }
+    }
+
+    std::vector<std::string> payloads;
+    std::vector<const lg::BinaryLogCallSite*> callSites;
+    lg::BinaryLogReader::Read(binaryLogPath, nullptr, [&](const lg::BinaryLogMessage& message) {
+        payloads.push_back(message.payload);
+        callSites.push_back(message.callSite);
+        });
+
+    EXPECT_EQ(payloads, (std::vector<std::string>{ "even 0", "odd 1", "even 2", "odd 3" }));
+    ASSERT_EQ(callSites.size(), 4u);
+    EXPECT_NE(callSites[0], callSites[1]);
+    EXPECT_EQ(callSites[0], callSites[2]); // written once per text, not again when the text at the address changes
+    EXPECT_EQ(callSites[1], callSites[3]);
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Caller thread cost of one line: formatting into the shared file buffer vs binary encoding
+TEST(BinaryLogBenchmark, DISABLED_WriteCost) {
+    constexpr size_t linesCount = 200'000;
+    const auto logsDir = std::filesystem::temp_directory_path() / "BinaryLogBenchmark";
+    std::filesystem::create_directories(logsDir);
+
+    auto runBench = [&](const char* name, auto&& writeLine) {
+        Benchmark::Report(name, Benchmark::MeasureNsPerOp(linesCount, [&] {
+            for (size_t i = 0; i < linesCount; i++) {
+                writeLine(i);
+            }
+            }), "ns/line");
+    };
+
+    const std::string payloadName = "frame";
+    {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>((logsDir / "text.log").native(), true);
+        auto fileSink = fileWriter->CreateSink();
+        fileSink->set_pattern("[%L] [%t] %d.%m.%Y %H:%M:%S:%e {%s:%# %!} %v");
+        spdlog::logger logger("logger", fileSink);
+
+        runBench("Text", [&](size_t i) {
+            logger.log(LOG_CTX, spdlog::level::debug, "{} #{} pts = {:.3f} ok = {}", payloadName, i, i / 30.0, true);
+            });
+    }
+    {
+        auto fileWriter = std::make_shared<lg::SharedFileWriter>((logsDir / "binary.binlog").native(), true);
+        lg::BinaryLogWriter binaryWriter(fileWriter, spdlog::level::err);
+        spdlog::logger logger("logger");
+
+        runBench("Binary", [&](size_t i) {
+            binaryWriter.Write<char>(logger, LOG_CTX, spdlog::level::debug, "{} #{} pts = {:.3f} ok = {}", lg::BinaryLogClassName{}, payloadName, i, i / 30.0, true);
+            });
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+
+
+
+//
+// SegmentedLogFile
+//
+TEST(SegmentedLogFileTest, LzCodecRoundTrip) {
+    std::string text;
+    for (int i = 0; i < 10'000; i++) {
+        text += fmt::format("[I] [{}] 17.10.2026 12:00:{:02}:{:03} {{main.cpp:42 Worker::Run}} frame #{} processed\n", 1000 + i % 8, i % 60, i % 1000, i);
+    }
+
+    const auto compressed = lg::LzCodec::Compress(text);
+    EXPECT_LT(compressed.size(), text.size() / 3);
+    EXPECT_EQ(lg::LzCodec::Decompress(compressed), text);
+
+    for (const std::string& data : { std::string{}, std::string{ "abc" }, std::string(1000, 'x') }) {
+        EXPECT_EQ(lg::LzCodec::Decompress(lg::LzCodec::Compress(data)), data);
+    }
+    EXPECT_THROW(lg::LzCodec::Decompress(compressed.substr(0, compressed.size() / 2)), spdlog::spdlog_ex);
+}
+
+TEST(SegmentedLogFileTest, OldestSegmentsAreDeleted) {
+    constexpr uintmax_t maxTotalSize = 1024 * 1024;
+    const auto logsDir = std::filesystem::temp_directory_path() / "SegmentedLogFileTest";
+    std::filesystem::remove_all(logsDir);
+    std::filesystem::create_directories(logsDir);
+    const auto logPath = logsDir / "main.log";
+
+    for (bool compress : { false, true }) {
+        {
+            auto fileWriter = std::make_shared<lg::SharedFileWriter>(logPath.native(), true, lg::FileFlushPolicy{}, maxTotalSize, lg::FileRotationPolicy{ 4, compress });
+            spdlog::logger logger("logger", fileWriter->CreateSink());
+            for (int i = 0; i < 50'000; i++) {
+                logger.info("line {} with some payload to fill the segments quickly", i);
+            }
+            logger.flush();
+
+            // compression runs in background and pending segments are left for the next start, wait for the first one
+            auto hasCompressedSegment = [&logPath] {
+                const auto segments = lg::SegmentedLogFile::ListSegments(logPath);
+                return std::any_of(segments.begin(), segments.end(), [](const std::filesystem::path& segment) {
+                    return segment.extension() == ".lz";
+                    });
+            };
+            for (int i = 0; compress && i < 500 && !hasCompressedSegment(); i++) {
+                std::this_thread::sleep_for(10ms);
+            }
+            EXPECT_EQ(hasCompressedSegment(), compress);
+        }
+
+        const auto segments = lg::SegmentedLogFile::ListSegments(logPath);
+        ASSERT_GT(segments.size(), 1u);
+        EXPECT_EQ(segments.back(), logPath);
+
+        uintmax_t totalSize = 0;
+        std::string content;
+        for (auto& segment : segments) {
+            totalSize += std::filesystem::file_size(segment);
+            content += lg::SegmentedLogFile::ReadSegment(segment);
+        }
+        EXPECT_LE(totalSize, maxTotalSize + lg::FileFlushPolicy{}.bufferSize);
+        EXPECT_EQ(content.find("line 0 "), std::string::npos);
+        EXPECT_NE(content.find("line 49999 "), std::string::npos);
+
+        // index lists the same files, the active one is the last
+        std::ifstream index(lg::SegmentedLogFile::IndexPath(logPath));
+        std::vector<std::string> indexedFiles;
+        for (std::string line; std::getline(index, line);) {
+            indexedFiles.push_back(line.substr(line.find(' ') + 1));
+        }
+        ASSERT_EQ(indexedFiles.size(), segments.size());
+        for (size_t i = 0; i < segments.size(); i++) {
+            EXPECT_EQ(indexedFiles[i], segments[i].filename().string());
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+// Tests that the newest closed segment survives even when the limit leaves no room for it
+TEST(SegmentedLogFileTest, NewestClosedSegmentIsKept) {
+    const auto logsDir = std::filesystem::temp_directory_path() / "SegmentedLogFileKeepTest";
+    std::filesystem::remove_all(logsDir);
+    std::filesystem::create_directories(logsDir);
+    const auto logPath = logsDir / "main.log";
+    const std::string line(1000, 'x');
+
+    {
+        // one segment: every rotation would delete the data it has just closed
+        lg::SegmentedLogFile file(logPath.native(), true, lg::SegmentedLogFile::minSegmentSize, lg::FileRotationPolicy{ 1, false });
+        spdlog::memory_buf_t buffer;
+        buffer.append(line.data(), line.data() + line.size());
+
+        for (uintmax_t written = 0; written < 3 * lg::SegmentedLogFile::minSegmentSize; written += line.size()) {
+            file.Write(buffer);
+        }
+    }
+
+    auto segments = lg::SegmentedLogFile::ListSegments(logPath);
+    ASSERT_EQ(segments.size(), 2u); // the newest closed one + active
+    EXPECT_GE(std::filesystem::file_size(segments.front()), lg::SegmentedLogFile::minSegmentSize);
+
+    {
+        // reopening with a smaller limit keeps it too
+        lg::SegmentedLogFile file(logPath.native(), false, 1, lg::FileRotationPolicy{ 4, false });
+    }
+    segments = lg::SegmentedLogFile::ListSegments(logPath);
+    EXPECT_EQ(segments.size(), 2u);
+
+    std::error_code ec;
+    std::filesystem::remove_all(logsDir, ec);
+}
+
+
+
+//
+// Log filtering
+//
+TEST(LogFilteringTest, FilteredCallsDontEvaluateArguments) {
+    int evaluated = 0;
+    auto argument = [&evaluated] {
+        return ++evaluated;
+    };
+
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Debug, spdlog::level::info);
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Func, spdlog::level::off);
+    EXPECT_FALSE(lg::DefaultLoggers::IsEnabled(lg::LogCategory::Debug, spdlog::level::debug));
+    EXPECT_TRUE(lg::DefaultLoggers::IsEnabled(lg::LogCategory::Debug, spdlog::level::info));
+
+    LOG_DEBUG_D("filtered {}", argument());
+    LOG_DEBUG_S(lg::nullctx, "filtered {}", argument());
+    {
+        LOG_FUNCTION_SCOPE("FilteredScope({})", argument());
+    }
+    EXPECT_EQ(evaluated, 0);
+
+    // logging mode level applies on top of the category levels
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Debug, spdlog::level::trace);
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Func, spdlog::level::trace);
+    lg::DefaultLoggers::SetLoggingMode(lg::LoggingMode::Normal);
+    LOG_DEBUG("filtered {}", argument());
+    LOG_DEBUG_D("filtered {}", argument());
+    EXPECT_EQ(evaluated, 0);
+
+    lg::DefaultLoggers::SetLoggingMode(lg::LoggingMode::Verbose);
+    LOG_DEBUG_D("passed {}", argument());
+    {
+        LOG_FUNCTION_SCOPE("PassedScope({})", argument()); // evaluated on enter and on exit
+    }
+    EXPECT_EQ(evaluated, 3);
+
+    // LOG_SCOPED is filtered by its own category, not by Debug
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Func, spdlog::level::off);
+    {
+        LOG_SCOPED(lg::DefaultLoggers::FuncLogger(), Func, lg::nullctx, "FilteredScoped({})", argument());
+    }
+    {
+        LOG_SCOPED(lg::DefaultLoggers::DebugLogger(), Debug, lg::nullctx, "PassedScoped({})", argument());
+    }
+    EXPECT_EQ(evaluated, 5);
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Func, spdlog::level::trace);
+}
+
+// Tests that enabled levels match the last category level and logging mode set by concurrent threads
+TEST(LogFilteringTest, ConcurrentLevelChangesSettle) {
+    constexpr int iterations = 10'000;
+
+    std::thread categoryThread([] {
+        for (int i = 0; i < iterations; i++) {
+            lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Debug, i % 2 == 0 ? spdlog::level::err : spdlog::level::trace);
+        }
+        });
+    std::thread modeThread([] {
+        for (int i = 0; i < iterations; i++) {
+            lg::DefaultLoggers::SetLoggingMode(i % 2 == 0 ? lg::LoggingMode::Normal : lg::LoggingMode::Verbose);
+        }
+        });
+    categoryThread.join();
+    modeThread.join();
+
+    // both end on trace, an unguarded update could leave max() of the other thread's stale value
+    EXPECT_EQ(lg::DefaultLoggers::GetCategoryLevel(lg::LogCategory::Debug), spdlog::level::trace);
+    EXPECT_EQ(lg::DefaultLoggers::GetLoggingMode(), lg::LoggingMode::Verbose);
+    EXPECT_TRUE(lg::DefaultLoggers::IsEnabled(lg::LogCategory::Debug, spdlog::level::trace));
+}
+
+TEST(LogFilteringTest, SamplingMacros) {
+    int everyN = 0;
+    int firstN = 0;
+    int rateLimited = 0;
+    auto count = [](int& counter) {
+        return ++counter;
+    };
+
+    for (int i = 0; i < 100; i++) {
+        LOG_EVERY_N(10, LOG_DEBUG_D("every 10th {}", count(everyN)));
+        LOG_FIRST_N(3, LOG_DEBUG_D("first 3 {}", count(firstN)));
+        LOG_RATE_LIMITED(5, LOG_DEBUG_D("5 per second {}", count(rateLimited)));
+    }
+
+    EXPECT_EQ(everyN, 10);
+    EXPECT_EQ(firstN, 3);
+    EXPECT_GE(rateLimited, 5);
+    EXPECT_LE(rateLimited, 10); // the loop may cross a second boundary
+}
+
+// Cost of a filtered LOG_DEBUG_D: logger level check inside Log() (context, logger and arguments are evaluated)
+// vs category level check in the macro.
+TEST(LogFilteringBenchmark, DISABLED_FilteredCallCost) {
+    constexpr size_t callsCount = 1'000'000;
+
+    auto runBench = [&](const char* name, auto&& call) {
+        Benchmark::Report(name, Benchmark::MeasureNsPerOp(callsCount, [&] {
+            for (size_t i = 0; i < callsCount; i++) {
+                call(i);
+            }
+            }), "ns/call");
+    };
+
+    const std::string payloadName = "frame";
+    const auto debugLoggerLevel = lg::DefaultLoggers::DebugLogger()->level();
+
+    lg::DefaultLoggers::DebugLogger()->set_level(spdlog::level::info);
+    runBench("Logger level", [&](size_t i) {
+        LOG_DEBUG_D("{} #{} pts = {:.3f}", payloadName, i, i / 30.0);
+        });
+    lg::DefaultLoggers::DebugLogger()->set_level(debugLoggerLevel);
+
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Debug, spdlog::level::info);
+    runBench("Category level", [&](size_t i) {
+        LOG_DEBUG_D("{} #{} pts = {:.3f}", payloadName, i, i / 30.0);
+        });
+    lg::DefaultLoggers::SetCategoryLevel(lg::LogCategory::Debug, spdlog::level::trace);
+}
+
+
+
+//
+// FramedReadBuffer
+//
+namespace {
+#pragma pack(push, 1)
+    struct BenchFrameDescriptor {
+        uint32_t size = 0;
+        uint32_t type = 0;
+    };
+#pragma pack(pop)
+}
+
+TEST(FramedReadBufferTest, OversizedFrameRejectedBeforeReserve) {
+    H::FramedReadBuffer<uint8_t, BenchFrameDescriptor> readBuffer{ 0, 1024 };
+
+    auto appendFrame = [&](uint32_t size, std::size_t payloadSize) {
+        BenchFrameDescriptor descriptor{ size, 0 };
+        auto& buffer = readBuffer.PrepareForRead();
+        auto descriptorBytes = reinterpret_cast<const uint8_t*>(&descriptor);
+        buffer.insert(buffer.end(), descriptorBytes, descriptorBytes + sizeof(descriptor));
+        buffer.resize(buffer.size() + payloadSize, 1);
+    };
+
+    appendFrame(16, 16);
+    auto frame = readBuffer.NextFrame();
+    ASSERT_TRUE(frame.has_value());
+    EXPECT_EQ(frame->payload.size(), 16u);
+
+    appendFrame(0xFFFFFFF0u, 8); // corrupted or hostile size, payload is incomplete
+    EXPECT_FALSE(readBuffer.NextFrame().has_value());
+    EXPECT_TRUE(readBuffer.HasOversizedFrame());
+    EXPECT_LT(readBuffer.PrepareForRead().capacity(), 1024u * 1024u);
+
+    appendFrame(16, 16); // parsing stays stopped after oversized frame
+    EXPECT_FALSE(readBuffer.NextFrame().has_value());
+
+    readBuffer.Clear();
+    EXPECT_FALSE(readBuffer.HasOversizedFrame());
+    appendFrame(1024, 1024);
+    EXPECT_TRUE(readBuffer.NextFrame().has_value());
+}
+
+// Stream of frames is read by 64 KB chunks (like transport reads), so frames are split between reads.
+TEST(FramedReadBufferBenchmark, DISABLED_MessagesPerSecond) {
+    constexpr std::size_t readChunkSize = 64 * 1024;
+    constexpr std::size_t streamSize = 64 * 1024 * 1024;
+
+    for (std::size_t payloadSize : { 16, 1024, 64 * 1024 }) {
+        const std::size_t framesCount = streamSize / (sizeof(BenchFrameDescriptor) + payloadSize);
+
+        std::vector<uint8_t> stream;
+        stream.reserve(framesCount * (sizeof(BenchFrameDescriptor) + payloadSize));
+        for (std::size_t i = 0; i < framesCount; i++) {
+            BenchFrameDescriptor descriptor{ static_cast<uint32_t>(payloadSize), static_cast<uint32_t>(i) };
+            auto descriptorBytes = reinterpret_cast<const uint8_t*>(&descriptor);
+            stream.insert(stream.end(), descriptorBytes, descriptorBytes + sizeof(descriptor));
+            stream.resize(stream.size() + payloadSize, static_cast<uint8_t>(i));
+        }
+
+        auto runBench = [&](const char* name, auto&& onFrame) {
+            H::FramedReadBuffer<uint8_t, BenchFrameDescriptor> readBuffer;
+            std::size_t framesRead = 0;
+
+            const double messagesPerSec = Benchmark::MeasureOpsPerSec(framesCount, [&] {
+                for (std::size_t pos = 0; pos < stream.size(); pos += readChunkSize) {
+                    auto& buffer = readBuffer.PrepareForRead();
+                    const std::size_t chunkSize = (std::min)(readChunkSize, stream.size() - pos);
+                    buffer.insert(buffer.end(), stream.begin() + pos, stream.begin() + pos + chunkSize);
+
+                    while (auto frame = readBuffer.NextFrame()) {
+                        onFrame(frame->payload);
+                        framesRead++;
+                    }
+                }
+                });
+
+            EXPECT_EQ(framesRead, framesCount);
+            Benchmark::Report("payload = " + std::to_string(payloadSize) + " B, " + name, messagesPerSec, "msg/s");
+        };
+
+        uint64_t checksum = 0;
+        runBench("view", [&](std::span<uint8_t> payload) {
+            checksum += payload.front();
+            });
+        runBench("copy to Message", [&](std::span<uint8_t> payload) { // Channel without message view handler
+            auto msg = std::make_shared<std::vector<uint8_t>>(payload.begin(), payload.end());
+            checksum += msg->front();
+            });
+        EXPECT_GT(checksum, 0u);
+    }
+}
+
+
+
+//
+// ChannelLanes
+//
+namespace {
+    struct LaneTestMessage {
+        uint8_t lane = 0;
+        int id = 0;
+    };
+}
+
+// Tests that sender doesn't exceed the receive window before the peer's first credit grant arrives
+TEST(ChannelLanesTest, InitialSendWindowBeforeGrant) {
+    H::ChannelLanes<LaneTestMessage> lanes;
+    lanes.Configure(1, H::ChannelLaneOptions{ .receiveWindow = 100 });
+
+    auto grants = lanes.ResetFlowControl();
+    ASSERT_EQ(grants.size(), 1u);
+    EXPECT_EQ(grants[0], (std::pair<uint8_t, uint64_t>{ 1, 100 }));
+
+    for (int i = 0; i < 3; i++) {
+        lanes.Push(LaneTestMessage{ 1, i }, 60);
+    }
+
+    auto first = lanes.PopNext();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->id, 0);
+    auto second = lanes.PopNext(); // started with credit left (60 < 100), may overrun the window
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->id, 1);
+    EXPECT_FALSE(lanes.PopNext().has_value()); // 120 >= 100, waits for grant
+
+    lanes.OnCreditGranted(1, 200);
+    auto third = lanes.PopNext();
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(third->id, 2);
+
+    // Lane without window is not flow controlled
+    lanes.Push(LaneTestMessage{ 0, 3 }, 1'000'000);
+    EXPECT_TRUE(lanes.PopNext().has_value());
+}
+
+
+
+
+//
+// ThreadPool (libhelpers)
+//
+TEST(ThreadPoolBenchmark, DISABLED_Scaling) {
+    const uint32_t maxThreadCount = (std::min)((std::max)(std::thread::hardware_concurrency(), 1u), 8u);
+    const auto results = ThreadPoolScalingBenchmark(maxThreadCount, 50'000, 2000);
+
+    ASSERT_EQ(results.size(), static_cast<size_t>(maxThreadCount));
+    for (auto& result : results) {
+        EXPECT_GT(result.parallelForItemsPerSec, 0.0);
+        EXPECT_GT(result.submitTasksPerSec, 0.0);
+        const std::string name = "threads = " + std::to_string(result.threadCount) + ", ";
+        Benchmark::Report(name + "ParallelFor", result.parallelForItemsPerSec, "items/s");
+        Benchmark::Report(name + "Submit", result.submitTasksPerSec, "tasks/s");
+        Benchmark::Report(name + "speedup", result.speedup, "x");
+    }
+}
+
+
+
+//
+// LockProfiler (libhelpers)
+//
+namespace {
+    const LockProfilerLockStats* FindLockStats(const std::vector<LockProfilerLockStats>& stats, const void* lockAddress) {
+        auto it = std::find_if(stats.begin(), stats.end(), [lockAddress](const LockProfilerLockStats& lock) {
+            return lock.lockAddress == lockAddress;
+            });
+        return it != stats.end() ? &*it : nullptr;
+    }
+}
+
+// Tests that wait time is recorded only for contended acquisitions and hold time for every unlock
+TEST(LockProfilerTest, WaitAndHoldAccounting) {
+    auto profiler = LockProfiler::Instance();
+    profiler->Reset();
+
+    int lockObj = 0;
+    int callSiteObj = 0;
+    LockProfilerHold hold;
+
+    hold.Acquired(profiler->Lock(&lockObj, &callSiteObj, [] { return true; }, [] {}));
+    std::this_thread::sleep_for(2ms);
+    EXPECT_TRUE(hold.Released(&lockObj));
+
+    hold.Acquired(profiler->Lock(&lockObj, &callSiteObj,
+        [] { return false; },
+        [] { std::this_thread::sleep_for(5ms); })); // contended, "waits" for the owner
+    EXPECT_TRUE(hold.Released(&lockObj));
+
+    const auto stats = profiler->Aggregate();
+    const auto lockStats = FindLockStats(stats, &lockObj);
+    ASSERT_TRUE(lockStats != nullptr);
+
+    EXPECT_EQ(lockStats->acquireCount, 2u);
+    EXPECT_EQ(lockStats->contentionCount, 1u);
+    EXPECT_EQ(lockStats->waitTime.count, 1u);
+    EXPECT_GE(lockStats->waitTime.totalNs, 5'000'000u);
+    EXPECT_EQ(lockStats->holdTime.count, 2u);
+    EXPECT_GE(lockStats->holdTime.maxNs, 2'000'000u);
+    EXPECT_LT(lockStats->holdTime.PercentileNs(0.0), 2'000'000u); // the 2nd hold is short
+
+    ASSERT_EQ(lockStats->topCallSites.size(), 1u);
+    EXPECT_EQ(lockStats->topCallSites[0].address, static_cast<const void*>(&callSiteObj));
+    EXPECT_EQ(lockStats->topCallSites[0].contentionCount, 1u);
+    EXPECT_EQ(lockStats->topCallSites[0].totalWaitNs, lockStats->waitTime.totalNs);
+
+    profiler->Reset();
+    EXPECT_TRUE(FindLockStats(profiler->Aggregate(), &lockObj) == nullptr);
+}
+
+// Tests that recursive acquisitions are part of the outer hold and condition variable wait is excluded from it
+TEST(LockProfilerTest, RecursiveHoldRecordedOnce) {
+    auto profiler = LockProfiler::Instance();
+    profiler->Reset();
+
+    int lockObj = 0;
+    LockProfilerHold hold;
+
+    hold.Acquired(LockProfiler::NowNs());
+    std::this_thread::sleep_for(2ms);
+    hold.Acquired(LockProfiler::NowNs());
+    EXPECT_FALSE(hold.Released(&lockObj));
+    std::this_thread::sleep_for(2ms);
+    EXPECT_TRUE(hold.Released(&lockObj));
+
+    auto stats = profiler->Aggregate();
+    auto lockStats = FindLockStats(stats, &lockObj);
+    ASSERT_TRUE(lockStats != nullptr);
+    EXPECT_EQ(lockStats->holdTime.count, 1u);
+    EXPECT_GE(lockStats->holdTime.totalNs, 4'000'000u);
+
+    profiler->Reset();
+
+    hold.Acquired(LockProfiler::NowNs());
+    hold.WaitBegin(&lockObj);
+    std::this_thread::sleep_for(20ms); // asleep in condition variable
+    hold.WaitEnd();
+    EXPECT_TRUE(hold.Released(&lockObj));
+
+    stats = profiler->Aggregate();
+    lockStats = FindLockStats(stats, &lockObj);
+    ASSERT_TRUE(lockStats != nullptr);
+    EXPECT_EQ(lockStats->holdTime.count, 2u);
+    EXPECT_LT(lockStats->holdTime.totalNs, 20'000'000u);
+
+    profiler->Reset();
+}
+
+// Tests that JSON report contains escaped lock name, counters and histograms of locks recorded by several threads
+TEST(LockProfilerTest, ReportJson) {
+    auto profiler = LockProfiler::Instance();
+    profiler->Reset();
+    EXPECT_EQ(profiler->ReportJson(), "{\"locks\":[]}");
+
+    int lockObj = 0;
+    profiler->SetLockName(&lockObj, "test \"lock\"");
+
+    std::thread otherThread([profiler, &lockObj] {
+        profiler->RecordAcquire(&lockObj, true, 1000, nullptr);
+        profiler->RecordHold(&lockObj, 10);
+        });
+    otherThread.join();
+    profiler->RecordAcquire(&lockObj, false, 0, nullptr);
+    profiler->RecordHold(&lockObj, 3);
+
+    const std::string json = profiler->ReportJson();
+    EXPECT_EQ(json.rfind("{\"locks\":[{", 0), 0u);
+    EXPECT_EQ(json.substr(json.size() - 3), "}]}");
+    EXPECT_NE(json.find("\"name\":\"test \\\"lock\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"acquireCount\":2,\"contentionCount\":1"), std::string::npos);
+    EXPECT_NE(json.find("\"waitTime\":{\"count\":1,\"totalNs\":1000,\"maxNs\":1000"), std::string::npos);
+    EXPECT_NE(json.find("\"holdTime\":{\"count\":2,\"totalNs\":13,\"maxNs\":10"), std::string::npos);
+    EXPECT_NE(json.find("\"log2Buckets\":[0,1,0,1]"), std::string::npos); // hold 3 and 10 ns
+    EXPECT_NE(json.find("\"topCallSites\":[{"), std::string::npos);
+
+    profiler->Reset();
+}
+
+// Tests that contended thread::critical_section reports wait and hold through LockProfiler (project is built with USE_LockProfiler)
+TEST(LockProfilerTest, CriticalSectionContention) {
+    auto profiler = LockProfiler::Instance();
+    profiler->Reset();
+
+    thread::critical_section cs;
+    std::latch otherStarted{ 1 };
+
+    cs.lock();
+    std::thread otherThread([&cs, &otherStarted] {
+        otherStarted.count_down();
+        thread::critical_section::scoped_lock lk(cs);
+        });
+    otherStarted.wait();
+    std::this_thread::sleep_for(20ms); // other thread is blocked in lock
+    cs.unlock();
+    otherThread.join();
+
+    const auto stats = profiler->Aggregate();
+    const auto lockStats = FindLockStats(stats, &cs); // stats are keyed by CRITICAL_SECTION, the first member
+    ASSERT_TRUE(lockStats != nullptr);
+
+    EXPECT_EQ(lockStats->acquireCount, 2u);
+    EXPECT_EQ(lockStats->contentionCount, 1u);
+    EXPECT_EQ(lockStats->waitTime.count, 1u);
+    EXPECT_GE(lockStats->waitTime.totalNs, 10'000'000u);
+    EXPECT_EQ(lockStats->holdTime.count, 2u);
+    EXPECT_GE(lockStats->holdTime.maxNs, 10'000'000u);
+
+    profiler->Reset();
+}
+
+namespace {
+    class TestQueuedLockItem : public thread::QueuedLockItem {
+    public:
+        bool acquired = false;
+
+        void Acquired() override {
+            this->acquired = true;
+        }
+
+        bool IsCancelled() override {
+            return false;
+        }
+    };
+}
+
+// Tests that QueuedLock wait time of queued item lasts until the previous owner pops it
+TEST(LockProfilerTest, QueuedLockWaitUntilPreviousPop) {
+    auto profiler = LockProfiler::Instance();
+    profiler->Reset();
+
+    thread::QueuedLock queuedLock;
+    TestQueuedLockItem first;
+    TestQueuedLockItem second;
+
+    queuedLock.Push(&first);
+    queuedLock.Push(&second);
+    EXPECT_TRUE(first.acquired);
+    EXPECT_FALSE(second.acquired);
+
+    std::this_thread::sleep_for(5ms);
+    queuedLock.Pop(&first);
+    EXPECT_TRUE(second.acquired);
+    queuedLock.Pop(&second);
+
+    const auto stats = profiler->Aggregate();
+    const auto lockStats = FindLockStats(stats, &queuedLock);
+    ASSERT_TRUE(lockStats != nullptr);
+
+    EXPECT_EQ(lockStats->acquireCount, 2u);
+    EXPECT_EQ(lockStats->contentionCount, 1u);
+    EXPECT_EQ(lockStats->waitTime.count, 1u);
+    EXPECT_GE(lockStats->waitTime.totalNs, 5'000'000u);
+    EXPECT_EQ(lockStats->holdTime.count, 2u);
+    EXPECT_GE(lockStats->holdTime.maxNs, 5'000'000u);
+
+    profiler->Reset();
+}
+
+
+
+
+//
+// ObjectPoolMt (libhelpers)
+//
+// Tests that empty GrowOnEmpty pool creates objects with factory and reuses returned ones
+TEST(ObjectPoolMtTest, GrowOnEmptyUsesFactory) {
+    int factoryCalls = 0;
+    containers::ObjectPoolMt<std::unique_ptr<int>> pool(containers::ObjectPoolMtPolicy::GrowOnEmpty, [&factoryCalls] {
+        return std::make_unique<int>(factoryCalls++);
+        });
+
+    int* firstObj = nullptr;
+    {
+        auto first = pool.Get();
+        auto second = pool.Get();
+        EXPECT_EQ(factoryCalls, 2);
+        firstObj = first.obj.get();
+    }
+
+    auto reused = pool.Get(); // the last returned object is taken back first
+    EXPECT_EQ(factoryCalls, 2);
+    EXPECT_EQ(reused.obj.get(), firstObj);
+}
+
+// Tests that BlockOnEmpty Get waits until another thread returns an object
+TEST(ObjectPoolMtTest, BlockOnEmptyWakesOnRelease) {
+    containers::ObjectPoolMt<std::unique_ptr<int>> pool(containers::ObjectPoolMtPolicy::BlockOnEmpty);
+    pool.Add(std::make_unique<int>(42));
+
+    auto held = pool.Get();
+    std::atomic<bool> waiterDone = false;
+    std::thread waiterThread([&pool, &waiterDone] {
+        auto obj = pool.Get();
+        EXPECT_EQ(*obj.obj, 42);
+        waiterDone = true;
+        });
+
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(waiterDone.load());
+
+    { auto release = std::move(held); } // returned to the pool from this thread's slot
+    waiterThread.join();
+    EXPECT_TRUE(waiterDone.load());
+}
+
+// Tests that objects added by one thread reach another one through the depot (full magazines)
+TEST(ObjectPoolMtTest, MagazinesMoveThroughDepot) {
+    constexpr int objCount = 10 * containers::ObjectPoolMt<std::unique_ptr<int>>::MagazineSize;
+
+    std::atomic<int> factoryCalls = 0;
+    containers::ObjectPoolMt<std::unique_ptr<int>> pool(containers::ObjectPoolMtPolicy::GrowOnEmpty, [&factoryCalls] {
+        factoryCalls++;
+        return std::make_unique<int>(-1);
+        });
+
+    std::thread producerThread([&pool] {
+        for (int i = 0; i < objCount; i++) {
+            pool.Add(std::make_unique<int>(i));
+        }
+        });
+    producerThread.join();
+
+    std::vector<containers::ObjectPoolMt<std::unique_ptr<int>>::UsageScope> borrowed;
+    std::thread consumerThread([&pool, &borrowed] {
+        for (int i = 0; i < objCount; i++) {
+            borrowed.push_back(pool.Get());
+        }
+        });
+    consumerThread.join();
+
+    // producer slot keeps at most its 2 magazines, the rest is taken from the depot
+    EXPECT_LE(factoryCalls.load(), 2 * static_cast<int>(containers::ObjectPoolMt<std::unique_ptr<int>>::MagazineSize));
+    int addedObjs = 0;
+    for (auto& scope : borrowed) {
+        addedObjs += *scope.obj >= 0 ? 1 : 0;
+    }
+    EXPECT_EQ(addedObjs + factoryCalls.load(), objCount);
+}
+
+// Get + return throughput of ObjectPoolMt against single mutex pool.
+TEST(ObjectPoolMtBenchmark, DISABLED_Scaling) {
+    const uint32_t maxThreadCount = (std::min)((std::max)(std::thread::hardware_concurrency(), 1u), 8u);
+    const auto results = ObjectPoolMtScalingBenchmark(maxThreadCount, 100'000);
+
+    for (auto& result : results) {
+        EXPECT_GT(result.poolOpsPerSec, 0.0);
+        const std::string name = "threads = " + std::to_string(result.threadCount) + ", ";
+        Benchmark::Report(name + "ObjectPoolMt", result.poolOpsPerSec, "ops/s");
+        Benchmark::Report(name + "mutex pool", result.lockedOpsPerSec, "ops/s");
+    }
+}
+
+
+
+
+//
+// ChunkedDataBuffer (libhelpers)
+//
+// Tests that data keeps its order when active chunks wrap around the ring end and when the ring grows
+TEST(ChunkedDataBufferTest, RingWrapAround) {
+    ChunkedDataBuffer<int> buffer(4);
+    std::deque<int> expected;
+    int nextValue = 0;
+
+    auto push = [&](size_t count) {
+        std::vector<int> block(count);
+        for (auto& v : block) {
+            v = nextValue++;
+            expected.push_back(v);
+        }
+        buffer.PushBack(block.data(), block.size());
+    };
+
+    auto popAndCheck = [&](size_t count) {
+        std::vector<int> block(count);
+        size_t popped = buffer.Pop(block.data(), block.size());
+        ASSERT_EQ(popped, (std::min)(count, expected.size()));
+        for (size_t i = 0; i < popped; i++) {
+            ASSERT_EQ(block[i], expected.front());
+            expected.pop_front();
+        }
+        ASSERT_EQ(buffer.Size(), expected.size());
+    };
+
+    push(8);        // 2 chunks
+    popAndCheck(6); // first chunk recycled, head is the 2nd chunk
+    push(6);        // fills recycled chunk at the ring start, then grows the ring
+    popAndCheck(3);
+    push(13);
+    popAndCheck(20);
+
+    // irregular sizes, so chunk boundaries are hit at different offsets
+    for (size_t i = 1; i < 40; i++) {
+        push(i * 7 % 11);
+        popAndCheck(i * 5 % 9);
+    }
+    popAndCheck(expected.size() + 1);
+    EXPECT_TRUE(buffer.Empty());
+}
+
+// Tests that fully read chunk is reused by the next PushBack instead of allocating a new one
+TEST(ChunkedDataBufferTest, ChunkRecycling) {
+    ChunkedDataBuffer<int> buffer(4);
+    const int values[] = { 1, 2, 3, 4 };
+
+    buffer.PushBack(std::begin(values), std::end(values));
+    const int* chunkData = buffer.FrontSpan().data;
+    buffer.PopFront(4);
+    EXPECT_TRUE(buffer.Empty());
+
+    for (int i = 0; i < 10; i++) {
+        buffer.PushBack(std::begin(values), std::end(values));
+        auto front = buffer.FrontSpan();
+        EXPECT_EQ(front.data, chunkData);
+        EXPECT_EQ(front.size, 4u);
+        buffer.PopFront(4);
+    }
+
+    buffer.PushBack(5);
+    buffer.PopFront(10); // clamped to Size()
+    EXPECT_EQ(buffer.Size(), 0u);
+    EXPECT_EQ(buffer.FrontSpan().size, 0u);
+}
+
+// Tests that PeekSpans gives contiguous pieces across chunk boundaries without removing data and stops when func returns false
+TEST(ChunkedDataBufferTest, PeekSpans) {
+    ChunkedDataBuffer<int> buffer(4);
+    for (int i = 0; i < 10; i++) {
+        buffer.PushBack(i);
+    }
+    buffer.PopFront(1);
+
+    std::vector<size_t> pieceSizes;
+    std::vector<int> peeked;
+    size_t peekedCount = buffer.PeekSpans(8, [&](const ChunkedDataBuffer<int>::span& piece) {
+        pieceSizes.push_back(piece.size);
+        peeked.insert(peeked.end(), piece.data, piece.data + piece.size);
+        return true;
+        });
+
+    EXPECT_EQ(peekedCount, 8u);
+    EXPECT_EQ(pieceSizes, (std::vector<size_t>{ 3, 4, 1 }));
+    EXPECT_EQ(peeked, (std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8 }));
+    EXPECT_EQ(buffer.Size(), 9u);
+    EXPECT_EQ(buffer.Front(), 1);
+
+    int calls = 0;
+    peekedCount = buffer.PeekSpans(100, [&calls](const ChunkedDataBuffer<int>::span&) {
+        calls++;
+        return false;
+        });
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(peekedCount, 3u);
+
+    peekedCount = buffer.PeekSpans(100, [](const ChunkedDataBuffer<int>::span&) {
+        return true;
+        });
+    EXPECT_EQ(peekedCount, 9u); // clamped to Size()
+}
+
+// Per-element, bulk and span throughput for audio-like block sizes.
+TEST(ChunkedDataBufferBenchmark, DISABLED_Throughput) {
+    const auto results = ChunkedDataBufferThroughputBenchmark(4 * 1024 * 1024);
+
+    for (auto& result : results) {
+        EXPECT_TRUE(result.dataValid);
+        EXPECT_GT(result.bulkSamplesPerSec, 0.0);
+        const std::string name = "block = " + std::to_string(result.blockSize) + ", ";
+        Benchmark::Report(name + "per element", result.perElementSamplesPerSec, "samples/s");
+        Benchmark::Report(name + "bulk", result.bulkSamplesPerSec, "samples/s");
+        Benchmark::Report(name + "spans", result.spanSamplesPerSec, "samples/s");
+    }
+}
+
+
+
+
+//
+// slot_map (libhelpers)
+//
+// Tests that removed value's handle is rejected, also after its slot is reused
+TEST(SlotMapTest, StaleHandleRejected) {
+    slot_map<int> map;
+    auto h1 = map.push(1);
+    auto h2 = map.push(2);
+    auto h3 = map.push(3);
+
+    EXPECT_TRUE(map.remove(h2));
+    EXPECT_FALSE(map.remove(h2));
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_FALSE(map.contains(h2));
+    EXPECT_EQ(map.get(h2), nullptr);
+    ASSERT_NE(map.get(h1), nullptr);
+    ASSERT_NE(map.get(h3), nullptr); // moved into the hole
+    EXPECT_EQ(*map.get(h1), 1);
+    EXPECT_EQ(*map.get(h3), 3);
+
+    auto h4 = map.push(4);
+    EXPECT_EQ(h4.index, h2.index); // free slot is reused with the next generation
+    EXPECT_NE(h4.generation, h2.generation);
+    EXPECT_EQ(map.get(h2), nullptr);
+    EXPECT_EQ(*map.get(h4), 4);
+
+    EXPECT_EQ(map.get(slot_map_handle{}), nullptr);
+    EXPECT_EQ(map.get(slot_map_handle::from_uint64(h4.to_uint64())), map.get(h4));
+}
+
+// Tests that slot is retired when its generation wraps, so the first handle of that slot never matches again
+TEST(SlotMapTest, GenerationWrapRetiresSlot) {
+    slot_map<int, std::allocator<int>, uint8_t> map; // wraps after 256 removes
+    auto first = map.push(0);
+    EXPECT_TRUE(map.remove(first));
+
+    for (int i = 1; i < 256; i++) {
+        auto h = map.push(i);
+        ASSERT_EQ(h.index, first.index);
+        ASSERT_EQ(h.generation, static_cast<uint32_t>(i));
+        EXPECT_TRUE(map.remove(h));
+    }
+
+    // generation of the first slot is 0 again, but the slot is not reused
+    auto next = map.push(256);
+    EXPECT_NE(next.index, first.index);
+    EXPECT_EQ(map.get(first), nullptr);
+    EXPECT_FALSE(map.remove(first));
+    EXPECT_EQ(*map.get(next), 256);
+    EXPECT_EQ(map.size(), 1u);
+}
+
+// Tests that throwing value constructor leaves map unchanged
+TEST(SlotMapTest, EmplaceThrowLeavesMapUnchanged) {
+    struct ThrowingValue {
+        int value = 0;
+
+        explicit ThrowingValue(int value)
+            : value{ value }
+        {
+            if (value < 0) {
+                throw std::runtime_error("negative");
+            }
+        }
+    };
+
+    slot_map<ThrowingValue> map;
+    auto h1 = map.emplace(1);
+    auto h2 = map.emplace(2);
+    EXPECT_TRUE(map.remove(h1)); // slot on free list
+
+    EXPECT_THROW(map.emplace(-1), std::runtime_error);
+    EXPECT_THROW(map.emplace(-2), std::runtime_error);
+    EXPECT_EQ(map.size(), 1u);
+    EXPECT_EQ(map.get(h2)->value, 2);
+
+    auto h3 = map.emplace(3);
+    EXPECT_EQ(h3.index, h1.index);
+    auto h4 = map.emplace(4);
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_EQ(map.get(h3)->value, 3);
+    EXPECT_EQ(map.get(h4)->value, 4);
+    EXPECT_EQ(map.handle_at_dense(map.size() - 1), h4);
+}
+
+// Tests that dense iteration visits every live value once and dense index maps back to its handle
+TEST(SlotMapTest, DenseIterationAfterRemoves) {
+    slot_map<int> map;
+    std::vector<slot_map_handle> handles;
+    for (int i = 0; i < 10; i++) {
+        handles.push_back(map.push(i));
+    }
+    for (int i = 0; i < 10; i += 3) {
+        EXPECT_TRUE(map.remove(handles[i])); // removes 0, 3, 6, 9
+    }
+
+    std::vector<int> iterated(map.begin(), map.end());
+    std::sort(iterated.begin(), iterated.end());
+    EXPECT_EQ(iterated, (std::vector<int>{ 1, 2, 4, 5, 7, 8 }));
+    EXPECT_EQ(map.data(), &*map.begin());
+
+    for (size_t i = 0; i < map.size(); i++) {
+        auto h = map.handle_at_dense(i);
+        EXPECT_EQ(map.get(h), &map.at_dense(i));
+        EXPECT_EQ(handles[map.at_dense(i)], h);
+    }
+}
+
+// Tests that parallel_for_each calls func once per value, with the value's handle in func(handle, T&) form
+TEST(SlotMapTest, ParallelForEachVisitsEveryValue) {
+    constexpr int valuesCount = 10'000;
+    auto pool = ThreadPool::Make(4);
+
+    slot_map<int> map;
+    std::vector<slot_map_handle> handles;
+    for (int i = 0; i < valuesCount; i++) {
+        handles.push_back(map.push(i));
+    }
+    for (int i = 0; i < valuesCount; i += 2) {
+        map.remove(handles[i]);
+    }
+
+    map.parallel_for_each(*pool, [](int& value) {
+        value *= 2;
+        });
+    for (int i = 1; i < valuesCount; i += 2) {
+        EXPECT_EQ(*map.get(handles[i]), i * 2);
+    }
+
+    std::atomic<int> mismatchCount = 0;
+    std::atomic<int> visitedCount = 0;
+    map.parallel_for_each(*pool, [&](slot_map_handle h, int& value) {
+        if (map.get(h) != &value) {
+            mismatchCount++;
+        }
+        visitedCount++;
+        }, 16);
+    EXPECT_EQ(mismatchCount, 0);
+    EXPECT_EQ(visitedCount, valuesCount / 2);
+}
+
+
+
+
 int main(int argc, char** argv) {
     lg::DefaultLoggers::Init(".\\Logs\\main.log", lg::InitFlags::DefaultFlags);
     